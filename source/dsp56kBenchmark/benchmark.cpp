@@ -0,0 +1,273 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+
+#if defined(_MSC_VER) && defined(_M_X64)
+#include <intrin.h>
+#define HAVE_HOST_CYCLES 1
+#elif defined(__x86_64__)
+#include <x86intrin.h>
+#define HAVE_HOST_CYCLES 1
+#else
+#define HAVE_HOST_CYCLES 0
+#endif
+
+#include "workloads.h"
+
+#include "dsp56kEmu/dsp.h"
+#include "dsp56kEmu/interrupts.h"
+#include "dsp56kEmu/jit.h"
+#include "dsp56kEmu/memory.h"
+#include "dsp56kEmu/peripherals.h"
+
+using namespace dsp56k;
+
+namespace dsp56kBenchmark
+{
+	struct Result
+	{
+		std::string workload;
+		bool jit = false;
+		uint64_t instructions = 0;
+		double seconds = 0.0;
+		uint64_t hostCycles = 0;
+		double compileSeconds = 0.0;
+		size_t codeSize = 0;
+		uint64_t checksum = 0;
+	};
+
+	uint64_t readHostCycles()
+	{
+#if HAVE_HOST_CYCLES
+		return __rdtsc();
+#else
+		return 0;
+#endif
+	}
+
+	// FNV-1a
+	void hash(uint64_t& _hash, const uint64_t _value)
+	{
+		for(size_t i=0; i<sizeof(_value); ++i)
+		{
+			_hash ^= (_value >> (i<<3)) & 0xff;
+			_hash *= 0x100000001b3ull;
+		}
+	}
+
+	Result run(const Workload& _workload, const bool _jit, const uint64_t _instructions)
+	{
+		static DefaultMemoryValidator validator;
+
+		auto periphX = std::make_unique<Peripherals56362>();
+		auto periphY = std::make_unique<Peripherals56367>();
+		auto mem = std::make_unique<Memory>(validator, 0x080000, 0x800000, 0x200000);
+		auto dsp = std::make_unique<DSP>(*mem, periphX.get(), periphY.get());
+
+		dsp->setUseInterpreter(!_jit);
+		dsp->resetHW();
+
+		// fixed pseudo random input data
+		uint32_t seed = 0x12345678;
+
+		for(TWord i=0; i<0x1000; ++i)
+		{
+			seed = seed * 1664525 + 1013904223;
+			mem->set(MemArea_X, i, seed >> 8);
+			seed = seed * 1664525 + 1013904223;
+			mem->set(MemArea_Y, i, seed >> 8);
+		}
+
+		for (const auto& s : _workload.x)
+			mem->set(MemArea_X, s.address, s.words.data(), static_cast<TWord>(s.words.size()));
+		for (const auto& s : _workload.y)
+			mem->set(MemArea_Y, s.address, s.words.data(), static_cast<TWord>(s.words.size()));
+		for (const auto& s : _workload.p)
+			mem->set(MemArea_P, s.address, s.words.data(), static_cast<TWord>(s.words.size()));
+
+		dsp->clearOpcodeCache();
+		dsp->setPC(0x100);
+
+		for(uint32_t i=0; i<_workload.hostWords; ++i)
+		{
+			seed = seed * 1664525 + 1013904223;
+			const TWord w = seed >> 8;
+			periphX->getHDI08().writeRX(&w, 1);
+		}
+
+		const auto interval = _workload.irqAInterval ? _workload.irqAInterval : _instructions;
+
+		const auto tStart = std::chrono::steady_clock::now();
+		const auto cStart = readHostCycles();
+
+		uint64_t executed = 0;
+
+		while(executed < _instructions)
+		{
+			const auto next = std::min(executed + interval, _instructions);
+
+			if(_workload.irqAInterval && executed)
+			{
+				dsp->injectInterrupt(Vba_IRQA);
+
+				if(_workload.irqBInterval && (executed / _workload.irqBInterval) != (next / _workload.irqBInterval))
+					dsp->injectInterrupt(Vba_IRQB);
+			}
+
+			const auto target = dsp->getInstructionCounter() + next - executed;
+			const auto begin = dsp->getInstructionCounter();
+
+			while(dsp->getInstructionCounter() < target)
+				dsp->exec();
+
+			executed += dsp->getInstructionCounter() - begin;
+		}
+
+		const auto cEnd = readHostCycles();
+		const auto tEnd = std::chrono::steady_clock::now();
+
+		Result r;
+		r.workload = _workload.name;
+		r.jit = _jit;
+		r.instructions = executed;
+		r.seconds = std::chrono::duration<double>(tEnd - tStart).count();
+		r.hostCycles = cEnd - cStart;
+
+		if(_jit)
+		{
+			uint64_t compileNs = 0;
+
+			dsp->getJit().forEachChain([&](const JitBlockChain& _chain)
+			{
+				compileNs += _chain.getCompileTimeNs();
+				r.codeSize += _chain.getCodeSize();
+			});
+
+			r.compileSeconds = static_cast<double>(compileNs) * 1e-9;
+		}
+
+		// the final state identifies the workload result, it only changes if code generation or the interpreter changes
+		r.checksum = 0xcbf29ce484222325ull;
+		hash(r.checksum, dsp->regs().a.var);
+		hash(r.checksum, dsp->regs().b.var);
+		for(TWord i=0; i<0x1000; ++i)
+		{
+			hash(r.checksum, mem->get(MemArea_X, i));
+			hash(r.checksum, mem->get(MemArea_Y, i));
+		}
+
+		return r;
+	}
+
+	std::string toJson(const std::vector<Result>& _results)
+	{
+		std::stringstream ss;
+
+		ss << "{" << std::endl;
+		ss << "\t\"hostCyclesAvailable\": " << (HAVE_HOST_CYCLES ? "true" : "false") << "," << std::endl;
+		ss << "\t\"results\": [" << std::endl;
+
+		for(size_t i=0; i<_results.size(); ++i)
+		{
+			const auto& r = _results[i];
+
+			const auto mips = static_cast<double>(r.instructions) / r.seconds * 1e-6;
+			const auto cyclesPerInstruction = static_cast<double>(r.hostCycles) / static_cast<double>(r.instructions);
+
+			char checksum[32];
+			snprintf(checksum, sizeof(checksum), "%016llx", static_cast<unsigned long long>(r.checksum));
+
+			ss << "\t\t{";
+			ss << "\"workload\": \"" << r.workload << "\", ";
+			ss << "\"engine\": \"" << (r.jit ? "jit" : "interpreter") << "\", ";
+			ss << "\"instructions\": " << r.instructions << ", ";
+			ss << "\"seconds\": " << r.seconds << ", ";
+			ss << "\"mips\": " << mips << ", ";
+			if(HAVE_HOST_CYCLES)
+				ss << "\"hostCyclesPerInstruction\": " << cyclesPerInstruction << ", ";
+			else
+				ss << "\"hostCyclesPerInstruction\": null, ";
+			ss << "\"jitCompileSeconds\": " << r.compileSeconds << ", ";
+			ss << "\"jitCodeSize\": " << r.codeSize << ", ";
+			ss << "\"checksum\": \"" << checksum << "\"";
+			ss << "}" << (i + 1 < _results.size() ? "," : "") << std::endl;
+		}
+
+		ss << "\t]" << std::endl;
+		ss << "}" << std::endl;
+
+		return ss.str();
+	}
+}
+
+int main(int _argc, char* _argv[])
+{
+	using namespace dsp56kBenchmark;
+
+	uint64_t instructions = 20000000;
+	std::string filter;
+	std::string output;
+	bool runJit = g_jitSupported;
+	bool runInterpreter = true;
+
+	for(int i=1; i<_argc; ++i)
+	{
+		const std::string arg(_argv[i]);
+		const bool hasValue = i + 1 < _argc;
+
+		if(arg == "--instructions" && hasValue)
+			instructions = std::stoull(_argv[++i]);
+		else if(arg == "--workload" && hasValue)
+			filter = _argv[++i];
+		else if(arg == "--output" && hasValue)
+			output = _argv[++i];
+		else if(arg == "--jit-only")
+			runInterpreter = false;
+		else if(arg == "--interpreter-only")
+			runJit = false;
+		else
+		{
+			std::cout << "Usage: dsp56kBenchmark [--instructions count] [--workload name] [--output file.json] [--jit-only] [--interpreter-only]" << std::endl;
+			std::cout << "Workloads:";
+			for (const auto& w : getWorkloads())
+				std::cout << ' ' << w.name;
+			std::cout << std::endl;
+			return -1;
+		}
+	}
+
+	std::vector<Result> results;
+
+	for (const auto& w : getWorkloads())
+	{
+		if(!filter.empty() && filter != w.name)
+			continue;
+
+		if(runJit)
+			results.push_back(run(w, true, instructions));
+		if(runInterpreter)
+			results.push_back(run(w, false, instructions));
+	}
+
+	const auto json = toJson(results);
+
+	if(output.empty())
+	{
+		std::cout << json;
+		return 0;
+	}
+
+	std::ofstream o(output);
+	if(!o.is_open())
+	{
+		std::cout << "Failed to create " << output << std::endl;
+		return -1;
+	}
+	o << json;
+	return 0;
+}
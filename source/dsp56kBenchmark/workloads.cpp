@@ -0,0 +1,154 @@
+#include "workloads.h"
+
+namespace dsp56kBenchmark
+{
+	namespace
+	{
+		// 64 tap FIR filter with modulo addressed delay line and coefficients, REP + MAC with parallel XY moves
+		Workload fir()
+		{
+			Workload w{"fir"};
+			w.p = {{0x100, {
+				0x304000,			// move #$40,r0
+				0x348000,			// move #$80,r4
+				0x053fa0,			// move #$3f,m0
+				0x053fa4,			// move #$3f,m4
+				0x62f400, 0x000100,	// move #>$100,r2
+				0x05ffa2,			// move #$ff,m2
+				0x63f400, 0x000200,	// move #>$200,r3
+				0x05ffa3,			// move #$ff,m3
+				0x44da00,			// move x:(r2)+,x0
+				0x445800,			// move x0,x:(r0)+
+				0xf09813,			// clr a			x:(r0)+,x0		y:(r4)+,y0
+				0x063fa0,			// rep #$3f
+				0xf098d2,			// mac y0,x0,a		x:(r0)+,x0		y:(r4)+,y0
+				0x2050d3,			// macr y0,x0,a		(r0)-
+				0x565b00,			// move a,x:(r3)+
+				0x0c010a			// jmp $10a
+			}}};
+			return w;
+		}
+
+		// ring buffers with non power of two sizes, post increment by offset register and parallel XY moves
+		Workload modulo()
+		{
+			Workload w{"modulo"};
+			w.p = {{0x100, {
+				0x05f420, 0x0003e7,	// move #>$3e7,m0
+				0x300000,			// move #$0,r0
+				0x05f424, 0x0002bb,	// move #>$2bb,m4
+				0x64f400, 0x000400,	// move #>$400,r4
+				0x05ffa1,			// move #$ff,m1
+				0x61f400, 0x000800,	// move #>$800,r1
+				0x380300,			// move #$3,n0
+				0x3c0500,			// move #$5,n4
+				0xd08840,			// add x0,a			x:(r0)+n0,x0	y:(r4)+n4,y0
+				0xf59054,			// sub y0,a			x:(r0)-,x1		y:(r4)+,y1
+				0x565968,			// add x1,b			a,x:(r1)+
+				0xe0987c,			// sub y1,b			x:(r0)+,x0		y:(r4)-,y0
+				0x0c010c			// jmp $10c
+			}}};
+			return w;
+		}
+
+		// inner DO loop inside of an outer DO loop
+		Workload nestedLoops()
+		{
+			Workload w{"nestedloops"};
+			w.p = {{0x100, {
+				0x240100,			// move #$1,x0
+				0x61f400, 0x000300,	// move #>$300,r1
+				0x05ffa1,			// move #$ff,m1
+				0x062080, 0x00010c,	// do #$20,$10d
+				0x060880, 0x00010a,	// do #$8,$10b
+				0x205940,			// add x0,a			(r1)+
+				0x20003f,			// rol b
+				0x200026,			// abs a
+				0x200009,			// tfr a,b
+				0x575900,			// move b,x:(r1)+
+				0x0c0104			// jmp $104
+			}}};
+			return w;
+		}
+
+		// short ALU loop that is interrupted by fast interrupts (IRQA) and long interrupts (IRQB) all the time
+		Workload interrupts()
+		{
+			Workload w{"interrupts"};
+			w.p = {
+				{0x10, {
+					0x000009,		// inc b
+					0x000000,		// nop
+					0x0d0180,		// jsr $180
+					0x000000		// nop
+				}},
+				{0x100, {
+					0x240100,			// move #$1,x0
+					0x67f400, 0x000400,	// move #>$400,r7
+					0x05ffa7,			// move #$ff,m7
+					0x00fcb8,			// andi #$fc,mr
+					0x200040,			// add x0,a
+					0x20003f,			// rol b
+					0x200009,			// tfr a,b
+					0x0c0105			// jmp $105
+				}},
+				{0x180, {
+					0x565f00,		// move a,x:(r7)+
+					0x200040,		// add x0,a
+					0x000004		// rti
+				}}
+			};
+			w.irqAInterval = 16;
+			w.irqBInterval = 128;
+			return w;
+		}
+
+		// patches the first instruction of a subroutine before each call
+		Workload selfModifying()
+		{
+			Workload w{"selfmodifying"};
+			w.p = {
+				{0x100, {
+					0x351000,			// move #$10,r5
+					0x0501a5,			// move #$1,m5
+					0x66f400, 0x000140,	// move #>$140,r6
+					0x240100,			// move #$1,x0
+					0x4ddd00,			// move y:(r5)+,x1
+					0x076685,			// move x1,p:(r6)
+					0x200048,			// add x0,b
+					0x0d0140,			// jsr $140
+					0x0c0105			// jmp $105
+				}},
+				{0x140, {
+					0x000000,		// nop, patched
+					0x00000c		// rts
+				}}
+			};
+			w.y = {{0x10, {
+				0x000008,			// inc a
+				0x000009			// inc b
+			}}};
+			return w;
+		}
+
+		// polls the HDI08 status register and reads host data, keeps polling once all data has been read
+		Workload polling()
+		{
+			Workload w{"polling"};
+			w.p = {{0x100, {
+				0x0a8380, 0x000100,	// jclr #0,x:$ffffc3,$100
+				0x084406,			// movep x:$ffffc6,x0
+				0x200040,			// add x0,a
+				0x0c0100			// jmp $100
+			}}};
+			w.hostWords = 4096;
+			return w;
+		}
+	}
+
+	const std::vector<Workload>& getWorkloads()
+	{
+		static const std::vector<Workload> workloads{fir(), modulo(), nestedLoops(), interrupts(), selfModifying(), polling()};
+		return workloads;
+	}
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "dsp56kEmu/types.h"
+
+namespace dsp56kBenchmark
+{
+	struct Segment
+	{
+		dsp56k::TWord address;
+		std::vector<dsp56k::TWord> words;
+	};
+
+	// a synthetic DSP program. Execution starts at P:$100, X and Y memory is filled with pseudo random data before the
+	// segments are written
+	struct Workload
+	{
+		const char* name;
+		std::vector<Segment> p;
+		std::vector<Segment> x;
+		std::vector<Segment> y;
+
+		// host side stimulus, an interrupt is injected whenever the given number of instructions has been executed
+		uint32_t irqAInterval = 0;
+		uint32_t irqBInterval = 0;
+
+		// number of words that are written to the HDI08 receive register before execution starts
+		uint32_t hostWords = 0;
+	};
+
+	const std::vector<Workload>& getWorkloads();
+}
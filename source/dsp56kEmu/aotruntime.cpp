@@ -0,0 +1,204 @@
+#include "aotruntime.h"
+
+#include "dsp.h"
+#include "jitblock.h"
+#include "jitblockchain.h"
+#include "jitblockinfo.h"
+#include "jitblockruntimedata.h"
+#include "logging.h"
+
+namespace dsp56k
+{
+	namespace
+	{
+		// blocks are generated in multiple passes as linking blocks can generate blocks that overlap with other discovered code
+		constexpr size_t g_maxGeneratePasses = 8;
+	}
+
+	AotRuntime::AotRuntime(DSP& _dsp) : m_dsp(_dsp)
+	{
+	}
+
+	std::vector<TWord> AotRuntime::getDefaultEntryPoints(const DSP& _dsp)
+	{
+		std::vector<TWord> entryPoints;
+
+		entryPoints.push_back(_dsp.getPC().toWord());
+
+		const auto vba = _dsp.regs().vba.toWord();
+
+		for(TWord v=0; v<Vba_End; v += 2)
+		{
+			TWord opA, opB;
+			_dsp.memory().getOpcode(vba + v, opA, opB);
+
+			// a vector that contains two NOPs is not used
+			if(opA || opB)
+				entryPoints.push_back(vba + v);
+		}
+
+		return entryPoints;
+	}
+
+	size_t AotRuntime::compile()
+	{
+		return compile(getDefaultEntryPoints(m_dsp));
+	}
+
+	size_t AotRuntime::compile(const std::vector<TWord>& _entryPoints)
+	{
+		auto& jit = m_dsp.getJit();
+
+		jit.setAheadOfTime(true);
+
+		discover(_entryPoints);
+		const auto count = generate();
+
+		jit.setAheadOfTime(false);
+
+		LOG("AOT: Generated " << count << " blocks for " << m_blockStarts.size() << " discovered code locations, " << m_loops.size() << " loops");
+
+		return count;
+	}
+
+	void AotRuntime::discover(const std::vector<TWord>& _entryPoints)
+	{
+		const auto pSize = m_dsp.memory().sizeP();
+
+		std::vector<TWord> pending;
+		std::set<TWord> visited;
+
+		auto add = [&](const TWord _pc)
+		{
+			if(_pc < pSize && visited.insert(_pc).second)
+				pending.push_back(_pc);
+		};
+
+		for (const auto pc : _entryPoints)
+			add(pc);
+
+		while(!pending.empty())
+		{
+			const auto pc = pending.back();
+			pending.pop_back();
+
+			JitBlockInfo info;
+			Instruction lastInstA, lastInstB;
+
+			if(!analyze(info, lastInstA, lastInstB, pc))
+				continue;
+
+			m_blockStarts.insert(pc);
+
+			const auto pcNext = pc + info.memSize;
+			const auto isFastInterrupt = pc < Vba_End;
+
+			if(info.loopBegin != g_invalidAddress && info.loopEnd != g_invalidAddress)
+			{
+				m_loops.insert(std::make_pair(info.loopBegin, info.loopEnd));
+				add(info.loopEnd);
+			}
+
+			switch (info.terminationReason)
+			{
+			case JitBlockInfo::TerminationReason::Branch:
+				if(info.branchTarget != g_invalidAddress && info.branchTarget != g_dynamicAddress)
+					add(info.branchTarget);
+
+				// execution continues after conditional branches and after returning from subroutines
+				if(!isFastInterrupt && (info.branchIsConditional || (Opcodes::getFlags(lastInstA, lastInstB) & OpFlagPushPC)))
+					add(pcNext);
+				break;
+			case JitBlockInfo::TerminationReason::PopPC:
+				break;
+			default:
+				if(!isFastInterrupt)
+					add(pcNext);
+				break;
+			}
+		}
+	}
+
+	bool AotRuntime::analyze(JitBlockInfo& _info, Instruction& _lastInstA, Instruction& _lastInstB, const TWord _pc) const
+	{
+		// blocks are analyzed without knowing about other blocks and loops, generate() will split them as needed
+		static const std::vector<JitCacheEntry> noCache;
+		static const std::map<TWord, TWord> noLoops;
+		static const std::set<TWord> noLoopEnds;
+
+		const auto& jit = m_dsp.getJit();
+
+		JitBlock::getInfo(_info, m_dsp, _pc, jit.getConfig(_pc), noCache, jit.getVolatileP(), noLoops, noLoopEnds);
+
+		if(!_info.instructionCount)
+			return false;
+
+		const auto& mem = m_dsp.memory();
+		const auto& opcodes = m_dsp.opcodes();
+
+		for(TWord pc = _pc; pc < _pc + _info.memSize;)
+		{
+			TWord opA, opB;
+			mem.getOpcode(pc, opA, opB);
+			opcodes.getInstructionTypes(opA, _lastInstA, _lastInstB);
+
+			// data or uninitialized memory, do not generate code for it
+			if(_lastInstA == Invalid)
+				return false;
+
+			pc += Opcodes::getOpcodeLength(opA, _lastInstA, _lastInstB);
+		}
+
+		return true;
+	}
+
+	size_t AotRuntime::generate()
+	{
+		auto& jit = m_dsp.getJit();
+
+		// loops are usually registered when the block containing the DO is generated. Register them upfront so that
+		// blocks are split at the loop ends even if they are generated before the block that starts the loop
+		for (const auto& [begin, end] : m_loops)
+		{
+			if(jit.getLoops().find(begin) == jit.getLoops().end() && jit.getLoopEnds().find(end) == jit.getLoopEnds().end())
+				jit.addLoop(begin, end);
+		}
+
+		// generate from high to low addresses, a block ends where an already generated block starts
+		for(size_t pass=0; pass<g_maxGeneratePasses; ++pass)
+		{
+			bool done = true;
+
+			for(auto it = m_blockStarts.rbegin(); it != m_blockStarts.rend(); ++it)
+			{
+				const auto pc = *it;
+
+				const auto* block = jit.getCurrentChain()->getBlock(pc);
+
+				if(block && block->getPCFirst() == pc)
+					continue;
+
+				if(block)
+					jit.destroyToRecreate(pc);
+
+				jit.create(pc, false);
+
+				done = false;
+			}
+
+			if(done)
+				break;
+		}
+
+		size_t count = 0;
+
+		for (const auto pc : m_blockStarts)
+		{
+			const auto* block = jit.getCurrentChain()->getBlock(pc);
+			if(block && block->getPCFirst() == pc)
+				++count;
+		}
+
+		return count;
+	}
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <map>
+#include <set>
+#include <vector>
+
+#include "opcodetypes.h"
+#include "types.h"
+
+namespace dsp56k
+{
+	struct JitBlockInfo;
+	class DSP;
+
+	// Ahead-of-time compilation for a fixed P memory image. Discovers all code that is reachable from a set of entry points
+	// and generates the JIT blocks for it before execution starts, including the links between blocks.
+	// Code that can only be found at runtime (dynamic jumps, code that is written to P memory later) is still generated on demand
+	class AotRuntime
+	{
+	public:
+		explicit AotRuntime(DSP& _dsp);
+
+		// the current PC plus all interrupt vectors that contain code
+		static std::vector<TWord> getDefaultEntryPoints(const DSP& _dsp);
+
+		// returns the number of blocks that have been generated
+		size_t compile();
+		size_t compile(const std::vector<TWord>& _entryPoints);
+
+		const std::set<TWord>& getBlockStarts() const { return m_blockStarts; }
+		const std::map<TWord, TWord>& getLoops() const { return m_loops; }
+
+	private:
+		void discover(const std::vector<TWord>& _entryPoints);
+		bool analyze(JitBlockInfo& _info, Instruction& _lastInstA, Instruction& _lastInstB, TWord _pc) const;
+		size_t generate();
+
+		DSP& m_dsp;
+
+		std::set<TWord> m_blockStarts;
+		std::map<TWord, TWord> m_loops;		// loop begin => loop end
+	};
+}
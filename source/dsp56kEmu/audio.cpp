@@ -29,4 +29,102 @@ namespace dsp56k
 		if (m_audioOutputs.size() >= (m_callbackSamples << 1))
 			m_callback(this);
 	}
+
+	void Audio::processAudioInputInterleaved(const void* const* _inputs, const SampleFormat _format, const uint32_t _frames, const size_t _latency/* = 0*/)
+	{
+		constexpr uint32_t channels = RxRegisterCount << 1;
+
+		m_convertIn.resize(static_cast<size_t>(_frames) * channels);
+
+		for(uint32_t c=0; c<channels; ++c)
+			AudioConvert::toDsp(&m_convertIn[c * _frames], _inputs[c], _format, _frames);
+
+		const TWord* in = m_convertIn.data();
+
+		processAudioInput<TWord>(_frames, _latency, [&](const size_t _s, RxFrame& _f)
+		{
+			_f.resize(2);
+			_f[0] = RxSlot{in[_s], in[2 * _frames + _s], in[4 * _frames + _s], in[6 * _frames + _s]};
+			_f[1] = RxSlot{in[_frames + _s], in[3 * _frames + _s], in[5 * _frames + _s], in[7 * _frames + _s]};
+		});
+	}
+
+	void Audio::processAudioOutputInterleaved(void* const* _outputs, const SampleFormat _format, const uint32_t _frames)
+	{
+		constexpr uint32_t channels = TxRegisterCount << 1;
+
+		m_convertOut.resize(static_cast<size_t>(_frames) * channels);
+		m_incompleteOutFrames.clear();
+
+		TWord* out = m_convertOut.data();
+
+		processAudioOutput<TWord>(_frames, [&](const size_t _frame, const TxFrame& _tx)
+		{
+			if(_tx.size() < 2)
+				m_incompleteOutFrames.emplace_back(_frame, _tx.size());
+
+			for(uint32_t s=0; s<2 && s<_tx.size(); ++s)
+			{
+				for(uint32_t r=0; r<TxRegisterCount; ++r)
+					out[((r << 1) + s) * _frames + _frame] = _tx[s][r];
+			}
+		});
+
+		const auto sampleSize = getSampleSize(_format);
+
+		for(uint32_t c=0; c<channels; ++c)
+		{
+			auto* dst = static_cast<uint8_t*>(_outputs[c]);
+			const auto* src = &m_convertOut[c * _frames];
+
+			// outputs of slots that have not been transmitted are left untouched, convert the ranges in between
+			size_t begin = 0;
+
+			for (const auto& [frame, slotCount] : m_incompleteOutFrames)
+			{
+				if((c & 1) < slotCount)
+					continue;
+
+				AudioConvert::fromDsp(dst + begin * sampleSize, src + begin, _format, frame - begin);
+				begin = frame + 1;
+			}
+
+			AudioConvert::fromDsp(dst + begin * sampleSize, src + begin, _format, _frames - begin);
+		}
+	}
+
+	void Audio::processAudioInput(const void* _input, const SampleFormat _format, const uint32_t _frames, const uint32_t _slotsPerFrame, const size_t _latency/* = 0*/)
+	{
+		const size_t wordsPerFrame = static_cast<size_t>(_slotsPerFrame) * RxRegisterCount;
+
+		m_convertIn.resize(_frames * wordsPerFrame);
+
+		AudioConvert::toDsp(m_convertIn.data(), _input, _format, m_convertIn.size());
+
+		const TWord* in = m_convertIn.data();
+
+		processAudioInput<TWord>(_frames, _latency, [&](size_t, RxFrame& _f)
+		{
+			_f.resize(_slotsPerFrame);
+
+			for(uint32_t s=0; s<_slotsPerFrame; ++s)
+			{
+				for(uint32_t i=0; i<RxRegisterCount; ++i)
+					_f[s][i] = *in++;
+			}
+		});
+	}
+
+	void Audio::processAudioOutput(void* _output, const SampleFormat _format, const uint32_t _frames)
+	{
+		m_convertOut.clear();
+
+		processAudioOutput<TWord>(_frames, [&](size_t, const TxFrame& _tx)
+		{
+			for(size_t s=0; s<_tx.size(); ++s)
+				m_convertOut.insert(m_convertOut.end(), _tx[s].begin(), _tx[s].end());
+		});
+
+		AudioConvert::fromDsp(_output, m_convertOut.data(), _format, m_convertOut.size());
+	}
 }
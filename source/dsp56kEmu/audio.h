@@ -5,7 +5,10 @@
 #include <functional>
 #include <array>
 #include <cstring> // memcpy
+#include <type_traits>
+#include <vector>
 
+#include "audioconvert.h"
 #include "fastmath.h"
 #include "ringbuffer.h"
 #include "utils.h"
@@ -121,8 +124,10 @@ namespace dsp56k
 
 		void writeEmptyAudioIn(const size_t _len)
 		{
-			for (size_t i = 0; i < _len; ++i)
-				m_audioInputs.push_back({});
+			m_audioInputs.emplace_back_n(_len, [](RxFrame& _frame, size_t)
+			{
+				_frame.clear();
+			});
 		}
 
 		template<typename T>
@@ -135,116 +140,160 @@ namespace dsp56k
 		template<typename T, typename TFunc>
 		void processAudioInput(const uint32_t _frames, const size_t _latency, const TFunc& _createRxFrame)
 		{
-			for (uint32_t s = 0; s < _frames; ++s)
+			if(_latency > m_latency)
 			{
-				// INPUT
+				// a latency increase on the input means to feed additional zeroes into it. One zero frame is inserted before each input frame until the target is reached
+				const auto inc = std::min(static_cast<size_t>(_frames), _latency - m_latency);
 
-				if(_latency > m_latency)
+				m_audioInputs.emplace_back_n(_frames + inc, [&](RxFrame& _frame, const size_t _i)
 				{
-					// a latency increase on the input means to feed additional zeroes into it
-					m_audioInputs.waitNotFull();
-					m_audioInputs.push_back({});
+					if(_i >= (inc << 1))
+						_createRxFrame(_i - inc, _frame);
+					else if(_i & 1)
+						_createRxFrame(_i >> 1, _frame);
+					else
+						_frame.clear();
+				});
+
+				m_latency += inc;
+			}
+			else if(_latency < m_latency)
+			{
+				// a latency decrease on the input means to skip writing data
+				const auto skip = std::min(static_cast<size_t>(_frames), m_latency - _latency);
 
-					++m_latency;
-				}
-				if(_latency < m_latency)
+				m_audioInputs.emplace_back_n(_frames - skip, [&](RxFrame& _frame, const size_t _i)
 				{
-					// a latency decrease on the input means to skip writing data
-					--m_latency;
-				}
-				else
+					_createRxFrame(_i + skip, _frame);
+				});
+
+				m_latency -= skip;
+			}
+			else
+			{
+				m_audioInputs.emplace_back_n(_frames, [&](RxFrame& _frame, const size_t _i)
 				{
-					m_audioInputs.emplace_back([&](RxFrame& _frame)
-					{
-						_createRxFrame(s, _frame);
-					});
-				}
+					_createRxFrame(_i, _frame);
+				});
 			}
 		}
 
 		template<typename T>
 		void processAudioInputInterleaved(const T** _ins, const uint32_t _frames, const size_t _latency = 0)
 		{
-			return processAudioInput<T>(_frames, _latency, [&](size_t _s, RxFrame& _f)
+			if constexpr (std::is_same_v<T, float>)
 			{
-				_f.resize(2);
-				_f[0] = RxSlot{sample2dsp<T>(_ins[0][_s]), sample2dsp<T>(_ins[2][_s]), sample2dsp<T>(_ins[4][_s]), sample2dsp<T>(_ins[6][_s])};
-				_f[1] = RxSlot{sample2dsp<T>(_ins[1][_s]), sample2dsp<T>(_ins[3][_s]), sample2dsp<T>(_ins[5][_s]), sample2dsp<T>(_ins[7][_s])};
-			});
+				processAudioInputInterleaved(reinterpret_cast<const void* const*>(_ins), SampleFormat::Float32, _frames, _latency);
+			}
+			else
+			{
+				return processAudioInput<T>(_frames, _latency, [&](size_t _s, RxFrame& _f)
+				{
+					_f.resize(2);
+					_f[0] = RxSlot{sample2dsp<T>(_ins[0][_s]), sample2dsp<T>(_ins[2][_s]), sample2dsp<T>(_ins[4][_s]), sample2dsp<T>(_ins[6][_s])};
+					_f[1] = RxSlot{sample2dsp<T>(_ins[1][_s]), sample2dsp<T>(_ins[3][_s]), sample2dsp<T>(_ins[5][_s]), sample2dsp<T>(_ins[7][_s])};
+				});
+			}
 		}
 
 		template<typename T>
 		void processAudioInput(const T* _input, const uint32_t _frames, const uint32_t _slotsPerFrame, const size_t _latency = 0)
 		{
-			uint32_t readPos = 0;
-
-			return processAudioInput<T>(_frames, _latency, [&](size_t _s, RxFrame& _f)
+			if constexpr (std::is_same_v<T, float>)
+			{
+				processAudioInput(static_cast<const void*>(_input), SampleFormat::Float32, _frames, _slotsPerFrame, _latency);
+			}
+			else
 			{
-				_f.resize(_slotsPerFrame);
+				uint32_t readPos = 0;
 
-				for(uint32_t s=0; s<_slotsPerFrame; ++s)
+				return processAudioInput<T>(_frames, _latency, [&](size_t _s, RxFrame& _f)
 				{
-					for(uint32_t i=0; i<_f[s].size(); ++i)
-						_f[s][i] = sample2dsp<T>(_input[readPos++]);
-				}
-			});
+					_f.resize(_slotsPerFrame);
+
+					for(uint32_t s=0; s<_slotsPerFrame; ++s)
+					{
+						for(uint32_t i=0; i<_f[s].size(); ++i)
+							_f[s][i] = sample2dsp<T>(_input[readPos++]);
+					}
+				});
+			}
 		}
 
 		template<typename T, typename TFunc>
 		void processAudioOutput(const uint32_t _frames, const TFunc& _readOutputCbk)
 		{
-			for (uint32_t i = 0; i < _frames; ++i)
+			m_audioOutputs.pop_front_n(_frames, [&](TxFrame& _frame, const size_t _i)
 			{
-				m_audioOutputs.waitNotEmpty();
-				m_audioOutputs.pop_front([&](TxFrame& _frame)
-				{
-					_readOutputCbk(i, _frame);
-				});
-			}
+				_readOutputCbk(_i, _frame);
+			});
 		}
 
 		template<typename T>
 		void processAudioOutputInterleaved(T** _outputs, const uint32_t _sampleFrames)
 		{
-			processAudioOutput<T>(_sampleFrames, [&](size_t _frame, TxFrame& _tx)
+			if constexpr (std::is_same_v<T, float>)
 			{
-				if(_tx.empty())
-					return;
-
-				_outputs[0 ][_frame] = dsp2sample<T>(_tx[0][0]);
-				_outputs[2 ][_frame] = dsp2sample<T>(_tx[0][1]);
-				_outputs[4 ][_frame] = dsp2sample<T>(_tx[0][2]);
-				_outputs[6 ][_frame] = dsp2sample<T>(_tx[0][3]);
-				_outputs[8 ][_frame] = dsp2sample<T>(_tx[0][4]);
-				_outputs[10][_frame] = dsp2sample<T>(_tx[0][5]);
-
-				if(_tx.size() < 2)
-					return;
-
-				_outputs[ 1][_frame] = dsp2sample<T>(_tx[1][0]);
-				_outputs[ 3][_frame] = dsp2sample<T>(_tx[1][1]);
-				_outputs[ 5][_frame] = dsp2sample<T>(_tx[1][2]);
-				_outputs[ 7][_frame] = dsp2sample<T>(_tx[1][3]);
-				_outputs[ 9][_frame] = dsp2sample<T>(_tx[1][4]);
-				_outputs[11][_frame] = dsp2sample<T>(_tx[1][5]);
-			});
+				processAudioOutputInterleaved(reinterpret_cast<void* const*>(_outputs), SampleFormat::Float32, _sampleFrames);
+			}
+			else
+			{
+				processAudioOutput<T>(_sampleFrames, [&](size_t _frame, TxFrame& _tx)
+				{
+					if(_tx.empty())
+						return;
+
+					_outputs[0 ][_frame] = dsp2sample<T>(_tx[0][0]);
+					_outputs[2 ][_frame] = dsp2sample<T>(_tx[0][1]);
+					_outputs[4 ][_frame] = dsp2sample<T>(_tx[0][2]);
+					_outputs[6 ][_frame] = dsp2sample<T>(_tx[0][3]);
+					_outputs[8 ][_frame] = dsp2sample<T>(_tx[0][4]);
+					_outputs[10][_frame] = dsp2sample<T>(_tx[0][5]);
+
+					if(_tx.size() < 2)
+						return;
+
+					_outputs[ 1][_frame] = dsp2sample<T>(_tx[1][0]);
+					_outputs[ 3][_frame] = dsp2sample<T>(_tx[1][1]);
+					_outputs[ 5][_frame] = dsp2sample<T>(_tx[1][2]);
+					_outputs[ 7][_frame] = dsp2sample<T>(_tx[1][3]);
+					_outputs[ 9][_frame] = dsp2sample<T>(_tx[1][4]);
+					_outputs[11][_frame] = dsp2sample<T>(_tx[1][5]);
+				});
+			}
 		}
 
 		template<typename T>
 		void processAudioOutput(T* _outputs, const uint32_t _sampleFrames)
 		{
-			size_t writePos = 0;
-			processAudioOutput<T>(_sampleFrames, [&](size_t _frame, TxFrame& _tx)
+			if constexpr (std::is_same_v<T, float>)
+			{
+				processAudioOutput(static_cast<void*>(_outputs), SampleFormat::Float32, _sampleFrames);
+			}
+			else
 			{
-				for(size_t s=0; s<_tx.size(); ++s)
+				size_t writePos = 0;
+				processAudioOutput<T>(_sampleFrames, [&](size_t _frame, TxFrame& _tx)
 				{
-					const auto& slot = _tx[s];
-					for (const auto v : slot)
-						_outputs[writePos++] = dsp2sample<T>(v);
-				}
-			});
+					for(size_t s=0; s<_tx.size(); ++s)
+					{
+						const auto& slot = _tx[s];
+						for (const auto v : slot)
+							_outputs[writePos++] = dsp2sample<T>(v);
+					}
+				});
+			}
 		}
 
+		// Block based variants that use the vectorized conversion of AudioConvert. Interleaved means one buffer per channel,
+		// 8 input channels are mapped to two RX slots, 12 output channels to two TX slots
+		void processAudioInputInterleaved(const void* const* _inputs, SampleFormat _format, uint32_t _frames, size_t _latency = 0);
+		void processAudioOutputInterleaved(void* const* _outputs, SampleFormat _format, uint32_t _frames);
+
+		// a single buffer with all slots of a frame next to each other
+		void processAudioInput(const void* _input, SampleFormat _format, uint32_t _frames, uint32_t _slotsPerFrame, size_t _latency = 0);
+		void processAudioOutput(void* _output, SampleFormat _format, uint32_t _frames);
+
 		const auto& getAudioInputs() const { return m_audioInputs; }
 		const auto& getAudioOutputs() const { return m_audioOutputs; }
 
@@ -277,5 +326,10 @@ namespace dsp56k
 		RingBuffer<RxFrame, RingBufferSize, true, false> m_audioInputs;
 		RingBuffer<TxFrame, RingBufferSize, true, false> m_audioOutputs;
 		size_t m_latency = 0;
+
+	private:
+		std::vector<TWord> m_convertIn;
+		std::vector<TWord> m_convertOut;
+		std::vector<std::pair<size_t, uint32_t>> m_incompleteOutFrames;	// frame index, slot count
 	};
 }
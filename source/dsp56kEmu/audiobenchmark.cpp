@@ -0,0 +1,101 @@
+#include "audiobenchmark.h"
+
+#include <chrono>
+#include <memory>
+#include <thread>
+
+#include "audio.h"
+#include "logging.h"
+
+namespace dsp56k
+{
+	namespace
+	{
+		using Buffer = RingBuffer<Audio::RxFrame, Audio::RingBufferSize, true, false>;
+		using Clock = std::chrono::high_resolution_clock;
+
+		template<bool Bulk> double measure(const size_t _blockSize, const size_t _totalFrames)
+		{
+			// the buffer is too large for the stack
+			auto rb = std::make_unique<Buffer>();
+
+			const auto blockCount = _totalFrames / _blockSize;
+
+			const auto tStart = Clock::now();
+
+			std::thread consumer([&]
+			{
+				uint64_t sum = 0;
+
+				for(size_t b=0; b<blockCount; ++b)
+				{
+					if constexpr (Bulk)
+					{
+						rb->pop_front_n(_blockSize, [&](const Audio::RxFrame& _f, size_t)
+						{
+							sum += _f.size();
+						});
+					}
+					else
+					{
+						for(size_t i=0; i<_blockSize; ++i)
+						{
+							rb->pop_front([&](const Audio::RxFrame& _f)
+							{
+								sum += _f.size();
+							});
+						}
+					}
+				}
+
+				if(sum != blockCount * _blockSize * 2)
+					LOG("Audio benchmark received unexpected data");
+			});
+
+			for(size_t b=0; b<blockCount; ++b)
+			{
+				if constexpr (Bulk)
+				{
+					rb->emplace_back_n(_blockSize, [&](Audio::RxFrame& _f, size_t)
+					{
+						_f.resize(2);
+					});
+				}
+				else
+				{
+					for(size_t i=0; i<_blockSize; ++i)
+					{
+						rb->emplace_back([&](Audio::RxFrame& _f)
+						{
+							_f.resize(2);
+						});
+					}
+				}
+			}
+
+			consumer.join();
+
+			const auto us = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - tStart).count();
+
+			return static_cast<double>(blockCount * _blockSize) * 1000000.0 / static_cast<double>(us > 0 ? us : 1);
+		}
+	}
+
+	AudioBenchmark::Result AudioBenchmark::run(const size_t _blockSize, const size_t _totalFrames)
+	{
+		Result r;
+
+		if(!_blockSize || _blockSize > Audio::RingBufferSize)
+		{
+			LOG("Invalid block size " << _blockSize << ", must be between 1 and " << Audio::RingBufferSize);
+			return r;
+		}
+
+		r.perFrameFramesPerSecond = measure<false>(_blockSize, _totalFrames);
+		r.bulkFramesPerSecond = measure<true>(_blockSize, _totalFrames);
+
+		LOG("Audio ring buffer, block size " << _blockSize << ": per frame " << r.perFrameFramesPerSecond << " frames/s, bulk " << r.bulkFramesPerSecond << " frames/s, speedup " << (r.bulkFramesPerSecond / r.perFrameFramesPerSecond));
+
+		return r;
+	}
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace dsp56k
+{
+	// Measures the throughput of the Audio ring buffers when transferring host sized blocks between two threads, once
+	// with one synchronization per frame and once with one synchronization per block
+	class AudioBenchmark
+	{
+	public:
+		struct Result
+		{
+			double perFrameFramesPerSecond = 0.0;
+			double bulkFramesPerSecond = 0.0;
+		};
+
+		static Result run(size_t _blockSize = 512, size_t _totalFrames = 0x1000000);
+	};
+}
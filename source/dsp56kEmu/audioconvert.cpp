@@ -0,0 +1,528 @@
+#include "audioconvert.h"
+
+#include "audio.h"
+#include "buildconfig.h"
+
+#if defined(HAVE_SSE)
+#	include <immintrin.h>
+#endif
+
+#if defined(HAVE_X86_64)
+#	include "asmjit/core/cpuinfo.h"
+#endif
+
+#if defined(HAVE_ARM64)
+#	include <arm_neon.h>
+#endif
+
+#if defined(_MSC_VER)
+#	define DSP56K_TARGET_AVX2
+#else
+#	define DSP56K_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+namespace dsp56k
+{
+	namespace
+	{
+		constexpr TWord g_wordMask = 0x00ffffff;
+
+		// scalar
+
+		void toDspFloat(TWord* _dst, const void* _src, const size_t _count)
+		{
+			const auto* src = static_cast<const float*>(_src);
+			for(size_t i=0; i<_count; ++i)
+				_dst[i] = sample2dsp<float>(src[i]);
+		}
+
+		void toDspInt16(TWord* _dst, const void* _src, const size_t _count)
+		{
+			const auto* src = static_cast<const int16_t*>(_src);
+			for(size_t i=0; i<_count; ++i)
+				_dst[i] = (static_cast<TWord>(static_cast<int32_t>(src[i])) << 8) & g_wordMask;
+		}
+
+		void toDspInt24Packed(TWord* _dst, const void* _src, const size_t _count)
+		{
+			const auto* src = static_cast<const uint8_t*>(_src);
+			for(size_t i=0; i<_count; ++i, src += 3)
+				_dst[i] = static_cast<TWord>(src[0]) | (static_cast<TWord>(src[1]) << 8) | (static_cast<TWord>(src[2]) << 16);
+		}
+
+		void toDspInt32(TWord* _dst, const void* _src, const size_t _count)
+		{
+			const auto* src = static_cast<const uint32_t*>(_src);
+			for(size_t i=0; i<_count; ++i)
+				_dst[i] = src[i] >> 8;
+		}
+
+		void fromDspFloat(void* _dst, const TWord* _src, const size_t _count)
+		{
+			auto* dst = static_cast<float*>(_dst);
+			for(size_t i=0; i<_count; ++i)
+				dst[i] = dsp2sample<float>(_src[i]);
+		}
+
+		void fromDspInt16(void* _dst, const TWord* _src, const size_t _count)
+		{
+			auto* dst = static_cast<int16_t*>(_dst);
+			for(size_t i=0; i<_count; ++i)
+				dst[i] = static_cast<int16_t>(signextend<int32_t,24>(static_cast<int32_t>(_src[i])) >> 8);
+		}
+
+		void fromDspInt24Packed(void* _dst, const TWord* _src, const size_t _count)
+		{
+			auto* dst = static_cast<uint8_t*>(_dst);
+			for(size_t i=0; i<_count; ++i, dst += 3)
+			{
+				dst[0] = static_cast<uint8_t>(_src[i]);
+				dst[1] = static_cast<uint8_t>(_src[i] >> 8);
+				dst[2] = static_cast<uint8_t>(_src[i] >> 16);
+			}
+		}
+
+		void fromDspInt32(void* _dst, const TWord* _src, const size_t _count)
+		{
+			auto* dst = static_cast<uint32_t*>(_dst);
+			for(size_t i=0; i<_count; ++i)
+				dst[i] = _src[i] << 8;
+		}
+
+		const AudioConvert::Kernels g_kernelsScalar
+		{
+			"Scalar",
+			{toDspFloat, toDspInt16, toDspInt24Packed, toDspInt32},
+			{fromDspFloat, fromDspInt16, fromDspInt24Packed, fromDspInt32}
+		};
+
+		// the vector implementations process as many samples as possible and leave the rest to the scalar ones
+
+#if defined(HAVE_SSE)
+		void toDspFloatSse2(TWord* _dst, const void* _src, const size_t _count)
+		{
+			const auto* src = static_cast<const float*>(_src);
+
+			const auto scale = _mm_set1_ps(g_float2dspScale);
+			const auto lo = _mm_set1_ps(g_dspFloatMin);
+			const auto hi = _mm_set1_ps(g_dspFloatMax);
+			const auto mask = _mm_set1_epi32(g_wordMask);
+
+			size_t i = 0;
+			for(; i + 4 <= _count; i += 4)
+			{
+				auto v = _mm_mul_ps(_mm_loadu_ps(src + i), scale);
+				v = _mm_min_ps(_mm_max_ps(v, lo), hi);
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(_dst + i), _mm_and_si128(_mm_cvttps_epi32(v), mask));
+			}
+			toDspFloat(_dst + i, src + i, _count - i);
+		}
+
+		void toDspInt16Sse2(TWord* _dst, const void* _src, const size_t _count)
+		{
+			const auto* src = static_cast<const int16_t*>(_src);
+
+			const auto zero = _mm_setzero_si128();
+			const auto mask = _mm_set1_epi32(g_wordMask);
+
+			size_t i = 0;
+			for(; i + 8 <= _count; i += 8)
+			{
+				const auto v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+
+				// the sample ends up in the upper 16 bits, the arithmetic shift moves it to bits 8-23
+				const auto a = _mm_srai_epi32(_mm_unpacklo_epi16(zero, v), 8);
+				const auto b = _mm_srai_epi32(_mm_unpackhi_epi16(zero, v), 8);
+
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(_dst + i    ), _mm_and_si128(a, mask));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(_dst + i + 4), _mm_and_si128(b, mask));
+			}
+			toDspInt16(_dst + i, src + i, _count - i);
+		}
+
+		void toDspInt32Sse2(TWord* _dst, const void* _src, const size_t _count)
+		{
+			const auto* src = static_cast<const uint32_t*>(_src);
+
+			size_t i = 0;
+			for(; i + 4 <= _count; i += 4)
+			{
+				const auto v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(_dst + i), _mm_srli_epi32(v, 8));
+			}
+			toDspInt32(_dst + i, src + i, _count - i);
+		}
+
+		void fromDspFloatSse2(void* _dst, const TWord* _src, const size_t _count)
+		{
+			auto* dst = static_cast<float*>(_dst);
+
+			const auto scale = _mm_set1_ps(g_dsp2FloatScale);
+
+			size_t i = 0;
+			for(; i + 4 <= _count; i += 4)
+			{
+				auto v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(_src + i));
+				v = _mm_srai_epi32(_mm_slli_epi32(v, 8), 8);
+				_mm_storeu_ps(dst + i, _mm_mul_ps(_mm_cvtepi32_ps(v), scale));
+			}
+			fromDspFloat(dst + i, _src + i, _count - i);
+		}
+
+		void fromDspInt16Sse2(void* _dst, const TWord* _src, const size_t _count)
+		{
+			auto* dst = static_cast<int16_t*>(_dst);
+
+			size_t i = 0;
+			for(; i + 8 <= _count; i += 8)
+			{
+				auto a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(_src + i));
+				auto b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(_src + i + 4));
+
+				a = _mm_srai_epi32(_mm_slli_epi32(a, 8), 16);
+				b = _mm_srai_epi32(_mm_slli_epi32(b, 8), 16);
+
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_packs_epi32(a, b));
+			}
+			fromDspInt16(dst + i, _src + i, _count - i);
+		}
+
+		void fromDspInt32Sse2(void* _dst, const TWord* _src, const size_t _count)
+		{
+			auto* dst = static_cast<uint32_t*>(_dst);
+
+			size_t i = 0;
+			for(; i + 4 <= _count; i += 4)
+			{
+				const auto v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(_src + i));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_slli_epi32(v, 8));
+			}
+			fromDspInt32(dst + i, _src + i, _count - i);
+		}
+
+		// SSE2 has no byte shuffle, packed 24 bit data is converted by the scalar code
+		const AudioConvert::Kernels g_kernelsSse2
+		{
+			"SSE2",
+			{toDspFloatSse2, toDspInt16Sse2, toDspInt24Packed, toDspInt32Sse2},
+			{fromDspFloatSse2, fromDspInt16Sse2, fromDspInt24Packed, fromDspInt32Sse2}
+		};
+#endif
+
+#if defined(HAVE_X86_64)
+		DSP56K_TARGET_AVX2 void toDspFloatAvx2(TWord* _dst, const void* _src, const size_t _count)
+		{
+			const auto* src = static_cast<const float*>(_src);
+
+			const auto scale = _mm256_set1_ps(g_float2dspScale);
+			const auto lo = _mm256_set1_ps(g_dspFloatMin);
+			const auto hi = _mm256_set1_ps(g_dspFloatMax);
+			const auto mask = _mm256_set1_epi32(g_wordMask);
+
+			size_t i = 0;
+			for(; i + 8 <= _count; i += 8)
+			{
+				auto v = _mm256_mul_ps(_mm256_loadu_ps(src + i), scale);
+				v = _mm256_min_ps(_mm256_max_ps(v, lo), hi);
+				_mm256_storeu_si256(reinterpret_cast<__m256i*>(_dst + i), _mm256_and_si256(_mm256_cvttps_epi32(v), mask));
+			}
+			toDspFloatSse2(_dst + i, src + i, _count - i);
+		}
+
+		DSP56K_TARGET_AVX2 void toDspInt16Avx2(TWord* _dst, const void* _src, const size_t _count)
+		{
+			const auto* src = static_cast<const int16_t*>(_src);
+
+			const auto mask = _mm256_set1_epi32(g_wordMask);
+
+			size_t i = 0;
+			for(; i + 8 <= _count; i += 8)
+			{
+				const auto v = _mm256_cvtepi16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i)));
+				_mm256_storeu_si256(reinterpret_cast<__m256i*>(_dst + i), _mm256_and_si256(_mm256_slli_epi32(v, 8), mask));
+			}
+			toDspInt16(_dst + i, src + i, _count - i);
+		}
+
+		DSP56K_TARGET_AVX2 void toDspInt24PackedAvx2(TWord* _dst, const void* _src, const size_t _count)
+		{
+			const auto* src = static_cast<const uint8_t*>(_src);
+
+			const auto shuffle = _mm_setr_epi8(0,1,2,-1, 3,4,5,-1, 6,7,8,-1, 9,10,11,-1);
+
+			// four samples are converted per iteration but 16 bytes are read, stop early to not read past the end
+			size_t i = 0;
+			for(; i + 6 <= _count; i += 4)
+			{
+				const auto v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 3));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(_dst + i), _mm_shuffle_epi8(v, shuffle));
+			}
+			toDspInt24Packed(_dst + i, src + i * 3, _count - i);
+		}
+
+		DSP56K_TARGET_AVX2 void toDspInt32Avx2(TWord* _dst, const void* _src, const size_t _count)
+		{
+			const auto* src = static_cast<const uint32_t*>(_src);
+
+			size_t i = 0;
+			for(; i + 8 <= _count; i += 8)
+			{
+				const auto v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+				_mm256_storeu_si256(reinterpret_cast<__m256i*>(_dst + i), _mm256_srli_epi32(v, 8));
+			}
+			toDspInt32(_dst + i, src + i, _count - i);
+		}
+
+		DSP56K_TARGET_AVX2 void fromDspFloatAvx2(void* _dst, const TWord* _src, const size_t _count)
+		{
+			auto* dst = static_cast<float*>(_dst);
+
+			const auto scale = _mm256_set1_ps(g_dsp2FloatScale);
+
+			size_t i = 0;
+			for(; i + 8 <= _count; i += 8)
+			{
+				auto v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(_src + i));
+				v = _mm256_srai_epi32(_mm256_slli_epi32(v, 8), 8);
+				_mm256_storeu_ps(dst + i, _mm256_mul_ps(_mm256_cvtepi32_ps(v), scale));
+			}
+			fromDspFloatSse2(dst + i, _src + i, _count - i);
+		}
+
+		DSP56K_TARGET_AVX2 void fromDspInt16Avx2(void* _dst, const TWord* _src, const size_t _count)
+		{
+			auto* dst = static_cast<int16_t*>(_dst);
+
+			size_t i = 0;
+			for(; i + 8 <= _count; i += 8)
+			{
+				auto v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(_src + i));
+				v = _mm256_srai_epi32(_mm256_slli_epi32(v, 8), 16);
+
+				// the 256 bit pack instruction operates per lane, pack the two halves instead
+				const auto packed = _mm_packs_epi32(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), packed);
+			}
+			fromDspInt16(dst + i, _src + i, _count - i);
+		}
+
+		DSP56K_TARGET_AVX2 void fromDspInt24PackedAvx2(void* _dst, const TWord* _src, const size_t _count)
+		{
+			auto* dst = static_cast<uint8_t*>(_dst);
+
+			const auto shuffle = _mm_setr_epi8(0,1,2, 4,5,6, 8,9,10, 12,13,14, -1,-1,-1,-1);
+
+			// 16 bytes are written per iteration but only 12 are valid. The surplus is overwritten by the next iteration
+			size_t i = 0;
+			for(; i + 6 <= _count; i += 4)
+			{
+				const auto v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(_src + i));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 3), _mm_shuffle_epi8(v, shuffle));
+			}
+			fromDspInt24Packed(dst + i * 3, _src + i, _count - i);
+		}
+
+		DSP56K_TARGET_AVX2 void fromDspInt32Avx2(void* _dst, const TWord* _src, const size_t _count)
+		{
+			auto* dst = static_cast<uint32_t*>(_dst);
+
+			size_t i = 0;
+			for(; i + 8 <= _count; i += 8)
+			{
+				const auto v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(_src + i));
+				_mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), _mm256_slli_epi32(v, 8));
+			}
+			fromDspInt32(dst + i, _src + i, _count - i);
+		}
+
+		const AudioConvert::Kernels g_kernelsAvx2
+		{
+			"AVX2",
+			{toDspFloatAvx2, toDspInt16Avx2, toDspInt24PackedAvx2, toDspInt32Avx2},
+			{fromDspFloatAvx2, fromDspInt16Avx2, fromDspInt24PackedAvx2, fromDspInt32Avx2}
+		};
+#endif
+
+#if defined(HAVE_ARM64)
+		void toDspFloatNeon(TWord* _dst, const void* _src, const size_t _count)
+		{
+			const auto* src = static_cast<const float*>(_src);
+
+			const auto scale = vdupq_n_f32(g_float2dspScale);
+			const auto lo = vdupq_n_f32(g_dspFloatMin);
+			const auto hi = vdupq_n_f32(g_dspFloatMax);
+			const auto mask = vdupq_n_u32(g_wordMask);
+
+			size_t i = 0;
+			for(; i + 4 <= _count; i += 4)
+			{
+				auto v = vmulq_f32(vld1q_f32(src + i), scale);
+				v = vminq_f32(vmaxq_f32(v, lo), hi);
+				vst1q_u32(_dst + i, vandq_u32(vreinterpretq_u32_s32(vcvtq_s32_f32(v)), mask));
+			}
+			toDspFloat(_dst + i, src + i, _count - i);
+		}
+
+		void toDspInt16Neon(TWord* _dst, const void* _src, const size_t _count)
+		{
+			const auto* src = static_cast<const int16_t*>(_src);
+
+			const auto mask = vdupq_n_u32(g_wordMask);
+
+			size_t i = 0;
+			for(; i + 8 <= _count; i += 8)
+			{
+				const auto v = vld1q_s16(src + i);
+
+				const auto a = vshlq_n_s32(vmovl_s16(vget_low_s16(v)), 8);
+				const auto b = vshlq_n_s32(vmovl_s16(vget_high_s16(v)), 8);
+
+				vst1q_u32(_dst + i    , vandq_u32(vreinterpretq_u32_s32(a), mask));
+				vst1q_u32(_dst + i + 4, vandq_u32(vreinterpretq_u32_s32(b), mask));
+			}
+			toDspInt16(_dst + i, src + i, _count - i);
+		}
+
+		void toDspInt24PackedNeon(TWord* _dst, const void* _src, const size_t _count)
+		{
+			const auto* src = static_cast<const uint8_t*>(_src);
+
+			size_t i = 0;
+			for(; i + 16 <= _count; i += 16)
+			{
+				// deinterleave the three bytes of each sample and interleave them again with a zero as fourth byte
+				const auto v = vld3q_u8(src + i * 3);
+
+				uint8x16x4_t w;
+				w.val[0] = v.val[0];
+				w.val[1] = v.val[1];
+				w.val[2] = v.val[2];
+				w.val[3] = vdupq_n_u8(0);
+
+				vst4q_u8(reinterpret_cast<uint8_t*>(_dst + i), w);
+			}
+			toDspInt24Packed(_dst + i, src + i * 3, _count - i);
+		}
+
+		void toDspInt32Neon(TWord* _dst, const void* _src, const size_t _count)
+		{
+			const auto* src = static_cast<const uint32_t*>(_src);
+
+			size_t i = 0;
+			for(; i + 4 <= _count; i += 4)
+				vst1q_u32(_dst + i, vshrq_n_u32(vld1q_u32(src + i), 8));
+			toDspInt32(_dst + i, src + i, _count - i);
+		}
+
+		void fromDspFloatNeon(void* _dst, const TWord* _src, const size_t _count)
+		{
+			auto* dst = static_cast<float*>(_dst);
+
+			const auto scale = vdupq_n_f32(g_dsp2FloatScale);
+
+			size_t i = 0;
+			for(; i + 4 <= _count; i += 4)
+			{
+				auto v = vreinterpretq_s32_u32(vld1q_u32(_src + i));
+				v = vshrq_n_s32(vshlq_n_s32(v, 8), 8);
+				vst1q_f32(dst + i, vmulq_f32(vcvtq_f32_s32(v), scale));
+			}
+			fromDspFloat(dst + i, _src + i, _count - i);
+		}
+
+		void fromDspInt16Neon(void* _dst, const TWord* _src, const size_t _count)
+		{
+			auto* dst = static_cast<int16_t*>(_dst);
+
+			size_t i = 0;
+			for(; i + 8 <= _count; i += 8)
+			{
+				const auto a = vshrq_n_s32(vshlq_n_s32(vreinterpretq_s32_u32(vld1q_u32(_src + i    )), 8), 16);
+				const auto b = vshrq_n_s32(vshlq_n_s32(vreinterpretq_s32_u32(vld1q_u32(_src + i + 4)), 8), 16);
+
+				vst1q_s16(dst + i, vcombine_s16(vmovn_s32(a), vmovn_s32(b)));
+			}
+			fromDspInt16(dst + i, _src + i, _count - i);
+		}
+
+		void fromDspInt24PackedNeon(void* _dst, const TWord* _src, const size_t _count)
+		{
+			auto* dst = static_cast<uint8_t*>(_dst);
+
+			size_t i = 0;
+			for(; i + 16 <= _count; i += 16)
+			{
+				const auto v = vld4q_u8(reinterpret_cast<const uint8_t*>(_src + i));
+
+				uint8x16x3_t w;
+				w.val[0] = v.val[0];
+				w.val[1] = v.val[1];
+				w.val[2] = v.val[2];
+
+				vst3q_u8(dst + i * 3, w);
+			}
+			fromDspInt24Packed(dst + i * 3, _src + i, _count - i);
+		}
+
+		void fromDspInt32Neon(void* _dst, const TWord* _src, const size_t _count)
+		{
+			auto* dst = static_cast<uint32_t*>(_dst);
+
+			size_t i = 0;
+			for(; i + 4 <= _count; i += 4)
+				vst1q_u32(dst + i, vshlq_n_u32(vld1q_u32(_src + i), 8));
+			fromDspInt32(dst + i, _src + i, _count - i);
+		}
+
+		const AudioConvert::Kernels g_kernelsNeon
+		{
+			"NEON",
+			{toDspFloatNeon, toDspInt16Neon, toDspInt24PackedNeon, toDspInt32Neon},
+			{fromDspFloatNeon, fromDspInt16Neon, fromDspInt24PackedNeon, fromDspInt32Neon}
+		};
+#endif
+
+		const AudioConvert::Kernels& selectKernels()
+		{
+#if defined(HAVE_X86_64)
+			if(asmjit::CpuInfo::host().hasFeature(asmjit::CpuFeatures::X86::kAVX2))
+				return g_kernelsAvx2;
+#endif
+#if defined(HAVE_SSE)
+			return g_kernelsSse2;
+#elif defined(HAVE_ARM64)
+			return g_kernelsNeon;
+#else
+			return g_kernelsScalar;
+#endif
+		}
+	}
+
+	const AudioConvert::Kernels& AudioConvert::getKernels()
+	{
+		static const Kernels& kernels = selectKernels();
+		return kernels;
+	}
+
+	const AudioConvert::Kernels& AudioConvert::getScalarKernels()
+	{
+		return g_kernelsScalar;
+	}
+
+	std::vector<const AudioConvert::Kernels*> AudioConvert::getSupportedKernels()
+	{
+		std::vector<const Kernels*> kernels{&g_kernelsScalar};
+
+#if defined(HAVE_SSE)
+		kernels.push_back(&g_kernelsSse2);
+#endif
+#if defined(HAVE_X86_64)
+		if(asmjit::CpuInfo::host().hasFeature(asmjit::CpuFeatures::X86::kAVX2))
+			kernels.push_back(&g_kernelsAvx2);
+#endif
+#if defined(HAVE_ARM64)
+		kernels.push_back(&g_kernelsNeon);
+#endif
+		return kernels;
+	}
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "types.h"
+
+namespace dsp56k
+{
+	enum class SampleFormat
+	{
+		Float32,		// -1.0 .. 1.0
+		Int16,
+		Int24Packed,	// three bytes per sample, little endian
+		Int32,			// 24 bit data in the upper bits
+
+		Count
+	};
+
+	constexpr size_t getSampleSize(const SampleFormat _format)
+	{
+		switch (_format)
+		{
+		case SampleFormat::Int16:		return 2;
+		case SampleFormat::Int24Packed:	return 3;
+		default:						return 4;
+		}
+	}
+
+	// Converts contiguous blocks of host samples to DSP words and back. The implementation is selected at runtime
+	// depending on the host CPU (AVX2, SSE2, NEON or scalar). Float conversion matches sample2dsp<float> and dsp2sample<float>
+	class AudioConvert
+	{
+	public:
+		using FuncToDsp = void(*)(TWord* _dst, const void* _src, size_t _count);
+		using FuncFromDsp = void(*)(void* _dst, const TWord* _src, size_t _count);
+
+		struct Kernels
+		{
+			const char* name;
+			FuncToDsp toDsp[static_cast<size_t>(SampleFormat::Count)];
+			FuncFromDsp fromDsp[static_cast<size_t>(SampleFormat::Count)];
+		};
+
+		static void toDsp(TWord* _dst, const void* _src, const SampleFormat _format, const size_t _count)
+		{
+			getKernels().toDsp[static_cast<size_t>(_format)](_dst, _src, _count);
+		}
+
+		static void fromDsp(void* _dst, const TWord* _src, const SampleFormat _format, const size_t _count)
+		{
+			getKernels().fromDsp[static_cast<size_t>(_format)](_dst, _src, _count);
+		}
+
+		static const Kernels& getKernels();
+		static const Kernels& getScalarKernels();
+
+		// all implementations that can run on the host CPU
+		static std::vector<const Kernels*> getSupportedKernels();
+	};
+}
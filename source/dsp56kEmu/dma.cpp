@@ -5,6 +5,7 @@
 #include "dsp.h"
 #include "logging.h"
 #include "peripherals.h"
+#include "savestate.h"
 #include "utils.h"
 
 #include <cstring> // memcpy
@@ -335,10 +336,22 @@ namespace dsp56k
 			}
 		};
 
-		if(_dstArea == MemArea_P || isPeripheralAddr(_dstArea, _dstAddr, _count) || isPeripheralAddr(_srcArea, _srcAddr, _count))
+		if(isPeripheralAddr(_dstArea, _dstAddr, _count) || isPeripheralAddr(_srcArea, _srcAddr, _count))
 		{
 			copyIndividual();
 		}
+		else if(_dstArea == MemArea_P)
+		{
+			if(bridgedOverlap(_srcArea, _srcAddr, _count))
+			{
+				copyIndividual();
+			}
+			else
+			{
+				// the DSP invalidates decoded ops and JIT blocks once for the whole range. Words are copied in ascending order, same as copyIndividual, so overlapping ranges behave identical
+				m_peripherals.getDSP().memWriteP(_dstAddr, getMemPtr(_srcArea, _srcAddr), _count);
+			}
+		}
 		else
 		{
 //			auto& dsp = m_peripherals.getDSP();
@@ -794,4 +807,76 @@ namespace dsp56k
 		if (it != channels.end())
 			channels.erase(it);
 	}
+
+	void DmaChannel::saveState(StateWriter& _w) const
+	{
+		_w.write(m_dsr);
+		_w.write(m_ddr);
+		_w.write(m_dco);
+		_w.write(m_dcr);
+		_w.write(m_dcoh);
+		_w.write(m_dcom);
+		_w.write(m_dcol);
+		_w.write(m_dcohInit);
+		_w.write(m_dcomInit);
+		_w.write(m_dcolInit);
+		_w.write(m_pendingTransfer);
+		_w.write(m_lastClock);
+	}
+
+	bool DmaChannel::loadState(StateReader& _r)
+	{
+		return _r.read(m_dsr) && _r.read(m_ddr) && _r.read(m_dco) && _r.read(m_dcr)
+			&& _r.read(m_dcoh) && _r.read(m_dcom) && _r.read(m_dcol)
+			&& _r.read(m_dcohInit) && _r.read(m_dcomInit) && _r.read(m_dcolInit)
+			&& _r.read(m_pendingTransfer) && _r.read(m_lastClock);
+	}
+
+	void Dma::saveState(StateWriter& _w) const
+	{
+		_w.write(m_dstr);
+		_w.write(m_dor);
+
+		for (const auto& c : m_channels)
+			c.saveState(_w);
+
+		// channels are triggered in the order in which they have been enabled, store them as indices
+		for (const auto& channels : m_requestTargets)
+		{
+			_w.write(static_cast<uint32_t>(channels.size()));
+
+			for (const auto* c : channels)
+				_w.write(static_cast<uint32_t>(c - m_channels.data()));
+		}
+	}
+
+	bool Dma::loadState(StateReader& _r)
+	{
+		if(!_r.read(m_dstr) || !_r.read(m_dor))
+			return false;
+
+		for (auto& c : m_channels)
+		{
+			if(!c.loadState(_r))
+				return false;
+		}
+
+		for (auto& channels : m_requestTargets)
+		{
+			channels.clear();
+
+			uint32_t count;
+			if(!_r.read(count))
+				return false;
+
+			for(uint32_t i=0; i<count; ++i)
+			{
+				uint32_t index;
+				if(!_r.read(index) || index >= m_channels.size())
+					return false;
+				channels.push_back(&m_channels[index]);
+			}
+		}
+		return true;
+	}
 }
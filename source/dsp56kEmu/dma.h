@@ -9,6 +9,8 @@ namespace dsp56k
 {
 	class Dma;
 	class IPeripherals;
+	class StateReader;
+	class StateWriter;
 
 	class DmaChannel
 	{
@@ -136,6 +138,9 @@ namespace dsp56k
 
 		void extractDCOHML(TWord& _h, TWord& _m, TWord& _l) const;
 
+		void saveState(StateWriter& _w) const;
+		bool loadState(StateReader& _r);
+
 	private:
 		void memCopy(EMemArea _dstArea, TWord _dstAddr, EMemArea _srcArea, TWord _srcAddr, TWord _count) const;
 		void memFill(EMemArea _dstArea, TWord _dstAddr, EMemArea _srcArea, TWord _srcAddr, TWord _count) const;
@@ -215,6 +220,9 @@ namespace dsp56k
 		void addTriggerTarget(DmaChannel* _channel);
 		void removeTriggerTarget(const DmaChannel* _channel);
 
+		void saveState(StateWriter& _w) const;
+		bool loadState(StateReader& _r);
+
 	private:
 		TWord m_dstr;
 		std::array<DmaChannel, 6> m_channels;
@@ -13,6 +13,9 @@
 #include "debuggerinterface.h"
 #include "dspconfig.h"
 #include "interrupts.h"
+#include "opcodeanalysis.h"
+#include "peripherals.h"
+#include "savestate.h"
 
 #include "dsp_decode.inl"
 
@@ -38,6 +41,9 @@ namespace dsp56k
 {
 	constexpr bool g_traceSupported = false;
 
+	constexpr uint32_t g_stateMagic = 0x53363544;	// "D56S"
+	constexpr uint32_t g_stateVersion = 1;
+
 	Jumptable g_jumptable;
 
 	void dspExecDefaultPreventInterrupt(DSP* _dsp) noexcept
@@ -83,6 +89,7 @@ namespace dsp56k
 		, m_execPeripheralsFunc(findExecPeripheralsFunc(_pX, _pY))
 		, m_jit(*this)
 		, m_interruptFunc(m_execPeripheralsFunc)
+		, m_opcodeCache({&DSP::op_ResolveCache, nullptr, nullptr, 0, 0})
 		, m_disasm(m_opcodes)
 	{
 		assert(_pX != _pY && "cannot use the same peripherals twice");
@@ -199,10 +206,11 @@ namespace dsp56k
 			m_debugger->onExec(vba);
 #endif
 
-		if(g_useJIT)
+		if(useJIT())
 		{
 			LOGJITPC(vba);
 			const auto pc = getPC();
+			updateDirtyJitCCR();
 			m_jitEntries[vba](&m_jit, vba);
 //			m_jit.exec(vba);
 			if(m_processingMode != LongInterrupt)
@@ -341,6 +349,32 @@ namespace dsp56k
 		}
 	}
 
+	void DSP::execCachedOp()
+	{
+		const auto& opCache = m_opcodeCache[pcCurrentInstruction];
+
+		// the first execution of an address decodes the opcode, tracing needs the regular path for the disassembly
+		if(opCache.op == &DSP::op_ResolveCache || (g_traceSupported && m_trace))
+		{
+			const auto op = fetchPC();
+			execOp(op);
+			return;
+		}
+
+		// dispatch directly from the decoded entry without reading P memory again
+		m_opWordB = opCache.opB;
+		++reg.pc.var;
+
+		m_currentOpLen = 1;
+
+		const TWord currentOp = pcCurrentInstruction;
+
+		exec_jump(opCache.op, opCache.opA);
+
+		if(pcCurrentInstruction == currentOp)
+			++m_instructions;
+	}
+
 	void DSP::exec_jump(const TInstructionFunc& _func, TWord _op)
 	{
 		(this->*_func)(_op);
@@ -422,6 +456,8 @@ namespace dsp56k
 
 	void DSP::updateDirtyCCR() const
 	{
+		updateDirtyJitCCR();
+
 		if(!ccrCache.dirty)
 			return;
 
@@ -435,6 +471,31 @@ namespace dsp56k
 		dsp.sr_n_update(ccrCache.alu);
 	}
 
+	void DSP::updateDirtyJitCCR(const uint32_t _overwritten) const
+	{
+		auto& rt = const_cast<Jit&>(m_jit).getRuntimeData();
+
+		if(!rt.m_ccrPendingMask)
+			return;
+
+		// bits that are overwritten by the next JIT block before it reads them are never computed
+		const auto dirty = rt.m_ccrPendingMask & ~_overwritten;
+
+		rt.m_ccrPendingMask = 0;
+
+		if(!dirty)
+			return;
+
+		auto& dsp = const_cast<DSP&>(*this);
+
+		const TReg56 alu(static_cast<TReg56::MyType>(rt.m_ccrPendingAlu & 0x00ffffffffffffffull));
+
+		if(dirty & CCR_Z)	dsp.sr_z_update(alu);
+		if(dirty & CCR_N)	dsp.sr_n_update(alu);
+		if(dirty & CCR_E)	dsp.sr_e_update(alu);
+		if(dirty & CCR_U)	dsp.sr_u_update(alu);
+	}
+
 	void DSP::sr_debug(char* _dst) const
 	{
 		_dst[8] = 0;
@@ -1021,6 +1082,51 @@ namespace dsp56k
 		return res;
 	}
 
+	bool DSP::memWriteP(const TWord _offset, const TWord* _values, const TWord _count)
+	{
+		// invalidate contiguous ranges of modified words at once instead of every word individually
+		TWord first = 0;
+		TWord count = 0;
+
+		auto flush = [&]()
+		{
+			if(!count)
+				return;
+			notifyProgramMemWrite(first, count);
+			m_jit.notifyProgramMemWrite(first, count);
+			count = 0;
+		};
+
+		bool res = true;
+
+		for(TWord i=0; i<_count; ++i)
+		{
+			auto offset = _offset + i;
+			aarTranslate(MemArea_P, offset);
+
+			const auto oldValue = mem.get(MemArea_P, offset);
+
+			res &= mem.set(MemArea_P, offset, _values[i]);
+
+			if(offset >= m_opcodeCache.size() || oldValue == _values[i])
+				continue;
+
+			if(count && offset == first + count)
+			{
+				++count;
+				continue;
+			}
+
+			flush();
+			first = offset;
+			count = 1;
+		}
+
+		flush();
+
+		return res;
+	}
+
 	bool DSP::memWritePeriph( EMemArea _area, TWord _offset, TWord _value )
 	{
 		perif[_area - MemArea_X]->write(_offset | 0xff0000, _value );
@@ -1037,7 +1143,8 @@ namespace dsp56k
 
 	void DSP::notifyProgramMemWrite(TWord _offset)
 	{
-		m_opcodeCache[_offset].op = &DSP::op_ResolveCache;
+		// the entry of the previous address caches this word if it is the extension word of a two-word opcode
+		m_opcodeCache.invalidate(_offset ? _offset - 1 : 0, _offset ? 2 : 1);
 
 #if DSP56300_DEBUGGER
 		if(m_debugger)
@@ -1045,6 +1152,22 @@ namespace dsp56k
 #endif
 	}
 
+	void DSP::notifyProgramMemWrite(const TWord _first, const TWord _count)
+	{
+		if(_first)
+			m_opcodeCache.invalidate(_first - 1, _count + 1);
+		else
+			m_opcodeCache.invalidate(_first, _count);
+
+#if DSP56300_DEBUGGER
+		if(m_debugger)
+		{
+			for(TWord i=0; i<_count; ++i)
+				m_debugger->onProgramMemWrite(_first + i);
+		}
+#endif
+	}
+
 	// _____________________________________________________________________________
 	// memRead
 	//
@@ -1283,15 +1406,173 @@ namespace dsp56k
 
 	void DSP::clearOpcodeCache()
 	{
-		m_opcodeCache.clear();
-		m_opcodeCache.resize(mem.sizeP(), {&DSP::op_ResolveCache});
+		// pages are allocated once the interpreter executes code in them
+		m_opcodeCache.reset(mem.sizeP());
 	}
 
 	void DSP::clearOpcodeCache(const TWord _address)
 	{
-		m_opcodeCache[_address].op = &DSP::op_ResolveCache;
+		notifyProgramMemWrite(_address);
 		m_jit.notifyProgramMemWrite(_address);
 	}
+
+	void DSP::clearOpcodeCache(const TWord _first, const TWord _count)
+	{
+		if(_first >= m_opcodeCache.size())
+			return;
+
+		const auto count = std::min(_count, static_cast<TWord>(m_opcodeCache.size()) - _first);
+
+		notifyProgramMemWrite(_first, count);
+		m_jit.notifyProgramMemWrite(_first, count);
+	}
+
+	void DSP::saveState(StateWriter& _w) const
+	{
+		updateDirtyJitCCR();
+
+		_w.write(g_stateMagic);
+		_w.write(g_stateVersion);
+
+		_w.write(perif[0]->getType());
+		_w.write(perif[1]->getType());
+
+		_w.write(reg);
+		_w.write(ccrCache);
+		_w.write(m_instructions);
+		_w.write(m_cycles);
+		_w.write(m_processingMode);
+		_w.write(pcCurrentInstruction);
+		_w.write(m_opWordB);
+		_w.write(m_currentOpLen);
+
+		_w.write(m_pendingInterrupts);
+		_w.write(m_pendingExternalInterrupts);
+
+		mem.saveState(_w);
+
+		perif[0]->saveState(_w);
+		perif[1]->saveState(_w);
+	}
+
+	bool DSP::loadState(StateReader& _r)
+	{
+		// memory and peripherals are restored in place, a state that turns out to be invalid halfway through must not leave
+		// the DSP partially restored. The previous state is restored in that case
+		StateWriter backup;
+		saveState(backup);
+
+		if(loadStateImpl(_r))
+			return true;
+
+		StateReader r(backup.getData());
+		const auto restored = loadStateImpl(r);
+		assert(restored && "failed to restore the previous DSP state");
+		(void)restored;
+
+		return false;
+	}
+
+	bool DSP::loadStateImpl(StateReader& _r)
+	{
+		uint32_t magic, version;
+
+		if(!_r.read(magic) || !_r.read(version) || magic != g_stateMagic || version != g_stateVersion)
+		{
+			LOG("Failed to load DSP state, invalid header");
+			return false;
+		}
+
+		PeripheralType typeX, typeY;
+
+		if(!_r.read(typeX) || !_r.read(typeY) || typeX != perif[0]->getType() || typeY != perif[1]->getType())
+		{
+			LOG("Failed to load DSP state, it has been created for different peripherals");
+			return false;
+		}
+
+		if(!_r.read(reg) || !_r.read(ccrCache) || !_r.read(m_instructions) || !_r.read(m_cycles) || !_r.read(m_processingMode) ||
+			!_r.read(pcCurrentInstruction) || !_r.read(m_opWordB) || !_r.read(m_currentOpLen) ||
+			!_r.read(m_pendingInterrupts) || !_r.read(m_pendingExternalInterrupts))
+		{
+			LOG("Failed to load DSP state, unexpected end of data");
+			return false;
+		}
+
+		m_jit.getRuntimeData().m_ccrPendingMask = 0;
+
+		if(!mem.loadState(_r))
+		{
+			LOG("Failed to load DSP state, memory layout differs");
+			return false;
+		}
+
+		if(!perif[0]->loadState(_r) || !perif[1]->loadState(_r) || !_r.atEnd())
+		{
+			LOG("Failed to load DSP state, invalid peripheral state");
+			return false;
+		}
+
+		// the interrupt function is a host pointer, derive it from the processing mode
+		switch (m_processingMode)
+		{
+		case DefaultPreventInterrupt:
+			m_interruptFunc = &dspExecDefaultPreventInterrupt;
+			break;
+		case LongInterrupt:
+			m_interruptFunc = &dspExecNop;
+			break;
+		default:
+			m_processingMode = Default;
+			m_interruptFunc = m_pendingInterrupts.empty() ? m_execPeripheralsFunc : &dspExecInterrupts;
+			break;
+		}
+
+		m_jit.checkModeChange();
+		m_jit.restoreLoops(getActiveLoops());
+
+		return true;
+	}
+
+	std::vector<std::pair<TWord, TWord>> DSP::getActiveLoops() const
+	{
+		std::vector<std::pair<TWord, TWord>> loops;
+
+		if(!sr_test_noCache(SR_LF))
+			return loops;
+
+		// DO pushes LA/LC followed by the PC of the loop body and SR. Subroutine calls inside of the loop body might have pushed
+		// other entries, a loop entry is identified by the DO instruction in front of the loop body that ends at LA
+		auto end = reg.la.var + 1;
+
+		for(TWord i=ssIndex(); i>0; --i)
+		{
+			const auto body = hiword(reg.ss[i]).var;
+
+			if(body < 2)
+				continue;
+
+			TWord opA, opB;
+			mem.getOpcode(body - 2, opA, opB);
+
+			const auto* oi = m_opcodes.findNonParallelOpcodeInfo(opA);
+
+			TWord loopEnd;
+			if(!oi || !getLoopEndAddr(loopEnd, oi->getInstruction(), body - 2, opB) || loopEnd != end)
+				continue;
+
+			loops.emplace_back(body - 2, end);
+
+			// the pushed SR tells if an outer loop is active, its LA is stored in the entry below
+			if(!(loword(reg.ss[i]).var & SR_LF) || i < 2)
+				break;
+
+			--i;
+			end = hiword(reg.ss[i]).var + 1;
+		}
+
+		return loops;
+	}
 	
 	TInstructionFunc DSP::resolvePermutation(const Instruction _inst, const TWord _op)
 	{
@@ -1467,10 +1748,15 @@ aar0=$000008 aar1=$000000 aar2=$000000 aar3=$000000
 
 	void DSP::op_Wait(const TWord)
 	{
+		// The core is idle until an interrupt arrives. The peripherals know when their next event is due (frame sync,
+		// timers, DMA, HDI08 rate limits), skip the idle time by advancing the counters directly to it
 		while(m_pendingInterrupts.empty())
 		{
-			m_instructions += PeripheralsProcessingStepSize;
-			m_cycles += PeripheralsProcessingStepSize;
+			const auto target = perif[0]->getTargetClock();
+			const auto delta = target > m_instructions ? target - m_instructions : 1;
+
+			m_instructions += delta;
+			m_cycles += delta;
 
 			m_execPeripheralsFunc(this);
 		}
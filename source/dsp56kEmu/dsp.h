@@ -6,6 +6,7 @@
 #include "memory.h"
 #include "utils.h"
 #include "instructioncache.h"
+#include "opcodecache.h"
 #include "opcodes.h"
 #include "jit.h"
 #include "jittypes.h"
@@ -27,6 +28,8 @@ namespace dsp56k
 	class AotRuntime;
 	class DebuggerInterface;
 	class DSP;
+	class StateReader;
+	class StateWriter;
 	
 	using TInstructionFunc = void (DSP::*)(TWord _op);
 	
@@ -166,9 +169,11 @@ namespace dsp56k
 			TInstructionFunc op;
 			TInstructionFunc opMove;
 			TInstructionFunc opAlu;
+			TWord opA;			// opcode words, valid once op is no longer op_ResolveCache
+			TWord opB;
 		};
 
-		std::vector<OpcodeCacheEntry>	m_opcodeCache;
+		OpcodeCache<OpcodeCacheEntry>	m_opcodeCache;
 		
 		InstructionCache				cache;
 
@@ -199,6 +204,8 @@ namespace dsp56k
 
 		DebuggerInterface*	m_debugger = nullptr;
 
+		bool				m_useInterpreter = false;
+
 		// _____________________________________________________________________________
 		// implementation
 		//
@@ -218,7 +225,7 @@ namespace dsp56k
 
 		ASMJIT_FORCE_INLINE void exec() noexcept
 		{
-			if(g_useJIT)
+			if(useJIT())
 			{
 #if 0
 				if(m_processingMode == Default)
@@ -242,6 +249,8 @@ namespace dsp56k
 #endif
 				const auto pc = getPC().toWord();
 				LOGJITPC(pc);
+				if(m_jit.getRuntimeData().m_ccrPendingMask)
+					updateDirtyJitCCR(m_jit.getCCROverwrite(pc));
 				m_jitEntries[pc](&m_jit, pc);
 //				m_jit.exec(pc);
 			}
@@ -270,9 +279,7 @@ namespace dsp56k
 
 				pcCurrentInstruction = reg.pc.toWord();
 
-				const auto op = fetchPC();
-
-				execOp(op);
+				execCachedOp();
 			}			
 		}
 
@@ -360,6 +367,15 @@ namespace dsp56k
 
 		void			clearOpcodeCache				();
 		void			clearOpcodeCache				(TWord _address);
+		void			clearOpcodeCache				(TWord _first, TWord _count);
+
+		// Serializes registers, counters, pending interrupts, memory and peripherals. Host audio buffers are not included.
+		// Must be called from the DSP thread or while it is halted, same for loadState
+		void			saveState						(StateWriter& _w) const;
+
+		// Restores a state created by saveState of a DSP with the same memory and peripheral configuration. JIT blocks of
+		// unmodified P memory stay valid. If false is returned, the DSP keeps its previous state
+		bool			loadState						(StateReader& _r);
 
 		void			dumpRegisters					() const;
 		void			dumpRegisters					(std::stringstream& _ss) const;
@@ -377,6 +393,7 @@ namespace dsp56k
 		void			setPeriph						(const size_t _index, IPeripherals* _periph);
 		const IPeripherals*	getPeriph					(const size_t _index) const						{ return perif[_index]; }
 		IPeripherals*	getPeriph						(const size_t _index)							{ return perif[_index]; }
+		IPeripherals* const&	getPeriphRef			(const size_t _index) const						{ return perif[_index]; }
 		IPeripherals*	getPeriph						(const EMemArea _area)
 		{
 			switch (_area)
@@ -402,6 +419,10 @@ namespace dsp56k
 		void				setDebugger						(DebuggerInterface* _debugger);
 		DebuggerInterface*	getDebugger						()								{ return m_debugger; }
 
+		// runs the interpreter even if the JIT is supported, used to compare both or to measure the interpreter
+		void			setUseInterpreter				(const bool _interpreter)	{ updateDirtyJitCCR(); m_useInterpreter = _interpreter; }
+		bool			useJIT							() const					{ return g_useJIT && !m_useInterpreter; }
+
 		bool			isPeripheralAddress(const TWord _addr) const
 		{
 			if(sr_test(SR_SC))
@@ -437,6 +458,7 @@ namespace dsp56k
 		}
 
 		void 	execOp							(TWord op);
+		void	execCachedOp					();
 
 		void	exec_jump						(const TInstructionFunc& _func, TWord _op);
 		
@@ -620,7 +642,7 @@ namespace dsp56k
 
 		void setSR(const TReg24& _sr)
 		{
-			ccrCache.dirty = 0;
+			resetCCRCache();
 			reg.sr = _sr;
 		}
 
@@ -639,7 +661,8 @@ namespace dsp56k
 
 		void setCCRDirty(bool ab, const TReg56& _alu, uint32_t _dirtyBitsMask);
 		void updateDirtyCCR() const;
-		void resetCCRCache() { ccrCache.dirty = 0; }
+		void updateDirtyJitCCR(uint32_t _overwritten = 0) const;
+		void resetCCRCache() { ccrCache.dirty = 0; m_jit.getRuntimeData().m_ccrPendingMask = 0; }
 
 		void sr_debug(char* _dst) const;
 
@@ -852,13 +875,18 @@ namespace dsp56k
 
 	public:
 		bool	memWriteP			( TWord _offset, TWord _value );
+		bool	memWriteP			( TWord _offset, const TWord* _values, TWord _count );
 		bool	memWrite			( EMemArea _area, TWord _offset, TWord _value );
 		bool	memWritePeriph		( EMemArea _area, TWord _offset, TWord _value );
 		bool	memWritePeriphFFFF80( EMemArea _area, TWord _offset, TWord _value );
 		bool	memWritePeriphFFFFC0( EMemArea _area, TWord _offset, TWord _value );
 
 	private:
+		bool	loadStateImpl		(StateReader& _r);
+		std::vector<std::pair<TWord, TWord>> getActiveLoops() const;
+
 		void	notifyProgramMemWrite(TWord _offset);
+		void	notifyProgramMemWrite(TWord _first, TWord _count);
 		
 		TWord	memRead				( EMemArea _area, TWord _offset ) const;
 		void	memReadOpcode		( TWord _offset, TWord& _wordA, TWord& _wordB ) const;
@@ -508,6 +508,9 @@ namespace dsp56k
 		auto& cacheEntry = m_opcodeCache[pcCurrentInstruction];
 		cacheEntry.op = &DSP::op_Nop;
 
+		// the words are read from memory as the caller might pass a different extension word, i.e. when executing fast interrupts
+		memReadOpcode(pcCurrentInstruction, cacheEntry.opA, cacheEntry.opB);
+
 		if( !op )
 		{
 			op_Nop(0);
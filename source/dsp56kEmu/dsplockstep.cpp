@@ -0,0 +1,213 @@
+#include "dsplockstep.h"
+
+#include <algorithm>
+
+#include "dsp.h"
+#include "threadtools.h"
+
+namespace dsp56k
+{
+	namespace
+	{
+		// a DSP runs in chunks that process at most one audio frame, one frame is kept as reserve like in DSPScheduler
+		constexpr uint64_t g_chunkCycles = 128;
+		constexpr size_t g_minFrames = 2;
+
+		// the interpreter does not count cycles, it advances by instructions instead
+		uint64_t getCounter(const DSP& _dsp)
+		{
+			return _dsp.useJIT() ? _dsp.getCycles() : _dsp.getInstructionCounter();
+		}
+
+		void defaultConverter(const Audio::TxFrame& _src, Audio::RxFrame& _dst)
+		{
+			_dst.resize(_src.size());
+
+			for(uint32_t s=0; s<_src.size(); ++s)
+			{
+				for(uint32_t r=0; r<Audio::RxRegisterCount; ++r)
+					_dst[s][r] = _src[s][r];
+			}
+		}
+	}
+
+	DSPLockstep::~DSPLockstep()
+	{
+		stop();
+	}
+
+	void DSPLockstep::add(DSP& _dsp, const uint64_t _quantum)
+	{
+		Entry e;
+		e.dsp = &_dsp;
+		e.quantum = _quantum;
+		e.target = getCounter(_dsp);
+		m_entries.push_back(e);
+	}
+
+	void DSPLockstep::link(const DSP& _srcDsp, Audio& _src, const DSP& _dstDsp, Audio& _dst, const size_t _latencyFrames/* = 0*/, FrameConverter _converter/* = {}*/)
+	{
+		Link l;
+		l.src = &_src;
+		l.dst = &_dst;
+		l.srcDsp = &_srcDsp;
+		l.dstDsp = &_dstDsp;
+		l.converter = _converter ? std::move(_converter) : FrameConverter(defaultConverter);
+
+		if(_latencyFrames)
+			_dst.writeEmptyAudioIn(_latencyFrames);
+
+		m_links.push_back(std::move(l));
+	}
+
+	void DSPLockstep::step()
+	{
+		for (auto& e : m_entries)
+			runEntry(e);
+
+		transfer();
+	}
+
+	void DSPLockstep::start(uint32_t _threadCount/* = 1*/)
+	{
+		stop();
+
+		if(m_entries.empty())
+			return;
+
+		_threadCount = std::max(1u, std::min(_threadCount, static_cast<uint32_t>(m_entries.size())));
+
+		m_runThreads = true;
+		m_syncThreadCount = _threadCount;
+		m_syncWaiting = 0;
+
+		for(uint32_t i=0; i<_threadCount; ++i)
+		{
+			m_threads.emplace_back(new std::thread([this, i, _threadCount]
+			{
+				threadFunc(i, _threadCount);
+			}));
+		}
+	}
+
+	void DSPLockstep::stop()
+	{
+		if(m_threads.empty())
+			return;
+
+		m_runThreads = false;
+
+		// threads might wait for audio from the host or in the barrier
+		for (const auto& e : m_entries)
+			e.dsp->terminate();
+
+		{
+			std::lock_guard lock(m_syncMutex);
+			m_syncCv.notify_all();
+		}
+
+		for (const auto& t : m_threads)
+			t->join();
+
+		m_threads.clear();
+	}
+
+	bool DSPLockstep::canRun(const Entry& _entry) const
+	{
+		for (const auto& l : m_links)
+		{
+			// running now might block in the audio interface, the DSP catches up once audio has been transferred
+			if(l.dstDsp == _entry.dsp && l.dst->getAudioInputs().size() < g_minFrames)
+				return false;
+			if(l.srcDsp == _entry.dsp && l.src->getAudioOutputs().remaining() < g_minFrames)
+				return false;
+		}
+		return true;
+	}
+
+	void DSPLockstep::runEntry(Entry& _entry)
+	{
+		auto* dsp = _entry.dsp;
+
+		// A DSP that has been blocked by audio did not reach its last target. It does not catch up on the missed cycles, it would
+		// otherwise run several quanta at once after it has been unblocked. Cycles that exceeded the last target are still accounted for
+		_entry.target = std::min(_entry.target, getCounter(*dsp)) + _entry.quantum;
+
+		while(getCounter(*dsp) < _entry.target && canRun(_entry))
+		{
+			const auto chunkEnd = std::min(_entry.target, getCounter(*dsp) + g_chunkCycles);
+
+			while(getCounter(*dsp) < chunkEnd)
+				dsp->exec();
+		}
+	}
+
+	void DSPLockstep::transfer()
+	{
+		for (auto& l : m_links)
+		{
+			auto& outputs = l.src->getAudioOutputs();
+			auto& inputs = l.dst->getAudioInputs();
+
+			const auto count = std::min(outputs.size(), inputs.remaining());
+
+			if(!count)
+				continue;
+
+			// both sizes have been checked, this does not block
+			outputs.pop_front_n(count, [&](const Audio::TxFrame& _tx, size_t)
+			{
+				inputs.emplace_back([&](Audio::RxFrame& _rx)
+				{
+					l.converter(_tx, _rx);
+				});
+			});
+		}
+
+		++m_stepCount;
+	}
+
+	void DSPLockstep::threadFunc(const uint32_t _index, const uint32_t _threadCount)
+	{
+		ThreadTools::setCurrentThreadPriority(ThreadPriority::Highest);
+		ThreadTools::setCurrentThreadName("DSP lockstep " + std::to_string(_index));
+
+		while(m_runThreads)
+		{
+			for(size_t i=_index; i<m_entries.size(); i += _threadCount)
+				runEntry(m_entries[i]);
+
+			// all DSPs have finished their quantum, the first thread forwards audio while the others wait
+			if(!sync())
+				break;
+
+			if(_index == 0)
+				transfer();
+
+			if(!sync())
+				break;
+		}
+	}
+
+	bool DSPLockstep::sync()
+	{
+		std::unique_lock lock(m_syncMutex);
+
+		const auto generation = m_syncGeneration;
+
+		if(++m_syncWaiting == m_syncThreadCount)
+		{
+			m_syncWaiting = 0;
+			++m_syncGeneration;
+			m_syncCv.notify_all();
+			return m_runThreads;
+		}
+
+		m_syncCv.wait(lock, [&]
+		{
+			return generation != m_syncGeneration || !m_runThreads;
+		});
+
+		return m_runThreads;
+	}
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "audio.h"
+
+namespace dsp56k
+{
+	class DSP;
+
+	// Runs several coupled DSPs cooperatively in fixed cycle quanta instead of running each one on its own DSPThread.
+	// Audio that one DSP sends to another via ESAI/ESSI is handed over between two steps without blocking. Frames that have been
+	// transmitted during a step are received by the other DSP in the next step, which makes the timing between DSPs deterministic
+	class DSPLockstep final
+	{
+	public:
+		// converts a frame that has been transmitted by the source to a frame that is received by the destination
+		using FrameConverter = std::function<void(const Audio::TxFrame&, Audio::RxFrame&)>;
+
+		DSPLockstep() = default;
+		~DSPLockstep();
+
+		DSPLockstep(const DSPLockstep&) = delete;
+		DSPLockstep& operator = (const DSPLockstep&) = delete;
+
+		// adds a DSP that advances by _quantum cycles per step (instructions for the interpreter, it does not count cycles). Cycles that
+		// are missed while the DSP is blocked by audio are not caught up later
+		void add(DSP& _dsp, uint64_t _quantum);
+
+		// Forwards the output of _src, an audio interface of _srcDsp, to the input of _dst, an audio interface of _dstDsp. _latencyFrames
+		// empty frames are received by the destination before the first transmitted frame. A DSP only runs as long as its linked inputs
+		// have data and its linked outputs have space, without latency the destination waits until the source has transmitted audio.
+		// The default converter forwards the first RxRegisterCount TX registers of each slot
+		void link(const DSP& _srcDsp, Audio& _src, const DSP& _dstDsp, Audio& _dst, size_t _latencyFrames = 0, FrameConverter _converter = {});
+
+		// runs one quantum of all DSPs on the calling thread, then forwards audio between them
+		void step();
+
+		// runs steps on _threadCount threads until stop() is called. DSPs are distributed evenly among the threads
+		void start(uint32_t _threadCount = 1);
+
+		// terminates all DSPs like DSPThread::join() does to release threads that wait for audio
+		void stop();
+
+		bool isRunning() const { return !m_threads.empty(); }
+
+		uint64_t getStepCount() const { return m_stepCount; }
+
+	private:
+		struct Entry
+		{
+			DSP* dsp = nullptr;
+			uint64_t quantum = 0;
+			uint64_t target = 0;
+		};
+
+		struct Link
+		{
+			Audio* src = nullptr;
+			Audio* dst = nullptr;
+			const DSP* srcDsp = nullptr;
+			const DSP* dstDsp = nullptr;
+			FrameConverter converter;
+		};
+
+		bool canRun(const Entry& _entry) const;
+		void runEntry(Entry& _entry);
+		void transfer();
+
+		void threadFunc(uint32_t _index, uint32_t _threadCount);
+		bool sync();
+
+		std::vector<Entry> m_entries;
+		std::vector<Link> m_links;
+
+		std::atomic<uint64_t> m_stepCount{0};
+
+		std::vector<std::unique_ptr<std::thread>> m_threads;
+		std::atomic<bool> m_runThreads{false};
+
+		// barrier between the threads
+		std::mutex m_syncMutex;
+		std::condition_variable m_syncCv;
+		uint32_t m_syncThreadCount = 0;
+		uint32_t m_syncWaiting = 0;
+		uint64_t m_syncGeneration = 0;
+	};
+}
@@ -0,0 +1,332 @@
+#include "dspscheduler.h"
+
+#include <algorithm>
+#include <chrono>
+
+#include "audio.h"
+#include "dsp.h"
+
+namespace dsp56k
+{
+	namespace
+	{
+		void defaultCallback(uint32_t)
+		{
+		}
+
+		constexpr uint32_t g_chunkSize = 128;
+
+		// interval at which parked DSPs are polled even if the queues are not empty
+		constexpr auto g_pollInterval = std::chrono::milliseconds(1);
+	}
+
+	DSPScheduler::Entry::Entry(DSP& _dsp, std::string _name, Budget _budget)
+		: m_dsp(_dsp)
+		, m_budget(std::move(_budget))
+		, m_callback(defaultCallback)
+		, m_stats(std::move(_name))
+	{
+	}
+
+	void DSPScheduler::Entry::setCallback(const Callback& _callback)
+	{
+		const Callback c = _callback ? _callback : defaultCallback;
+
+		Guard g(m_mutex);
+		m_callback = c;
+	}
+
+	bool DSPScheduler::Entry::canRun() const
+	{
+		return !m_budget || m_budget() >= MinBudget;
+	}
+
+	uint32_t DSPScheduler::Entry::runSlice(const uint32_t _maxChunks)
+	{
+		Guard g(m_mutex);
+
+		uint32_t chunks = 0;
+
+		while(chunks < _maxChunks && !m_remove && canRun())
+		{
+			const auto iBegin = m_dsp.getInstructionCounter();
+			const auto cBegin = m_dsp.getCycles();
+
+			for(size_t i=0; i<g_chunkSize; i += 8)
+			{
+				m_dsp.exec();
+				m_dsp.exec();
+				m_dsp.exec();
+				m_dsp.exec();
+				m_dsp.exec();
+				m_dsp.exec();
+				m_dsp.exec();
+				m_dsp.exec();
+			}
+
+			const auto di = m_dsp.getInstructionCounter() - iBegin;
+			const auto dc = m_dsp.getCycles() - cBegin;
+
+			m_stats.add(di, dc, g_chunkSize);
+
+			m_callback(static_cast<uint32_t>(di));
+
+			++chunks;
+		}
+
+		return chunks;
+	}
+
+	DSPScheduler::DSPScheduler(uint32_t _workerCount/* = 0*/, const ThreadPriority _priority/* = ThreadPriority::Highest*/, const uint32_t _sliceChunks/* = 256*/)
+		: m_sliceChunks(std::max(_sliceChunks, 1u))
+	{
+		if(!_workerCount)
+			_workerCount = std::max(std::thread::hardware_concurrency(), 1u);
+
+		m_workers.reserve(_workerCount);
+
+		for(uint32_t i=0; i<_workerCount; ++i)
+			m_workers.emplace_back(new Worker());
+
+		for(size_t i=0; i<m_workers.size(); ++i)
+		{
+			m_workers[i]->thread.reset(new std::thread([this, i, _priority]
+			{
+				workerFunc(i, _priority);
+			}));
+		}
+	}
+
+	DSPScheduler::~DSPScheduler()
+	{
+		m_running = false;
+
+		{
+			std::lock_guard lock(m_mutex);
+
+			// unblock workers that wait for audio inside of a slice
+			for (const auto& e : m_entries)
+				e->dsp().terminate();
+
+			m_cv.notify_all();
+		}
+
+		for (const auto& w : m_workers)
+			w->thread->join();
+	}
+
+	DSPScheduler::Entry* DSPScheduler::add(DSP& _dsp, const char* _name/* = nullptr*/, Budget _budget/* = {}*/)
+	{
+		auto* e = new Entry(_dsp, _name ? _name : std::string(), std::move(_budget));
+
+		{
+			std::lock_guard lock(m_mutex);
+			m_entries.emplace_back(e);
+		}
+
+		pushEntry(m_nextWorker++ % m_workers.size(), e);
+
+		m_cv.notify_one();
+
+		return e;
+	}
+
+	DSPScheduler::Entry* DSPScheduler::add(DSP& _dsp, const char* _name, const std::vector<Audio*>& _audio)
+	{
+		if(_audio.empty())
+			return add(_dsp, _name);
+
+		return add(_dsp, _name, [_audio]
+		{
+			size_t budget = getAudioBudget(*_audio.front());
+
+			for(size_t i=1; i<_audio.size(); ++i)
+				budget = std::min(budget, getAudioBudget(*_audio[i]));
+
+			return budget;
+		});
+	}
+
+	void DSPScheduler::remove(Entry* _entry)
+	{
+		_entry->m_remove = true;
+
+		// a worker might wait for audio inside of a slice
+		_entry->dsp().terminate();
+
+		std::unique_lock lock(m_mutex);
+
+		// a parked DSP is not owned by any worker
+		const auto it = std::find(m_parked.begin(), m_parked.end(), _entry);
+
+		if(it != m_parked.end())
+		{
+			m_parked.erase(it);
+			_entry->m_removed = true;
+		}
+
+		m_cv.notify_all();
+
+		m_cv.wait(lock, [&]
+		{
+			return _entry->m_removed || !m_running;
+		});
+
+		m_entries.erase(std::find_if(m_entries.begin(), m_entries.end(), [&](const std::unique_ptr<Entry>& _e)
+		{
+			return _e.get() == _entry;
+		}));
+	}
+
+	void DSPScheduler::wakeUp()
+	{
+		m_cv.notify_all();
+	}
+
+	size_t DSPScheduler::getAudioBudget(const Audio& _audio)
+	{
+		return std::min(_audio.getAudioInputs().size(), _audio.getAudioOutputs().remaining());
+	}
+
+	void DSPScheduler::workerFunc(const size_t _index, const ThreadPriority _priority)
+	{
+		ThreadTools::setCurrentThreadPriority(_priority);
+		ThreadTools::setCurrentThreadName("DSP worker " + std::to_string(_index));
+
+		using Clock = std::chrono::steady_clock;
+
+		auto nextPoll = Clock::now() + g_pollInterval;
+
+		while(m_running)
+		{
+			// runnable DSPs might keep all queues busy, parked DSPs need to be polled anyway
+			const auto now = Clock::now();
+
+			if(now >= nextPoll)
+			{
+				unpark(_index);
+				nextPoll = now + g_pollInterval;
+			}
+
+			auto* e = popEntry(_index);
+
+			if(!e && unpark(_index))
+				e = popEntry(_index);
+
+			if(!e)
+			{
+				std::unique_lock lock(m_mutex);
+
+				// audio producers do not notify us, poll parked DSPs
+				m_cv.wait_for(lock, std::chrono::milliseconds(1));
+				continue;
+			}
+
+			if(!e->m_remove && e->runSlice(m_sliceChunks) == 0)
+			{
+				if(!e->m_remove)
+				{
+					park(e);
+					continue;
+				}
+			}
+
+			if(e->m_remove)
+				detach(e);
+			else
+				pushEntry(_index, e);
+		}
+	}
+
+	DSPScheduler::Entry* DSPScheduler::popEntry(const size_t _index)
+	{
+		{
+			auto& w = *m_workers[_index];
+			Guard g(w.mutex);
+
+			if(!w.queue.empty())
+			{
+				auto* e = w.queue.front();
+				w.queue.pop_front();
+				return e;
+			}
+		}
+
+		// steal from the back of the queues of other workers
+		for(size_t i=1; i<m_workers.size(); ++i)
+		{
+			auto& w = *m_workers[(_index + i) % m_workers.size()];
+			Guard g(w.mutex);
+
+			if(!w.queue.empty())
+			{
+				auto* e = w.queue.back();
+				w.queue.pop_back();
+				return e;
+			}
+		}
+
+		return nullptr;
+	}
+
+	void DSPScheduler::pushEntry(const size_t _index, Entry* _entry)
+	{
+		auto& w = *m_workers[_index];
+		Guard g(w.mutex);
+		w.queue.push_back(_entry);
+	}
+
+	bool DSPScheduler::unpark(const size_t _index)
+	{
+		std::lock_guard lock(m_mutex);
+
+		bool res = false;
+
+		// DSPs that can run again are moved to the queue of the calling worker
+		for(auto it = m_parked.begin(); it != m_parked.end();)
+		{
+			auto* e = *it;
+
+			if(e->m_remove)
+			{
+				it = m_parked.erase(it);
+				e->m_removed = true;
+				m_cv.notify_all();
+			}
+			else if(e->canRun())
+			{
+				it = m_parked.erase(it);
+				pushEntry(_index, e);
+				res = true;
+			}
+			else
+			{
+				++it;
+			}
+		}
+
+		return res;
+	}
+
+	void DSPScheduler::park(Entry* _entry)
+	{
+		std::lock_guard lock(m_mutex);
+
+		// remove() might have missed the entry while it was still owned by the worker
+		if(_entry->m_remove)
+		{
+			_entry->m_removed = true;
+			m_cv.notify_all();
+			return;
+		}
+
+		m_parked.push_back(_entry);
+	}
+
+	void DSPScheduler::detach(Entry* _entry)
+	{
+		std::lock_guard lock(m_mutex);
+		_entry->m_removed = true;
+		m_cv.notify_all();
+	}
+}
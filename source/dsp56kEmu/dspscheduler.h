@@ -0,0 +1,127 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "dspstats.h"
+#include "threadtools.h"
+
+namespace dsp56k
+{
+	class Audio;
+	class DSP;
+
+	// Runs many DSPs on a fixed pool of worker threads instead of using one DSPThread per DSP.
+	// Each DSP is executed in time slices. A slice ends early if the DSP runs out of audio, i.e. if the next audio frame would
+	// block in the ESAI/ESSI ring buffers. Such DSPs are parked until their audio interface has data again, parked DSPs are polled
+	// regularly by all workers. Workers process their own queue first and steal DSPs from other workers if their own queue is empty
+	class DSPScheduler final
+	{
+	public:
+		using Guard = std::lock_guard<std::mutex>;
+		using Callback = std::function<void(uint32_t)>;
+
+		// returns the number of audio frames that the DSP can process without blocking
+		using Budget = std::function<size_t()>;
+
+		// a DSP needs at least this many frames to be scheduled. Audio is processed while a slice runs, one frame is kept as reserve
+		static constexpr size_t MinBudget = 2;
+
+		class Entry final
+		{
+		public:
+			Entry(DSP& _dsp, std::string _name, Budget _budget);
+
+			DSP& dsp() { return m_dsp; }
+			std::mutex& mutex() { return m_mutex; }
+
+			void setCallback(const Callback& _callback);
+
+			void setLogToDebug(const bool _log) { m_stats.setLogToDebug(_log); }
+			void setLogToStdout(const bool _log) { m_stats.setLogToStdout(_log); }
+
+			const char* getMipsString() const { return m_stats.getMipsString(); }
+			double getCurrentMips() const { return m_stats.getCurrentMips(); }
+			double getAverageMips() const { return m_stats.getAverageMips(); }
+
+		private:
+			friend class DSPScheduler;
+
+			bool canRun() const;
+			uint32_t runSlice(uint32_t _maxChunks);
+
+			DSP& m_dsp;
+			const Budget m_budget;
+
+			std::mutex m_mutex;
+			Callback m_callback;
+
+			std::atomic<bool> m_remove{false};
+			bool m_removed = false;		// protected by the scheduler mutex
+
+			DSPStats m_stats;
+		};
+
+		// _workerCount = 0 uses one worker per hardware thread. A slice runs up to _sliceChunks * 128 instructions
+		explicit DSPScheduler(uint32_t _workerCount = 0, ThreadPriority _priority = ThreadPriority::Highest, uint32_t _sliceChunks = 256);
+		~DSPScheduler();
+
+		DSPScheduler(const DSPScheduler&) = delete;
+		DSPScheduler& operator = (const DSPScheduler&) = delete;
+
+		// adds a DSP that is scheduled until it is removed. Without a budget, the DSP is always runnable
+		Entry* add(DSP& _dsp, const char* _name = nullptr, Budget _budget = {});
+
+		// adds a DSP whose slices are bounded by the frames that are available in its audio interfaces
+		Entry* add(DSP& _dsp, const char* _name, const std::vector<Audio*>& _audio);
+
+		// stops scheduling the DSP and waits until no worker is running it anymore. The DSP is terminated like in DSPThread::join() to
+		// release a worker that waits for audio, the entry is destroyed
+		void remove(Entry* _entry);
+
+		// wakes up idle workers, call after audio input has been provided to reduce latency of parked DSPs
+		void wakeUp();
+
+		size_t getWorkerCount() const { return m_workers.size(); }
+
+		// frames that can be processed by the DSP of an audio interface without blocking on its input or output
+		static size_t getAudioBudget(const Audio& _audio);
+
+	private:
+		struct Worker
+		{
+			std::mutex mutex;
+			std::deque<Entry*> queue;
+			std::unique_ptr<std::thread> thread;
+		};
+
+		void workerFunc(size_t _index, ThreadPriority _priority);
+
+		Entry* popEntry(size_t _index);
+		void pushEntry(size_t _index, Entry* _entry);
+
+		bool unpark(size_t _index);
+		void park(Entry* _entry);
+		void detach(Entry* _entry);
+
+		const uint32_t m_sliceChunks;
+
+		std::vector<std::unique_ptr<Worker>> m_workers;
+		std::atomic<size_t> m_nextWorker{0};
+
+		std::mutex m_mutex;
+		std::condition_variable m_cv;
+		std::list<Entry*> m_parked;
+		std::vector<std::unique_ptr<Entry>> m_entries;
+
+		std::atomic<bool> m_running{true};
+	};
+}
@@ -0,0 +1,69 @@
+#include "dspstats.h"
+
+#include <cstdio>
+#include <iterator>
+
+#include "logging.h"
+
+namespace dsp56k
+{
+	namespace
+	{
+#ifdef _DEBUG
+		constexpr uint64_t g_ipsStep = 0x0400000;
+#else
+		constexpr uint64_t g_ipsStep = 0x2000000;
+#endif
+	}
+
+	DSPStats::DSPStats(std::string _name/* = {}*/) : m_name(std::move(_name))
+	{
+#ifdef _WIN32
+		m_logToStdout = true;
+#endif
+		m_start = m_time = Clock::now();
+	}
+
+	void DSPStats::add(const uint64_t _instructions, const uint64_t _cycles, const uint32_t _execCount)
+	{
+		m_instructions += _instructions;
+		m_totalInstructions += _instructions;
+
+		m_cycles += _cycles;
+		m_totalCycles += _cycles;
+
+		m_counter += _execCount;
+
+		if((m_counter & (g_ipsStep-1)) == 0)
+			update();
+	}
+
+	void DSPStats::update()
+	{
+		const auto t = Clock::now();
+
+		const auto us = std::chrono::duration_cast<std::chrono::microseconds>(t - m_time);
+		const auto usTotal = std::chrono::duration_cast<std::chrono::microseconds>(t - m_start);
+
+		m_currentMips = static_cast<double>(m_instructions) / static_cast<double>(us.count());
+		m_averageMips = static_cast<double>(m_totalInstructions) / static_cast<double>(usTotal.count());
+
+		m_currentMcps = static_cast<double>(m_cycles) / static_cast<double>(us.count());
+		m_averageMcps = static_cast<double>(m_totalCycles) / static_cast<double>(usTotal.count());
+
+		m_instructions = 0;
+		m_cycles = 0;
+
+		m_time = t;
+
+		if(!m_name.empty())
+			snprintf(m_mipsString, std::size(m_mipsString), "[%s] MIPS: %.4f (%.4f avg), MHz: %.4f (%.4f avg)", m_name.c_str(), m_currentMips, m_averageMips, m_currentMcps, m_averageMcps);
+		else
+			snprintf(m_mipsString, std::size(m_mipsString), "MIPS: %.4f (%.4f avg), MHz: %.4f (%.4f avg)", m_currentMips, m_averageMips, m_currentMcps, m_averageMcps);
+
+		if(m_logToStdout)
+			puts(m_mipsString);
+		if(m_logToDebug)
+			LOG(m_mipsString);
+	}
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+namespace dsp56k
+{
+	// Measures the MIPS and MHz of a DSP that is executed in chunks of instructions, used by DSPThread and DSPScheduler
+	class DSPStats final
+	{
+	public:
+		explicit DSPStats(std::string _name = {});
+
+		// accounts for a chunk of _execCount DSP::exec() calls. The stats are updated and logged once every ipsStep calls
+		void add(uint64_t _instructions, uint64_t _cycles, uint32_t _execCount);
+
+		void setLogToDebug(const bool _log) { m_logToDebug = _log; }
+		void setLogToStdout(const bool _log) { m_logToStdout = _log; }
+
+		const char* getMipsString() const { return m_mipsString; }
+		double getCurrentMips() const { return m_currentMips; }
+		double getAverageMips() const { return m_averageMips; }
+
+	private:
+		void update();
+
+		using Clock = std::chrono::high_resolution_clock;
+
+		const std::string m_name;
+
+		Clock::time_point m_time;
+		Clock::time_point m_start;
+
+		uint64_t m_counter = 0;
+		uint64_t m_instructions = 0;
+		uint64_t m_cycles = 0;
+		uint64_t m_totalInstructions = 0;
+		uint64_t m_totalCycles = 0;
+
+		double m_currentMips = 0.0;
+		double m_averageMips = 0.0;
+
+		double m_currentMcps = 0.0;
+		double m_averageMcps = 0.0;
+
+		char m_mipsString[128]{0};
+
+		bool m_logToDebug = true;
+		bool m_logToStdout = false;
+	};
+}
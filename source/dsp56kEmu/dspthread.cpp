@@ -21,10 +21,8 @@ namespace dsp56k
 		, m_name(_name ? _name : std::string())
 		, m_runThread(true)
 		, m_debugger(std::move(_debugger))
+		, m_stats(m_name)
 	{
-#ifdef _WIN32
-		m_logToStdout = true;
-#endif
 		if(m_debugger)
 			setDebugger(m_debugger.get());
 
@@ -94,23 +92,6 @@ namespace dsp56k
 		ThreadTools::setCurrentThreadPriority(ThreadPriority::Highest);
 		ThreadTools::setCurrentThreadName(m_name.empty() ? "DSP" : "DSP " + m_name);
 
-		uint64_t instructions = 0;
-		uint64_t cycles = 0;
-		uint64_t counter = 0;
-
-		uint64_t totalInstructions = 0;
-		uint64_t totalCycles = 0;
-
-		using Clock = std::chrono::high_resolution_clock;
-
-		auto t = Clock::now();
-		const auto tStart = t;
-
-#ifdef _DEBUG
-		constexpr size_t ipsStep = 0x0400000;
-#else
-		constexpr size_t ipsStep = 0x2000000;
-#endif
 		while(m_runThread)
 		{
 			{
@@ -131,19 +112,10 @@ namespace dsp56k
 					m_dsp.exec();
 				}
 
-				const auto iEnd = m_dsp.getInstructionCounter();
-				const auto cEnd = m_dsp.getCycles();
-
-				const auto di = iEnd - iBegin;
-				const auto dc = cEnd - cBegin;
-
-				instructions += di;
-				totalInstructions += di;
+				const auto di = m_dsp.getInstructionCounter() - iBegin;
+				const auto dc = m_dsp.getCycles() - cBegin;
 
-				cycles += dc;
-				totalCycles += dc;
-
-				counter += 128;
+				m_stats.add(di, dc, 128);
 
 				m_callback(static_cast<uint32_t>(di));
 
@@ -151,37 +123,6 @@ namespace dsp56k
 				m_dsp.setDebugger(m_nextDebugger);
 #endif
 			}
-
-			if((counter & (ipsStep-1)) == 0)
-			{
-				const auto t2 = Clock::now();
-				const auto d = t2 - t;
-				const auto dTotal = t2 - tStart;
-
-				const auto ms = std::chrono::duration_cast<std::chrono::microseconds>(d);
-				const auto msTotal = std::chrono::duration_cast<std::chrono::microseconds>(dTotal);
-
-				m_currentMips = static_cast<double>(instructions) / static_cast<double>(ms.count());
-				m_averageMips = static_cast<double>(totalInstructions) / static_cast<double>(msTotal.count());
-
-				m_currentMcps = static_cast<double>(cycles) / static_cast<double>(ms.count());
-				m_averageMcps = static_cast<double>(totalCycles) / static_cast<double>(msTotal.count());
-
-				instructions = 0;
-				cycles = 0;
-
-				t = t2;
-
-				if(!m_name.empty())
-					snprintf(m_mipsString, std::size(m_mipsString), "[%s] MIPS: %.4f (%.4f avg), MHz: %.4f (%.4f avg)", m_name.c_str(), m_currentMips, m_averageMips, m_currentMcps, m_averageMcps);
-				else
-					snprintf(m_mipsString, std::size(m_mipsString), "MIPS: %.4f (%.4f avg), MHz: %.4f (%.4f avg)", m_currentMips, m_averageMips, m_currentMcps, m_averageMcps);
-
-				if(m_logToStdout)
-					puts(m_mipsString);
-				if(m_logToDebug)
-					LOG(m_mipsString);
-			}
 		}
 
 		m_dsp.setDebugger(m_nextDebugger);
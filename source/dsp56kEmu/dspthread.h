@@ -7,6 +7,7 @@
 #include <thread>
 
 #include "debuggerinterface.h"
+#include "dspstats.h"
 
 namespace dsp56k
 {
@@ -27,12 +28,12 @@ namespace dsp56k
 
 		void setCallback(const Callback& _callback);
 
-		void setLogToDebug(const bool _log) { m_logToDebug = _log; }
-		void setLogToStdout(const bool _log) { m_logToStdout = _log; }
+		void setLogToDebug(const bool _log) { m_stats.setLogToDebug(_log); }
+		void setLogToStdout(const bool _log) { m_stats.setLogToStdout(_log); }
 
-		const char* getMipsString() const { return m_mipsString; }
-		double getCurrentMips() const { return m_currentMips; }
-		double getAverageMips() const { return m_averageMips; }
+		const char* getMipsString() const { return m_stats.getMipsString(); }
+		double getCurrentMips() const { return m_stats.getCurrentMips(); }
+		double getAverageMips() const { return m_stats.getAverageMips(); }
 
 		void setDebugger(DebuggerInterface* _debugger);
 		void detachDebugger(const DebuggerInterface* _debugger);
@@ -59,15 +60,6 @@ namespace dsp56k
 
 		std::shared_ptr<DebuggerInterface> m_debugger;
 
-		double m_currentMips = 0.0;
-		double m_averageMips = 0.0;
-
-		double m_currentMcps = 0.0;
-		double m_averageMcps = 0.0;
-
-		char m_mipsString[128]{0};
-
-		bool m_logToDebug = true;
-		bool m_logToStdout = false;
+		DSPStats m_stats;
 	};
 }
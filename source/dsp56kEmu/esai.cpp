@@ -3,6 +3,7 @@
 #include "dsp.h"
 #include "interrupts.h"
 #include "peripherals.h"
+#include "savestate.h"
 
 namespace dsp56k
 {
@@ -198,6 +199,33 @@ namespace dsp56k
 		return m_rx[_index];
 	}
 
+	EsxiDataRegister Esai::getTxRegister(const uint32_t _index) const
+	{
+		EsxiDataRegister r;
+		r.tx = true;
+		r.data = &m_tx[_index];
+		r.flags = &m_writtenTX;
+		r.flagMask = 1 << _index;
+		r.control = &static_cast<const TWord&>(m_tcr);
+		r.controlMask = M_TEM;
+		r.status = &static_cast<const TWord&>(m_sr);
+		r.statusClearMask = (1 << M_TUE) | (1 << M_TDE);
+		return r;
+	}
+
+	EsxiDataRegister Esai::getRxRegister(const uint32_t _index) const
+	{
+		EsxiDataRegister r;
+		r.data = &m_rx[_index];
+		r.flags = &m_readRX;
+		r.flagMask = 1 << _index;
+		r.control = &static_cast<const TWord&>(m_rcr);
+		r.controlMask = 1 << _index;
+		r.status = &static_cast<const TWord&>(m_sr);
+		r.statusClearMask = (1 << M_RDF) | (1 << M_ROE);
+		return r;
+	}
+
 	std::string Esai::getTccrAsString() const
 	{
 		std::stringstream ss;
@@ -574,4 +602,36 @@ namespace dsp56k
 		addIR(Vba_ESAI_Transmit_Data_with_Exception_Status, "TransmitDataException");
 		addIR(Vba_ESAI_Transmit_Last_Slot, "TransmitLastSlot");
 	}
+
+	void Esai::saveState(StateWriter& _w) const
+	{
+		_w.write(m_sr);
+		_w.write(m_cr);
+		_w.write(m_tcr);
+		_w.write(m_rcr);
+		_w.write(m_rccr);
+		_w.write(m_tccr);
+		_w.write(m_tx);
+		_w.write(m_rx);
+		_w.write(m_txFrame);
+		_w.write(m_rxFrame);
+		_w.write(m_writtenTX);
+		_w.write(m_readRX);
+		_w.write(m_txSlotCounter);
+		_w.write(m_txFrameCounter);
+		_w.write(m_rxSlotCounter);
+		_w.write(m_rxFrameCounter);
+		_w.write(m_tsma);
+		_w.write(m_tsmb);
+		_w.write(m_vbaRead);
+	}
+
+	bool Esai::loadState(StateReader& _r)
+	{
+		return _r.read(m_sr) && _r.read(m_cr) && _r.read(m_tcr) && _r.read(m_rcr) && _r.read(m_rccr) && _r.read(m_tccr)
+			&& _r.read(m_tx) && _r.read(m_rx) && _r.read(m_txFrame) && _r.read(m_rxFrame)
+			&& _r.read(m_writtenTX) && _r.read(m_readRX)
+			&& _r.read(m_txSlotCounter) && _r.read(m_txFrameCounter) && _r.read(m_rxSlotCounter) && _r.read(m_rxFrameCounter)
+			&& _r.read(m_tsma) && _r.read(m_tsmb) && _r.read(m_vbaRead);
+	}
 }
@@ -13,6 +13,8 @@ namespace dsp56k
 	class Disassembler;
 	class IPeripherals;
 	class DSP;
+	class StateReader;
+	class StateWriter;
 
 	class Esai : public Esxi
 	{
@@ -328,6 +330,9 @@ namespace dsp56k
 		void writeTX(uint32_t _index, TWord _val);
 		TWord readRX(uint32_t _index);
 
+		EsxiDataRegister getTxRegister(uint32_t _index) const;
+		EsxiDataRegister getRxRegister(uint32_t _index) const;
+
 		TWord readTSMA() const
 		{
 			return m_tsma;
@@ -407,6 +412,9 @@ namespace dsp56k
 
 		const auto& getSR() const { return m_sr; }
 
+		void saveState(StateWriter& _w) const;
+		bool loadState(StateReader& _r);
+
 	private:
 		bool inputEnabled(uint32_t _index) const	{ return m_rcr.test(static_cast<RcrBits>(_index)); }
 		bool outputEnabled(uint32_t _index) const	{ return m_tcr.test(static_cast<TcrBits>(_index)); }
@@ -6,6 +6,7 @@
 #include "logging.h"
 
 #include "peripherals.h"
+#include "savestate.h"
 
 namespace dsp56k
 {
@@ -230,6 +231,41 @@ namespace dsp56k
 		return false;
 	}
 
+	void EsxiClock::saveState(StateWriter& _w) const
+	{
+		_w.write(m_lastClock);
+		_w.write(m_cyclesPerSample);
+		_w.write(m_pctl);
+		_w.write(m_speedHz);
+
+		// the list of ESAIs is created by the peripherals constructor, it is identical for all instances of the same type
+		_w.write(static_cast<uint32_t>(m_esais.size()));
+
+		for (const auto& e : m_esais)
+		{
+			_w.write(e.tx);
+			_w.write(e.rx);
+		}
+	}
+
+	bool EsxiClock::loadState(StateReader& _r)
+	{
+		uint32_t count;
+
+		if(!_r.read(m_lastClock) || !_r.read(m_cyclesPerSample) || !_r.read(m_pctl) || !_r.read(m_speedHz) || !_r.read(count))
+			return false;
+
+		if(count != m_esais.size())
+			return false;
+
+		for (auto& e : m_esais)
+		{
+			if(!_r.read(e.tx) || !_r.read(e.rx))
+				return false;
+		}
+		return true;
+	}
+
 	bool EsxiClock::setSpeedPercent(const uint32_t _percent)
 	{
 		if(m_speedPercent == _percent)
@@ -11,6 +11,8 @@ namespace dsp56k
 	class Esxi;
 	class IPeripherals;
 	class DSP;
+	class StateReader;
+	class StateWriter;
 
 	class EsxiClock
 	{
@@ -56,6 +58,9 @@ namespace dsp56k
 
 		TWord getRemainingInstructionsForFrameSync() const;
 
+		void saveState(StateWriter& _w) const;
+		bool loadState(StateReader& _r);
+
 	protected:
 		auto getDspInstructionCounter() const { return *m_dspInstructionCounter; }
 		auto getLastClock() const { return m_lastClock; }
@@ -2,6 +2,7 @@
 
 #include "dsp.h"
 #include "interrupts.h"
+#include "savestate.h"
 
 #if 1
 #define LOGESSI(S)		LOG("ESSI" << m_index << ' ' << S)
@@ -348,6 +349,34 @@ namespace dsp56k
 		}
 	}
 
+	EsxiDataRegister Essi::getTxRegister(const uint32_t _index) const
+	{
+		EsxiDataRegister r;
+		r.tx = true;
+		r.data = &m_tx[_index];
+		r.flags = &m_writtenTX;
+		r.flagMask = 1 << (RegCRBbits::CRB_TE0 - _index);
+		r.control = &static_cast<const TWord&>(m_crb);
+		r.controlMask = RegCRBbits::CRB_TE;
+		r.status = &static_cast<const TWord&>(m_sr);
+		r.statusClearMask = (1 << RegSSISRbits::SSISR_TUE) | (1 << RegSSISRbits::SSISR_TDE);
+		return r;
+	}
+
+	EsxiDataRegister Essi::getRxRegister() const
+	{
+		// there is only one receiver, reading it clears all flags
+		EsxiDataRegister r;
+		r.data = &m_rx[0];
+		r.flags = &m_readRX;
+		r.flagMask = 0xffffffff;
+		r.control = &static_cast<const TWord&>(m_crb);
+		r.controlMask = 1 << RegCRBbits::CRB_RE;
+		r.status = &static_cast<const TWord&>(m_sr);
+		r.statusClearMask = (1 << RegSSISRbits::SSISR_RDF) | (1 << RegSSISRbits::SSISR_ROE);
+		return r;
+	}
+
 	void Essi::writeTSR(const TWord _val)
 	{
 		LOGESSI("Write TSR " << "= " << HEX(_val));
@@ -516,4 +545,35 @@ namespace dsp56k
 
 		m_periph.getDMA().trigger(static_cast<DmaChannel::RequestSource>(_trigger + m_index * off));
 	}
+
+	void Essi::saveState(StateWriter& _w) const
+	{
+		_w.write(m_tx);
+		_w.write(m_tsr);
+		_w.write(m_rx);
+		_w.write(m_sr);
+		_w.write(m_cra);
+		_w.write(m_crb);
+		_w.write(m_tsma);
+		_w.write(m_tsmb);
+		_w.write(m_rsma);
+		_w.write(m_rsmb);
+		_w.write(m_vbaRead);
+		_w.write(m_rxSlotCounter);
+		_w.write(m_rxFrameCounter);
+		_w.write(m_txSlotCounter);
+		_w.write(m_txFrameCounter);
+		_w.write(m_readRX);
+		_w.write(m_writtenTX);
+		_w.write(m_txFrame);
+		_w.write(m_rxFrame);
+	}
+
+	bool Essi::loadState(StateReader& _r)
+	{
+		return _r.read(m_tx) && _r.read(m_tsr) && _r.read(m_rx) && _r.read(m_sr) && _r.read(m_cra) && _r.read(m_crb)
+			&& _r.read(m_tsma) && _r.read(m_tsmb) && _r.read(m_rsma) && _r.read(m_rsmb) && _r.read(m_vbaRead)
+			&& _r.read(m_rxSlotCounter) && _r.read(m_rxFrameCounter) && _r.read(m_txSlotCounter) && _r.read(m_txFrameCounter)
+			&& _r.read(m_readRX) && _r.read(m_writtenTX) && _r.read(m_txFrame) && _r.read(m_rxFrame);
+	}
 };
@@ -13,6 +13,8 @@ namespace dsp56k
 	class Disassembler;
 	class DSP;
 	class Memory;
+	class StateReader;
+	class StateWriter;
 
 	class Essi : public Esxi
 	{
@@ -199,12 +201,18 @@ namespace dsp56k
 		void writeTSMB(TWord _val);
 		void writeRSMA(TWord _val);
 		void writeRSMB(TWord _val);
+
+		EsxiDataRegister getTxRegister(uint32_t _index) const;
+		EsxiDataRegister getRxRegister() const;
 		
 		std::string getCraAsString() const;
 		std::string getCrbAsString() const;
 
 		const auto& getSR() const { return m_sr; }
 
+		void saveState(StateWriter& _w) const;
+		bool loadState(StateReader& _r);
+
 	private:
 		TWord getRxWordCount() const;
 		TWord getTxWordCount() const;
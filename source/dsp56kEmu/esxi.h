@@ -6,6 +6,21 @@
 
 namespace dsp56k
 {
+	// Side effects of a DSP access to a TX or RX data register, allows the JIT to emit the access inline, see JitConfig::inlineEsxiDataRegisters
+	// TX: data = value, flags |= flagMask, if flags == (control & controlMask) then status &= ~statusClearMask
+	// RX: if !(control & controlMask) return 0, flags &= ~flagMask, if !flags then status &= ~statusClearMask, return data
+	struct EsxiDataRegister
+	{
+		bool tx = false;
+		const TWord* data = nullptr;
+		const TWord* flags = nullptr;
+		TWord flagMask = 0;
+		const TWord* control = nullptr;
+		TWord controlMask = 0;
+		const TWord* status = nullptr;
+		TWord statusClearMask = 0;
+	};
+
 	class Esxi : public Audio
 	{
 	public:
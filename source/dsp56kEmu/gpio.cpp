@@ -1,5 +1,31 @@
 #include "gpio.h"
 
+#include "savestate.h"
+
 namespace dsp56k
 {
+	void Gpio::saveState(StateWriter& _w) const
+	{
+		_w.write(m_direction);
+		_w.write(m_control);
+		_w.write(m_dspWrite);
+		_w.write(m_hostWrite);
+	}
+
+	bool Gpio::loadState(StateReader& _r)
+	{
+		// restored silently, callbacks are not invoked
+		return _r.read(m_direction) && _r.read(m_control) && _r.read(m_dspWrite) && _r.read(m_hostWrite);
+	}
+
+	void EsaiPortC::saveState(StateWriter& _w) const
+	{
+		Gpio::saveState(_w);
+		_w.write(m_esaiControl);
+	}
+
+	bool EsaiPortC::loadState(StateReader& _r)
+	{
+		return Gpio::loadState(_r) && _r.read(m_esaiControl);
+	}
 }
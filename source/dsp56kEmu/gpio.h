@@ -6,6 +6,9 @@
 
 namespace dsp56k
 {
+	class StateReader;
+	class StateWriter;
+
 	class Gpio
 	{
 	public:
@@ -76,6 +79,9 @@ namespace dsp56k
 			m_callbackConfigChanged();
 		}
 
+		virtual void saveState(StateWriter& _w) const;
+		virtual bool loadState(StateReader& _r);
+
 	protected:
 		TWord m_direction = 0;	// bitmask, bit clear = Host to DSP, bit set = DSP to Host
 		TWord m_control = 0;	// bitmask, bit enabled = GPIO enabled
@@ -130,6 +136,9 @@ namespace dsp56k
 			return m_esaiControl;
 		}
 
+		void saveState(StateWriter& _w) const override;
+		bool loadState(StateReader& _r) override;
+
 	private:
 		TWord m_esaiControl = 0;
 	};
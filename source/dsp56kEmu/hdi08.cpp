@@ -1,6 +1,7 @@
 #include "dsp.h"
 #include "interrupts.h"
 #include "hdi08.h"
+#include "savestate.h"
 
 namespace dsp56k
 {
@@ -403,4 +404,32 @@ namespace dsp56k
 			return false;
 		return m_dma->hasTrigger(m_dmaReqSourceReceive);
 	}
+
+	void HDI08::saveState(StateWriter& _w) const
+	{
+		_w.write(m_hsr);
+		_w.write(m_hcr);
+		_w.write(m_hpcr);
+		_w.write(m_hdr);
+		_w.write(m_hddr);
+		_w.write(m_dataRX);
+		_w.write(m_dataTX);
+		_w.write(m_pendingTXInterrupts.load());
+		_w.write(m_lastRXClock);
+		_w.write(m_waitServeRXInterrupt);
+		_w.write(m_pendingHostFlags01);
+	}
+
+	bool HDI08::loadState(StateReader& _r)
+	{
+		uint32_t pendingTXInterrupts;
+
+		if(!_r.read(m_hsr) || !_r.read(m_hcr) || !_r.read(m_hpcr) || !_r.read(m_hdr) || !_r.read(m_hddr) ||
+			!_r.read(m_dataRX) || !_r.read(m_dataTX) || !_r.read(pendingTXInterrupts) ||
+			!_r.read(m_lastRXClock) || !_r.read(m_waitServeRXInterrupt) || !_r.read(m_pendingHostFlags01))
+			return false;
+
+		m_pendingTXInterrupts = pendingTXInterrupts;
+		return true;
+	}
 };
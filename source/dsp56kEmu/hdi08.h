@@ -15,6 +15,8 @@ namespace dsp56k
 {
 	class IPeripherals;
 	class Disassembler;
+	class StateReader;
+	class StateWriter;
 
 	class HDI08
 	{
@@ -122,6 +124,9 @@ namespace dsp56k
 
 		void terminate();
 
+		void saveState(StateWriter& _w) const;
+		bool loadState(StateReader& _r);
+
 		TWord readHDR() const;
 		void writeHDR(TWord _val);
 
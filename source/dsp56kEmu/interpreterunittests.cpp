@@ -10,6 +10,7 @@ namespace dsp56k
 	{
 		testCCCC();
 		testSubr();
+		testPatchExtensionWord();
 		
 		runAllTests();
 	}
@@ -37,6 +38,19 @@ namespace dsp56k
 		verify(!dsp.sr_test(CCR_V));
 	}
 
+	void InterpreterUnitTests::testPatchExtensionWord()
+	{
+		// move #>$111111,x0
+		execOpcode(0x44f400, 0x111111, true);
+		verify(dsp.x0() == 0x111111);
+
+		// the opcode cache entry of the first word must not keep the old extension word
+		dsp.memWriteP(1, 0x222222);
+		dsp.setPC(0);
+		dsp.exec();
+		verify(dsp.x0() == 0x222222);
+	}
+
 	void InterpreterUnitTests::testCCCC()
 	{
 		constexpr auto T=true;
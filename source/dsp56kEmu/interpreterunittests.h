@@ -10,6 +10,7 @@ namespace dsp56k
 		InterpreterUnitTests();
 	private:
 		void testSubr();
+		void testPatchExtensionWord();
 		void testCCCC();
 		void testCCCC(int64_t _val, int64_t _compareValue, bool _lt, bool _le, bool _eq, bool _ge, bool _gt, bool _neq);
 
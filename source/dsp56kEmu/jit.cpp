@@ -2,9 +2,14 @@
 
 #include "dsp.h"
 #include "jitblock.h"
+#include "jitcodecache.h"
+#include "jitcompilerthread.h"
 #include "jitdspmode.h"
 #include "jitprofilingsupport.h"
 #include "jitblockemitter.h"
+#include "jitblockruntimedata.h"
+#include "jitsharedcode.h"
+#include "opcodecycles.h"
 
 #include "asmjit/core/jitruntime.h"
 
@@ -124,6 +129,9 @@ namespace dsp56k
 
 	Jit::~Jit()
 	{
+		// wait for the background compiler before anything is torn down that it might be using
+		m_compilerThread.reset();
+
 		m_chains.clear();
 
 		for (const auto& emitter : m_emitters)
@@ -147,6 +155,158 @@ namespace dsp56k
 		m_currentChain->recreate(_pc);
 	}
 
+	bool Jit::createAsync(const TWord _pc)
+	{
+		const auto config = getConfig(_pc);
+
+		if(!config.asyncCompilation || m_profiling)
+			return false;
+
+		if(m_compilerThread && m_compilerThread->hasResults())
+		{
+			publishAsyncBlocks(_pc);
+
+			if(m_currentChain->getBlock(_pc))
+			{
+				m_currentChain->exec(_pc);
+				return true;
+			}
+		}
+
+		if(m_asyncRejected.erase(_pc))
+			return false;
+
+		if(!canInterpret(_pc, config))
+			return false;
+
+		if(!isAsyncPending(_pc) && !requestAsync(_pc, config))
+			return false;
+
+		interpret(_pc);
+		return true;
+	}
+
+	bool Jit::canInterpret(const TWord _pc, const JitConfig& _config) const
+	{
+		if(_pc < Vba_End || m_dsp.m_processingMode == DSP::FastInterrupt)
+			return false;
+
+		// analyze the first instruction only. Everything that JIT blocks need to know about, such as loops, P memory writes and
+		// volatile P, needs to be generated by the JIT
+		auto config = _config;
+		config.maxInstructionsPerBlock = 1;
+
+		JitBlockInfo info;
+		JitBlock::getInfo(info, m_dsp, _pc, config, m_currentChain->getCache(), m_volatileP, m_loops, m_loopEnds);
+
+		if(info.instructionCount != 1 || any(info.writtenRegs, RegisterMask::LA | RegisterMask::LC))
+			return false;
+
+		switch (info.terminationReason)
+		{
+		case JitBlockInfo::TerminationReason::PcMax:
+		case JitBlockInfo::TerminationReason::Branch:
+		case JitBlockInfo::TerminationReason::PopPC:
+		case JitBlockInfo::TerminationReason::InstructionLimit:
+		case JitBlockInfo::TerminationReason::ModeChange:
+			return true;
+		default:
+			return false;
+		}
+	}
+
+	void Jit::interpret(const TWord _pc)
+	{
+		TWord opA, opB;
+		m_dsp.mem.getOpcode(_pc, opA, opB);
+
+		Instruction instA, instB;
+		m_dsp.opcodes().getInstructionTypes(opA, instA, instB);
+
+		m_dsp.pcCurrentInstruction = _pc;
+		m_dsp.execOp(m_dsp.fetchPC());
+
+		// the interpreter counts instructions only
+		m_dsp.m_cycles += calcCycles(instA, instB, _pc, opA, m_dsp.mem.getBridgedMemoryAddress(), 1);
+
+		checkModeChange();
+	}
+
+	bool Jit::requestAsync(const TWord _pc, const JitConfig& _config)
+	{
+		JitBlockInfo info;
+		JitBlock::getInfo(info, m_dsp, _pc, _config, m_currentChain->getCache(), m_volatileP, m_loops, m_loopEnds);
+
+		// the background compiler does not know about running loops, these blocks are generated synchronously
+		if(!info.instructionCount || info.terminationReason == JitBlockInfo::TerminationReason::LoopEnd || info.hasFlag(JitBlockInfo::Flags::IsLoopBodyBegin))
+			return false;
+
+		if(!m_compilerThread)
+			m_compilerThread.reset(new JitCompilerThread(*this));
+
+		JitCompilerThread::Job job;
+
+		job.pc = _pc;
+		job.stopAt = info.terminationReason == JitBlockInfo::TerminationReason::ExistingCode ? _pc + info.memSize : g_invalidAddress;
+		job.generation = m_asyncGeneration;
+		job.mode = m_currentChain->getMode();
+		job.config = _config;
+		job.volatileP = m_volatileP;
+
+		// the analysis reads the opcode that ends the block and the second word of the last one
+		job.opcodes.create(m_dsp.memory(), _pc, std::min(info.memSize + 2, m_dsp.memory().sizeP() - _pc));
+
+		m_asyncPending.insert(std::make_pair(_pc, _pc + info.memSize));
+
+		m_compilerThread->request(std::move(job));
+
+		return true;
+	}
+
+	bool Jit::isAsyncPending(const TWord _pc) const
+	{
+		auto it = m_asyncPending.upper_bound(_pc);
+
+		if(it == m_asyncPending.begin())
+			return false;
+
+		--it;
+
+		return _pc < it->second;
+	}
+
+	void Jit::publishAsyncBlocks(const TWord _pc)
+	{
+		std::vector<JitCompilerThread::Result> results;
+		m_compilerThread->getResults(results);
+
+		for (const auto& r : results)
+		{
+			m_asyncPending.erase(r.pc);
+
+			if(!r.block)
+			{
+				m_asyncRejected.insert(r.pc);
+				continue;
+			}
+
+			const auto first = r.block->getPCFirst();
+			const auto next = r.block->getPCNext();
+
+			// discard the block if P memory has been modified in the meantime. The same applies if we are currently executing in
+			// the middle of the block, it would be recreated right away
+			const auto itChain = m_chains.find(r.mode);
+
+			if(r.generation == m_asyncGeneration && (_pc <= first || _pc >= next) && itChain != m_chains.end() && itChain->second->addBlock(r.block))
+				continue;
+
+			m_asyncRejected.insert(r.pc);
+
+			releaseCode(r.block->getFunc());
+			releaseBlockRuntimeData(r.block);
+		}
+	}
+
 	void Jit::addLoop(const JitBlockInfo& _info)
 	{
 		if(_info.loopBegin != g_invalidAddress && _info.loopEnd != g_invalidAddress)
@@ -191,6 +351,38 @@ namespace dsp56k
 		m_loops.erase(it);
 	}
 
+	void Jit::restoreLoops(const std::vector<std::pair<TWord, TWord>>& _activeLoops)
+	{
+		// loops are registered by the block that contains the DO instruction. Loops of blocks that do not exist anymore are dropped
+		m_loops.clear();
+		m_loopEnds.clear();
+
+		for (const auto& it : m_chains)
+		{
+			const auto& cache = it.second->getCache();
+
+			for(TWord pc=0; pc<static_cast<TWord>(cache.size()); ++pc)
+			{
+				const auto* block = cache[pc].block;
+
+				if(block && block->getPCFirst() == pc)
+					addLoop(block->getInfo());
+			}
+		}
+
+		// a loop that has been started before the state was saved has no block for its DO instruction
+		for (const auto& [begin, end] : _activeLoops)
+		{
+			if(m_loops.find(begin) != m_loops.end())
+				continue;
+
+			addLoop(begin, end);
+
+			// blocks that have been generated without knowing about the loop might run past its end
+			destroy(end - 1);
+		}
+	}
+
 	void Jit::destroy(TWord _pc)
 	{
 		for (auto& it : m_chains)
@@ -205,12 +397,27 @@ namespace dsp56k
 
 	void Jit::notifyProgramMemWrite(const TWord _offset)
 	{
+		++m_asyncGeneration;
+
 		for (auto& it : m_chains)
 			it.second->notifyPMemWrite(_offset, it.second.get() == m_currentChain);
 
 		m_maxUsedPAddress = std::max(m_maxUsedPAddress, static_cast<size_t>(_offset));
 	}
 
+	void Jit::notifyProgramMemWrite(const TWord _first, const TWord _count)
+	{
+		if(!_count)
+			return;
+
+		++m_asyncGeneration;
+
+		for (auto& it : m_chains)
+			it.second->notifyPMemWrite(_first, _count, it.second.get() == m_currentChain);
+
+		m_maxUsedPAddress = std::max(m_maxUsedPAddress, static_cast<size_t>(_first + _count - 1));
+	}
+
 	void Jit::run(const TWord _pc)
 	{
 		const auto* block = m_currentChain->getBlockUnsafe(_pc);
@@ -248,15 +455,108 @@ namespace dsp56k
 		checkModeChange();
 	}
 
+	uint32_t Jit::getCCROverwrite(const TWord _pc) const
+	{
+		const auto* block = m_currentChain->getBlock(_pc);
+
+		// the entry might be a function that recreates the block or that executes the interpreter first
+		if(!block || block->getPCFirst() != _pc || block->getFunc() != m_currentChain->getFunc(_pc))
+			return 0;
+
+		return block->getInfo().ccrOverwrite;
+	}
+
 	JitConfig Jit::getConfig(const TWord _pc) const
 	{
 		auto& globalConfig = getConfig();
-		if(!globalConfig.getBlockConfig)
-			return globalConfig;
-		auto localConfig = globalConfig.getBlockConfig(_pc);
-		if(localConfig)
-			return *localConfig;
-		return globalConfig;
+
+		std::optional<JitConfig> localConfig;
+		if(globalConfig.getBlockConfig)
+			localConfig = globalConfig.getBlockConfig(_pc);
+
+		JitConfig config = localConfig ? *localConfig : globalConfig;
+
+		if(m_codeCache || m_sharedCode)
+			config.relocatableCode = true;
+
+		if(m_sharedCode)
+			config.sharedCode = true;
+
+		return config;
+	}
+
+	JitRuntime* Jit::getRuntime() const
+	{
+		return m_sharedCode ? &m_sharedCode->getRuntime() : m_rt;
+	}
+
+	void Jit::releaseCode(const TJitFunc _func) const
+	{
+		if(m_sharedCode)
+			m_sharedCode->release(_func);
+		else
+			m_rt->release(_func);
+	}
+
+	void Jit::setSharedCode(std::shared_ptr<JitSharedCode> _sharedCode)
+	{
+		if(_sharedCode == m_sharedCode)
+			return;
+
+		// code of the background compiler and of existing blocks lives in the runtime that is about to be replaced
+		m_compilerThread.reset();
+		m_asyncPending.clear();
+		m_asyncRejected.clear();
+
+		destroyAllBlocks();
+
+		m_sharedCode = std::move(_sharedCode);
+		m_sharedCodeEnvironment = m_sharedCode ? JitCodeCache::hashEnvironment(m_dsp) : 0;
+
+		m_relocationTable.clear();
+		m_runtimeData.m_relocationTable = nullptr;
+	}
+
+	void Jit::setRelocationSlot(const uint32_t _slot, const void* _ptr)
+	{
+		if(_slot >= m_relocationTable.size())
+		{
+			m_relocationTable.resize(std::max(static_cast<size_t>(_slot + 1), m_relocationTable.size() << 1), nullptr);
+			m_runtimeData.m_relocationTable = m_relocationTable.data();
+		}
+
+		m_relocationTable[_slot] = _ptr;
+	}
+
+	void Jit::updateRelocationTable(const JitBlockRuntimeData& _block)
+	{
+		for (const auto& r : _block.getRelocations())
+		{
+			if(r.slot != JitRelocation::InvalidSlot)
+				setRelocationSlot(r.slot, r.ptr);
+		}
+	}
+
+	void Jit::setCodeCache(std::shared_ptr<JitCodeCache> _cache)
+	{
+		if(_cache == m_codeCache)
+			return;
+
+		// existing blocks may have been generated without support for relocation
+		destroyAllBlocks();
+
+		m_codeCache = std::move(_cache);
+		m_codeCacheEnvironment = m_codeCache ? JitCodeCache::hashEnvironment(m_dsp) : 0;
+	}
+
+	JitSingleOpCache::Stats Jit::getSingleOpCacheStats() const
+	{
+		JitSingleOpCache::Stats stats;
+
+		for (const auto& it : m_chains)
+			stats += it.second->getSingleOpCacheStats();
+
+		return stats;
 	}
 
 	void Jit::resetHW()
@@ -358,6 +658,8 @@ namespace dsp56k
 
 	void Jit::destroyAllBlocks()
 	{
+		++m_asyncGeneration;
+
 		m_chains.clear();
 		m_currentChain = nullptr;
 		checkModeChange();
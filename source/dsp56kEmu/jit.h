@@ -4,6 +4,7 @@
 
 #include "types.h"
 
+#include <map>
 #include <set>
 #include <vector>
 #include <unordered_map>
@@ -15,6 +16,7 @@
 #include "jitconfig.h"
 #include "jitdspmode.h"
 #include "jitruntimedata.h"
+#include "jitsingleopcache.h"
 
 namespace asmjit
 {
@@ -30,7 +32,10 @@ namespace dsp56k
 	struct JitBlockInfo;
 	class DSP;
 	class JitBlock;
+	class JitCodeCache;
+	class JitCompilerThread;
 	class JitProfilingSupport;
+	class JitSharedCode;
 	struct JitBlockEmitter;
 
 	class Jit final
@@ -47,6 +52,7 @@ namespace dsp56k
 		}
 
 		void notifyProgramMemWrite(const TWord _offset);
+		void notifyProgramMemWrite(TWord _first, TWord _count);
 
 		void run(TWord _pc);
 		void runCheckPMemWrite(TWord _pc);
@@ -58,15 +64,46 @@ namespace dsp56k
 		void setConfig(const JitConfig& _config) { m_config = _config; }
 		void resetHW();
 		const std::map<TWord, TWord>& getLoops() const { return m_loops; }
+		JitSingleOpCache::Stats getSingleOpCacheStats() const;
+
+		template<typename TFunc> void forEachChain(const TFunc& _func) const
+		{
+			for (const auto& it : m_chains)
+				_func(*it.second);
+		}
+
 		const std::set< TWord>& getLoopEnds() const { return m_loopEnds; }
 
 		static TJitFunc updateRunFunc(const JitCacheEntry& e);
 
-		auto* getRuntime() { return m_rt; }
+		asmjit::ASMJIT_ABI_NAMESPACE::JitRuntime* getRuntime() const;
+
+		// frees the code of a block, either in our runtime or in the shared one
+		void releaseCode(TJitFunc _func) const;
+		JitBlockChain* getCurrentChain() const { return m_currentChain; }
 		auto& getRuntimeData() { return m_runtimeData; }
 		const auto& getVolatileP()  { return m_volatileP; }
 		auto* getProfilingSupport() const { return m_profiling.get(); }
 
+		// attach a cache that is used to store generated code and to reuse it instead of generating it again. Can be shared between multiple DSPs
+		void setCodeCache(std::shared_ptr<JitCodeCache> _cache);
+		JitCodeCache* getCodeCache() const { return m_codeCache.get(); }
+		uint64_t getCodeCacheEnvironment() const { return m_codeCacheEnvironment; }
+
+		// attach code storage that is shared with other DSPs with an identical setup, see JitConfig::sharedCode. Blocks are taken from there
+		// instead of generating them again and newly generated blocks are published to it. Takes precedence over a code cache
+		void setSharedCode(std::shared_ptr<JitSharedCode> _sharedCode);
+		JitSharedCode* getSharedCode() const { return m_sharedCode.get(); }
+		uint64_t getSharedCodeEnvironment() const { return m_sharedCodeEnvironment; }
+
+		// the relocation table holds the host pointers of this DSP that shared code reads
+		void setRelocationSlot(uint32_t _slot, const void* _ptr);
+		void updateRelocationTable(const JitBlockRuntimeData& _block);
+
+		// set while an AotRuntime generates code, i.e. the generated code is not the code that is executed next
+		void setAheadOfTime(const bool _aot) { m_aheadOfTime = _aot; }
+		bool isAheadOfTime() const { return m_aheadOfTime; }
+
 		bool isVolatileP(const TWord _pc) const
 		{
 			return m_volatileP.find(_pc) != m_volatileP.end();
@@ -75,16 +112,25 @@ namespace dsp56k
 		void create(TWord _pc, bool _execute);
 		void recreate(TWord _pc);
 
+		// returns true if the block has been requested from the background compiler and the instruction at _pc has been interpreted instead
+		bool createAsync(TWord _pc);
+
 		void addLoop(const JitBlockInfo& _info);
 		void addLoop(TWord _begin, TWord _end);
 		void removeLoop(const JitBlockInfo& _info);
 		void removeLoop(TWord _begin);
 
+		// rebuilds the known loops from the existing blocks plus the loops that are active in a state that has been loaded
+		void restoreLoops(const std::vector<std::pair<TWord, TWord>>& _activeLoops);
+
 		void destroy(TWord _pc);
 		void destroyToRecreate(TWord _pc);
 
 		void checkModeChange();
 
+		// CCR bits that the block at _pc overwrites before reading them, zero if the block is not executed directly
+		uint32_t getCCROverwrite(TWord _pc) const;
+
 		void onDebuggerAttached(DebuggerInterface& _debugger) const;
 
 		void destroyAllBlocks();
@@ -100,6 +146,12 @@ namespace dsp56k
 	private:
 		void checkPMemWrite();
 
+		bool canInterpret(TWord _pc, const JitConfig& _config) const;
+		void interpret(TWord _pc);
+		bool requestAsync(TWord _pc, const JitConfig& _config);
+		bool isAsyncPending(TWord _pc) const;
+		void publishAsyncBlocks(TWord _pc);
+
 		DSP& m_dsp;
 
 		asmjit::ASMJIT_ABI_NAMESPACE::JitRuntime* m_rt = nullptr;
@@ -119,6 +171,18 @@ namespace dsp56k
 
 		std::unique_ptr<JitProfilingSupport> m_profiling;
 
+		std::shared_ptr<JitCodeCache> m_codeCache;
+		uint64_t m_codeCacheEnvironment = 0;
+
+		std::shared_ptr<JitSharedCode> m_sharedCode;
+		uint64_t m_sharedCodeEnvironment = 0;
+		std::vector<const void*> m_relocationTable;
+
+		std::unique_ptr<JitCompilerThread> m_compilerThread;
+		std::map<TWord, TWord> m_asyncPending;		// first => next PC of blocks that are generated in the background
+		std::set<TWord> m_asyncRejected;			// the background result could not be used, generate synchronously next time
+		uint64_t m_asyncGeneration = 0;				// incremented whenever results of the background compiler become invalid
+
 		std::vector<JitBlockEmitter*> m_emitters;
 		std::vector<JitBlockRuntimeData*> m_blockRuntimeDatas;
 
@@ -126,6 +190,8 @@ namespace dsp56k
 
 		size_t m_maxUsedPAddress = 0;
 
+		bool m_aheadOfTime = false;
+
 		// the following data is accessed by JIT code at runtime, it NEEDS to be put last into this struct to be
 		// able to use ARM relative addressing, see member ordering in dsp.h
 		JitRuntimeData m_runtimeData;
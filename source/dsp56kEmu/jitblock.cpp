@@ -5,7 +5,11 @@
 
 #include "jitblockinfo.h"
 #include "jitblockruntimedata.h"
+#include "jitcodecache.h"
+#include "jitopcodesnapshot.h"
 #include "jitops.h"
+#include "jitoptimizer.h"
+#include "jitsharedcode.h"
 #include "memory.h"
 #include "opcodecycles.h"
 
@@ -27,7 +31,7 @@ namespace dsp56k
 
 	JitBlock::~JitBlock() = default;
 
-	void JitBlock::getInfo(JitBlockInfo& _info, const DSP& _dsp, const TWord _pc, const JitConfig& _config, const std::vector<JitCacheEntry>& _cache, const std::set<TWord>& _volatileP, const std::map<TWord, TWord>& _loopStarts, const std::set<TWord>& _loopEnds)
+	void JitBlock::getInfo(JitBlockInfo& _info, const DSP& _dsp, const TWord _pc, const JitConfig& _config, const std::vector<JitCacheEntry>& _cache, const std::set<TWord>& _volatileP, const std::map<TWord, TWord>& _loopStarts, const std::set<TWord>& _loopEnds, const JitOpcodeSnapshot* _opcodes/* = nullptr*/)
 	{
 		const auto& opcodes = _dsp.opcodes();
 
@@ -53,12 +57,12 @@ namespace dsp56k
 
 		if(_loopStarts.find(_pc - 2) != _loopStarts.end())
 		{
-			assert(_pc == hiword(_dsp.regs().ss[_dsp.ssIndex()]).toWord());
+			assert(_dsp.getJit().isAheadOfTime() || _pc == hiword(_dsp.regs().ss[_dsp.ssIndex()]).toWord());
 			_info.addFlag(JitBlockInfo::Flags::IsLoopBodyBegin);
 		}
 		else
 		{
-			assert(_pc == 0 || _pc != hiword(_dsp.regs().ss[_dsp.ssIndex()]).toWord());
+			assert(_pc == 0 || _dsp.getJit().isAheadOfTime() || _pc != hiword(_dsp.regs().ss[_dsp.ssIndex()]).toWord());
 		}
 
 		auto writesM = RegisterMask::None;
@@ -83,7 +87,11 @@ namespace dsp56k
 
 			TWord opA;
 			TWord opB;
-			_dsp.memory().getOpcode(pc, opA, opB);
+
+			if(_opcodes)
+				_opcodes->getOpcode(pc, opA, opB);
+			else
+				_dsp.memory().getOpcode(pc, opA, opB);
 
 			Instruction instA, instB;
 
@@ -198,7 +206,7 @@ namespace dsp56k
 			// always terminate block if loop end has reached
 			if(_loopEnds.find(_pc + numWords) != _loopEnds.end())
 			{
-				assert((_pc + numWords) == static_cast<TWord>(_dsp.regs().la.var + 1));
+				assert(_dsp.getJit().isAheadOfTime() || (_pc + numWords) == static_cast<TWord>(_dsp.regs().la.var + 1));
 				terminationReason = JitBlockInfo::TerminationReason::LoopEnd;
 				break;
 			}
@@ -267,7 +275,7 @@ namespace dsp56k
 
 		uint32_t blockFlags = 0;
 
-		getInfo(info, dsp(), _pc, m_config, _cache, _volatileP, _loopStarts, _loopEnds);
+		getInfo(info, dsp(), _pc, m_config, _cache, _volatileP, _loopStarts, _loopEnds, m_opcodes);
 
 		const auto pcNext = _pc + info.memSize;
 
@@ -301,7 +309,7 @@ namespace dsp56k
 		{
 			opPC = _pc + pMemSize;
 
-			m_dsp.memory().getOpcode(opPC, opA, opB);
+			getOpcode(opPC, opA, opB);
 
 #if defined(_DEBUG)
 			m_dsp.disassembler().disassemble(opDisasm, opA, opB, 0, 0, 0);
@@ -456,6 +464,8 @@ namespace dsp56k
 		m_asm.setCursor(cursorInsertIncreaseInstructionCount);
 		increaseInstructionCount(asmjit::Imm(_rt.getEncodedInstructionCount()));
 		increaseCycleCount(asmjit::Imm(_rt.getEncodedCycleCount()));
+		if(m_config.blockProfiling)
+			increaseExecutionCount(_rt);
 		m_asm.setCursor(m_asm.lastNode());
 
 		auto jumpIfLoop = [&](const asmjit::Label& _ifTrue, const JitReg32& _regPC, const JitReg32& _regLC, const JitReg32& _temp)
@@ -610,7 +620,19 @@ namespace dsp56k
 
 				JitOps op(*this, _rt, fastInterruptMode);
 
-				op.updateDirtyCCR(ccrDirty);
+				if(!child && !nonBranchChild && !isLoopBody)
+				{
+					// The block returns to the C++ code. Bits that only depend on the ALU result are computed on demand, i.e. not
+					// at all if the next block overwrites them, see DSP::updateDirtyJitCCR. Loop bodies are excluded as they jump
+					// back to their beginning without returning
+					constexpr auto deferrable = static_cast<CCRMask>(CCR_E | CCR_U | CCR_N | CCR_Z);
+					op.updateDirtyCCR(static_cast<CCRMask>(ccrDirty & ~deferrable));
+					op.deferDirtyCCR(static_cast<CCRMask>(ccrDirty & deferrable));
+				}
+				else
+				{
+					op.updateDirtyCCR(ccrDirty);
+				}
 
 				m_asm.bind(skipCCRupdate);
 
@@ -732,6 +754,14 @@ namespace dsp56k
 
 		profileEnd(lj);
 
+		emitRelocations();
+
+		if(m_config.optimizeJitCode)
+		{
+			JitOptimizer optimizer(m_asm);
+			_rt.m_optimizerRemovedCount = optimizer.optimize().total();
+		}
+
 		m_currentJitBlockRuntimeData = nullptr;
 		return true;
 	}
@@ -791,6 +821,25 @@ namespace dsp56k
 #endif
 	}
 
+	void JitBlock::increaseExecutionCount(const JitBlockRuntimeData& _rt)
+	{
+		// the counter is not part of the DSP object, it needs to be addressed via a host pointer
+		const RegScratch scratch(*this);
+
+		movHostPtr(scratch.get(), &_rt.getExecutionCount());
+
+#ifdef HAVE_ARM64
+		// the second argument of a JIT block function is unused and there are no DSP registers allocated yet at the start of a block
+		const auto temp = r64(g_funcArgGPs[1]);
+
+		m_asm.ldr(temp, asmjit::arm::ptr(scratch.get()));
+		m_asm.add(temp, temp, asmjit::Imm(1));
+		m_asm.str(temp, asmjit::arm::ptr(scratch.get()));
+#else
+		m_asm.inc(asmjit::x86::qword_ptr(scratch.get()));
+#endif
+	}
+
 	AddressingMode JitBlock::getAddressingMode(const uint32_t _aguIndex) const
 	{
 		const auto* mode = getMode();
@@ -832,16 +881,194 @@ namespace dsp56k
 	JitReg64 JitBlock::getJumpTarget(const JitReg64& _dst, const JitBlockRuntimeData* _child) const
 	{
 		auto* p = asmjit::func_as_ptr(_child->getFunc());
-		const auto addr = reinterpret_cast<uint64_t>(p);
 
-		if(const auto offset = Jitmem::pointerOffset(p, &m_dsp.regs()))
+		if(m_config.relocatableCode)
+		{
+			JitRelocation r;
+			r.type = JitRelocation::Type::Block;
+			r.ptr = p;
+			r.arg = _child->getPCFirst();
+			r.ccrOverwrite = _child->getInfo().ccrOverwrite;
+			movHostPtr(_dst, std::move(r));
+		}
+		else if(const auto offset = Jitmem::pointerOffset(p, &m_dsp.regs()))
+		{
 			m_asm.lea_(_dst, regDspPtr, offset);
+		}
 		else
-			m_asm.mov(_dst, asmjit::Imm(addr));
+		{
+			m_asm.mov(_dst, asmjit::Imm(reinterpret_cast<uint64_t>(p)));
+		}
 
 		return _dst;
 	}
 
+	bool JitBlock::canAddressRelativeToDsp(const void* _ptr) const
+	{
+		if(!m_config.relocatableCode)
+			return true;
+
+		const auto* p = static_cast<const uint8_t*>(_ptr);
+		const auto* dsp = reinterpret_cast<const uint8_t*>(&m_dsp);
+
+		return p >= dsp && p < dsp + sizeof(DSP);
+	}
+
+	void JitBlock::movHostPtr(const JitReg64& _dst, const void* _ptr) const
+	{
+		JitRelocation r;
+		r.ptr = _ptr;
+		movHostPtr(_dst, std::move(r));
+	}
+
+	void JitBlock::movHostPtr(const JitReg64& _dst, JitRelocation&& _reloc) const
+	{
+		if(!m_config.relocatableCode || !m_currentJitBlockRuntimeData)
+		{
+			m_asm.mov(_dst, asmjit::Imm(reinterpret_cast<uint64_t>(_reloc.ptr)));
+			return;
+		}
+
+		if(m_config.sharedCode)
+		{
+			movSharedHostPtr(_dst, std::move(_reloc));
+			return;
+		}
+
+		const auto label = addRelocation(std::move(_reloc));
+
+#ifdef HAVE_ARM64
+		m_asm.ldr(_dst, asmjit::arm::ptr(label));
+#else
+		m_asm.mov(_dst, asmjit::x86::qword_ptr(label));
+#endif
+	}
+
+	void JitBlock::getOpcode(const TWord _pc, TWord& _wordA, TWord& _wordB) const
+	{
+		if(m_opcodes)
+			m_opcodes->getOpcode(_pc, _wordA, _wordB);
+		else
+			m_dsp.memory().getOpcode(_pc, _wordA, _wordB);
+	}
+
+	void JitBlock::callHostFunc(const void* _funcAsPtr) const
+	{
+		// host functions are at the same address for all DSP instances
+		if(!m_config.relocatableCode || m_config.sharedCode || !m_currentJitBlockRuntimeData)
+		{
+			m_asm.call(_funcAsPtr);
+			return;
+		}
+
+		JitRelocation r;
+		r.type = JitRelocation::Type::Code;
+		r.ptr = _funcAsPtr;
+
+#ifdef HAVE_ARM64
+		movHostPtr(asmjit::a64::regs::x30, std::move(r));
+		m_asm.blr(asmjit::a64::regs::x30);
+#else
+		m_asm.call(asmjit::x86::qword_ptr(addRelocation(std::move(r))));
+#endif
+	}
+
+	asmjit::Label JitBlock::addRelocation(JitRelocation&& _reloc) const
+	{
+		auto& relocs = m_currentJitBlockRuntimeData->m_relocations;
+
+		for (const auto& r : relocs)
+		{
+			if(r.type == _reloc.type && r.ptr == _reloc.ptr && r.arg == _reloc.arg)
+				return r.label;
+		}
+
+		_reloc.label = m_asm.newLabel();
+		relocs.emplace_back(std::move(_reloc));
+		return relocs.back().label;
+	}
+
+	void JitBlock::movSharedHostPtr(const JitReg64& _dst, JitRelocation&& _reloc) const
+	{
+		const auto* ptr = _reloc.ptr;
+
+		const auto slot = _reloc.type == JitRelocation::Type::Code ? JitRelocation::InvalidSlot : addRelocationSlot(std::move(_reloc));
+
+		// host functions are at the same address for all instances. Pointers into unknown host memory make the block private to this instance
+		if(slot == JitRelocation::InvalidSlot)
+		{
+			m_asm.mov(_dst, asmjit::Imm(reinterpret_cast<uint64_t>(ptr)));
+			return;
+		}
+
+		// the table is reallocated when it grows, it needs to be loaded every time
+		const auto table = m_dspRegPool.makeDspPtr(&m_runtimeData.m_relocationTable, sizeof(uint64_t));
+		assert(isValid(table));
+
+		auto offset = slot * static_cast<uint32_t>(sizeof(uint64_t));
+
+#ifdef HAVE_ARM64
+		m_asm.ldr(_dst, table);
+
+		// ldr can encode scaled offsets up to 32760 only
+		if(offset >= 0x1000)
+		{
+			m_asm.add(_dst, _dst, asmjit::Imm(offset & ~0xfffu));
+			offset &= 0xfff;
+		}
+
+		m_asm.ldr(_dst, asmjit::arm::ptr(_dst, offset));
+#else
+		m_asm.mov(_dst, table);
+		m_asm.mov(_dst, asmjit::x86::qword_ptr(_dst, static_cast<int32_t>(offset)));
+#endif
+	}
+
+	uint32_t JitBlock::addRelocationSlot(JitRelocation&& _reloc) const
+	{
+		auto& relocs = m_currentJitBlockRuntimeData->m_relocations;
+
+		for (const auto& r : relocs)
+		{
+			if(r.type == _reloc.type && r.ptr == _reloc.ptr && r.arg == _reloc.arg)
+				return r.slot;
+		}
+
+		JitCodeCache::Relocation desc;
+
+		auto* sharedCode = m_dsp.getJit().getSharedCode();
+
+		if(sharedCode && JitCodeCache::describe(desc, _reloc, m_dsp))
+		{
+			// child blocks are per chain, a block in another DSP mode is a different one
+			if(_reloc.type == JitRelocation::Type::Block)
+				desc.area = getMode()->get();
+
+			_reloc.slot = sharedCode->getSlot(desc);
+		}
+
+		relocs.emplace_back(std::move(_reloc));
+		return relocs.back().slot;
+	}
+
+	void JitBlock::emitRelocations() const
+	{
+		const auto& relocs = m_currentJitBlockRuntimeData->m_relocations;
+
+		// shared code has no constant pool
+		if(relocs.empty() || m_config.sharedCode)
+			return;
+
+		// constant pool, placed behind the last instruction of the block
+		m_asm.align(asmjit::AlignMode::kData, sizeof(uint64_t));
+
+		for (const auto& r : relocs)
+		{
+			m_asm.bind(r.label);
+			m_asm.embedUInt64(reinterpret_cast<uint64_t>(r.ptr));
+		}
+	}
+
 	void JitBlock::jumpToChild(const JitBlockRuntimeData* _child, const JitCondCode _cc/* = JitCondCode::kMaxValue*/) const
 	{
 		const auto tempReg = r64(g_funcArgGPs[1]);
@@ -5,11 +5,13 @@
 #include "jitdspregpool.h"
 #include "jitmem.h"
 #include "jitregtracker.h"
+#include "jitrelocation.h"
 #include "jitruntimedata.h"
 #include "jitstackhelper.h"
 #include "jittypes.h"
 #include "jitconfig.h"
 
+#include <map>
 #include <vector>
 #include <set>
 
@@ -30,6 +32,7 @@ namespace dsp56k
 	class JitBlockChain;
 	class JitBlockRuntimeData;
 	class JitDspMode;
+	class JitOpcodeSnapshot;
 
 	class JitBlock final
 	{
@@ -38,7 +41,8 @@ namespace dsp56k
 		JitBlock(JitEmitter& _a, DSP& _dsp, JitRuntimeData& _runtimeData, JitConfig&& _config);
 		~JitBlock();
 
-		static void getInfo(JitBlockInfo& _info, const DSP& _dsp, TWord _pc, const JitConfig& _config, const std::vector<JitCacheEntry>& _cache, const std::set<TWord>& _volatileP, const std::map<TWord, TWord>& _loopStarts, const std::set<TWord>& _loopEnds);
+		// if _opcodes is set, opcodes are read from there instead of P memory
+		static void getInfo(JitBlockInfo& _info, const DSP& _dsp, TWord _pc, const JitConfig& _config, const std::vector<JitCacheEntry>& _cache, const std::set<TWord>& _volatileP, const std::map<TWord, TWord>& _loopStarts, const std::set<TWord>& _loopEnds, const JitOpcodeSnapshot* _opcodes = nullptr);
 
 		bool emit(JitBlockRuntimeData& _rt, JitBlockChain* _chain, TWord _pc, const std::vector<JitCacheEntry>& _cache, const std::set<TWord>& _volatileP, const std::map<TWord, TWord>& _loopStarts, const std::set<TWord>& _loopEnds, bool _profilingSupport);
 
@@ -57,19 +61,33 @@ namespace dsp56k
 		// JIT code writes these
 		uint32_t& pMemWriteAddress() { return m_runtimeData.m_pMemWriteAddress; }
 		uint32_t& pMemWriteValue() { return m_runtimeData.m_pMemWriteValue; }
+		uint64_t& ccrPendingAlu() { return m_runtimeData.m_ccrPendingAlu; }
+		uint32_t& ccrPendingMask() { return m_runtimeData.m_ccrPendingMask; }
 
 		void setNextPC(const DspValue& _pc);
 
 		void increaseInstructionCount(const asmjit::Operand& _count);
 		void increaseCycleCount(const asmjit::Operand& _count);
 		void increaseUint64(const asmjit::Operand& _count, const uint64_t& _target);
+		void increaseExecutionCount(const JitBlockRuntimeData& _rt);
 
 		const JitConfig& getConfig() const { return m_config; }
 
+		// relocatable code may only use regDspPtr-relative addressing for data that is part of the DSP object
+		bool canAddressRelativeToDsp(const void* _ptr) const;
+
+		void movHostPtr(const JitReg64& _dst, const void* _ptr) const;
+		void movHostPtr(const JitReg64& _dst, JitRelocation&& _reloc) const;
+		void callHostFunc(const void* _funcAsPtr) const;
+
 		AddressingMode getAddressingMode(uint32_t _aguIndex) const;
 		const JitDspMode* getMode() const;
 		void setMode(JitDspMode* _mode);
 
+		// code is generated from a copy of P memory instead of P memory itself, used by the background compiler
+		void setOpcodeSnapshot(const JitOpcodeSnapshot* _opcodes) { m_opcodes = _opcodes; }
+		void getOpcode(TWord _pc, TWord& _wordA, TWord& _wordB) const;
+
 		void lockScratch()
 		{
 			assert(!m_scratchLocked && "scratch reg is already locked");
@@ -108,6 +126,11 @@ namespace dsp56k
 
 		JitReg64 getJumpTarget(const JitReg64& _dst, const JitBlockRuntimeData* _child) const;
 
+		asmjit::Label addRelocation(JitRelocation&& _reloc) const;
+		void movSharedHostPtr(const JitReg64& _dst, JitRelocation&& _reloc) const;
+		uint32_t addRelocationSlot(JitRelocation&& _reloc) const;
+		void emitRelocations() const;
+
 		void jumpToChild(const JitBlockRuntimeData* _child, JitCondCode _cc = JitCondCode::kMaxValue) const;
 		void jumpToOneOf(JitCondCode _ccTrue, const JitBlockRuntimeData* _childTrue, const JitBlockRuntimeData* _childFalse) const;
 
@@ -130,5 +153,6 @@ namespace dsp56k
 
 		JitDspMode* m_mode = nullptr;
 		JitBlockRuntimeData* m_currentJitBlockRuntimeData = nullptr;
+		const JitOpcodeSnapshot* m_opcodes = nullptr;
 	};
 }
@@ -1,11 +1,17 @@
 #include "jitblockchain.h"
 
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
 #include "dsp.h"
 #include "jitasmjithelpers.h"
 #include "jitblockruntimedata.h"
 #include "jitblock.h"
+#include "jitcodecache.h"
 #include "jitemitter.h"
 #include "jitprofilingsupport.h"
+#include "jitsharedcode.h"
 #include "asmjit/core/jitruntime.h"
 #include "jitblockemitter.h"
 
@@ -32,20 +38,17 @@ namespace dsp56k
 
 	JitBlockChain::~JitBlockChain()
 	{
-		for (auto& e : m_jitCache)
+		for (const auto& e : m_jitCache)
 		{
 			if(e.block)
 				destroy(e.block);
-
-			if(e.singleOpCache)
-			{
-				for (const auto& it : *e.singleOpCache)
-					release(it.second);
-
-				e.singleOpCache->clear();
-			}
 		}
 
+		m_singleOpCache.clear([this](JitBlockRuntimeData* _block)
+		{
+			release(_block);
+		});
+
 		m_jitCache.clear();
 	}
 
@@ -103,9 +106,7 @@ namespace dsp56k
 
 		ensureCacheSize(_pc+1);
 
-		auto& cacheEntry = m_jitCache[_pc];
-
-		if(cacheEntry.singleOpCache)
+		if(!m_singleOpCache.empty())
 		{
 			TWord opA;
 			TWord opB;
@@ -114,38 +115,52 @@ namespace dsp56k
 			// try to find two-word op first
 			auto key = JitBlockRuntimeData::getSingleOpCacheKey(opA, opB);
 
-			auto it = cacheEntry.findSingleOp(key);
+			auto* block = m_singleOpCache.find(_pc, key);
 
 			uint32_t cacheEntryLen = 2;
 
 			// if not found, try one-word op
-			if(!cacheEntry.isValid(it))
+			if(!block)
 			{
 				key = JitBlockRuntimeData::getSingleOpCacheKey(opA, JitBlockRuntimeData::SingleOpCacheIgnoreWordB);
-				it = cacheEntry.findSingleOp(key);
+				block = m_singleOpCache.find(_pc, key);
 				cacheEntryLen = 1;
 			}
 
-			if(cacheEntry.isValid(it))
+			if(block && (cacheEntryLen == 1 || m_jitCache[_pc+1].block == nullptr))
 			{
-				if(cacheEntryLen == 1 || m_jitCache[_pc+1].block == nullptr)
-				{
-//					LOG("Returning single-op " << HEX(opA) << " at PC " << HEX(_pc));
-					assert(cacheEntry.block == nullptr);
+//				LOG("Returning single-op " << HEX(opA) << " at PC " << HEX(_pc));
+				assert(m_jitCache[_pc].block == nullptr);
 
-					cacheEntry.block = it->second;
-					cacheEntry.removeSingleOp(it);
+				m_singleOpCache.remove(_pc, key);
+				m_singleOpCache.countLookup(true);
 
-					occupyArea(cacheEntry.block);
+				occupyArea(block);
 
-					if(_execute)
-						exec(_pc);
-					return;
-				}
+				if(_execute)
+					exec(_pc);
+				return;
 			}
+
+			m_singleOpCache.countLookup(false);
+		}
+
+		// code is interpreted while the block is generated in the background
+		if(_execute && m_jit.createAsync(_pc))
+			return;
+
+		// child blocks are generated recursively, only the outermost block is measured to not count them twice
+		if(m_generatingBlocks.empty())
+		{
+			const auto t = std::chrono::high_resolution_clock::now();
+			emit(_pc);
+			m_compileTimeNs += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::high_resolution_clock::now() - t).count();
+		}
+		else
+		{
+			emit(_pc);
 		}
 
-		emit(_pc);
 		if(_execute)
 			exec(_pc);
 	}
@@ -157,6 +172,24 @@ namespace dsp56k
 			ensureFuncSize(_addr);
 	}
 
+	void JitBlockChain::notifyPMemWrite(const TWord _first, const TWord _count, const bool _isCurrentChain)
+	{
+		if(!_count)
+			return;
+
+		const auto end = std::min(static_cast<size_t>(_first) + _count, m_jitCache.size());
+
+		// destroying a block unoccupies all addresses it covers, the following addresses of the same block are empty afterwards
+		for(size_t pc = _first; pc < end; ++pc)
+		{
+			if(auto* b = m_jitCache[pc].block)
+				destroy(b);
+		}
+
+		if(_isCurrentChain)
+			ensureFuncSize(_first + _count - 1);
+	}
+
 	void JitBlockChain::destroyParents(JitBlockRuntimeData* _block)
 	{
 		for (const auto parent : _block->getParents())
@@ -170,22 +203,14 @@ namespace dsp56k
 				destroy(e.block);
 
 			// single op cached entries that are calling the child block need to go, too. They have been created at a time when _block was not a volatile P block yet
-			if(e.singleOpCache)
+			m_singleOpCache.removeIf(parent, [&](const JitBlockRuntimeData* _b)
 			{
-				for(auto it = e.singleOpCache->begin(); it != e.singleOpCache->end();)
-				{
-					auto* b = it->second;
-					if (b->getChild() == _block->getPCFirst() || b->getNonBranchChild() == _block->getPCFirst())
-					{
-						release(b);
-						e.singleOpCache->erase(it++);
-					}
-					else
-					{
-						++it;
-					}
-				}
-			}
+				return _b->getChild() == _block->getPCFirst() || _b->getNonBranchChild() == _block->getPCFirst();
+			},
+			[this](JitBlockRuntimeData* _b)
+			{
+				release(_b);
+			});
 		}
 		_block->clearParents();
 	}
@@ -200,14 +225,14 @@ namespace dsp56k
 		{
 			// if a single-word-op, cache it
 			const auto first = _block->getPCFirst();
-			auto& cacheEntry = m_jitCache[first];
 			const auto op = _block->getSingleOpCacheKey();
 
-			if(!cacheEntry.containsSingleOp(op))
+			if(!m_singleOpCache.contains(first, op))
 			{
 //				LOG("Caching single-op block " << HEX(op) << " at PC " << HEX(first));
 
-				cacheEntry.addSingleOp(op, _block);
+				if(auto* evicted = m_singleOpCache.insert(first, op, _block))
+					release(evicted);
 				return;
 			}
 		}
@@ -247,7 +272,7 @@ namespace dsp56k
 #endif
 		assert(m_codeSize >= _block->codeSize());
 		m_codeSize -= _block->codeSize();
-		m_jit.getRuntime()->release(_block->getFunc());
+		m_jit.releaseCode(_block->getFunc());
 
 		m_jit.releaseBlockRuntimeData(_block);
 
@@ -324,6 +349,23 @@ namespace dsp56k
 
 	JitBlockRuntimeData* JitBlockChain::emit(TWord _pc)
 	{
+		auto* sharedCode = m_jit.getSharedCode();
+		auto* codeCache = sharedCode ? nullptr : m_jit.getCodeCache();
+		auto* profiling = m_jit.getProfilingSupport();
+
+		// cached code has no execution counters
+		if(codeCache && !profiling && !m_jit.getConfig().blockProfiling)
+		{
+			if(auto* b = loadFromCodeCache(*codeCache, _pc))
+				return b;
+		}
+
+		if(sharedCode && !profiling && !m_jit.getConfig().blockProfiling)
+		{
+			if(auto* b = loadFromSharedCode(*sharedCode, _pc))
+				return b;
+		}
+
 		auto* emitter = m_jit.acquireEmitter(_pc);
 
 //		m_logger->addFlags(asmjit::FormatFlags::kHexImms | /*asmjit::FormatFlags::kHexOffsets |*/ asmjit::FormatFlags::kMachineCode);
@@ -335,13 +377,9 @@ namespace dsp56k
 			emitter->emitter.addDiagnosticOptions(asmjit::DiagnosticOptions::kValidateAssembler);
 		}
 
-		emitter->codeHolder.setErrorHandler(m_errorHandler.get());
-		emitter->codeHolder.init(m_jit.getRuntime()->environment());
-		emitter->codeHolder.attach(&emitter->emitter);
-
 		auto* b = m_jit.acquireBlockRuntimeData();
 
-		m_errorHandler->setBlock(b);
+		initEmitter(emitter, b);
 
 		m_generatingBlocks.insert(std::make_pair(_pc, b));
 
@@ -372,6 +410,25 @@ namespace dsp56k
 
 		b->finalize(func, emitter->codeHolder);
 		m_codeSize += emitter->codeHolder.codeSize();
+		m_optimizerRemovedCount += b->getOptimizerRemovedCount();
+
+		if(codeCache && !profiling && emitter->block.getConfig().relocatableCode && !emitter->block.getConfig().blockProfiling)
+		{
+			const auto key = JitCodeCache::createKey(m_jit.dsp(), m_jit.getCodeCacheEnvironment(), b->getInfo(), m_mode.get(), emitter->block.getConfig());
+			codeCache->store(key, *b, m_jit.dsp());
+		}
+
+		if(sharedCode)
+		{
+			m_jit.updateRelocationTable(*b);
+
+			// blocks with execution counters point to data of this instance, they are not shared
+			if(!profiling && emitter->block.getConfig().sharedCode)
+			{
+				const auto key = JitCodeCache::createKey(m_jit.dsp(), m_jit.getSharedCodeEnvironment(), b->getInfo(), m_mode.get(), emitter->block.getConfig());
+				sharedCode->publish(key, *b, m_jit.dsp());
+			}
+		}
 
 		m_jit.releaseEmitter(emitter);
 
@@ -379,10 +436,252 @@ namespace dsp56k
 
 		occupyArea(b);
 
-		auto* profiling = m_jit.getProfilingSupport();
 		if (profiling)
 			profiling->addJitBlock(*b);
 
+#if DSP56300_DEBUGGER
+		auto* d = m_jit.dsp().getDebugger();
+		if(d)
+			d->onJitBlockCreated(m_mode, b);
+#endif
+		return b;
+	}
+
+	bool JitBlockChain::addBlock(JitBlockRuntimeData* _block)
+	{
+		// the block has been generated on another thread, it can only be used if the block analysis is still the same
+		const auto pc = _block->getPCFirst();
+
+		JitBlockInfo info;
+		JitBlock::getInfo(info, m_jit.dsp(), pc, m_jit.getConfig(pc), m_jitCache, m_jit.getVolatileP(), m_jit.getLoops(), m_jit.getLoopEnds());
+
+		if(!_block->getInfo().matches(info))
+			return false;
+
+		m_jit.updateRelocationTable(*_block);
+
+		m_codeSize += _block->codeSize();
+		m_optimizerRemovedCount += _block->getOptimizerRemovedCount();
+
+		occupyArea(_block);
+
+#if DSP56300_DEBUGGER
+		auto* d = m_jit.dsp().getDebugger();
+		if(d)
+			d->onJitBlockCreated(m_mode, _block);
+#endif
+		return true;
+	}
+
+	void JitBlockChain::initEmitter(JitBlockEmitter* _emitter, JitBlockRuntimeData* _block) const
+	{
+		_emitter->codeHolder.setErrorHandler(m_errorHandler.get());
+		_emitter->codeHolder.init(m_jit.getRuntime()->environment());
+		_emitter->codeHolder.attach(&_emitter->emitter);
+
+		m_errorHandler->setBlock(_block);
+	}
+
+	JitBlockRuntimeData* JitBlockChain::loadFromCodeCache(JitCodeCache& _cache, const TWord _pc)
+	{
+		const auto config = m_jit.getConfig(_pc);
+
+		JitBlockInfo info;
+		JitBlock::getInfo(info, m_jit.dsp(), _pc, config, m_jitCache, m_jit.getVolatileP(), m_jit.getLoops(), m_jit.getLoopEnds());
+
+		const auto entry = _cache.find(JitCodeCache::createKey(m_jit.dsp(), m_jit.getCodeCacheEnvironment(), info, m_mode.get(), config));
+
+		// the block analysis depends on volatile P and running loops, too, it needs to match
+		if(!entry || !entry->info.matches(info) || !JitCodeCache::matchesOpcodes(*entry, m_jit.dsp()))
+		{
+			_cache.countLookup(false);
+			return nullptr;
+		}
+
+		auto* b = m_jit.acquireBlockRuntimeData();
+
+		JitCodeCache::restore(*b, *entry);
+
+		// patch the constant pool of the block with the host addresses of this DSP
+		std::vector<uint8_t> code(entry->code);
+		std::vector<JitBlockRuntimeData*> children;
+
+		b->setGenerating(true);
+		m_generatingBlocks.insert(std::make_pair(_pc, b));
+
+		bool success = true;
+
+		for (const auto& r : entry->relocations)
+		{
+			const void* ptr = nullptr;
+
+			if(r.base == JitCodeCache::RelocationBase::Block)
+			{
+				// the parent omits CCR updates that are overwritten by the child, the child needs to do the same as before
+				auto* child = getChildBlock(b, r.arg);
+
+				if(child && child->getFunc() && child->getInfo().ccrOverwrite == r.check)
+				{
+					children.push_back(child);
+					ptr = asmjit::func_as_ptr(child->getFunc());
+				}
+			}
+			else
+			{
+				ptr = JitCodeCache::resolve(r, m_jit.dsp());
+			}
+
+			if(!ptr)
+			{
+				success = false;
+				break;
+			}
+
+			const auto value = reinterpret_cast<uint64_t>(ptr);
+			memcpy(&code[r.codeOffset], &value, sizeof(value));
+		}
+
+		m_generatingBlocks.erase(_pc);
+		b->setGenerating(false);
+
+		if(!success)
+		{
+			abortLoadFromCodeCache(b);
+			return nullptr;
+		}
+
+		auto* emitter = m_jit.acquireEmitter(_pc);
+
+		initEmitter(emitter, b);
+
+		emitter->emitter.embed(code.data(), code.size());
+		emitter->emitter.finalize();
+
+		TJitFunc func;
+
+		const auto err = m_jit.getRuntime()->add(&func, &emitter->codeHolder);
+
+		if(err)
+		{
+			const auto* const errString = asmjit::DebugUtils::errorAsString(err);
+			LOG("JIT failed to add cached code: " << err << " - " << errString << "PC " << HEX(_pc));
+			m_jit.releaseEmitter(emitter);
+			abortLoadFromCodeCache(b);
+			return nullptr;
+		}
+
+		b->finalize(func, emitter->codeHolder);
+		m_codeSize += emitter->codeHolder.codeSize();
+
+		m_jit.releaseEmitter(emitter);
+
+		for (auto* child : children)
+			child->addParent(_pc);
+
+		occupyArea(b);
+
+		_cache.countLookup(true);
+
+#if DSP56300_DEBUGGER
+		auto* d = m_jit.dsp().getDebugger();
+		if(d)
+			d->onJitBlockCreated(m_mode, b);
+#endif
+		return b;
+	}
+
+	void JitBlockChain::abortLoadFromCodeCache(JitBlockRuntimeData* _block)
+	{
+		// resolving child blocks may have occupied our area already
+		if(_block->getPCFirst() < m_jitCache.size() && m_jitCache[_block->getPCFirst()].block == _block)
+			unoccupyArea(_block);
+
+		m_jit.releaseBlockRuntimeData(_block);
+		m_jit.getCodeCache()->countLookup(false);
+	}
+
+	JitBlockRuntimeData* JitBlockChain::loadFromSharedCode(JitSharedCode& _sharedCode, const TWord _pc)
+	{
+		const auto config = m_jit.getConfig(_pc);
+
+		JitBlockInfo info;
+		JitBlock::getInfo(info, m_jit.dsp(), _pc, config, m_jitCache, m_jit.getVolatileP(), m_jit.getLoops(), m_jit.getLoopEnds());
+
+		const auto shared = _sharedCode.acquire(JitCodeCache::createKey(m_jit.dsp(), m_jit.getSharedCodeEnvironment(), info, m_mode.get(), config));
+
+		if(!shared)
+			return nullptr;
+
+		// the block analysis depends on volatile P and running loops, too, it needs to match
+		if(!shared->entry.info.matches(info) || !JitCodeCache::matchesOpcodes(shared->entry, m_jit.dsp()))
+		{
+			_sharedCode.release(shared->func);
+			return nullptr;
+		}
+
+		auto* b = m_jit.acquireBlockRuntimeData();
+
+		JitCodeCache::restore(*b, shared->entry);
+
+		// fill the relocation table with the host pointers of this DSP
+		std::vector<JitBlockRuntimeData*> children;
+
+		b->setGenerating(true);
+		m_generatingBlocks.insert(std::make_pair(_pc, b));
+
+		bool success = true;
+
+		for (const auto slot : shared->slots)
+		{
+			const auto r = _sharedCode.getSlotRelocation(slot);
+
+			const void* ptr = nullptr;
+
+			if(r.base == JitCodeCache::RelocationBase::Block)
+			{
+				auto* child = getChildBlock(b, r.arg);
+
+				if(child && child->getFunc() && child->getInfo().ccrOverwrite == r.check)
+				{
+					children.push_back(child);
+					ptr = asmjit::func_as_ptr(child->getFunc());
+				}
+			}
+			else
+			{
+				ptr = JitCodeCache::resolve(r, m_jit.dsp());
+			}
+
+			if(!ptr)
+			{
+				success = false;
+				break;
+			}
+
+			m_jit.setRelocationSlot(slot, ptr);
+		}
+
+		m_generatingBlocks.erase(_pc);
+		b->setGenerating(false);
+
+		if(!success)
+		{
+			if(_pc < m_jitCache.size() && m_jitCache[_pc].block == b)
+				unoccupyArea(b);
+
+			m_jit.releaseBlockRuntimeData(b);
+			_sharedCode.release(shared->func);
+			return nullptr;
+		}
+
+		b->finalize(shared->func, shared->codeSize);
+		m_codeSize += shared->codeSize;
+
+		for (auto* child : children)
+			child->addParent(_pc);
+
+		occupyArea(b);
+
 #if DSP56300_DEBUGGER
 		auto* d = m_jit.dsp().getDebugger();
 		if(d)
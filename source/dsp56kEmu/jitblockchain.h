@@ -5,6 +5,7 @@
 
 #include "jitcacheentry.h"
 #include "jitdspmode.h"
+#include "jitsingleopcache.h"
 #include "jittypes.h"
 
 namespace dsp56k
@@ -12,6 +13,9 @@ namespace dsp56k
 	class AsmJitLogger;
 	class AsmJitErrorHandler;
 	class DSP;
+	class JitCodeCache;
+	class JitSharedCode;
+	struct JitBlockEmitter;
 	class JitBlockRuntimeData;
 
 	class JitBlockChain final
@@ -29,6 +33,7 @@ namespace dsp56k
 
 		JitBlockRuntimeData* getChildBlock(JitBlockRuntimeData* _parent, TWord _pc, bool _allowCreate = true);
 		JitBlockRuntimeData* emit(TWord _pc);
+		bool addBlock(JitBlockRuntimeData* _block);
 
 		JitBlockRuntimeData* getBlock(const TWord _pc) const
 		{
@@ -43,6 +48,11 @@ namespace dsp56k
 			return m_jitCache[_pc].block;
 		}
 
+		const std::vector<JitCacheEntry>& getCache() const
+		{
+			return m_jitCache;
+		}
+
 		const auto& getFuncs() const
 		{
 			return m_jitFuncs;
@@ -69,6 +79,7 @@ namespace dsp56k
 		}
 
 		void notifyPMemWrite(TWord _addr, bool _isCurrentChain);
+		void notifyPMemWrite(TWord _first, TWord _count, bool _isCurrentChain);
 
 		size_t getFuncSize() const
 		{
@@ -85,6 +96,28 @@ namespace dsp56k
 			return m_jit;
 		}
 
+		size_t getCodeSize() const
+		{
+			return m_codeSize;
+		}
+
+		// time spent in generating blocks (or loading them from a code cache), excluding blocks from the background compiler
+		uint64_t getCompileTimeNs() const
+		{
+			return m_compileTimeNs;
+		}
+
+		// total number of host instructions removed by the JitOptimizer from the blocks that have been generated
+		uint64_t getOptimizerRemovedCount() const
+		{
+			return m_optimizerRemovedCount;
+		}
+
+		const JitSingleOpCache::Stats& getSingleOpCacheStats() const
+		{
+			return m_singleOpCache.getStats();
+		}
+
 	private:
 
 		void destroyParents(JitBlockRuntimeData* _block);
@@ -94,6 +127,13 @@ namespace dsp56k
 		void occupyArea(JitBlockRuntimeData* _block);
 		void unoccupyArea(const JitBlockRuntimeData* _block);
 
+		void initEmitter(JitBlockEmitter* _emitter, JitBlockRuntimeData* _block) const;
+
+		JitBlockRuntimeData* loadFromCodeCache(JitCodeCache& _cache, TWord _pc);
+		void abortLoadFromCodeCache(JitBlockRuntimeData* _block);
+
+		JitBlockRuntimeData* loadFromSharedCode(JitSharedCode& _sharedCode, TWord _pc);
+
 		bool isBeingGeneratedRecursive(const JitBlockRuntimeData* _block) const;
 		bool isBeingGenerated(const JitBlockRuntimeData* _block) const;
 
@@ -109,11 +149,15 @@ namespace dsp56k
 		std::vector<JitCacheEntry> m_jitCache;
 		std::vector<TJitFunc> m_jitFuncs;
 
+		JitSingleOpCache m_singleOpCache;
+
 		std::map<TWord, JitBlockRuntimeData*> m_generatingBlocks;
 
 		std::unique_ptr<AsmJitLogger> m_logger;
 		std::unique_ptr<AsmJitErrorHandler> m_errorHandler;
 
 		size_t m_codeSize = 0;
+		uint64_t m_compileTimeNs = 0;
+		uint64_t m_optimizerRemovedCount = 0;
 	};
 }
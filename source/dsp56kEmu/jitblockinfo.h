@@ -42,6 +42,15 @@ namespace dsp56k
 			flags |= static_cast<uint32_t>(_flag);
 		}
 
+		// true if the block analysis of both infos is identical. Fields that are filled during code generation are not compared
+		bool matches(const JitBlockInfo& _i) const
+		{
+			return terminationReason == _i.terminationReason && flags == _i.flags && pc == _i.pc && memSize == _i.memSize &&
+				instructionCount == _i.instructionCount && cycleCount == _i.cycleCount &&
+				branchTarget == _i.branchTarget && branchIsConditional == _i.branchIsConditional &&
+				loopBegin == _i.loopBegin && loopEnd == _i.loopEnd;
+		}
+
 		void reset()
 		{
 			terminationReason = TerminationReason::None;
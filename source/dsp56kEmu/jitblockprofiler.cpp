@@ -0,0 +1,133 @@
+#include "jitblockprofiler.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+
+#include "dsp.h"
+#include "jit.h"
+#include "jitblockruntimedata.h"
+#include "logging.h"
+
+namespace dsp56k
+{
+	namespace
+	{
+		template<typename TFunc> void forEachBlock(const Jit& _jit, const TFunc& _func)
+		{
+			_jit.forEachChain([&](const JitBlockChain& _chain)
+			{
+				const auto& cache = _chain.getCache();
+
+				for(TWord pc=0; pc<cache.size(); ++pc)
+				{
+					auto* b = cache[pc].block;
+
+					// a block occupies all addresses it covers, visit it only once
+					if(b && b->getPCFirst() == pc)
+						_func(*b);
+				}
+			});
+		}
+	}
+
+	std::vector<JitBlockProfiler::Entry> JitBlockProfiler::collect(const size_t _maxEntries) const
+	{
+		std::vector<Entry> entries;
+
+		forEachBlock(m_dsp.getJit(), [&](const JitBlockRuntimeData& _b)
+		{
+			if(!_b.getExecutionCount())
+				return;
+
+			Entry e;
+			e.pc = _b.getPCFirst();
+			e.memSize = _b.getPMemSize();
+			e.executions = _b.getExecutionCount();
+			e.cycles = e.executions * _b.getEncodedCycleCount();
+			e.codeSize = _b.getCodeSize();
+			entries.push_back(e);
+		});
+
+		std::sort(entries.begin(), entries.end(), [](const Entry& _a, const Entry& _b)
+		{
+			if(_a.cycles != _b.cycles)
+				return _a.cycles > _b.cycles;
+			return _a.executions > _b.executions;
+		});
+
+		if(_maxEntries && entries.size() > _maxEntries)
+			entries.resize(_maxEntries);
+
+		// the disassembly is only stored in debug builds, create it for the reported blocks only
+		for (auto& e : entries)
+			e.disasm = disassemble(e.pc, e.memSize);
+
+		return entries;
+	}
+
+	void JitBlockProfiler::dump(std::ostream& _out, const size_t _maxEntries) const
+	{
+		const auto entries = collect();
+
+		uint64_t totalCycles = 0;
+		for (const auto& e : entries)
+			totalCycles += e.cycles;
+
+		_out << "JIT block profile, " << entries.size() << " blocks executed, " << totalCycles << " cycles" << std::endl;
+
+		const auto count = _maxEntries ? std::min(_maxEntries, entries.size()) : entries.size();
+
+		for(size_t i=0; i<count; ++i)
+		{
+			const auto& e = entries[i];
+
+			const auto percent = totalCycles ? 100.0 * static_cast<double>(e.cycles) / static_cast<double>(totalCycles) : 0.0;
+
+			_out << std::dec << '#' << i << " $" << HEX(e.pc) << "-$" << HEX(e.pc + e.memSize - 1)
+				<< std::dec << std::setfill(' ')
+				<< " hits " << e.executions
+				<< " cycles " << e.cycles << " (" << std::fixed << std::setprecision(2) << percent << "%)"
+				<< " code " << e.codeSize << " bytes" << std::endl;
+
+			std::stringstream ss(e.disasm);
+			std::string line;
+			while(std::getline(ss, line))
+				_out << '\t' << line << std::endl;
+		}
+	}
+
+	void JitBlockProfiler::dumpToLog(const size_t _maxEntries) const
+	{
+		std::stringstream ss;
+		dump(ss, _maxEntries);
+		LOG(std::endl << ss.str());
+	}
+
+	void JitBlockProfiler::reset()
+	{
+		forEachBlock(m_dsp.getJit(), [](JitBlockRuntimeData& _b)
+		{
+			_b.resetExecutionCount();
+		});
+	}
+
+	std::string JitBlockProfiler::disassemble(const TWord _pc, const TWord _memSize) const
+	{
+		std::stringstream res;
+		std::string line;
+
+		for(TWord pc=_pc; pc<_pc + _memSize;)
+		{
+			TWord opA, opB;
+			m_dsp.memory().getOpcode(pc, opA, opB);
+
+			const auto len = m_dsp.disassembler().disassemble(line, opA, opB, 0, 0, pc);
+
+			res << HEX(pc) << ": " << line << '\n';
+
+			pc += std::max(len, 1u);
+		}
+		return res.str();
+	}
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+#include "types.h"
+
+namespace dsp56k
+{
+	class DSP;
+
+	// Creates a report of the JIT blocks that have been executed most. Requires JitConfig::blockProfiling to be enabled
+	// before the code is generated. Only blocks that currently exist are reported, blocks that have been destroyed
+	// because P memory has been overwritten lose their counters.
+	// Needs to be called from the DSP thread or while the DSP thread is halted
+	class JitBlockProfiler
+	{
+	public:
+		struct Entry
+		{
+			TWord pc = 0;
+			TWord memSize = 0;
+			uint64_t executions = 0;
+			uint64_t cycles = 0;		// encoded cycles of the block multiplied by its executions
+			size_t codeSize = 0;		// host code size in bytes
+			std::string disasm;
+		};
+
+		explicit JitBlockProfiler(DSP& _dsp) : m_dsp(_dsp) {}
+
+		// blocks sorted by DSP cycles, highest first. Zero = no limit
+		std::vector<Entry> collect(size_t _maxEntries = 0) const;
+
+		void dump(std::ostream& _out, size_t _maxEntries = 32) const;
+		void dumpToLog(size_t _maxEntries = 32) const;
+
+		void reset();
+
+	private:
+		std::string disassemble(TWord _pc, TWord _memSize) const;
+
+		DSP& m_dsp;
+	};
+}
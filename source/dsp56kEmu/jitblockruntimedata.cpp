@@ -27,6 +27,19 @@ namespace dsp56k
 			pi.codeOffset = _codeHolder.labelOffset(pi.labelBefore);
 			pi.codeOffsetAfter = _codeHolder.labelOffset(pi.labelAfter);
 		}
+
+		// relocations of shared code are not part of the code
+		for (auto& r : m_relocations)
+		{
+			if(r.label.isValid())
+				r.codeOffset = _codeHolder.labelOffset(r.label);
+		}
+	}
+
+	void JitBlockRuntimeData::finalize(const TJitFunc& _func, const size_t _codeSize)
+	{
+		m_func = _func;
+		m_codeSize = _codeSize;
 	}
 
 	void JitBlockRuntimeData::reset()
@@ -43,12 +56,15 @@ namespace dsp56k
 		m_child = g_invalidAddress;			// JIT block that we call
 		m_nonBranchChild = g_invalidAddress;
 		m_codeSize = 0;
+		m_optimizerRemovedCount = 0;
 
 		m_info.reset();
 
 		m_parents.clear();
 		m_generating = false;
 		m_profilingInfo.clear();
+		m_relocations.clear();
+		m_executionCount = 0;
 	}
 
 	void JitBlockRuntimeData::addParent(const TWord _pc)
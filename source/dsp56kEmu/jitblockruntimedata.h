@@ -5,6 +5,7 @@
 #include "interrupts.h"
 #include "jitblock.h"
 #include "jitblockinfo.h"
+#include "jitrelocation.h"
 #include "types.h"
 
 namespace dsp56k
@@ -15,6 +16,9 @@ namespace dsp56k
 	{
 	public:
 		friend class JitBlock;
+		friend class JitBlockChain;
+		friend class JitCodeCache;
+		friend class JitSharedCode;
 
 		static constexpr TWord SingleOpCacheIgnoreWordB = 0xffffffff;
 
@@ -61,17 +65,28 @@ namespace dsp56k
 		bool isFastInterrupt() const { return getPCFirst() < Vba_End; }
 
 		void finalize(const TJitFunc& _func, const asmjit::CodeHolder& _codeHolder);
+		void finalize(const TJitFunc& _func, size_t _codeSize);
 
 		const TJitFunc& getFunc() const { return m_func; }
 
 		TWord& getEncodedInstructionCount() { return m_encodedInstructionCount; }
 		TWord& getEncodedCycleCount() { return m_encodedCycles; }
+		TWord getEncodedCycleCount() const { return m_encodedCycles; }
 
 		std::vector<InstructionProfilingInfo>& getProfilingInfo() { return m_profilingInfo; }
 		size_t getCodeSize() const { return m_codeSize; }
 
 		const JitBlockInfo& getInfo() const { return m_info; }
 
+		const std::vector<JitRelocation>& getRelocations() const { return m_relocations; }
+
+		// incremented by the generated code on every execution if JitConfig::blockProfiling is enabled
+		const uint64_t& getExecutionCount() const { return m_executionCount; }
+		void resetExecutionCount() { m_executionCount = 0; }
+
+		// number of host instructions removed by the JitOptimizer if JitConfig::optimizeJitCode is enabled
+		uint32_t getOptimizerRemovedCount() const { return m_optimizerRemovedCount; }
+
 		void reset();
 
 	private:
@@ -95,5 +110,8 @@ namespace dsp56k
 		std::set<TWord> m_parents;
 		bool m_generating = false;
 		std::vector<InstructionProfilingInfo> m_profilingInfo;
+		std::vector<JitRelocation> m_relocations;
+		uint64_t m_executionCount = 0;
+		uint32_t m_optimizerRemovedCount = 0;
 	};
 }
@@ -0,0 +1,671 @@
+#include "jitcodecache.h"
+
+#include <cstring>
+#include <fstream>
+#include <random>
+#include <type_traits>
+#include <typeinfo>
+
+#include "dsp.h"
+#include "jitblockruntimedata.h"
+#include "jitconfig.h"
+#include "logging.h"
+
+#ifdef _WIN32
+#	define NOMINMAX
+#	define WIN32_LEAN_AND_MEAN
+#	include <Windows.h>
+#else
+#	include <dlfcn.h>
+#endif
+
+namespace dsp56k
+{
+	void funcCreate(Jit* _jit, TWord _pc) noexcept;
+
+	namespace
+	{
+		constexpr uint32_t g_fileMagic = 0x4a363544;	// "D56J"
+		constexpr uint32_t g_fileVersion = 3;
+
+		// number of bytes at the start of a host function that are used to verify that a code relocation is still valid
+		constexpr size_t g_codeCheckSize = 16;
+
+		class Hash
+		{
+		public:
+			void add(const void* _data, const size_t _size)
+			{
+				const auto* d = static_cast<const uint8_t*>(_data);
+
+				for(size_t i=0; i<_size; ++i)
+				{
+					m_hash ^= d[i];
+					m_hash *= 0x100000001b3ull;
+				}
+			}
+
+			template<typename T> void add(const T& _value)
+			{
+				static_assert(std::is_arithmetic_v<T> || std::is_enum_v<T>);
+				add(&_value, sizeof(_value));
+			}
+
+			void add(const std::string& _s)
+			{
+				add(_s.c_str(), _s.size());
+			}
+
+			uint64_t get() const { return m_hash; }
+
+		private:
+			uint64_t m_hash = 0xcbf29ce484222325ull;
+		};
+
+		const uint8_t* getCodeAnchor()
+		{
+			return reinterpret_cast<const uint8_t*>(&funcCreate);
+		}
+
+		// returns the base address of the host module (executable or shared library) that contains _addr or nullptr
+		const void* getModuleBase(const void* _addr)
+		{
+#ifdef _WIN32
+			HMODULE module = nullptr;
+			if(!GetModuleHandleExA(GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS | GET_MODULE_HANDLE_EX_FLAG_UNCHANGED_REFCOUNT, static_cast<LPCSTR>(_addr), &module))
+				return nullptr;
+			return module;
+#else
+			Dl_info info;
+			if(!dladdr(_addr, &info))
+				return nullptr;
+			return info.dli_fbase;
+#endif
+		}
+
+		std::string getModuleFilename(const void* _addr)
+		{
+#ifdef _WIN32
+			HMODULE module = nullptr;
+			if(!GetModuleHandleExA(GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS | GET_MODULE_HANDLE_EX_FLAG_UNCHANGED_REFCOUNT, static_cast<LPCSTR>(_addr), &module))
+				return {};
+			char name[MAX_PATH]{};
+			if(!GetModuleFileNameA(module, name, MAX_PATH))
+				return {};
+			return name;
+#else
+			Dl_info info;
+			if(!dladdr(_addr, &info) || !info.dli_fname)
+				return {};
+			return info.dli_fname;
+#endif
+		}
+
+		// the host module that contains the emulator. Code relocations are relative to it and only valid for the build that created them
+		struct HostModule
+		{
+			const void* base = nullptr;
+			uint64_t buildId = 0;
+		};
+
+		const HostModule& getHostModule()
+		{
+			static const HostModule module = []
+			{
+				HostModule m;
+				m.base = getModuleBase(getCodeAnchor());
+
+				// the build is identified by the contents of the binary. If it cannot be read, cached code is only valid for this process
+				std::ifstream in(getModuleFilename(getCodeAnchor()), std::ios::binary);
+
+				if(in.is_open())
+				{
+					Hash h;
+					std::vector<char> buffer(0x10000);
+
+					while(in)
+					{
+						in.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+						h.add(buffer.data(), static_cast<size_t>(in.gcount()));
+					}
+
+					m.buildId = h.get();
+				}
+				else
+				{
+					std::random_device rd;
+					m.buildId = (static_cast<uint64_t>(rd()) << 32) | rd();
+				}
+
+				return m;
+			}();
+
+			return module;
+		}
+
+		bool isInHostModule(const void* _ptr)
+		{
+			const auto& module = getHostModule();
+			return module.base && getModuleBase(_ptr) == module.base;
+		}
+
+		uint64_t hashCode(const void* _func)
+		{
+			Hash h;
+			h.add(_func, g_codeCheckSize);
+			return h.get();
+		}
+
+		int64_t pointerDiff(const void* _ptr, const void* _base)
+		{
+			return static_cast<int64_t>(reinterpret_cast<uint64_t>(_ptr) - reinterpret_cast<uint64_t>(_base));
+		}
+
+		bool isInMemory(Memory& _mem, const void* _ptr)
+		{
+			for(auto a : {MemArea_P, MemArea_X, MemArea_Y})
+			{
+				const auto* begin = _mem.getMemAreaPtr(a);
+				const auto* end = begin + _mem.size(a);
+
+				if(_ptr >= begin && _ptr < end)
+					return true;
+			}
+			return false;
+		}
+
+		class Writer
+		{
+		public:
+			explicit Writer(std::ofstream& _out) : m_out(_out) {}
+
+			template<typename T> void write(const T& _value)
+			{
+				static_assert(std::is_arithmetic_v<T> || std::is_enum_v<T>);
+				m_out.write(reinterpret_cast<const char*>(&_value), sizeof(_value));
+			}
+
+			void write(const void* _data, const size_t _size)
+			{
+				write(static_cast<uint32_t>(_size));
+				if(_size)
+					m_out.write(static_cast<const char*>(_data), static_cast<std::streamsize>(_size));
+			}
+
+			template<typename T> void write(const std::vector<T>& _data)
+			{
+				write(static_cast<uint32_t>(_data.size()));
+				if(!_data.empty())
+					m_out.write(reinterpret_cast<const char*>(_data.data()), static_cast<std::streamsize>(_data.size() * sizeof(T)));
+			}
+
+		private:
+			std::ofstream& m_out;
+		};
+
+		class Reader
+		{
+		public:
+			explicit Reader(std::ifstream& _in) : m_in(_in) {}
+
+			template<typename T> bool read(T& _value)
+			{
+				static_assert(std::is_arithmetic_v<T> || std::is_enum_v<T>);
+				m_in.read(reinterpret_cast<char*>(&_value), sizeof(_value));
+				return m_in.good();
+			}
+
+			template<typename T> bool read(std::vector<T>& _data)
+			{
+				uint32_t size;
+				if(!read(size))
+					return false;
+				_data.resize(size);
+				if(size)
+					m_in.read(reinterpret_cast<char*>(_data.data()), static_cast<std::streamsize>(size * sizeof(T)));
+				return m_in.good();
+			}
+
+			bool read(std::string& _s)
+			{
+				std::vector<char> data;
+				if(!read(data))
+					return false;
+				_s.assign(data.begin(), data.end());
+				return true;
+			}
+
+		private:
+			std::ifstream& m_in;
+		};
+	}
+
+	size_t JitCodeCache::KeyHash::operator()(const Key& _k) const
+	{
+		Hash h;
+		h.add(_k.environment);
+		h.add(_k.config);
+		h.add(_k.opcodes);
+		h.add(_k.mode);
+		h.add(_k.pc);
+		h.add(_k.memSize);
+		return static_cast<size_t>(h.get());
+	}
+
+	std::shared_ptr<const JitCodeCache::Entry> JitCodeCache::find(const Key& _key) const
+	{
+		std::lock_guard lock(m_mutex);
+
+		const auto it = m_entries.find(_key);
+
+		if(it == m_entries.end())
+			return {};
+
+		return it->second;
+	}
+
+	void JitCodeCache::countLookup(const bool _hit)
+	{
+		std::lock_guard lock(m_mutex);
+
+		if(_hit)
+			++m_stats.hits;
+		else
+			++m_stats.misses;
+	}
+
+	bool JitCodeCache::store(const Key& _key, const JitBlockRuntimeData& _block, DSP& _dsp)
+	{
+		auto e = std::make_shared<Entry>();
+
+		e->key = _key;
+		e->info = _block.getInfo();
+		e->disasm = _block.getDisasm();
+		e->lastOpSize = _block.m_lastOpSize;
+		e->singleOpWordA = _block.m_singleOpWordA;
+		e->singleOpWordB = _block.m_singleOpWordB;
+		e->encodedInstructionCount = _block.m_encodedInstructionCount;
+		e->encodedCycles = _block.m_encodedCycles;
+		e->child = _block.m_child;
+		e->nonBranchChild = _block.m_nonBranchChild;
+		e->opcodes = readOpcodes(_dsp, e->info);
+
+		const auto* code = reinterpret_cast<const uint8_t*>(_block.getFunc());
+		e->code.assign(code, code + _block.getCodeSize());
+
+		for (const auto& r : _block.getRelocations())
+		{
+			Relocation reloc;
+
+			if(!describe(reloc, r, _dsp))
+			{
+				std::lock_guard lock(m_mutex);
+				++m_stats.rejected;
+				return false;
+			}
+
+			e->relocations.push_back(reloc);
+		}
+
+		std::lock_guard lock(m_mutex);
+		m_entries[_key] = std::move(e);
+		++m_stats.stores;
+		return true;
+	}
+
+	bool JitCodeCache::describe(Relocation& _dst, const JitRelocation& _reloc, DSP& _dsp)
+	{
+		_dst.codeOffset = static_cast<uint32_t>(_reloc.codeOffset);
+		_dst.arg = _reloc.arg;
+		_dst.area = _reloc.area;
+		_dst.inst = _reloc.inst;
+
+		switch (_reloc.type)
+		{
+		case JitRelocation::Type::Data:
+			{
+				auto& mem = _dsp.memory();
+				const auto* dsp = reinterpret_cast<const uint8_t*>(&_dsp);
+
+				if(_reloc.ptr >= dsp && _reloc.ptr < dsp + sizeof(DSP))
+				{
+					_dst.base = RelocationBase::Dsp;
+					_dst.value = pointerDiff(_reloc.ptr, dsp);
+				}
+				else if(isInMemory(mem, _reloc.ptr))
+				{
+					_dst.base = RelocationBase::Memory;
+					_dst.value = pointerDiff(_reloc.ptr, mem.getMemAreaPtr(MemArea_P));
+				}
+				else
+				{
+					return false;
+				}
+			}
+			break;
+		case JitRelocation::Type::Code:
+			if(!isInHostModule(_reloc.ptr))
+				return false;
+			_dst.base = RelocationBase::Code;
+			_dst.value = pointerDiff(_reloc.ptr, getCodeAnchor());
+			_dst.check = hashCode(_reloc.ptr);
+			break;
+		case JitRelocation::Type::Block:
+			_dst.base = RelocationBase::Block;
+			_dst.check = _reloc.ccrOverwrite;
+			break;
+		case JitRelocation::Type::Peripheral:
+			_dst.base = RelocationBase::Peripheral;
+			break;
+		}
+		return true;
+	}
+
+	const void* JitCodeCache::resolve(const Relocation& _reloc, DSP& _dsp)
+	{
+		switch (_reloc.base)
+		{
+		case RelocationBase::Dsp:
+			return reinterpret_cast<const uint8_t*>(&_dsp) + _reloc.value;
+		case RelocationBase::Memory:
+			return reinterpret_cast<const uint8_t*>(_dsp.memory().getMemAreaPtr(MemArea_P)) + _reloc.value;
+		case RelocationBase::Code:
+			{
+				// the offset has been read from a file, verify that it points into the emulator before reading from it
+				const auto* func = getCodeAnchor() + _reloc.value;
+				if(!isInHostModule(func) || hashCode(func) != _reloc.check)
+					return nullptr;
+				return func;
+			}
+		case RelocationBase::Peripheral:
+			{
+				auto* periph = _dsp.getPeriph(static_cast<EMemArea>(_reloc.area));
+				if(!periph)
+					return nullptr;
+				return periph->readAsPtr(_reloc.arg, static_cast<Instruction>(_reloc.inst));
+			}
+		case RelocationBase::Block:
+		default:
+			return nullptr;
+		}
+	}
+
+	void JitCodeCache::restore(JitBlockRuntimeData& _block, const Entry& _entry)
+	{
+		_block.m_info = _entry.info;
+		_block.m_dspAsm = _entry.disasm;
+		_block.m_lastOpSize = _entry.lastOpSize;
+		_block.m_singleOpWordA = _entry.singleOpWordA;
+		_block.m_singleOpWordB = _entry.singleOpWordB;
+		_block.m_encodedInstructionCount = _entry.encodedInstructionCount;
+		_block.m_encodedCycles = _entry.encodedCycles;
+		_block.m_child = _entry.child;
+		_block.m_nonBranchChild = _entry.nonBranchChild;
+	}
+
+	bool JitCodeCache::load(const std::string& _filename)
+	{
+		std::ifstream in(_filename, std::ios::binary);
+
+		if(!in.is_open())
+			return false;
+
+		Reader r(in);
+
+		uint32_t magic = 0, version = 0, count = 0;
+
+		if(!r.read(magic) || !r.read(version) || !r.read(count))
+			return false;
+
+		if(magic != g_fileMagic || version != g_fileVersion)
+		{
+			LOG("JIT code cache " << _filename << " has an unsupported format, ignoring it");
+			return false;
+		}
+
+		std::vector<std::shared_ptr<Entry>> entries;
+		entries.reserve(count);
+
+		for(uint32_t i=0; i<count; ++i)
+		{
+			auto e = std::make_shared<Entry>();
+
+			auto& k = e->key;
+			auto& info = e->info;
+
+			uint64_t readRegs = 0, writtenRegs = 0;
+			uint8_t branchIsConditional = 0;
+			uint32_t relocCount = 0;
+
+			const bool success =
+				r.read(k.environment) && r.read(k.config) && r.read(k.opcodes) && r.read(k.mode) && r.read(k.pc) && r.read(k.memSize) &&
+				r.read(info.terminationReason) && r.read(info.flags) && r.read(info.pc) && r.read(info.memSize) &&
+				r.read(info.instructionCount) && r.read(info.cycleCount) && r.read(readRegs) && r.read(writtenRegs) &&
+				r.read(info.branchTarget) && r.read(branchIsConditional) && r.read(info.loopBegin) && r.read(info.loopEnd) &&
+				r.read(info.ccrRead) && r.read(info.ccrWrite) && r.read(info.ccrOverwrite) &&
+				r.read(e->disasm) && r.read(e->lastOpSize) && r.read(e->singleOpWordA) && r.read(e->singleOpWordB) &&
+				r.read(e->encodedInstructionCount) && r.read(e->encodedCycles) && r.read(e->child) && r.read(e->nonBranchChild) &&
+				r.read(e->opcodes) && r.read(e->code) && r.read(relocCount);
+
+			if(!success || e->opcodes.size() != static_cast<size_t>(info.memSize) + 1)
+				return false;
+
+			info.readRegs = static_cast<RegisterMask>(readRegs);
+			info.writtenRegs = static_cast<RegisterMask>(writtenRegs);
+			info.branchIsConditional = branchIsConditional != 0;
+
+			e->relocations.resize(relocCount);
+
+			for (auto& reloc : e->relocations)
+			{
+				if(!r.read(reloc.base) || !r.read(reloc.codeOffset) || !r.read(reloc.value) || !r.read(reloc.arg) || !r.read(reloc.area) || !r.read(reloc.inst) || !r.read(reloc.check))
+					return false;
+
+				if(reloc.codeOffset + sizeof(uint64_t) > e->code.size())
+					return false;
+			}
+
+			entries.emplace_back(std::move(e));
+		}
+
+		std::lock_guard lock(m_mutex);
+
+		for (auto& e : entries)
+		{
+			const auto key = e->key;
+			m_entries[key] = std::move(e);
+		}
+
+		return true;
+	}
+
+	bool JitCodeCache::save(const std::string& _filename) const
+	{
+		std::ofstream out(_filename, std::ios::binary | std::ios::trunc);
+
+		if(!out.is_open())
+			return false;
+
+		std::lock_guard lock(m_mutex);
+
+		Writer w(out);
+
+		w.write(g_fileMagic);
+		w.write(g_fileVersion);
+		w.write(static_cast<uint32_t>(m_entries.size()));
+
+		for (const auto& it : m_entries)
+		{
+			const auto& e = *it.second;
+			const auto& k = e.key;
+			const auto& info = e.info;
+
+			w.write(k.environment);	w.write(k.config);	w.write(k.opcodes);	w.write(k.mode);	w.write(k.pc);	w.write(k.memSize);
+
+			w.write(info.terminationReason);
+			w.write(info.flags);
+			w.write(info.pc);
+			w.write(info.memSize);
+			w.write(info.instructionCount);
+			w.write(info.cycleCount);
+			w.write(static_cast<uint64_t>(info.readRegs));
+			w.write(static_cast<uint64_t>(info.writtenRegs));
+			w.write(info.branchTarget);
+			w.write(static_cast<uint8_t>(info.branchIsConditional ? 1 : 0));
+			w.write(info.loopBegin);
+			w.write(info.loopEnd);
+			w.write(info.ccrRead);
+			w.write(info.ccrWrite);
+			w.write(info.ccrOverwrite);
+
+			w.write(e.disasm.c_str(), e.disasm.size());
+			w.write(e.lastOpSize);
+			w.write(e.singleOpWordA);
+			w.write(e.singleOpWordB);
+			w.write(e.encodedInstructionCount);
+			w.write(e.encodedCycles);
+			w.write(e.child);
+			w.write(e.nonBranchChild);
+			w.write(e.opcodes);
+			w.write(e.code.data(), e.code.size());
+
+			w.write(static_cast<uint32_t>(e.relocations.size()));
+
+			for (const auto& r : e.relocations)
+			{
+				w.write(r.base);
+				w.write(r.codeOffset);
+				w.write(r.value);
+				w.write(r.arg);
+				w.write(r.area);
+				w.write(r.inst);
+				w.write(r.check);
+			}
+		}
+
+		out.close();
+
+		return !out.fail();
+	}
+
+	void JitCodeCache::clear()
+	{
+		std::lock_guard lock(m_mutex);
+		m_entries.clear();
+	}
+
+	size_t JitCodeCache::size() const
+	{
+		std::lock_guard lock(m_mutex);
+		return m_entries.size();
+	}
+
+	JitCodeCache::Stats JitCodeCache::getStats() const
+	{
+		std::lock_guard lock(m_mutex);
+		return m_stats;
+	}
+
+	JitCodeCache::Key JitCodeCache::createKey(const DSP& _dsp, const uint64_t _environment, const JitBlockInfo& _info, const uint32_t _mode, const JitConfig& _config)
+	{
+		Key k;
+
+		k.environment = _environment;
+		k.config = hashConfig(_config);
+		k.mode = _mode;
+		k.pc = _info.pc;
+		k.memSize = _info.memSize;
+
+		Hash h;
+
+		for (const auto op : readOpcodes(_dsp, _info))
+			h.add(op);
+
+		k.opcodes = h.get();
+
+		return k;
+	}
+
+	std::vector<TWord> JitCodeCache::readOpcodes(const DSP& _dsp, const JitBlockInfo& _info)
+	{
+		std::vector<TWord> opcodes;
+		opcodes.reserve(_info.memSize + 1);
+
+		const auto& mem = _dsp.memory();
+
+		TWord opA = 0, opB = 0;
+
+		for(TWord i=0; i<_info.memSize; ++i)
+		{
+			mem.getOpcode(_info.pc + i, opA, opB);
+			opcodes.push_back(opA);
+		}
+
+		// the code generator reads the second opcode word of the last instruction, too
+		opcodes.push_back(opB);
+
+		return opcodes;
+	}
+
+	bool JitCodeCache::matchesOpcodes(const Entry& _entry, const DSP& _dsp)
+	{
+		return _entry.opcodes == readOpcodes(_dsp, _entry.info);
+	}
+
+	uint64_t JitCodeCache::hashEnvironment(DSP& _dsp)
+	{
+		auto& mem = _dsp.memory();
+
+		Hash h;
+
+		h.add(g_fileVersion);
+		h.add(static_cast<uint64_t>(sizeof(DSP)));
+
+		// changes if the emulator binary has been rebuilt, code relocations are relative to funcCreate
+		h.add(getHostModule().buildId);
+
+		h.add(mem.sizeP());
+		h.add(mem.sizeXY());
+		h.add(mem.getBridgedMemoryAddress());
+		h.add(mem.hasMmuSupport());
+		h.add(pointerDiff(mem.getMemAreaPtr(MemArea_X), mem.getMemAreaPtr(MemArea_P)));
+		h.add(pointerDiff(mem.getMemAreaPtr(MemArea_Y), mem.getMemAreaPtr(MemArea_P)));
+
+		for(size_t i=0; i<2; ++i)
+		{
+			const auto* p = _dsp.getPeriph(i);
+			h.add(p ? std::string(typeid(*p).name()) : std::string());
+		}
+
+#ifdef HAVE_ARM64
+		h.add(std::string("aarch64"));
+#else
+		h.add(std::string("x86-64"));
+#endif
+		return h.get();
+	}
+
+	uint64_t JitCodeCache::hashConfig(const JitConfig& _config)
+	{
+		Hash h;
+
+		h.add(_config.aguSupportBitreverse);
+		h.add(_config.aguSupportMultipleWrapModulo);
+		h.add(_config.cacheSingleOpBlocks);
+		h.add(_config.linkJitBlocks);
+		h.add(_config.splitOpsByNops);
+		h.add(_config.dynamicPeripheralAddressing);
+		h.add(_config.maxInstructionsPerBlock);
+		h.add(_config.memoryWritesCallCpp);
+		h.add(_config.support16BitSCMode);
+		h.add(_config.maxDoIterations);
+		h.add(_config.dynamicFastInterrupts);
+		h.add(_config.debugDynamicPeripheralAddressing);
+		h.add(_config.relocatableCode);
+		h.add(_config.sharedCode);
+		h.add(_config.optimizeJitCode);
+		h.add(_config.inlineEsxiDataRegisters);
+
+		return h.get();
+	}
+}
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "jitblockinfo.h"
+#include "types.h"
+
+namespace dsp56k
+{
+	class DSP;
+	class JitBlockRuntimeData;
+	struct JitConfig;
+	struct JitRelocation;
+
+	// Stores the generated code of JIT blocks so that it can be reused later, either by another DSP instance with an
+	// identical setup or by a later run of the emulator if the cache is saved to disk.
+	// Blocks are only stored if they have been generated as relocatable code, see JitConfig::relocatableCode
+	class JitCodeCache
+	{
+	public:
+		struct Key
+		{
+			uint64_t environment = 0;	// memory layout, peripherals, ...
+			uint64_t config = 0;		// JitConfig used to generate the block
+			uint64_t opcodes = 0;		// hash of all P memory words covered by the block, the words are stored in the Entry
+			uint32_t mode = 0;			// JitDspMode
+			TWord pc = 0;
+			TWord memSize = 0;
+
+			bool operator == (const Key& _k) const
+			{
+				return environment == _k.environment && config == _k.config && opcodes == _k.opcodes && mode == _k.mode && pc == _k.pc && memSize == _k.memSize;
+			}
+		};
+
+		enum class RelocationBase : uint8_t
+		{
+			Dsp,			// value = offset relative to the DSP object
+			Memory,			// value = offset relative to P memory
+			Code,			// value = offset relative to a known host function
+			Block,			// value unused, arg = child block PC
+			Peripheral		// value unused, arg/area/inst are passed to IPeripherals::readAsPtr
+		};
+
+		struct Relocation
+		{
+			RelocationBase base = RelocationBase::Dsp;
+			uint32_t codeOffset = 0;
+			int64_t value = 0;
+			TWord arg = 0;
+			uint32_t area = 0;
+			uint32_t inst = 0;
+			uint64_t check = 0;		// Code: hash of the first bytes of the function, Block: ccrOverwrite of the child
+		};
+
+		struct Entry
+		{
+			Key key;
+			JitBlockInfo info;
+			std::string disasm;
+			TWord lastOpSize = 0;
+			TWord singleOpWordA = 0;
+			TWord singleOpWordB = 0;
+			TWord encodedInstructionCount = 0;
+			TWord encodedCycles = 0;
+			TWord child = g_invalidAddress;
+			TWord nonBranchChild = g_invalidAddress;
+			std::vector<TWord> opcodes;		// see readOpcodes
+			std::vector<uint8_t> code;
+			std::vector<Relocation> relocations;
+		};
+
+		struct Stats
+		{
+			uint64_t hits = 0;
+			uint64_t misses = 0;
+			uint64_t stores = 0;
+			uint64_t rejected = 0;	// blocks that could not be stored because they reference unknown host memory
+		};
+
+		std::shared_ptr<const Entry> find(const Key& _key) const;
+		void countLookup(bool _hit);
+		bool store(const Key& _key, const JitBlockRuntimeData& _block, DSP& _dsp);
+
+		// converts a host pointer of a block into a description that is independent of the DSP instance. Fails for pointers to unknown host memory
+		static bool describe(Relocation& _dst, const JitRelocation& _reloc, DSP& _dsp);
+
+		// returns the host pointer a relocation resolves to or nullptr if it cannot be resolved. Block relocations are resolved by the caller
+		static const void* resolve(const Relocation& _reloc, DSP& _dsp);
+
+		static void restore(JitBlockRuntimeData& _block, const Entry& _entry);
+
+		bool load(const std::string& _filename);
+		bool save(const std::string& _filename) const;
+
+		void clear();
+		size_t size() const;
+		Stats getStats() const;
+
+		static Key createKey(const DSP& _dsp, uint64_t _environment, const JitBlockInfo& _info, uint32_t _mode, const JitConfig& _config);
+
+		// returns the P memory words that the code of a block has been generated from
+		static std::vector<TWord> readOpcodes(const DSP& _dsp, const JitBlockInfo& _info);
+
+		// the key only contains a hash of the opcodes. An entry must not be used unless its opcodes are identical to P memory
+		static bool matchesOpcodes(const Entry& _entry, const DSP& _dsp);
+		static uint64_t hashEnvironment(DSP& _dsp);
+		static uint64_t hashConfig(const JitConfig& _config);
+
+	private:
+		struct KeyHash
+		{
+			size_t operator () (const Key& _k) const;
+		};
+
+		mutable std::mutex m_mutex;
+		std::unordered_map<Key, std::shared_ptr<const Entry>, KeyHash> m_entries;
+		Stats m_stats;
+	};
+}
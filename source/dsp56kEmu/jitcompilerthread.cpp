@@ -0,0 +1,176 @@
+#include "jitcompilerthread.h"
+
+#include "jit.h"
+#include "jitasmjithelpers.h"
+#include "jitblockemitter.h"
+#include "jitblockruntimedata.h"
+#include "logging.h"
+#include "threadtools.h"
+
+#include "asmjit/core/jitruntime.h"
+
+namespace dsp56k
+{
+	JitCompilerThread::JitCompilerThread(Jit& _jit)
+		: m_jit(_jit)
+		, m_errorHandler(new AsmJitErrorHandler())
+		, m_placeholder(new JitBlockRuntimeData())
+	{
+		m_thread.reset(new std::thread([this]
+		{
+			threadFunc();
+		}));
+	}
+
+	JitCompilerThread::~JitCompilerThread()
+	{
+		{
+			std::lock_guard lock(m_mutex);
+			m_exit = true;
+		}
+
+		m_jobsAvailable.notify();
+
+		m_thread->join();
+		m_thread.reset();
+
+		for (const auto& r : m_results)
+		{
+			if(!r.block)
+				continue;
+			m_jit.releaseCode(r.block->getFunc());
+			delete r.block;
+		}
+
+		m_results.clear();
+	}
+
+	void JitCompilerThread::request(Job&& _job)
+	{
+		{
+			std::lock_guard lock(m_mutex);
+			m_jobs.emplace_back(std::move(_job));
+		}
+
+		m_jobsAvailable.notify();
+	}
+
+	void JitCompilerThread::getResults(std::vector<Result>& _results)
+	{
+		std::lock_guard lock(m_mutex);
+
+		_results.insert(_results.end(), m_results.begin(), m_results.end());
+		m_results.clear();
+
+		m_hasResults.store(false, std::memory_order_release);
+	}
+
+	void JitCompilerThread::threadFunc()
+	{
+		ThreadTools::setCurrentThreadName("DSP JIT");
+
+		while(true)
+		{
+			m_jobsAvailable.wait();
+
+			Job job;
+
+			{
+				std::lock_guard lock(m_mutex);
+
+				if(m_exit)
+					return;
+
+				job = std::move(m_jobs.front());
+				m_jobs.pop_front();
+			}
+
+			Result result;
+
+			result.pc = job.pc;
+			result.generation = job.generation;
+			result.mode = job.mode;
+			result.block = compile(job);
+
+			{
+				std::lock_guard lock(m_mutex);
+				m_results.push_back(result);
+				m_hasResults.store(true, std::memory_order_release);
+			}
+		}
+	}
+
+	JitBlockRuntimeData* JitCompilerThread::compile(Job& _job)
+	{
+		if(!m_emitter)
+			m_emitter.reset(new JitBlockEmitter(m_jit.dsp(), m_jit.getRuntimeData(), JitConfig(_job.config)));
+		else
+			m_emitter->reset(JitConfig(_job.config));
+
+		auto& e = *m_emitter;
+
+		if(_job.config.asmjitDiagnostics)
+		{
+			e.emitter.addDiagnosticOptions(asmjit::DiagnosticOptions::kValidateIntermediate);
+			e.emitter.addDiagnosticOptions(asmjit::DiagnosticOptions::kValidateAssembler);
+		}
+
+		auto* b = new JitBlockRuntimeData();
+
+		e.codeHolder.setErrorHandler(m_errorHandler.get());
+		e.codeHolder.init(m_jit.getRuntime()->environment());
+		e.codeHolder.attach(&e.emitter);
+
+		m_errorHandler->setBlock(b);
+
+		// the chain of the DSP thread cannot be accessed here. The caller tells us where existing code starts so that the block analysis is identical
+		if(_job.stopAt != g_invalidAddress)
+		{
+			if(_job.stopAt >= m_cache.size())
+				m_cache.resize(_job.stopAt + 1);
+			m_cache[_job.stopAt].block = m_placeholder.get();
+		}
+
+		// loops are not passed, blocks that are part of a running loop are generated by the DSP thread
+		static const std::map<TWord, TWord> noLoops;
+		static const std::set<TWord> noLoopEnds;
+
+		e.block.setMode(&_job.mode);
+		e.block.setOpcodeSnapshot(&_job.opcodes);
+
+		const auto success = e.block.emit(*b, nullptr, _job.pc, m_cache, _job.volatileP, noLoops, noLoopEnds, false);
+
+		e.block.setOpcodeSnapshot(nullptr);
+		e.block.setMode(nullptr);
+
+		if(_job.stopAt != g_invalidAddress)
+			m_cache[_job.stopAt].block = nullptr;
+
+		m_errorHandler->setBlock(nullptr);
+
+		if(!success)
+		{
+			LOG("Background code generation failed for PC " << HEX(_job.pc));
+			delete b;
+			return nullptr;
+		}
+
+		e.emitter.finalize();
+
+		TJitFunc func;
+
+		const auto err = m_jit.getRuntime()->add(&func, &e.codeHolder);
+
+		if(err)
+		{
+			const auto* const errString = asmjit::DebugUtils::errorAsString(err);
+			LOG("JIT failed: " << err << " - " << errString << "PC " << HEX(_job.pc));
+			delete b;
+			return nullptr;
+		}
+
+		b->finalize(func, e.codeHolder);
+
+		return b;
+	}
+}
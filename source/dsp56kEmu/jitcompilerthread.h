@@ -0,0 +1,83 @@
+#pragma once
+
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+
+#include "jitcacheentry.h"
+#include "jitconfig.h"
+#include "jitdspmode.h"
+#include "jitopcodesnapshot.h"
+#include "opcodeanalysis.h"
+#include "semaphore.h"
+#include "types.h"
+
+namespace dsp56k
+{
+	class AsmJitErrorHandler;
+	class Jit;
+	class JitBlockRuntimeData;
+	struct JitBlockEmitter;
+
+	// Generates JIT blocks on a background thread, see JitConfig::asyncCompilation
+	// Blocks are generated without links to child blocks as the block chains are owned by the DSP thread. Code is generated from
+	// a copy of the P memory words of the block that is taken when it is requested. The DSP thread validates a block before it is
+	// added to a chain, it is discarded if P memory has been modified in the meantime
+	class JitCompilerThread
+	{
+	public:
+		struct Job
+		{
+			TWord pc = 0;
+			TWord stopAt = g_invalidAddress;	// first address that is occupied by an existing block
+			uint64_t generation = 0;
+			JitDspMode mode;
+			JitConfig config;
+			std::set<TWord> volatileP;
+			JitOpcodeSnapshot opcodes;		// P memory is not read by the compiler thread
+		};
+
+		struct Result
+		{
+			TWord pc = 0;
+			uint64_t generation = 0;
+			JitDspMode mode;
+			JitBlockRuntimeData* block = nullptr;	// nullptr if code generation failed
+		};
+
+		explicit JitCompilerThread(Jit& _jit);
+		~JitCompilerThread();
+
+		JitCompilerThread(const JitCompilerThread&) = delete;
+		JitCompilerThread& operator = (const JitCompilerThread&) = delete;
+
+		void request(Job&& _job);
+
+		bool hasResults() const { return m_hasResults.load(std::memory_order_acquire); }
+		void getResults(std::vector<Result>& _results);
+
+	private:
+		void threadFunc();
+		JitBlockRuntimeData* compile(Job& _job);
+
+		Jit& m_jit;
+
+		std::unique_ptr<AsmJitErrorHandler> m_errorHandler;
+		std::unique_ptr<JitBlockEmitter> m_emitter;
+		std::unique_ptr<JitBlockRuntimeData> m_placeholder;
+		std::vector<JitCacheEntry> m_cache;
+
+		std::mutex m_mutex;
+		std::deque<Job> m_jobs;
+		std::vector<Result> m_results;
+		Semaphore m_jobsAvailable;
+		std::atomic<bool> m_hasResults{false};
+		bool m_exit = false;
+
+		std::unique_ptr<std::thread> m_thread;
+	};
+}
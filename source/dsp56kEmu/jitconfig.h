@@ -35,6 +35,29 @@ namespace dsp56k
 		// x86-64 only: Will issue int3() = breakpoint interrupt if a memory address is detected that points to peripherals but DPA is disabled
 		bool debugDynamicPeripheralAddressing = false;
 
+		// generate code that loads host pointers from a per-block constant pool so that blocks can be stored in a JitCodeCache.
+		// Set automatically if a code cache is attached to the Jit
+		bool relocatableCode = false;
+
+		// generate code that is identical for all DSP instances with the same setup so that it can be placed in a JitSharedCode.
+		// Host pointers that differ per instance are loaded from a relocation table of the Jit. Set automatically if shared code is attached to the Jit
+		bool sharedCode = false;
+
+		// generate JIT blocks on a background thread. Until a block is ready, the code is executed by the interpreter.
+		// Avoids long stalls of the DSP thread when a lot of new code is executed at once, i.e. after boot or when loading new code
+		bool asyncCompilation = false;
+
+		// every JIT block counts how often it is executed, see JitBlockProfiler. Blocks that count executions cannot be stored in a JitCodeCache
+		bool blockProfiling = false;
+
+		// x86-64 only: run a peephole pass over the generated code of each block that removes dead stores, redundant loads and
+		// dead register moves before the block is assembled, see JitOptimizer
+		bool optimizeJitCode = false;
+
+		// emit writes to ESAI/ESSI TX and reads from RX data registers with a known address inline instead of calling the register
+		// handlers, see EsxiDataRegister
+		bool inlineEsxiDataRegisters = false;
+
 		// retrieves a JitConfig for a specific PC. If null, the global default config is used
 		std::function<std::optional<JitConfig>(TWord)> getBlockConfig;
 	};
@@ -1011,6 +1011,9 @@ namespace dsp56k
 
 	JitMemPtr JitDspRegPool::makeDspPtr(const void* _ptr, const size_t _size) const
 	{
+		if(!m_block.canAddressRelativeToDsp(_ptr))
+			return {};
+
 		const void* base = &m_block.dsp().regs();
 		const auto p = Jitmem::makeRelativePtr(_ptr, base, regDspPtr, _size);
 		return p;
@@ -207,13 +207,13 @@ namespace dsp56k
 	void Jitmem::makeBasePtr(const JitReg64& _base, const void* _ptr, const size_t _size/* = sizeof(uint64_t)*/) const
 	{
 #ifdef HAVE_ARM64
-		m_block.asm_().mov(_base, asmjit::Imm(_ptr));
+		m_block.movHostPtr(_base, _ptr);
 #else
 		const auto p = m_block.dspRegPool().makeDspPtr(_ptr, _size);
 		if(isValid(p))
 			m_block.asm_().lea(_base, p);
 		else
-			m_block.asm_().mov(_base, asmjit::Imm(reinterpret_cast<uint64_t>(_ptr)));
+			m_block.movHostPtr(_base, _ptr);
 #endif
 	}
 
@@ -303,6 +303,14 @@ namespace dsp56k
 		m_block.asm_().lea_(r64(_dst), r64(regDspPtr), &m_block.dsp(), &m_block.dsp().regs());
 	}
 
+	void Jitmem::makePeriphPtr(const JitReg64& _dst, const EMemArea _area) const
+	{
+		// loaded from the DSP instead of being an immediate to keep the code relocatable
+		const auto& periph = m_block.dsp().getPeriphRef(_area == MemArea_Y ? 1 : 0);
+		static_assert(sizeof(periph) == sizeof(uint64_t), "unexpected pointer size");
+		mov(_dst, reinterpret_cast<const uint64_t&>(periph));
+	}
+
 	Jitmem::MemoryRef Jitmem::readDspMemory(DspValue& _dst, const EMemArea _area, const JitRegGP& _offset, MemoryRef&& _ref) const
 	{
 		const SkipLabel skip(m_block.asm_());
@@ -651,8 +659,12 @@ namespace dsp56k
 	{
 		_offset |= 0xff0000;
 
+		if(readEsxiRegister(_dst, _area, _offset))
+			return;
+
 		auto* periph = m_block.dsp().getPeriph(_area);
 
+		const auto& reg = periph->getRegister(_offset);
 		const auto* memPtr = periph->readAsPtr(_offset, _inst);
 
 		if(memPtr)
@@ -660,22 +672,35 @@ namespace dsp56k
 			if (!_dst.isRegValid())
 				_dst.temp(DspValue::Memory);
 
+			if(m_block.getConfig().relocatableCode)
+			{
+				JitRelocation r;
+				r.type = JitRelocation::Type::Peripheral;
+				r.ptr = memPtr;
+				r.arg = _offset;
+				r.area = _area;
+				r.inst = _inst;
+
+				m_block.movHostPtr(r64(_dst.get()), std::move(r));
+				mov<sizeof(TWord)>(_dst.get(), makePtr(r64(_dst.get()), sizeof(TWord)));
+				return;
+			}
+
 			mov(_dst.get(), *memPtr);
 			return;
 		}
 
 		{
+			// the address is known, call the register handler directly
 			const FuncArg r0(m_block, 0);
 			const FuncArg r1(m_block, 1);
 			const FuncArg r2(m_block, 2);
-			const FuncArg r3(m_block, 3);
 
-			makeDspPtr(r0);
-			m_block.asm_().mov(r32(r1), asmjit::Imm(_area == MemArea_Y ? 1 : 0));
-			m_block.asm_().mov(r32(r2), asmjit::Imm(_offset));
-			m_block.asm_().mov(r32(r3), asmjit::Imm(_inst));
+			makePeriphPtr(r0, _area);
+			m_block.asm_().mov(r32(r1), asmjit::Imm(_offset));
+			m_block.asm_().mov(r32(r2), asmjit::Imm(_inst));
 
-			m_block.stack().call(asmjit::func_as_ptr(&callDSPMemReadPeriph));
+			m_block.stack().call(asmjit::func_as_ptr(reg.read));
 		}
 
 		if (!_dst.isRegValid())
@@ -768,33 +793,39 @@ namespace dsp56k
 
 	void Jitmem::writePeriph(const EMemArea _area, const TWord& _offset, const DspValue& _value) const
 	{
+		const auto addr = _offset | 0xff0000;
+
+		if(writeEsxiRegister(_area, addr, _value))
+			return;
+
+		// the address is known, call the register handler directly
+		const auto& reg = m_block.dsp().getPeriph(_area)->getRegister(addr);
+
 		const FuncArg r0(m_block, 0);
 		const FuncArg r1(m_block, 1);
 		const FuncArg r2(m_block, 2);
-		const FuncArg r3(m_block, 3);
 		
 		if (_value.isImmediate())
 		{
-			makeDspPtr(r0);
-			m_block.asm_().mov(r32(r3), asmjit::Imm(_value.imm()));
+			makePeriphPtr(r0, _area);
+			m_block.asm_().mov(r32(r2), asmjit::Imm(_value.imm()));
 		}
 		else
 		{
-			auto assignArg = [this](const uint32_t _index, const JitRegGP& _dst, const JitRegGP& _src)
+			auto assignArg = [this, _area](const uint32_t _index, const JitRegGP& _dst, const JitRegGP& _src)
 			{
 				if(_index == 0)
-					makeDspPtr(_dst.as<JitReg64>());
+					makePeriphPtr(_dst.as<JitReg64>(), _area);
 				else if(r32(_dst) != r32(_src))
 					m_block.asm_().mov(r32(_dst), r32(_src));
 			};
 
-			assignFuncArgs({r0, r3}, {regDspPtr, _value.get()}, assignArg);
+			assignFuncArgs({r0, r2}, {regDspPtr, _value.get()}, assignArg);
 		}
 
-		m_block.asm_().mov(r32(r1), asmjit::Imm(_area == MemArea_Y ? 1 : 0));
-		m_block.asm_().mov(r32(r2), asmjit::Imm(_offset));
+		m_block.asm_().mov(r32(r1), asmjit::Imm(addr));
 
-		m_block.stack().call(asmjit::func_as_ptr(&callDSPMemWritePeriph));
+		m_block.stack().call(asmjit::func_as_ptr(reg.write));
 	}
 
 	void Jitmem::writePeriph(EMemArea _area, const DspValue& _offset, const DspValue& _value) const
@@ -818,6 +849,120 @@ namespace dsp56k
 		}
 	}
 
+	bool Jitmem::readEsxiRegister(DspValue& _dst, const EMemArea _area, const TWord _addr) const
+	{
+		if(!m_block.getConfig().inlineEsxiDataRegisters)
+			return false;
+
+		const auto* periph = m_block.dsp().getPeriph(_area);
+		const auto* reg = periph->getEsxiRegister(_addr);
+
+		if(!reg || reg->tx)
+			return false;
+
+		// all members are addressed relative to the peripherals, which keeps the code relocatable
+		const RegGP base(m_block);
+
+		const auto data = makeRelativePtr(reg->data, periph, base, sizeof(TWord));
+		const auto flags = makeRelativePtr(reg->flags, periph, base, sizeof(TWord));
+		const auto control = makeRelativePtr(reg->control, periph, base, sizeof(TWord));
+		const auto status = makeRelativePtr(reg->status, periph, base, sizeof(TWord));
+
+		if(!isValid(data) || !isValid(flags) || !isValid(control) || !isValid(status))
+			return false;
+
+		if (!_dst.isRegValid())
+			_dst.temp(DspValue::Memory);
+
+		auto& a = m_block.asm_();
+
+		const RegGP temp(m_block);
+		const RegGP scratch(m_block);
+
+		makePeriphPtr(base, _area);
+
+		a.clr(r32(_dst.get()));
+
+		const SkipLabel disabled(a);
+
+		// a disabled receiver returns zero
+		mov<sizeof(TWord)>(r32(temp), control);
+		a.test_(r32(temp), asmjit::Imm(reg->controlMask));
+		a.jz(disabled);
+
+		mov<sizeof(TWord)>(r32(temp), flags);
+		clearBits(flags, reg->flagMask, temp, scratch);
+
+		{
+			const SkipLabel notEmpty(a);
+
+			a.test_(r32(temp));
+			a.jnz(notEmpty);
+
+			clearBits(status, reg->statusClearMask, temp, scratch);
+		}
+
+		mov<sizeof(TWord)>(r32(_dst.get()), data);
+
+		return true;
+	}
+
+	bool Jitmem::writeEsxiRegister(const EMemArea _area, const TWord _addr, const DspValue& _value) const
+	{
+		if(!m_block.getConfig().inlineEsxiDataRegisters)
+			return false;
+
+		const auto* periph = m_block.dsp().getPeriph(_area);
+		const auto* reg = periph->getEsxiRegister(_addr);
+
+		if(!reg || !reg->tx)
+			return false;
+
+		const RegGP base(m_block);
+
+		const auto data = makeRelativePtr(reg->data, periph, base, sizeof(TWord));
+		const auto flags = makeRelativePtr(reg->flags, periph, base, sizeof(TWord));
+		const auto control = makeRelativePtr(reg->control, periph, base, sizeof(TWord));
+		const auto status = makeRelativePtr(reg->status, periph, base, sizeof(TWord));
+
+		if(!isValid(data) || !isValid(flags) || !isValid(control) || !isValid(status))
+			return false;
+
+		auto& a = m_block.asm_();
+
+		const RegGP written(m_block);
+		const RegGP temp(m_block);
+
+		makePeriphPtr(base, _area);
+
+		mov<sizeof(TWord)>(data, _value);
+
+		mov<sizeof(TWord)>(r32(written), flags);
+		a.or_(r32(written), asmjit::Imm(reg->flagMask));
+		mov<sizeof(TWord)>(flags, r32(written));
+
+		// the status is updated once all enabled transmitters have been written
+		const SkipLabel pending(a);
+
+		mov<sizeof(TWord)>(r32(temp), control);
+		a.and_(r32(temp), asmjit::Imm(reg->controlMask));
+		a.cmp(r32(temp), r32(written));
+		a.jnz(pending);
+
+		clearBits(status, reg->statusClearMask, temp, written);
+
+		return true;
+	}
+
+	void Jitmem::clearBits(const JitMemPtr& _ptr, const TWord _mask, const JitRegGP& _temp, const JitRegGP& _scratch) const
+	{
+		// the inverted mask is usually not encodable as an immediate on ARM64
+		mov<sizeof(TWord)>(r32(_temp), _ptr);
+		m_block.asm_().mov(r32(_scratch), asmjit::Imm(~_mask));
+		m_block.asm_().and_(r32(_temp), r32(_scratch));
+		mov<sizeof(TWord)>(_ptr, r32(_temp));
+	}
+
 	const TWord* Jitmem::getMemAreaHostPtr(const EMemArea _area) const
 	{
 		const auto& mem = m_block.dsp().memory();
@@ -925,7 +1070,7 @@ namespace dsp56k
 
 		if(!_ref.isValid())
 		{
-			ptr = makeRelativePtr(hostPtr, &m_block.dsp().regs(), regDspPtr, 4);
+			ptr = m_block.dspRegPool().makeDspPtr(hostPtr, 4);
 		}
 		else
 		{
@@ -1062,7 +1207,7 @@ namespace dsp56k
 		}
 
 		// try dsp reg
-		const auto off = pointerOffset(ptr, &m_block.dsp().regs());
+		const auto off = m_block.canAddressRelativeToDsp(ptr) ? pointerOffset(ptr, &m_block.dsp().regs()) : 0;
 		if(off)
 		{
 			m_block.asm_().lea_(r64(_dst), r64(regDspPtr), off);
@@ -95,6 +95,7 @@ namespace dsp56k
 		static JitMemPtr makeRelativePtr(const void* _ptr, const void* _base, const JitReg64& _baseReg, size_t _size);
 
 		void makeDspPtr(const JitReg64& _dst) const;
+		void makePeriphPtr(const JitReg64& _dst, EMemArea _area) const;
 
 		MemoryRef readDspMemory(DspValue& _dstX, DspValue& _dstY, const TWord& _offset) const;
 		MemoryRef readDspMemory(DspValue& _dst, EMemArea _area, TWord _offset) const;
@@ -152,6 +153,10 @@ namespace dsp56k
 
 		void writePeriph(EMemArea _area, const JitReg32& _offset, const DspValue& _value) const;
 
+		bool readEsxiRegister(DspValue& _dst, EMemArea _area, TWord _addr) const;
+		bool writeEsxiRegister(EMemArea _area, TWord _addr, const DspValue& _value) const;
+		void clearBits(const JitMemPtr& _ptr, TWord _mask, const JitRegGP& _temp, const JitRegGP& _scratch) const;
+
 		const TWord* getMemAreaHostPtr(EMemArea _area) const;
 
 		MemoryRef noRef() const;
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <vector>
+
+#include "dspassert.h"
+#include "memory.h"
+#include "types.h"
+
+namespace dsp56k
+{
+	// Copy of the P memory words that a block is generated from. Used by the background compiler as P memory must not be read
+	// while the DSP thread modifies it, see JitCompilerThread
+	class JitOpcodeSnapshot
+	{
+	public:
+		void create(const Memory& _mem, const TWord _first, const TWord _count)
+		{
+			m_first = _first;
+			m_words.resize(_count + 1);
+
+			TWord opB = 0;
+
+			for(TWord i=0; i<_count; ++i)
+				_mem.getOpcode(_first + i, m_words[i], opB);
+
+			m_words[_count] = opB;
+		}
+
+		bool empty() const { return m_words.empty(); }
+
+		void getOpcode(const TWord _offset, TWord& _wordA, TWord& _wordB) const
+		{
+			const auto i = _offset - m_first;
+
+			// the snapshot needs to cover everything that the code generator reads
+			if(_offset < m_first || i + 1 >= m_words.size())
+			{
+				assert(false && "opcode snapshot does not cover the requested address");
+				_wordA = _wordB = 0;
+				return;
+			}
+
+			_wordA = m_words[i];
+			_wordB = m_words[i + 1];
+		}
+
+	private:
+		TWord m_first = 0;
+		std::vector<TWord> m_words;
+	};
+}
@@ -270,7 +270,7 @@ namespace dsp56k
 	{
 		TWord op;
 		TWord opB;
-		m_block.dsp().memory().getOpcode(_pc, op, opB);
+		m_block.getOpcode(_pc, op, opB);
 		emit(_pc, op, opB);
 	}
 
@@ -414,7 +414,7 @@ namespace dsp56k
 	{
 		TWord opA;
 		TWord opB;
-		m_block.dsp().memory().getOpcode(_pc, opA, opB);
+		m_block.getOpcode(_pc, opA, opB);
 		Instruction instA;
 		Instruction instB;
 		m_block.dsp().opcodes().getInstructionTypes(opA, instA, instB);
@@ -548,7 +548,7 @@ namespace dsp56k
 
 	void JitOps::op_Wait(TWord op)
 	{
-		// TODO use this for idle processng
+		// idle time is skipped up to the next peripheral event, see DSP::op_Wait
 		callDSPFunc(&callDSPWait, op);
 		/*
 #ifdef HAVE_X86_64
@@ -837,7 +837,7 @@ namespace dsp56k
 
 		TWord opA;
 		TWord opB;
-		m_block.dsp().mem.getOpcode(m_pcCurrentOp + 1, opA, opB);
+		m_block.getOpcode(m_pcCurrentOp + 1, opA, opB);
 
 		if(opA && !OpcodeInfo::isParallelOpcode(opA))
 		{
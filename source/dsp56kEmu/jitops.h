@@ -510,6 +510,7 @@ namespace dsp56k
 		void updateDirtyCCR(CCRMask _whatToUpdate);
 		void updateDirtyCCRWithTemp(const JitRegGP& _temp, CCRMask _whatToUpdate);
 		void updateDirtyCCR(const JitReg64& _alu, CCRMask _dirtyBits);
+		void deferDirtyCCR(CCRMask _whatToDefer);
 
 		void ccr_getBitValue(const JitRegGP& _dst, CCRBit _bit);
 		void sr_getBitValue(const JitRegGP& _dst, SRBit _bit) const;
@@ -92,6 +92,21 @@ namespace dsp56k
 			ccr_u_update(_alu);
 	}
 
+	void JitOps::deferDirtyCCR(const CCRMask _whatToDefer)
+	{
+		const auto dirty = m_ccrDirty & _whatToDefer;
+		if(!dirty)
+			return;
+
+		// the ALU result is stored unmasked, the bits are computed by the C++ code when needed
+		const RegGP r(m_block);
+		m_asm.movq(r64(r), regLastModAlu);
+		m_block.mem().mov(m_block.ccrPendingAlu(), r64(r));
+		m_block.mem().mov(&m_block.ccrPendingMask(), static_cast<uint32_t>(dirty));
+
+		m_ccrDirty = static_cast<CCRMask>(m_ccrDirty & ~dirty);
+	}
+
 	void JitOps::ccr_v_update(const JitReg64& _nonMaskedResult)
 	{
 		{
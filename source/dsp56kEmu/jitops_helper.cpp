@@ -183,16 +183,29 @@ namespace dsp56k
 
 		static_assert(sizeof(m_block.dsp().m_interruptFunc) == 8);
 
-		if(_mode == DSP::DefaultPreventInterrupt)
+		auto setInterruptFunc = [this](const void* _func)
 		{
-			const auto* ptr = asmjit::func_as_ptr(&dspExecDefaultPreventInterrupt);
-			m_block.mem().mov(reinterpret_cast<uint64_t*>(&m_block.dsp().m_interruptFunc), reinterpret_cast<uint64_t>(ptr));
-		}
+			auto& dst = reinterpret_cast<uint64_t&>(m_block.dsp().m_interruptFunc);
+
+			if(!m_block.getConfig().relocatableCode)
+			{
+				m_block.mem().mov(&dst, reinterpret_cast<uint64_t>(_func));
+				return;
+			}
+
+			JitRelocation r;
+			r.type = JitRelocation::Type::Code;
+			r.ptr = _func;
+
+			const RegGP temp(m_block);
+			m_block.movHostPtr(r64(temp), std::move(r));
+			m_block.mem().mov(dst, r64(temp));
+		};
+
+		if(_mode == DSP::DefaultPreventInterrupt)
+			setInterruptFunc(asmjit::func_as_ptr(&dspExecDefaultPreventInterrupt));
 		else if(_mode == DSP::LongInterrupt)
-		{
-			const auto* ptr = asmjit::func_as_ptr(&dspExecNop);
-			m_block.mem().mov(reinterpret_cast<uint64_t*>(&m_block.dsp().m_interruptFunc), reinterpret_cast<uint64_t>(ptr));
-		}
+			setInterruptFunc(asmjit::func_as_ptr(&dspExecNop));
 		else
 			assert(false && "support missing");
 	}
@@ -1,77 +1,511 @@
 #include "jitoptimizer.h"
 
-#include "logging.h"
+#include "jitemitter.h"
+#include "jitregtypes.h"
 
 #include <asmjit/asmjit.h>
 
-#include "jitemitter.h"
-
 namespace dsp56k
 {
+#ifdef HAVE_X86_64
+	namespace
+	{
+		using namespace asmjit;
+
+		constexpr uint32_t g_groupGp = 0;
+		constexpr uint32_t g_groupVec = 1;
+
+		uint32_t makeKey(const uint32_t _group, const uint32_t _id)
+		{
+			return (_group << 8) | _id;
+		}
+
+		bool isGpKey(const uint32_t _key)
+		{
+			return (_key >> 8) == g_groupGp;
+		}
+
+		// instructions with implicit register or memory operands or that leave the straight-line code
+		constexpr InstId g_barriers[] =
+		{
+			x86::Inst::kIdCall, x86::Inst::kIdRet, x86::Inst::kIdJmp,
+			x86::Inst::kIdPush, x86::Inst::kIdPop, x86::Inst::kIdPushf, x86::Inst::kIdPopf,
+			x86::Inst::kIdMul, x86::Inst::kIdDiv, x86::Inst::kIdIdiv, x86::Inst::kIdMulx,
+			x86::Inst::kIdCbw, x86::Inst::kIdCwde, x86::Inst::kIdCdqe, x86::Inst::kIdCwd, x86::Inst::kIdCdq, x86::Inst::kIdCqo,
+			x86::Inst::kIdCpuid, x86::Inst::kIdRdtsc, x86::Inst::kIdRdtscp,
+			x86::Inst::kIdXchg, x86::Inst::kIdCmpxchg,
+			x86::Inst::kIdMovs, x86::Inst::kIdStos, x86::Inst::kIdLods, x86::Inst::kIdScas, x86::Inst::kIdCmps,
+			x86::Inst::kIdEnter, x86::Inst::kIdLeave, x86::Inst::kIdLahf, x86::Inst::kIdSahf,
+			x86::Inst::kIdInt3, x86::Inst::kIdVzeroupper, x86::Inst::kIdVzeroall
+		};
+
+		bool overlaps(const int32_t _offsetA, const uint32_t _sizeA, const int32_t _offsetB, const uint32_t _sizeB)
+		{
+			return _offsetA < _offsetB + static_cast<int32_t>(_sizeB) && _offsetB < _offsetA + static_cast<int32_t>(_sizeA);
+		}
+
+		bool isMove(const InstId _id)
+		{
+			return _id == x86::Inst::kIdMov || _id == x86::Inst::kIdMovq || _id == x86::Inst::kIdMovd;
+		}
+
+		// instructions that write their destination register completely if it is a 32 or 64 bit GP. The check is limited to these
+		// as other instructions, for example cmov, might only write conditionally
+		bool writesFullGp(const InstId _id)
+		{
+			return isMove(_id) || _id == x86::Inst::kIdMovzx || _id == x86::Inst::kIdMovsx || _id == x86::Inst::kIdMovsxd || _id == x86::Inst::kIdLea;
+		}
+
+		// movq and movd clear the upper bits of an XMM destination
+		bool writesFullVec(const InstId _id)
+		{
+			return _id == x86::Inst::kIdMovq || _id == x86::Inst::kIdMovd;
+		}
+	}
+
 	JitOptimizer::JitOptimizer(JitEmitter& _emitter) : m_asm(_emitter)
 	{
 	}
 
-	void JitOptimizer::optimize(const JitEmitter& _emitter)
+	JitOptimizer::Stats JitOptimizer::optimize()
 	{
-//		optimize(_emitter.firstNode());
+		m_stats = Stats();
+
+		barrier();
+
+		BaseNode* node = m_asm.firstNode();
+
+		while(node)
+		{
+			auto* next = node->next();
+
+			if(node->isInst())
+				process(node->as<InstNode>());
+			else
+				barrier();
+
+			node = next;
+		}
+
+		barrier();
+
+		return m_stats;
+	}
+
+	void JitOptimizer::process(InstNode* _inst)
+	{
+		if(isBarrier(_inst))
+		{
+			barrier();
+			return;
+		}
+
+		Access access;
+
+		if(!decode(access, _inst))
+		{
+			barrier();
+			return;
+		}
+
+		if(tryStore(_inst, access) || tryLoad(_inst, access) || tryCopy(_inst, access))
+			return;
+
+		apply(access);
+
+		// a plain move into a register might turn out to be dead if the register is overwritten before it is read
+		if(isMove(_inst->id()) && _inst->opCount() == 2 && _inst->op(0).isReg())
+		{
+			const auto& dst = access.regs.front();
+
+			if(dst.fullWrite)
+				addPendingWrite(dst.key, _inst);
+		}
 	}
 
-	void JitOptimizer::optimize(asmjit::BaseNode* _node)
+	bool JitOptimizer::decode(Access& _access, const InstNode* _inst)
 	{
-		m_ops.clear();
-		LOG("BEGIN");
+		InstRWInfo rwInfo;
+
+		if(InstAPI::queryRWInfo(Environment::host().arch(), _inst->baseInst(), _inst->operands(), _inst->opCount(), &rwInfo) != kErrorOk)
+			return false;
 
-		/*
-		size_t idx=0;
+		const auto id = _inst->id();
+		const bool isLea = id == x86::Inst::kIdLea;
 
-		while(_node)
+		for(uint32_t i=0; i<_inst->opCount(); ++i)
 		{
-			if(!_node->isInst())
+			const auto& op = _inst->op(i);
+			const auto& opInfo = rwInfo.operand(i);
+
+			if(op.isReg())
 			{
-				_node = _node->next();
-				++idx;
-				continue;
-			}
+				const auto& reg = op.as<BaseReg>();
 
-			const auto* inst = _node->as<asmjit::InstNode>();
-			asmjit::InstRWInfo rwInfo{};
-			asmjit::InstAPI::queryRWInfo(asmjit::Environment::host().arch(), inst->baseInst(), inst->_opArray, inst->opCount(), &rwInfo);
+				// high byte registers share their id with the low byte registers
+				if((!reg.isGp() && !reg.isVec()) || op.as<x86::Reg>().isGpbHi())
+					return false;
 
-			assert(rwInfo.opCount() == inst->opCount());
+				RegAccess r;
+				r.key = makeKey(reg.isGp() ? g_groupGp : g_groupVec, reg.id());
+				r.size = reg.size();
+				r.read = opInfo.isRead() || opInfo.isReadWrite();
+				r.write = opInfo.isWrite() || opInfo.isReadWrite();
+				r.fullWrite = r.write && !r.read && (reg.isGp() ? reg.size() >= 4 && writesFullGp(id) : writesFullVec(id));
 
-			for(size_t i=0; i<rwInfo.opCount(); ++i)
+				_access.regs.push_back(r);
+			}
+			else if(op.isMem())
 			{
-				const auto& op = inst->operands()[i];
+				const auto& mem = op.as<x86::Mem>();
 
-				if(!op.isReg())
-					continue;
+				if(mem.hasBaseReg())
+				{
+					RegAccess base;
+					base.key = makeKey(g_groupGp, mem.baseId());
+					base.read = true;
+					_access.regs.push_back(base);
+				}
 
-				const auto& reg = op.as<asmjit::BaseReg>();
+				if(mem.hasIndexReg())
+				{
+					RegAccess index;
+					index.key = makeKey(g_groupGp, mem.indexId());
+					index.read = true;
+					_access.regs.push_back(index);
+				}
 
-				if(!reg.isGp() && !reg.isVec())
+				// lea only computes the address. If the result points to DSP registers, accesses via that pointer are unknown below
+				if(isLea)
 					continue;
 
-				const asmjit::OpRWInfo& opInfo = rwInfo.operand(i);
+				const bool dspBase = mem.hasBaseReg() && mem.baseId() == regDspPtr.id();
 
-				const auto rw = opInfo.isReadWrite();
-				const auto written = rw || opInfo.isWrite();
-				const auto read = rw || opInfo.isRead();
+				MemAccess m;
+				m.read = opInfo.isRead() || opInfo.isReadWrite();
+				m.write = opInfo.isWrite() || opInfo.isReadWrite();
+				m.offset = static_cast<int32_t>(mem.offset());
+				m.size = mem.size();
 
-				const auto prefix = reg.isVec() ? "vec" : "gp";
+				if(!m.size)
+				{
+					// size is implied by the register operand
+					for(uint32_t j=0; j<_inst->opCount(); ++j)
+					{
+						if(_inst->op(j).isReg())
+							m.size = _inst->op(j).as<BaseReg>().size();
+					}
+				}
 
-				if(rw)
-					LOG(idx << " rw " << prefix << reg._baseId);
-				else if(written)
-					LOG(idx << " write " << prefix << reg._baseId);
-				else if(read)
-					LOG(idx << " read " << prefix << reg._baseId);
+				// Stack accesses and constants do not alias DSP registers. Anything else might, pointers to DSP registers can be
+				// formed via lea or might be embedded as immediates
+				const bool stack = mem.hasBaseReg() && mem.baseId() == x86::Gp::kIdSp;
+				const bool constant = mem.hasBaseLabel();
+
+				if(dspBase && !mem.hasIndexReg() && m.size)
+					m.dspRelative = true;
+				else if(!stack && !constant)
+					m.unknown = true;
+
+				_access.mems.push_back(m);
 			}
+		}
 
-			_node = _node->next();
-			++idx;
+		return true;
+	}
+
+	bool JitOptimizer::isBarrier(const InstNode* _inst) const
+	{
+		const auto id = _inst->id();
+
+		for (const auto b : g_barriers)
+		{
+			if(b == id)
+				return true;
+		}
+
+		// single operand form of imul uses rdx:rax implicitly
+		if(id == x86::Inst::kIdImul && _inst->opCount() < 2)
+			return true;
+
+		// conditional jumps
+		for(uint32_t i=0; i<_inst->opCount(); ++i)
+		{
+			if(_inst->op(i).isLabel())
+				return true;
 		}
-		*/
-		LOG("END");
+
+		// writes to the pointer to the DSP registers invalidate all offsets
+		if(_inst->opCount() && _inst->op(0).isReg() && _inst->op(0).as<BaseReg>().isGp() && _inst->op(0).as<BaseReg>().id() == regDspPtr.id())
+			return true;
+
+		return false;
+	}
+
+	void JitOptimizer::barrier()
+	{
+		m_memFacts.clear();
+		m_copies.clear();
+		m_pendingWrites.clear();
+		m_pendingStores.clear();
+	}
+
+	bool JitOptimizer::tryStore(InstNode* _inst, const Access& _access)
+	{
+		// mov [regDspPtr + offset], reg/imm
+		if(!isMove(_inst->id()) || _inst->opCount() != 2 || !_inst->op(0).isMem() || _access.mems.size() != 1)
+			return false;
+
+		const auto& m = _access.mems.front();
+
+		if(!m.dspRelative || !m.write || m.read)
+			return false;
+
+		// a previous store that is completely covered by this one has never been read
+		for(auto it = m_pendingStores.begin(); it != m_pendingStores.end(); ++it)
+		{
+			if(it->offset >= m.offset && it->offset + static_cast<int32_t>(it->size) <= m.offset + static_cast<int32_t>(m.size))
+			{
+				remove(it->node, m_stats.deadStores);
+				m_pendingStores.erase(it);
+				break;
+			}
+		}
+
+		apply(_access);
+
+		m_pendingStores.push_back({_inst, m.offset, m.size});
+
+		const auto& src = _inst->op(1);
+
+		if(src.isReg())
+		{
+			const auto& reg = src.as<BaseReg>();
+			const auto key = makeKey(reg.isGp() ? g_groupGp : g_groupVec, reg.id());
+
+			if(!reg.isGp() || reg.size() == m.size)
+				m_memFacts[key] = {m.offset, m.size, _inst->id(), false};
+		}
+
+		return true;
+	}
+
+	bool JitOptimizer::tryLoad(InstNode* _inst, const Access& _access)
+	{
+		// mov reg, [regDspPtr + offset]
+		const auto id = _inst->id();
+
+		if(!isMove(id) || _inst->opCount() != 2 || !_inst->op(0).isReg() || !_inst->op(1).isMem() || _access.mems.size() != 1)
+			return false;
+
+		const auto& m = _access.mems.front();
+
+		if(!m.dspRelative || !m.read)
+			return false;
+
+		const auto& dst = _access.regs.front();
+
+		const auto it = m_memFacts.find(dst.key);
+
+		if(it != m_memFacts.end() && it->second.offset == m.offset && it->second.size == m.size)
+		{
+			const auto& f = it->second;
+
+			// Loads of 32 bits into GPs or any load into XMMs clear the upper bits, a previous store does not tell us anything about
+			// these. 8 and 16 bit loads do not modify the upper bits, 64 bit loads write everything
+			const bool redundant = f.fromLoad ? f.instId == id : (isGpKey(dst.key) && m.size != 4);
+
+			if(redundant)
+			{
+				remove(_inst, m_stats.redundantLoads);
+				return true;
+			}
+		}
+
+		apply(_access);
+
+		if(dst.fullWrite)
+			addPendingWrite(dst.key, _inst);
+
+		if(!isGpKey(dst.key) || dst.size == m.size)
+			m_memFacts[dst.key] = {m.offset, m.size, id, true};
+
+		return true;
+	}
+
+	bool JitOptimizer::tryCopy(InstNode* _inst, const Access& _access)
+	{
+		// mov gp64, gp64 / movq xmm, gp64 / movq gp64, xmm / movq xmm, xmm
+		const auto id = _inst->id();
+
+		if(id != x86::Inst::kIdMov && id != x86::Inst::kIdMovq)
+			return false;
+
+		if(_inst->opCount() != 2 || !_inst->op(0).isReg() || !_inst->op(1).isReg() || _access.regs.size() != 2)
+			return false;
+
+		const auto& dst = _access.regs[0];
+		const auto& src = _access.regs[1];
+
+		if(isGpKey(dst.key) && dst.size != 8)
+			return false;
+		if(isGpKey(src.key) && src.size != 8)
+			return false;
+
+		bool redundant = dst.key == src.key && isGpKey(dst.key);
+
+		// the same move has been done before and neither register has been modified since
+		auto it = m_copies.find(dst.key);
+		if(it != m_copies.end() && it->second == src.key)
+			redundant = true;
+
+		// the inverse move has been done before, a GP destination receives exactly the bits that it has been copied from
+		it = m_copies.find(src.key);
+		if(it != m_copies.end() && it->second == dst.key && isGpKey(dst.key))
+			redundant = true;
+
+		if(redundant)
+		{
+			remove(_inst, m_stats.redundantMoves);
+			return true;
+		}
+
+		apply(_access);
+
+		if(dst.fullWrite)
+			addPendingWrite(dst.key, _inst);
+
+		m_copies[dst.key] = src.key;
+
+		return true;
+	}
+
+	void JitOptimizer::apply(const Access& _access)
+	{
+		for (const auto& m : _access.mems)
+		{
+			if(m.read)
+				memRead(m);
+		}
+
+		for (const auto& r : _access.regs)
+		{
+			if(r.read)
+				regRead(r.key);
+		}
+
+		for (const auto& m : _access.mems)
+		{
+			if(m.write)
+				memWrite(m);
+		}
+
+		for (const auto& r : _access.regs)
+		{
+			if(r.write)
+				regWrite(r.key, r.fullWrite);
+		}
+	}
+
+	void JitOptimizer::memRead(const MemAccess& _mem)
+	{
+		if(_mem.unknown)
+		{
+			m_pendingStores.clear();
+			return;
+		}
+
+		if(!_mem.dspRelative)
+			return;
+
+		for(auto it = m_pendingStores.begin(); it != m_pendingStores.end();)
+		{
+			if(overlaps(it->offset, it->size, _mem.offset, _mem.size))
+				it = m_pendingStores.erase(it);
+			else
+				++it;
+		}
+	}
+
+	void JitOptimizer::memWrite(const MemAccess& _mem)
+	{
+		if(_mem.unknown)
+		{
+			m_pendingStores.clear();
+			m_memFacts.clear();
+			return;
+		}
+
+		if(!_mem.dspRelative)
+			return;
+
+		// partially overwritten stores are still live
+		for(auto it = m_pendingStores.begin(); it != m_pendingStores.end();)
+		{
+			if(overlaps(it->offset, it->size, _mem.offset, _mem.size))
+				it = m_pendingStores.erase(it);
+			else
+				++it;
+		}
+
+		for(auto it = m_memFacts.begin(); it != m_memFacts.end();)
+		{
+			if(overlaps(it->second.offset, it->second.size, _mem.offset, _mem.size))
+				it = m_memFacts.erase(it);
+			else
+				++it;
+		}
+	}
+
+	void JitOptimizer::regRead(const RegKey _key)
+	{
+		m_pendingWrites.erase(_key);
+	}
+
+	void JitOptimizer::regWrite(const RegKey _key, const bool _fullWrite)
+	{
+		// a previous move into the register is dead if nothing has read it and the register is now overwritten completely
+		const auto itWrite = m_pendingWrites.find(_key);
+
+		if(itWrite != m_pendingWrites.end())
+		{
+			if(_fullWrite)
+				remove(itWrite->second, m_stats.deadWrites);
+			m_pendingWrites.erase(itWrite);
+		}
+
+		m_memFacts.erase(_key);
+		m_copies.erase(_key);
+
+		for(auto it = m_copies.begin(); it != m_copies.end();)
+		{
+			if(it->second == _key)
+				it = m_copies.erase(it);
+			else
+				++it;
+		}
+	}
+
+	void JitOptimizer::addPendingWrite(const RegKey _key, BaseNode* _node)
+	{
+		// a dead previous move has already been removed by regWrite()
+		m_pendingWrites[_key] = _node;
+	}
+
+	void JitOptimizer::remove(BaseNode* _node, uint32_t& _counter)
+	{
+		m_asm.removeNode(_node);
+		++_counter;
+	}
+#else
+	JitOptimizer::JitOptimizer(JitEmitter& _emitter) : m_asm(_emitter)
+	{
+	}
+
+	JitOptimizer::Stats JitOptimizer::optimize()
+	{
+		// the analysis is based on x86 instruction semantics
+		return {};
 	}
+#endif
 }
@@ -1,6 +1,7 @@
 #pragma once
 
-#include <set>
+#include <cstdint>
+#include <map>
 #include <vector>
 
 #include "asmjit/core/api-config.h"
@@ -10,6 +11,7 @@ namespace asmjit
 	inline namespace ASMJIT_ABI_NAMESPACE
 	{
 		class BaseNode;
+		class InstNode;
 	}
 }
 
@@ -17,21 +19,99 @@ namespace dsp56k
 {
 	class JitEmitter;
 
+	// Post-emission pass over the node list of a JIT block, see JitConfig::optimizeJitCode. Runs before the block is finalized.
+	// The analysis is local to straight-line code, any label, jump, call or instruction with implicit operands ends a region and
+	// everything is assumed to be live at that point. Removed are:
+	// - stores of DSP registers that are overwritten by another store before they are read
+	// - loads of DSP registers into host registers that already hold that value
+	// - moves between GP and XMM registers whose source and destination are already equal
+	// - moves into registers that are overwritten before they are read, i.e. deferred CCR updates via regLastModAlu
 	class JitOptimizer
 	{
-		struct Op
+	public:
+		struct Stats
 		{
-			asmjit::BaseNode* node = nullptr;
+			uint32_t deadStores = 0;
+			uint32_t redundantLoads = 0;
+			uint32_t redundantMoves = 0;
+			uint32_t deadWrites = 0;
+
+			uint32_t total() const { return deadStores + redundantLoads + redundantMoves + deadWrites; }
 		};
 
-	public:
-		JitOptimizer(JitEmitter& _emitter);
+		explicit JitOptimizer(JitEmitter& _emitter);
 
-		void optimize(const JitEmitter& _emitter);
-		void optimize(asmjit::BaseNode* _node);
+		Stats optimize();
 
 	private:
+		using RegKey = uint32_t;
+
+		struct RegAccess
+		{
+			RegKey key = 0;
+			uint32_t size = 0;
+			bool read = false;
+			bool write = false;
+			bool fullWrite = false;		// all bits are written and the previous value is not read
+		};
+
+		struct MemAccess
+		{
+			bool dspRelative = false;	// based on regDspPtr without index, offset and size are exact
+			bool unknown = false;		// might access DSP registers at any offset
+			int32_t offset = 0;
+			uint32_t size = 0;
+			bool read = false;
+			bool write = false;
+		};
+
+		struct Access
+		{
+			std::vector<RegAccess> regs;
+			std::vector<MemAccess> mems;
+		};
+
+		// value of a DSP register that a host register holds
+		struct MemFact
+		{
+			int32_t offset = 0;
+			uint32_t size = 0;
+			uint32_t instId = 0;
+			bool fromLoad = false;
+		};
+
+		struct PendingStore
+		{
+			asmjit::BaseNode* node = nullptr;
+			int32_t offset = 0;
+			uint32_t size = 0;
+		};
+
+		void process(asmjit::InstNode* _inst);
+		bool decode(Access& _access, const asmjit::InstNode* _inst);
+		bool isBarrier(const asmjit::InstNode* _inst) const;
+		void barrier();
+
+		bool tryStore(asmjit::InstNode* _inst, const Access& _access);
+		bool tryLoad(asmjit::InstNode* _inst, const Access& _access);
+		bool tryCopy(asmjit::InstNode* _inst, const Access& _access);
+
+		void apply(const Access& _access);
+		void memRead(const MemAccess& _mem);
+		void memWrite(const MemAccess& _mem);
+		void regRead(RegKey _key);
+		void regWrite(RegKey _key, bool _fullWrite);
+
+		void addPendingWrite(RegKey _key, asmjit::BaseNode* _node);
+		void remove(asmjit::BaseNode* _node, uint32_t& _counter);
+
 		JitEmitter& m_asm;
-		std::vector<Op> m_ops;
+
+		std::map<RegKey, MemFact> m_memFacts;
+		std::map<RegKey, RegKey> m_copies;				// register => register that it equals
+		std::map<RegKey, asmjit::BaseNode*> m_pendingWrites;	// moves into registers that have not been read yet
+		std::vector<PendingStore> m_pendingStores;		// stores of DSP registers that have not been read yet
+
+		Stats m_stats;
 	};
 }
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstdint>
+
+#include "types.h"
+
+#include "asmjit/core/operand.h"
+
+namespace dsp56k
+{
+	// A host pointer that is not encoded into the generated code directly but loaded from a constant pool at the end of
+	// a JIT block. This makes it possible to move the code of a JIT block to another process or another DSP instance
+	// by patching the pool entries only. Shared code loads it from the relocation table of the Jit instead
+	struct JitRelocation
+	{
+		enum class Type : uint8_t
+		{
+			Data,			// pointer into the DSP object or into DSP memory
+			Code,			// host function that is called
+			Block,			// child JIT block, arg = PC of the child
+			Peripheral		// peripheral register as returned by IPeripherals::readAsPtr, arg = address
+		};
+
+		Type type = Type::Data;
+		const void* ptr = nullptr;
+		TWord arg = 0;
+		uint32_t area = 0;
+		uint32_t inst = 0;
+		uint32_t ccrOverwrite = 0;		// Block: CCR bits overwritten by the child, their update has been omitted in the parent
+
+		// shared code only: index into the relocation table of the Jit, see JitSharedCode. Invalid if the pointer is part of the code
+		static constexpr uint32_t InvalidSlot = 0xffffffff;
+		uint32_t slot = InvalidSlot;
+
+		asmjit::Label label;
+		uint64_t codeOffset = 0;
+	};
+}
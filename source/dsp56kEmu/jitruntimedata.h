@@ -10,5 +10,11 @@ namespace dsp56k
 	{
 		TWord m_pMemWriteAddress = g_pcInvalid;
 		TWord m_pMemWriteValue = 0;
+		const void* const* m_relocationTable = nullptr;		// shared code loads host pointers of this DSP from here
+
+		// CCR bits that a block did not compute before returning to the C++ code, they are computed from the ALU result
+		// once they are needed, see DSP::updateDirtyJitCCR
+		uint64_t m_ccrPendingAlu = 0;
+		uint32_t m_ccrPendingMask = 0;
 	};
 }
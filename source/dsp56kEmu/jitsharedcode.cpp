@@ -0,0 +1,151 @@
+#include "jitsharedcode.h"
+
+#include <cassert>
+
+#include "jitblockruntimedata.h"
+
+#include "asmjit/core/jitruntime.h"
+
+namespace dsp56k
+{
+	JitSharedCode::JitSharedCode() : m_rt(new asmjit::JitRuntime())
+	{
+	}
+
+	JitSharedCode::~JitSharedCode()
+	{
+		// all attached instances hold a reference to us, their code has been released already
+		assert(m_refs.empty());
+		m_blocks.clear();
+	}
+
+	size_t JitSharedCode::KeyHash::operator()(const JitCodeCache::Key& _k) const
+	{
+		size_t h = std::hash<uint64_t>()(_k.opcodes);
+		h ^= std::hash<uint64_t>()(_k.environment) + 0x9e3779b9 + (h << 6) + (h >> 2);
+		h ^= std::hash<uint64_t>()(_k.config) + 0x9e3779b9 + (h << 6) + (h >> 2);
+		h ^= std::hash<uint64_t>()((static_cast<uint64_t>(_k.pc) << 32) | _k.memSize) + 0x9e3779b9 + (h << 6) + (h >> 2);
+		h ^= std::hash<uint32_t>()(_k.mode) + 0x9e3779b9 + (h << 6) + (h >> 2);
+		return h;
+	}
+
+	std::shared_ptr<const JitSharedCode::Block> JitSharedCode::acquire(const JitCodeCache::Key& _key)
+	{
+		std::lock_guard lock(m_mutex);
+
+		const auto it = m_blocks.find(_key);
+
+		if(it == m_blocks.end())
+		{
+			++m_stats.misses;
+			return {};
+		}
+
+		++m_refs[it->second->func].refCount;
+		++m_stats.hits;
+
+		return it->second;
+	}
+
+	bool JitSharedCode::publish(const JitCodeCache::Key& _key, const JitBlockRuntimeData& _block, const DSP& _dsp)
+	{
+		auto b = std::make_shared<Block>();
+
+		for (const auto& r : _block.getRelocations())
+		{
+			// pointers that could not be put into the relocation table are part of the code, it is specific to the instance
+			if(r.slot == JitRelocation::InvalidSlot)
+				return false;
+
+			b->slots.push_back(r.slot);
+		}
+
+		auto& e = b->entry;
+
+		e.key = _key;
+		e.info = _block.getInfo();
+		e.disasm = _block.getDisasm();
+		e.lastOpSize = _block.m_lastOpSize;
+		e.singleOpWordA = _block.m_singleOpWordA;
+		e.singleOpWordB = _block.m_singleOpWordB;
+		e.encodedInstructionCount = _block.m_encodedInstructionCount;
+		e.encodedCycles = _block.m_encodedCycles;
+		e.child = _block.m_child;
+		e.nonBranchChild = _block.m_nonBranchChild;
+		e.opcodes = JitCodeCache::readOpcodes(_dsp, e.info);
+
+		b->func = _block.getFunc();
+		b->codeSize = _block.getCodeSize();
+
+		std::lock_guard lock(m_mutex);
+
+		if(m_blocks.find(_key) != m_blocks.end())
+			return false;
+
+		auto& ref = m_refs[b->func];
+		ref.key = _key;
+		ref.refCount = 1;
+
+		m_blocks.insert(std::make_pair(_key, std::move(b)));
+
+		++m_stats.published;
+
+		return true;
+	}
+
+	void JitSharedCode::release(const TJitFunc _func)
+	{
+		std::lock_guard lock(m_mutex);
+
+		const auto it = m_refs.find(_func);
+
+		if(it != m_refs.end())
+		{
+			assert(it->second.refCount > 0);
+
+			if(--it->second.refCount)
+				return;
+
+			m_blocks.erase(it->second.key);
+			m_refs.erase(it);
+		}
+
+		m_rt->release(_func);
+	}
+
+	uint32_t JitSharedCode::getSlot(const JitCodeCache::Relocation& _reloc)
+	{
+		const SlotKey key(_reloc.base, _reloc.value, _reloc.arg, _reloc.area, _reloc.inst, _reloc.check);
+
+		std::lock_guard lock(m_mutex);
+
+		const auto it = m_slotIndices.find(key);
+
+		if(it != m_slotIndices.end())
+			return it->second;
+
+		const auto slot = static_cast<uint32_t>(m_slots.size());
+
+		m_slots.push_back(_reloc);
+		m_slots.back().codeOffset = 0;
+		m_slotIndices.insert(std::make_pair(key, slot));
+
+		return slot;
+	}
+
+	JitCodeCache::Relocation JitSharedCode::getSlotRelocation(const uint32_t _slot) const
+	{
+		std::lock_guard lock(m_mutex);
+		return m_slots[_slot];
+	}
+
+	JitSharedCode::Stats JitSharedCode::getStats() const
+	{
+		std::lock_guard lock(m_mutex);
+
+		auto s = m_stats;
+		s.blocks = m_blocks.size();
+		s.slots = m_slots.size();
+		return s;
+	}
+}
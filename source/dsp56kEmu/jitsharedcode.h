@@ -0,0 +1,99 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+#include "jitcodecache.h"
+#include "jittypes.h"
+
+namespace asmjit
+{
+	inline namespace ASMJIT_ABI_NAMESPACE
+	{
+		class JitRuntime;
+	}
+}
+
+namespace dsp56k
+{
+	// Process-wide storage for JIT code that is shared between DSP instances with an identical setup, see JitConfig::sharedCode.
+	// Shared code does not contain any host pointer that differs between instances, these are loaded from the relocation table
+	// of each Jit. The table index of such a pointer (slot) is assigned here so that it is identical for all instances.
+	// All code of attached instances is placed into the runtime of this class. Published blocks are reference counted and
+	// are freed once the last instance has released them
+	class JitSharedCode
+	{
+	public:
+		struct Block
+		{
+			JitCodeCache::Entry entry;		// block metadata, code and relocations are unused
+			std::vector<uint32_t> slots;	// relocation table entries that the block reads
+			TJitFunc func = nullptr;
+			size_t codeSize = 0;
+		};
+
+		struct Stats
+		{
+			uint64_t hits = 0;
+			uint64_t misses = 0;
+			uint64_t published = 0;
+			size_t blocks = 0;		// number of blocks that are currently shared
+			size_t slots = 0;
+		};
+
+		JitSharedCode();
+		~JitSharedCode();
+
+		JitSharedCode(const JitSharedCode&) = delete;
+		JitSharedCode& operator = (const JitSharedCode&) = delete;
+
+		asmjit::JitRuntime& getRuntime() { return *m_rt; }
+
+		// returns the block and increases its reference count, nullptr if there is no block for the key
+		std::shared_ptr<const Block> acquire(const JitCodeCache::Key& _key);
+
+		// makes a block that has been generated by an attached instance available to others. The block is referenced once, by
+		// the caller. Fails if a block for the same key exists already, the code of the caller stays private in this case
+		bool publish(const JitCodeCache::Key& _key, const JitBlockRuntimeData& _block, const DSP& _dsp);
+
+		// releases a reference to a published block or frees private code
+		void release(TJitFunc _func);
+
+		// returns the relocation table index for a relocation. Block relocations need the JitDspMode in area as children are per chain
+		uint32_t getSlot(const JitCodeCache::Relocation& _reloc);
+		JitCodeCache::Relocation getSlotRelocation(uint32_t _slot) const;
+
+		Stats getStats() const;
+
+	private:
+		using SlotKey = std::tuple<JitCodeCache::RelocationBase, int64_t, TWord, uint32_t, uint32_t, uint64_t>;
+
+		struct KeyHash
+		{
+			size_t operator () (const JitCodeCache::Key& _k) const;
+		};
+
+		struct FuncRef
+		{
+			JitCodeCache::Key key;
+			uint32_t refCount = 0;
+		};
+
+		mutable std::mutex m_mutex;
+
+		std::unique_ptr<asmjit::JitRuntime> m_rt;
+
+		std::unordered_map<JitCodeCache::Key, std::shared_ptr<const Block>, KeyHash> m_blocks;
+		std::unordered_map<TJitFunc, FuncRef> m_refs;
+
+		std::map<SlotKey, uint32_t> m_slotIndices;
+		std::vector<JitCodeCache::Relocation> m_slots;
+
+		Stats m_stats;
+	};
+}
@@ -0,0 +1,119 @@
+#include "jitsingleopcache.h"
+
+#include <cassert>
+
+namespace dsp56k
+{
+	JitSingleOpCache::JitSingleOpCache(const size_t _capacity)
+	{
+		uint32_t bits = 4;
+		while((static_cast<size_t>(1) << bits) < _capacity)
+			++bits;
+
+		m_capacity = static_cast<size_t>(1) << bits;
+		m_mask = m_capacity - 1;
+		m_shift = 32 - bits;
+
+		// linear probing degrades quickly if the table is nearly full
+		m_maxSize = m_capacity - (m_capacity >> 2);
+	}
+
+	JitBlockRuntimeData* JitSingleOpCache::find(const TWord _pc, const uint64_t _key) const
+	{
+		if(empty())
+			return nullptr;
+
+		for(auto i = home(_pc);; i = (i + 1) & m_mask)
+		{
+			const auto& e = m_entries[i];
+
+			if(!e.block)
+				return nullptr;
+
+			if(e.pc == _pc && e.key == _key)
+				return e.block;
+		}
+	}
+
+	JitBlockRuntimeData* JitSingleOpCache::remove(const TWord _pc, const uint64_t _key)
+	{
+		if(empty())
+			return nullptr;
+
+		for(auto i = home(_pc);; i = (i + 1) & m_mask)
+		{
+			const auto& e = m_entries[i];
+
+			if(!e.block)
+				return nullptr;
+
+			if(e.pc == _pc && e.key == _key)
+			{
+				auto* b = e.block;
+				eraseSlot(i);
+				return b;
+			}
+		}
+	}
+
+	JitBlockRuntimeData* JitSingleOpCache::insert(const TWord _pc, const uint64_t _key, JitBlockRuntimeData* _block)
+	{
+		assert(_block);
+		assert(!contains(_pc, _key));
+
+		if(m_entries.empty())
+			m_entries.resize(m_capacity);
+
+		JitBlockRuntimeData* evicted = nullptr;
+
+		if(m_size >= m_maxSize)
+		{
+			// evict the first entry in the probe sequence of the new key. As the hash is well distributed, this is a random eviction
+			auto i = home(_pc);
+
+			while(!m_entries[i].block)
+				i = (i + 1) & m_mask;
+
+			evicted = m_entries[i].block;
+			eraseSlot(i);
+
+			++m_stats.evictions;
+		}
+
+		auto i = home(_pc);
+
+		while(m_entries[i].block)
+			i = (i + 1) & m_mask;
+
+		auto& e = m_entries[i];
+		e.block = _block;
+		e.key = _key;
+		e.pc = _pc;
+
+		++m_size;
+		++m_stats.inserts;
+
+		return evicted;
+	}
+
+	void JitSingleOpCache::eraseSlot(const size_t _index)
+	{
+		// backward shift deletion, no tombstones needed
+		auto hole = _index;
+
+		for(auto i = (_index + 1) & m_mask; m_entries[i].block; i = (i + 1) & m_mask)
+		{
+			const auto h = home(m_entries[i].pc);
+
+			// the entry can be moved into the hole if the hole is located between its home slot and its current slot
+			if(((i - h) & m_mask) >= ((i - hole) & m_mask))
+			{
+				m_entries[hole] = m_entries[i];
+				hole = i;
+			}
+		}
+
+		m_entries[hole] = Entry();
+		--m_size;
+	}
+}
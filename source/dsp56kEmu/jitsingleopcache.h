@@ -0,0 +1,120 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "types.h"
+
+namespace dsp56k
+{
+	class JitBlockRuntimeData;
+	class JitUnittests;
+
+	// Stores JIT blocks that consist of a single op and have been removed because P memory has been overwritten. If the
+	// same op is written again later, which is common for self-modifying code, the block can be reused.
+	// The table uses open addressing with linear probing and has a fixed capacity. If it is full, an existing entry is evicted
+	class JitSingleOpCache
+	{
+		friend class JitUnittests;
+	public:
+		struct Stats
+		{
+			uint64_t hits = 0;
+			uint64_t misses = 0;
+			uint64_t inserts = 0;
+			uint64_t evictions = 0;
+
+			Stats& operator += (const Stats& _s)
+			{
+				hits += _s.hits;
+				misses += _s.misses;
+				inserts += _s.inserts;
+				evictions += _s.evictions;
+				return *this;
+			}
+		};
+
+		explicit JitSingleOpCache(size_t _capacity = 8192);
+
+		bool empty() const { return m_size == 0; }
+		size_t size() const { return m_size; }
+
+		JitBlockRuntimeData* find(TWord _pc, uint64_t _key) const;
+		bool contains(const TWord _pc, const uint64_t _key) const { return find(_pc, _key) != nullptr; }
+
+		// returns the removed block or nullptr if there was no entry
+		JitBlockRuntimeData* remove(TWord _pc, uint64_t _key);
+
+		// returns a block that had to be evicted to make room or nullptr. The key must not be present yet
+		JitBlockRuntimeData* insert(TWord _pc, uint64_t _key, JitBlockRuntimeData* _block);
+
+		template<typename TPred, typename TRemoved> void removeIf(const TWord _pc, const TPred& _pred, const TRemoved& _onRemoved)
+		{
+			if(empty())
+				return;
+
+			for(auto i = home(_pc); m_entries[i].block;)
+			{
+				const auto& e = m_entries[i];
+
+				if(e.pc == _pc && _pred(e.block))
+				{
+					auto* b = e.block;
+					eraseSlot(i);
+					_onRemoved(b);
+
+					// erasing moves the following entries back, check this slot again
+					continue;
+				}
+
+				i = (i + 1) & m_mask;
+			}
+		}
+
+		template<typename TRemoved> void clear(const TRemoved& _onRemoved)
+		{
+			for (auto& e : m_entries)
+			{
+				if(!e.block)
+					continue;
+				_onRemoved(e.block);
+				e = Entry();
+			}
+			m_size = 0;
+		}
+
+		void countLookup(const bool _hit)
+		{
+			if(_hit)
+				++m_stats.hits;
+			else
+				++m_stats.misses;
+		}
+
+		const Stats& getStats() const { return m_stats; }
+
+	private:
+		struct Entry
+		{
+			JitBlockRuntimeData* block = nullptr;	// nullptr = empty slot
+			uint64_t key = 0;
+			TWord pc = 0;
+		};
+
+		size_t home(const TWord _pc) const
+		{
+			// Fibonacci hashing, all single op blocks of one address are stored next to each other
+			return static_cast<uint32_t>(_pc * 2654435769u) >> m_shift;
+		}
+
+		void eraseSlot(size_t _index);
+
+		std::vector<Entry> m_entries;	// allocated on first insert
+		size_t m_capacity;
+		size_t m_mask;
+		uint32_t m_shift;
+		size_t m_size = 0;
+		size_t m_maxSize;
+		Stats m_stats;
+	};
+}
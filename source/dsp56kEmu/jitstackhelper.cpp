@@ -228,7 +228,7 @@ namespace dsp56k
 	{
 		call([&]()
 		{
-			m_block.asm_().call(_funcAsPtr);
+			m_block.callHostFunc(_funcAsPtr);
 		});
 	}
 
@@ -1,11 +1,22 @@
 #include "jitunittests.h"
 
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <map>
+#include <sstream>
+#include <thread>
+
 #include "jitasmjithelpers.h"
 #include "jitblock.h"
+#include "jitblockprofiler.h"
 #include "jitblockruntimedata.h"
+#include "jitcodecache.h"
 #include "jitemitter.h"
 #include "jithelper.h"
 #include "jitops.h"
+#include "jitsingleopcache.h"
+#include "savestate.h"
 
 namespace dsp56k
 {
@@ -52,6 +63,14 @@ namespace dsp56k
 		rep_div();
 
 		parallelMoveXY();
+
+		codeCache();
+		asyncCompilation();
+		singleOpCache();
+		loadStateInsideLoop();
+		esxiDataRegisters();
+		interruptPendingCCR();
+		blockProfiler();
 	}
 
 	JitUnittests::~JitUnittests()
@@ -1060,6 +1079,747 @@ namespace dsp56k
 		});
 	}
 
+	void JitUnittests::codeCache()
+	{
+		dsp.memory().set(MemArea_P, 0x100, 0x000008);	// inc a
+		dsp.memory().set(MemArea_P, 0x101, 0x000008);	// inc a
+		dsp.memory().set(MemArea_P, 0x102, 0x0ae080);	// jmp (r0)
+
+		auto run = [&]()
+		{
+			dsp.regs().a.var = 0;
+			dsp.regs().r[0].var = 0x100;
+			dsp.setPC(0x100);
+
+			for(size_t i=0; i<3; ++i)
+				dsp.exec();
+
+			return dsp.regs().a.var;
+		};
+
+		const auto filename = (std::filesystem::temp_directory_path() / "dsp56kJitCodeCacheTest.bin").string();
+
+		auto cache = std::make_shared<JitCodeCache>();
+		dsp.getJit().setCodeCache(cache);
+
+		verify(run() == 6);
+
+		const auto generated = cache->getStats();
+		verify(generated.stores > 0);
+		verify(generated.misses > 0);
+		verify(generated.hits == 0);
+
+		verify(cache->save(filename));
+
+		// replacing the cache destroys all blocks, they are loaded from the file now instead of being generated again
+		auto loaded = std::make_shared<JitCodeCache>();
+		verify(loaded->load(filename));
+		verify(loaded->size() == cache->size());
+
+		dsp.getJit().setCodeCache(loaded);
+
+		verify(run() == 6);
+
+		const auto reloaded = loaded->getStats();
+		verify(reloaded.hits > 0);
+		verify(reloaded.misses == 0);
+		verify(reloaded.stores == 0);
+
+		dsp.getJit().setCodeCache(nullptr);
+
+		std::filesystem::remove(filename);
+
+		// keys only contain a hash of the opcodes, an entry is used only if its opcodes are identical to P memory
+		JitCodeCache::Entry entry;
+		entry.info.pc = 0x100;
+		entry.info.memSize = 3;
+		entry.opcodes = JitCodeCache::readOpcodes(dsp, entry.info);
+
+		verify(entry.opcodes.size() == 4);
+		verify(entry.opcodes[0] == 0x000008 && entry.opcodes[1] == 0x000008 && entry.opcodes[2] == 0x0ae080);
+		verify(JitCodeCache::matchesOpcodes(entry, dsp));
+
+		dsp.memory().set(MemArea_P, 0x101, 0x000009);	// inc b
+		verify(!JitCodeCache::matchesOpcodes(entry, dsp));
+
+		dsp.memory().set(MemArea_P, 0x101, 0x000008);	// inc a
+		verify(JitCodeCache::matchesOpcodes(entry, dsp));
+	}
+
+	void JitUnittests::asyncCompilation()
+	{
+		const auto config = dsp.getJit().getConfig();
+
+		auto c = config;
+		c.asyncCompilation = true;
+		dsp.getJit().setConfig(c);
+		dsp.getJit().destroyAllBlocks();
+
+		auto run = [&](const TWord _pc)
+		{
+			dsp.regs().a.var = 0;
+			dsp.regs().r[0].var = _pc;
+			dsp.setPC(_pc);
+			dsp.exec();
+			return dsp.regs().a.var;
+		};
+
+		// runs until the background result has been picked up, the block executes all instructions at once
+		auto waitForBlock = [&](const TWord _pc)
+		{
+			const auto timeout = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+
+			while(!dsp.getJit().getCurrentChain()->getBlock(_pc) && std::chrono::steady_clock::now() < timeout)
+			{
+				run(_pc);
+				std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			}
+
+			return dsp.getJit().getCurrentChain()->getBlock(_pc) != nullptr;
+		};
+
+		// publish: the first instruction is interpreted while the block is generated in the background
+		dsp.memory().set(MemArea_P, 0x200, 0x000008);	// inc a
+		dsp.memory().set(MemArea_P, 0x201, 0x000008);	// inc a
+		dsp.memory().set(MemArea_P, 0x202, 0x0ae080);	// jmp (r0)
+
+		verify(run(0x200) == 1);
+		verify(dsp.getPC().var == 0x201);
+
+		verify(waitForBlock(0x200));
+
+		verify(run(0x200) == 2);
+		verify(dsp.getPC().var == 0x200);
+
+		// fallback: P memory is modified while the block is pending. The stale result has to be discarded, the block is then
+		// generated synchronously from the current code
+		dsp.memory().set(MemArea_P, 0x300, 0x000008);	// inc a
+		dsp.memory().set(MemArea_P, 0x301, 0x000008);	// inc a
+		dsp.memory().set(MemArea_P, 0x302, 0x0ae080);	// jmp (r0)
+
+		verify(run(0x300) == 1);
+
+		dsp.memWriteP(0x301, 0x000000);					// nop
+
+		verify(waitForBlock(0x300));
+
+		verify(run(0x300) == 1);
+		verify(dsp.getPC().var == 0x300);
+
+		dsp.getJit().setConfig(config);
+		dsp.getJit().destroyAllBlocks();
+	}
+
+	void JitUnittests::singleOpCache()
+	{
+		// the cache never dereferences the blocks, fake pointers are sufficient
+		auto block = [](const size_t _i)
+		{
+			return reinterpret_cast<JitBlockRuntimeData*>(static_cast<uintptr_t>(0x1000 + (_i << 4)));
+		};
+
+		// addresses whose home slot is the given one
+		auto findPCs = [](const JitSingleOpCache& _cache, const size_t _home, const size_t _count)
+		{
+			std::vector<TWord> pcs;
+			for(TWord pc=0; pcs.size() < _count; ++pc)
+			{
+				if(_cache.home(pc) == _home)
+					pcs.push_back(pc);
+			}
+			return pcs;
+		};
+
+		using Key = std::pair<TWord, uint64_t>;
+
+		// every entry of the reference needs to be found, nothing else may be found
+		auto verifyCache = [](const JitSingleOpCache& _cache, const std::map<Key, JitBlockRuntimeData*>& _ref)
+		{
+			verify(_cache.size() == _ref.size());
+
+			for (const auto& [k, b] : _ref)
+				verify(_cache.find(k.first, k.second) == b);
+
+			size_t count = 0;
+
+			for (const auto& e : _cache.m_entries)
+			{
+				if(!e.block)
+					continue;
+
+				++count;
+
+				const auto it = _ref.find(Key(e.pc, e.key));
+				verify(it != _ref.end() && it->second == e.block);
+			}
+
+			verify(count == _ref.size());
+		};
+
+		// collisions: several addresses with the same home slot plus multiple keys per address
+		{
+			JitSingleOpCache cache(16);
+			std::map<Key, JitBlockRuntimeData*> ref;
+
+			const auto pcs = findPCs(cache, 5, 3);
+
+			size_t i = 0;
+
+			for (const auto pc : pcs)
+			{
+				for(uint64_t key=0; key<3; ++key, ++i)
+				{
+					verify(cache.insert(pc, key, block(i)) == nullptr);
+					ref.insert(std::make_pair(Key(pc, key), block(i)));
+				}
+			}
+
+			verifyCache(cache, ref);
+
+			verify(!cache.contains(pcs[0], 3));
+			verify(cache.getStats().inserts == 9);
+			verify(cache.getStats().evictions == 0);
+		}
+
+		// wrap-around: entries of the last slot continue at the beginning of the table and are moved back across the end on erase
+		{
+			JitSingleOpCache cache(16);
+			std::map<Key, JitBlockRuntimeData*> ref;
+
+			const auto last = cache.m_capacity - 1;
+			const auto pcs = findPCs(cache, last, 3);
+
+			for(size_t i=0; i<pcs.size(); ++i)
+			{
+				cache.insert(pcs[i], 0, block(i));
+				ref.insert(std::make_pair(Key(pcs[i], 0), block(i)));
+			}
+
+			verify(cache.m_entries[last].pc == pcs[0]);
+			verify(cache.m_entries[0].pc == pcs[1]);
+			verify(cache.m_entries[1].pc == pcs[2]);
+
+			verifyCache(cache, ref);
+
+			verify(cache.remove(pcs[0], 0) == block(0));
+			ref.erase(Key(pcs[0], 0));
+
+			verify(cache.m_entries[last].pc == pcs[1]);
+			verify(cache.m_entries[0].pc == pcs[2]);
+			verify(cache.m_entries[1].block == nullptr);
+
+			verifyCache(cache, ref);
+		}
+
+		// erase in the middle of a probe chain. The chain is followed by an entry of the next home slot that has been displaced by it
+		{
+			JitSingleOpCache cache(16);
+			std::map<Key, JitBlockRuntimeData*> ref;
+
+			const auto chain = findPCs(cache, 7, 4);
+			const auto next = findPCs(cache, 8, 1);
+
+			for(size_t i=0; i<chain.size(); ++i)
+			{
+				cache.insert(chain[i], 0, block(i));
+				ref.insert(std::make_pair(Key(chain[i], 0), block(i)));
+			}
+
+			cache.insert(next[0], 0, block(10));
+			ref.insert(std::make_pair(Key(next[0], 0), block(10)));
+
+			verify(cache.m_entries[11].pc == next[0]);
+
+			verify(cache.remove(chain[1], 0) == block(1));
+			ref.erase(Key(chain[1], 0));
+
+			verifyCache(cache, ref);
+			verify(cache.m_entries[10].pc == next[0]);
+			verify(cache.m_entries[11].block == nullptr);
+
+			verify(cache.remove(chain[1], 0) == nullptr);
+		}
+
+		// eviction: the table never fills up completely, once the limit is reached each insert evicts an existing entry
+		{
+			JitSingleOpCache cache(16);
+			std::map<Key, JitBlockRuntimeData*> ref;
+
+			size_t i = 0;
+
+			for(; i<cache.m_maxSize; ++i)
+			{
+				verify(cache.insert(static_cast<TWord>(i), 0, block(i)) == nullptr);
+				ref.insert(std::make_pair(Key(static_cast<TWord>(i), 0), block(i)));
+			}
+
+			for(; i<cache.m_maxSize * 3; ++i)
+			{
+				auto* evicted = cache.insert(static_cast<TWord>(i), 0, block(i));
+				verify(evicted != nullptr);
+
+				const auto it = std::find_if(ref.begin(), ref.end(), [&](const auto& _e) { return _e.second == evicted; });
+				verify(it != ref.end());
+				ref.erase(it);
+
+				ref.insert(std::make_pair(Key(static_cast<TWord>(i), 0), block(i)));
+
+				verifyCache(cache, ref);
+			}
+
+			verify(cache.size() == cache.m_maxSize);
+			verify(cache.getStats().evictions == cache.m_maxSize * 2);
+
+			size_t removed = 0;
+			cache.clear([&](JitBlockRuntimeData*) { ++removed; });
+
+			verify(removed == cache.m_maxSize);
+			verify(cache.empty());
+		}
+
+		// removeIf with several entries for the same address, interleaved with entries of another address with the same home slot
+		{
+			JitSingleOpCache cache(16);
+			std::map<Key, JitBlockRuntimeData*> ref;
+
+			const auto pcs = findPCs(cache, 12, 2);
+
+			size_t i = 0;
+
+			for(uint64_t key=0; key<5; ++key)
+			{
+				for (const auto pc : pcs)
+				{
+					cache.insert(pc, key, block(i));
+					ref.insert(std::make_pair(Key(pc, key), block(i++)));
+				}
+			}
+
+			std::vector<JitBlockRuntimeData*> removed;
+
+			// remove every other entry of the first address
+			cache.removeIf(pcs[0], [&](const JitBlockRuntimeData* _b)
+			{
+				return ((reinterpret_cast<uintptr_t>(_b) >> 4) & 2) != 0;
+			}, [&](JitBlockRuntimeData* _b)
+			{
+				removed.push_back(_b);
+			});
+
+			for(auto it = ref.begin(); it != ref.end();)
+			{
+				if(it->first.first == pcs[0] && ((reinterpret_cast<uintptr_t>(it->second) >> 4) & 2))
+				{
+					verify(std::find(removed.begin(), removed.end(), it->second) != removed.end());
+					it = ref.erase(it);
+				}
+				else
+				{
+					++it;
+				}
+			}
+
+			verify(removed.size() == 2);
+			verifyCache(cache, ref);
+
+			// remove all remaining entries of the first address, the second address needs to be unaffected
+			removed.clear();
+			cache.removeIf(pcs[0], [](const JitBlockRuntimeData*) { return true; }, [&](JitBlockRuntimeData* _b) { removed.push_back(_b); });
+
+			verify(removed.size() == 3);
+
+			for(auto it = ref.begin(); it != ref.end();)
+			{
+				if(it->first.first == pcs[0])
+					it = ref.erase(it);
+				else
+					++it;
+			}
+
+			verifyCache(cache, ref);
+			verify(cache.size() == 5);
+		}
+	}
+
+	void JitUnittests::loadStateInsideLoop()
+	{
+		dsp.getJit().destroyAllBlocks();
+
+		// the jmp splits the loop body into two blocks, the loop end is only handled by the second one
+		dsp.memory().set(MemArea_P, 0x100, 0x060580);	// do #5,$104
+		dsp.memory().set(MemArea_P, 0x101, 0x000104);
+		dsp.memory().set(MemArea_P, 0x102, 0x000008);	// inc a
+		dsp.memory().set(MemArea_P, 0x103, 0x0c0104);	// jmp $104
+		dsp.memory().set(MemArea_P, 0x104, 0x000009);	// inc b
+		dsp.memory().set(MemArea_P, 0x105, 0x0c0105);	// jmp $105
+
+		dsp.regs().a.var = 0;
+		dsp.regs().b.var = 0;
+		dsp.setPC(0x100);
+
+		auto inLoop = [](const DSP& _dsp)
+		{
+			return (_dsp.getSR().var & SR_LF) && _dsp.getPC().var == 0x104;
+		};
+
+		for(size_t i=0; i<10 && !inLoop(dsp); ++i)
+			dsp.exec();
+
+		verify(inLoop(dsp));
+		verify(dsp.regs().a.var == 1);
+
+		StateWriter w;
+		dsp.saveState(w);
+
+		// the new instance has never seen the DO instruction
+		DefaultMemoryValidator validator;
+		Peripherals56362 perifX;
+		Peripherals56367 perifY;
+		Memory m(validator, mem.sizeP(), mem.sizeXY(), mem.getBridgedMemoryAddress());
+		DSP clone(m, &perifX, &perifY);
+		clone.getJit().setConfig(dsp.getJit().getConfig());
+
+		StateReader r(w.getData());
+		verify(clone.loadState(r));
+
+		verify(clone.getJit().getLoops().find(0x100) != clone.getJit().getLoops().end());
+
+		auto run = [](DSP& _dsp)
+		{
+			for(size_t i=0; i<100 && _dsp.getPC().var != 0x105; ++i)
+				_dsp.exec();
+		};
+
+		run(dsp);
+		run(clone);
+
+		for (const auto* d : {&dsp, &clone})
+		{
+			verify(d->getPC().var == 0x105);
+			verify(!(d->getSR().var & SR_LF));
+			verify(d->regs().a.var == 5);
+			verify(d->regs().b.var == 5);
+		}
+
+		verify(clone.getSR().var == dsp.getSR().var);
+		verify(clone.regs().la.var == dsp.regs().la.var);
+		verify(clone.regs().lc.var == dsp.regs().lc.var);
+		verify(clone.regs().sp.var == dsp.regs().sp.var);
+		verify(clone.regs().sc.var == dsp.regs().sc.var);
+
+		for(TWord i=0x100; i<0x106; ++i)
+			verify(clone.memory().get(MemArea_P, i) == dsp.memory().get(MemArea_P, i));
+
+		dsp.getJit().destroyAllBlocks();
+	}
+
+	void JitUnittests::esxiDataRegisters()
+	{
+		// movep dd,x:<<qq / movep x:<<qq,dd
+		auto movepWrite = [](const TWord _dddddd, const TWord _addr)
+		{
+			const auto qq = _addr - 0xffff80;
+			return 0x04c080 | (_dddddd << 8) | ((qq & 0x20) << 1) | (qq & 0x1f);
+		};
+
+		auto movepRead = [&](const TWord _addr, const TWord _dddddd)
+		{
+			return movepWrite(_dddddd, _addr) & ~0x008000;
+		};
+
+		// the register descriptions point to the state that the inlined code modifies. It is set up directly, writing
+		// the control registers via the peripherals would start the audio clock
+		auto set = [](const TWord* _ptr, const TWord _value)
+		{
+			*const_cast<TWord*>(_ptr) = _value;
+		};
+
+		// runs the code once with peripheral function calls and once with inlined accesses, the results need to be identical
+		auto run = [&](DSP& _dsp, EsxiClock& _clock, const std::vector<TWord>& _code, const std::vector<TWord>& _regs, const std::function<void()>& _init)
+		{
+			const auto config = _dsp.getJit().getConfig();
+
+			std::array<std::vector<uint64_t>, 2> results;
+
+			for(size_t i=0; i<results.size(); ++i)
+			{
+				auto c = config;
+				c.inlineEsxiDataRegisters = i > 0;
+				_dsp.getJit().setConfig(c);
+				_dsp.getJit().destroyAllBlocks();
+
+				_init();
+				_clock.restartClock();
+
+				_dsp.x0(0x111111);
+				_dsp.x1(0x222222);
+				_dsp.y0(0x333333);
+				_dsp.y1(0x444444);
+				_dsp.regs().a.var = 0;
+				_dsp.regs().b.var = 0;
+
+				const auto end = static_cast<TWord>(0x200 + _code.size());
+
+				for(TWord pc=0x200; pc<end; ++pc)
+					_dsp.memory().set(MemArea_P, pc, _code[pc - 0x200]);
+				_dsp.memory().set(MemArea_P, end, 0x0c0000 | end);	// jmp end
+
+				_dsp.setPC(0x200);
+
+				for(size_t j=0; j<100 && _dsp.getPC().toWord() != end; ++j)
+					_dsp.exec();
+
+				verify(_dsp.getPC().toWord() == end);
+
+				auto& r = results[i];
+
+				r.push_back(_dsp.regs().a.var);
+				r.push_back(_dsp.regs().b.var);
+				r.push_back(_dsp.regs().x.var);
+
+				for (const auto a : _regs)
+				{
+					const auto* reg = _dsp.getPeriph(0)->getEsxiRegister(a);
+					verify(reg);
+					r.push_back(*reg->data);
+					r.push_back(*reg->flags);
+					r.push_back(*reg->status);
+				}
+			}
+
+			_dsp.getJit().setConfig(config);
+			_dsp.getJit().destroyAllBlocks();
+
+			verify(results[0] == results[1]);
+		};
+
+		// ESAI: three of six transmitters and two of four receivers are enabled
+		{
+			auto& esai = peripheralsX.getEsai();
+
+			run(dsp, peripheralsX.getEsaiClock(),
+			{
+				movepWrite(0x04, Esai::M_TX0),	// movep x0,x:<<M_TX0
+				movepWrite(0x05, Esai::M_TX1),	// movep x1,x:<<M_TX1
+				movepWrite(0x06, Esai::M_TX2),	// movep y0,x:<<M_TX2, all enabled transmitters written
+				movepWrite(0x07, Esai::M_TX3),	// movep y1,x:<<M_TX3, disabled transmitter
+				movepRead(Esai::M_RX0, 0x0e),	// movep x:<<M_RX0,a
+				movepRead(Esai::M_RX1, 0x0f),	// movep x:<<M_RX1,b, all pending receivers read
+				movepRead(Esai::M_RX2, 0x04),	// movep x:<<M_RX2,x0, disabled receiver
+			},
+			{Esai::M_TX0, Esai::M_TX1, Esai::M_TX2, Esai::M_TX3, Esai::M_RX0, Esai::M_RX1, Esai::M_RX2},
+			[&]
+			{
+				for(uint32_t i=0; i<6; ++i)
+					set(esai.getTxRegister(i).data, 0);
+				for(uint32_t i=0; i<4; ++i)
+					set(esai.getRxRegister(i).data, 0x500000 + i);
+
+				const auto tx = esai.getTxRegister(0);
+				const auto rx = esai.getRxRegister(0);
+
+				set(tx.flags, 0);
+				set(tx.control, 0x7);
+				set(rx.flags, 0x3);
+				set(rx.control, 0x3);
+				set(tx.status, tx.statusClearMask | rx.statusClearMask);
+			});
+
+			verify(dsp.regs().a.var == 0x00500000000000);
+			verify(dsp.regs().b.var == 0x00500001000000);
+			verify(dsp.x0().var == 0);
+
+			for(uint32_t i=0; i<4; ++i)
+				verify(*esai.getTxRegister(i).data == 0x111111 * (i + 1));
+
+			verify(*esai.getTxRegister(0).flags == 0xf);
+			verify(*esai.getRxRegister(0).flags == 0);
+			verify(esai.readStatusRegister() == 0);
+
+			set(esai.getTxRegister(0).control, 0);
+			set(esai.getRxRegister(0).control, 0);
+		}
+
+		// ESSI: two of three transmitters are enabled, there is only one receiver
+		{
+			DefaultMemoryValidator validator;
+			PeripheralsNop perifY;
+			Peripherals56303 perifX;
+			Memory m(validator, mem.sizeP(), mem.sizeXY(), mem.getBridgedMemoryAddress());
+			DSP d(m, &perifX, &perifY);
+
+			auto& essi = perifX.getEssi0();
+
+			run(d, perifX.getEssiClock(),
+			{
+				movepWrite(0x04, Essi::ESSI0_TX0),	// movep x0,x:<<ESSI0_TX0
+				movepWrite(0x05, Essi::ESSI0_TX1),	// movep x1,x:<<ESSI0_TX1, all enabled transmitters written
+				movepWrite(0x07, Essi::ESSI0_TX2),	// movep y1,x:<<ESSI0_TX2, disabled transmitter
+				movepRead(Essi::ESSI0_RX, 0x0e),	// movep x:<<ESSI0_RX,a
+			},
+			{Essi::ESSI0_TX0, Essi::ESSI0_TX1, Essi::ESSI0_TX2, Essi::ESSI0_RX},
+			[&]
+			{
+				for(uint32_t i=0; i<3; ++i)
+					set(essi.getTxRegister(i).data, 0);
+				set(essi.getRxRegister().data, 0x654321);
+
+				const auto tx = essi.getTxRegister(0);
+				const auto rx = essi.getRxRegister();
+
+				set(tx.flags, 0);
+				set(tx.control, (1 << Essi::CRB_TE0) | (1 << Essi::CRB_TE1) | (1 << Essi::CRB_RE));
+				set(rx.flags, 1);
+				set(tx.status, tx.statusClearMask | rx.statusClearMask);
+			});
+
+			verify(d.regs().a.var == 0x00654321000000);
+			verify(essi.readTX(0) == 0x111111);
+			verify(essi.readTX(1) == 0x222222);
+			verify(essi.readTX(2) == 0x444444);
+			verify(*essi.getTxRegister(0).flags == Essi::CRB_TE);
+			verify(*essi.getRxRegister().flags == 0);
+			verify(essi.readSR() == 0);
+		}
+	}
+
+	void JitUnittests::interruptPendingCCR()
+	{
+		const auto config = dsp.getJit().getConfig();
+
+		// unlinked blocks return to the dispatcher and leave their E, U, N and Z bits pending
+		auto c = config;
+		c.linkJitBlocks = false;
+		dsp.getJit().setConfig(c);
+		dsp.getJit().destroyAllBlocks();
+
+		dsp.memory().set(MemArea_P, 0x200, 0x00000a);	// dec a
+		dsp.memory().set(MemArea_P, 0x201, 0x0c0202);	// jmp $202
+		dsp.memory().set(MemArea_P, 0x202, 0x0c0202);	// jmp $202
+
+		// long interrupt, the ISR overwrites all bits that are pending
+		dsp.memory().set(MemArea_P, Vba_IRQA, 0x0d0300);		// jsr $300
+		dsp.memory().set(MemArea_P, Vba_IRQA + 1, 0x000000);	// nop
+		dsp.memory().set(MemArea_P, 0x300, 0x20001b);			// clr b
+		dsp.memory().set(MemArea_P, 0x301, 0x000004);			// rti
+
+		dsp.regs().a.var = 0;
+		dsp.regs().b.var = 0x00123456000000;
+		dsp.setSR(CCR_Z | CCR_E);
+		dsp.setPC(0x200);
+
+		for(size_t i=0; i<10 && dsp.getPC().toWord() != 0x202; ++i)
+			dsp.exec();
+
+		verify(dsp.getPC().toWord() == 0x202);
+		verify(dsp.getJit().getRuntimeData().m_ccrPendingMask != 0);
+
+		const auto sp = dsp.regs().sp.var;
+
+		dsp.injectInterrupt(Vba_IRQA);
+
+		for(size_t i=0; i<10 && dsp.getPC().toWord() != 0x301; ++i)
+			dsp.exec();
+
+		verify(dsp.getPC().toWord() == 0x301);
+		verify(dsp.regs().sp.var == sp + 1);
+
+		constexpr auto mask = CCR_E | CCR_U | CCR_N | CCR_Z;
+
+		// clr b inside of the ISR
+		verify((dsp.getSR().var & mask) == (CCR_U | CCR_Z));
+
+		for(size_t i=0; i<10 && dsp.getPC().toWord() != 0x202; ++i)
+			dsp.exec();
+
+		// RTI restores the bits of dec a that were pending when the interrupt was taken, a = -1 is negative and unnormalized
+		verify(dsp.getPC().toWord() == 0x202);
+		verify(dsp.regs().sp.var == sp);
+		verify(dsp.regs().b.var == 0);
+		verify((dsp.getSR().var & mask) == (CCR_U | CCR_N));
+
+		dsp.getJit().setConfig(config);
+		dsp.getJit().destroyAllBlocks();
+	}
+
+	void JitUnittests::blockProfiler()
+	{
+		const auto config = dsp.getJit().getConfig();
+
+		auto c = config;
+		c.blockProfiling = true;
+		dsp.getJit().setConfig(c);
+		dsp.getJit().destroyAllBlocks();
+
+		// the first block runs once, the second one loops on itself. Both count their executions in A and B
+		dsp.memory().set(MemArea_P, 0x200, 0x000008);	// inc a
+		dsp.memory().set(MemArea_P, 0x201, 0x0c0210);	// jmp $210
+		dsp.memory().set(MemArea_P, 0x210, 0x000009);	// inc b
+		dsp.memory().set(MemArea_P, 0x211, 0x0ae080);	// jmp (r0)
+
+		auto run = [&]()
+		{
+			dsp.regs().r[0].var = 0x210;
+			dsp.setPC(0x200);
+
+			for(size_t i=0; i<50; ++i)
+				dsp.exec();
+		};
+
+		JitBlockProfiler profiler(dsp);
+
+		// blocks are created by the first run, it might execute the first instructions outside of the generated code
+		run();
+
+		profiler.reset();
+		verify(profiler.collect().empty());
+
+		dsp.regs().a.var = 0;
+		dsp.regs().b.var = 0;
+
+		run();
+		run();
+
+		const auto countA = static_cast<uint64_t>(dsp.regs().a.var);
+		const auto countB = static_cast<uint64_t>(dsp.regs().b.var);
+
+		verify(countA == 2);
+		verify(countB > countA);
+
+		// the loop has been executed most, it is reported first
+		const auto entries = profiler.collect();
+
+		verify(entries.size() == 2);
+
+		verify(entries[0].pc == 0x210);
+		verify(entries[0].memSize == 2);
+		verify(entries[0].executions == countB);
+
+		verify(entries[1].pc == 0x200);
+		verify(entries[1].memSize == 2);
+		verify(entries[1].executions == countA);
+
+		verify(entries[0].cycles > entries[1].cycles);
+
+		const auto hottest = profiler.collect(1);
+		verify(hottest.size() == 1 && hottest[0].pc == 0x210);
+
+		std::stringstream ss;
+		profiler.dump(ss);
+
+		const auto report = ss.str();
+		const auto posB = report.find(" hits " + std::to_string(countB) + ' ');
+		const auto posA = report.find(" hits " + std::to_string(countA) + ' ');
+
+		verify(posB != std::string::npos && posA != std::string::npos && posB < posA);
+
+		profiler.reset();
+		verify(profiler.collect().empty());
+
+		dsp.getJit().setConfig(config);
+		dsp.getJit().destroyAllBlocks();
+	}
+
 	void JitUnittests::emit(const TWord _opA, TWord _opB, TWord _pc)
 	{
 		JitDspMode mode;
@@ -75,6 +75,27 @@ namespace dsp56k
 		// host register pressure test
 		void parallelMoveXY();
 
+		// persistent code cache
+		void codeCache();
+
+		// background compilation
+		void asyncCompilation();
+
+		// hash table of removed single op blocks
+		void singleOpCache();
+
+		// state that is saved inside of a DO loop and loaded into another DSP
+		void loadStateInsideLoop();
+
+		// inlined ESAI/ESSI data register accesses
+		void esxiDataRegisters();
+
+		// CCR bits that are pending when a long interrupt is taken
+		void interruptPendingCCR();
+
+		// execution counters of JIT blocks and the hot block report
+		void blockProfiler();
+
 		void emit(TWord _opA, TWord _opB = 0, TWord _pc = 0) override;
 
 		asmjit::JitRuntime m_rt;
@@ -1,13 +1,16 @@
 #include "memory.h"
 
 
+#include <algorithm>
 #include <fstream>
 #include <iomanip>
+#include <limits>
 
 #include "disasm.h"
 #include "dsp.h"
 #include "error.h"
 #include "omfloader.h"
+#include "savestate.h"
 
 namespace dsp56k
 {
@@ -49,7 +52,7 @@ namespace dsp56k
 			fillWithInitPattern();
 	}
 
-	Memory::Memory(const IMemoryValidator& _memoryMap, TWord _memSizeP, TWord _memSizeXY, TWord _brigedMemoryAddress/* = 0*/, TWord* _externalBuffer/* = nullptr*/)
+	Memory::Memory(const IMemoryValidator& _memoryMap, TWord _memSizeP, TWord _memSizeXY, TWord _brigedMemoryAddress/* = 0*/, TWord* _externalBuffer/* = nullptr*/, std::shared_ptr<MemoryImage> _baseImage/* = {}*/)
 		: m_memoryMap(_memoryMap)
 		, m_size({_memSizeP, _memSizeXY, _memSizeXY})
 		, m_mem({nullptr})
@@ -60,7 +63,7 @@ namespace dsp56k
 		const auto pSize = calcPMemSize(_memSizeP, _memSizeXY, _brigedMemoryAddress);
 		const auto xySize = calcXYMemSize(_memSizeXY, _brigedMemoryAddress);
 
-		m_mmuBuffer.reset(new MemoryBuffer(pSize, xySize, _brigedMemoryAddress));
+		m_mmuBuffer.reset(new MemoryBuffer(pSize, xySize, _brigedMemoryAddress, _baseImage));
 
 		if(m_mmuBuffer->isValid())
 		{
@@ -92,6 +95,15 @@ namespace dsp56k
 				x = address;	address += xySize;
 				y = address;
 			}
+
+			// without MMU, pages cannot be shared but we still want the same initial contents
+			if(_baseImage && _baseImage->matches(pSize, xySize, _brigedMemoryAddress))
+			{
+				std::copy_n(_baseImage->ptrX(), xySize, x);
+				std::copy_n(_baseImage->ptrY(), xySize, y);
+				std::copy_n(_baseImage->ptrP(), xySize, p);
+				std::copy_n(_baseImage->ptrExternal(), pSize - xySize, p + xySize);
+			}
 		}
 
 		m_mem[MemArea_X] = x;
@@ -151,6 +163,34 @@ namespace dsp56k
 		return true;
 	}
 
+	bool Memory::set(const EMemArea _area, const TWord _offset, const TWord* _values, const TWord _count)
+	{
+		bool res = true;
+
+		TWord pFirst = std::numeric_limits<TWord>::max();
+		TWord pLast = 0;
+
+		for(TWord i=0; i<_count; ++i)
+		{
+			auto area = _area;
+			auto offset = _offset + i;
+
+			res &= dspWrite(area, offset, _values[i]);
+
+			if(area != MemArea_P)
+				continue;
+
+			pFirst = std::min(pFirst, offset);
+			pLast = std::max(pLast, offset);
+		}
+
+		// decoded ops and JIT code of the written range need to go, once for the whole range
+		if(m_dsp && pFirst <= pLast)
+			m_dsp->clearOpcodeCache(pFirst, pLast - pFirst + 1);
+
+		return res;
+	}
+
 	// _____________________________________________________________________________
 	// get
 	//
@@ -228,6 +268,56 @@ namespace dsp56k
 		OMFLoader loader;
 		return loader.load( _filename, *this );
 	}
+
+	void Memory::saveState(StateWriter& _w) const
+	{
+		_w.write(m_size);
+
+		// XY words at and above the bridged address are stored in P
+		const auto sizeXY = m_bridgedMemoryAddress ? std::min(m_bridgedMemoryAddress, this->sizeXY()) : this->sizeXY();
+
+		_w.writeWords(x, sizeXY);
+		_w.writeWords(y, sizeXY);
+		_w.writeWords(p, sizeP());
+	}
+
+	bool Memory::loadState(StateReader& _r)
+	{
+		std::array<TWord, MemArea_COUNT> sizes;
+
+		if(!_r.read(sizes) || sizes != m_size)
+			return false;
+
+		const auto sizeXY = m_bridgedMemoryAddress ? std::min(m_bridgedMemoryAddress, this->sizeXY()) : this->sizeXY();
+
+		if(!_r.readWords(x, sizeXY) || !_r.readWords(y, sizeXY))
+			return false;
+
+		std::vector<TWord> pMem(sizeP());
+
+		if(!_r.readWords(pMem.data(), pMem.size()))
+			return false;
+
+		// only modified P memory is written, decoded ops and JIT code of unchanged code stay valid
+		for(TWord i=0; i<sizeP();)
+		{
+			if(p[i] == pMem[i])
+			{
+				++i;
+				continue;
+			}
+
+			const auto first = i;
+
+			for(; i<sizeP() && p[i] != pMem[i]; ++i)
+				p[i] = pMem[i];
+
+			if(m_dsp)
+				m_dsp->clearOpcodeCache(first, i - first);
+		}
+
+		return true;
+	}
 	
 	bool Memory::save(const char* _file, EMemArea _area) const
 	{
@@ -379,6 +469,13 @@ namespace dsp56k
 		}
 	}
 
+	std::shared_ptr<MemoryImage> Memory::createImage() const
+	{
+		if(!m_mmuBuffer)
+			return {};
+		return MemoryImage::create(*m_mmuBuffer);
+	}
+
 	void Memory::memTranslateAddress(EMemArea& _area, const TWord& _addr) const
 	{
 		if(m_mmuBuffer->isValid())
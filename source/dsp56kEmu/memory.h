@@ -29,6 +29,8 @@ namespace dsp56k
 	class DSP;
 
 	class Jitmem;
+	class StateReader;
+	class StateWriter;
 
 	class IMemoryValidator
 	{
@@ -90,13 +92,17 @@ namespace dsp56k
 		//
 	public:
 		explicit Memory(const IMemoryValidator& _memoryMap, TWord _memSize = 0xc00000, TWord* _externalBuffer = nullptr);
-		explicit Memory(const IMemoryValidator& _memoryMap, TWord _memSizeP, TWord _memSizeXY, TWord _brigedMemoryAddress, TWord* _externalBuffer = nullptr);
+		explicit Memory(const IMemoryValidator& _memoryMap, TWord _memSizeP, TWord _memSizeXY, TWord _brigedMemoryAddress, TWord* _externalBuffer = nullptr, std::shared_ptr<MemoryImage> _baseImage = {});
 		Memory(const Memory&) = delete;
 		Memory& operator = (const Memory&) = delete;
 
 		bool				loadOMF				( const std::string& _filename );
 
+		void				saveState			( StateWriter& _w ) const;
+		bool				loadState			( StateReader& _r );
+
 		bool				set					( EMemArea _area, TWord _offset, TWord _value )	{ return dspWrite(_area, _offset, _value); }
+		bool				set					( EMemArea _area, TWord _offset, const TWord* _values, TWord _count );
 
 		bool				dspWrite			( EMemArea& _area, TWord& _offset, TWord _value );
 		TWord				get					( EMemArea _area, TWord _offset ) const;
@@ -158,6 +164,10 @@ namespace dsp56k
 
 		bool hasMmuSupport() const { return m_mmuBuffer != nullptr; }
 
+		// Captures the current memory contents, to be passed as base image to other instances with the same memory layout.
+		// Their memory pages are shared until modified. Only available with MMU support, returns nullptr otherwise
+		std::shared_ptr<MemoryImage> createImage() const;
+
 	private:
 		void				fillWithInitPattern	();
 		void				memTranslateAddress	(EMemArea& _area, const TWord& _addr) const;
@@ -3,6 +3,8 @@
 #ifndef __ANDROID__
 
 #include <algorithm>
+#include <atomic>
+#include <cstring>
 
 #include "types.h"
 #include "memory.h"
@@ -67,17 +69,32 @@ The memory layout that the emulator uses looks like this:
 bounds access will use this scratch area, not harmful if written to or read from but not
 affecting the regular, valid DSP memory.
 
+Many instances running the same firmware have mostly identical memory contents. A MemoryImage
+captures the contents of one instance and other instances can map their internal X, Y and P
+memory copy-on-write from it. The host shares these pages between all instances until an
+instance writes to a page, only then it receives a private copy.
+
 */
 
 namespace dsp56k
 {
-	MemoryBuffer::MemoryBuffer(TWord _pSize, TWord _xySize, TWord _externalMemAddress)
+	MemoryBuffer::MemoryBuffer(TWord _pSize, TWord _xySize, TWord _externalMemAddress, std::shared_ptr<MemoryImage> _baseImage/* = {}*/)
+		: m_pSize(_pSize)
+		, m_xySize(_xySize)
+		, m_externalMemAddress(_externalMemAddress)
+		, m_baseImage(std::move(_baseImage))
 	{
 		const auto usedAreaSize = std::max(_pSize, _xySize);
 
 		if(_externalMemAddress == 0 || _externalMemAddress >= usedAreaSize)
 			return;
 
+		if(m_baseImage && !m_baseImage->matches(_pSize, _xySize, _externalMemAddress))
+		{
+			LOG("Memory base image has a different memory layout, ignoring it");
+			m_baseImage.reset();
+		}
+
 		constexpr TWord totalDspAreaSize = 0x1000000;
 		constexpr TWord totalDspAreaByteSize = sizeof(TWord) * totalDspAreaSize;
 		constexpr TWord invalidDspMemoryBlockSize = 0x100000;
@@ -115,9 +132,19 @@ namespace dsp56k
 		TWord hostWordOffset = 0;
 
 		// map memory for internal X, Y and P memory. They point to unique memory and are separated
-		m_x = mapMem(hostWordOffset, _externalMemAddress, hostPtrX);	hostWordOffset += _externalMemAddress;
-		m_y = mapMem(hostWordOffset, _externalMemAddress, hostPtrY);	hostWordOffset += _externalMemAddress;
-		m_p = mapMem(hostWordOffset, _externalMemAddress, hostPtrP);	hostWordOffset += _externalMemAddress;
+		if(m_baseImage)
+		{
+			// the image has the same layout as our file mapping
+			m_x = mapMemCopyOnWrite(hostWordOffset, _externalMemAddress, hostPtrX);	hostWordOffset += _externalMemAddress;
+			m_y = mapMemCopyOnWrite(hostWordOffset, _externalMemAddress, hostPtrY);	hostWordOffset += _externalMemAddress;
+			m_p = mapMemCopyOnWrite(hostWordOffset, _externalMemAddress, hostPtrP);	hostWordOffset += _externalMemAddress;
+		}
+		else
+		{
+			m_x = mapMem(hostWordOffset, _externalMemAddress, hostPtrX);	hostWordOffset += _externalMemAddress;
+			m_y = mapMem(hostWordOffset, _externalMemAddress, hostPtrY);	hostWordOffset += _externalMemAddress;
+			m_p = mapMem(hostWordOffset, _externalMemAddress, hostPtrP);	hostWordOffset += _externalMemAddress;
+		}
 
 		if(!m_x || !m_y || !m_p)
 			return;
@@ -136,6 +163,9 @@ namespace dsp56k
 		if(!xShared || !yShared || !pShared)
 			return;
 
+		if(m_baseImage)
+			memcpy(xShared, m_baseImage->ptrExternal(), externalAreaSize * sizeof(TWord));
+
 		hostPtrX += externalAreaSize;
 		hostPtrY += externalAreaSize;
 		hostPtrP += externalAreaSize;
@@ -161,7 +191,10 @@ namespace dsp56k
 			actualDspAddress += invalidDspMemoryBlockSize;
 		}
 
-		// test if its working
+		// test if its working, restore the previous contents afterwards as they might originate from a base image
+
+		const TWord prevInternal[] = {m_x[_externalMemAddress-1], m_y[_externalMemAddress-1], m_p[_externalMemAddress-1]};
+		const TWord prevExternal[] = {m_x[_externalMemAddress+0], m_x[_externalMemAddress+1], m_x[_externalMemAddress+2]};
 
 		m_x[_externalMemAddress-1] = 0x111111;
 		m_y[_externalMemAddress-1] = 0x222222;
@@ -215,6 +248,13 @@ namespace dsp56k
 				last = mappedSize.first;
 			}
 		}
+
+		m_x[_externalMemAddress-1] = prevInternal[0];
+		m_y[_externalMemAddress-1] = prevInternal[1];
+		m_p[_externalMemAddress-1] = prevInternal[2];
+
+		for(auto i=0; i<3; ++i)
+			m_x[_externalMemAddress+i] = prevExternal[i];
 	}
 
 	MemoryBuffer::~MemoryBuffer()
@@ -227,7 +267,57 @@ namespace dsp56k
 
 		freeBasePtr();
 
-		destroyFileMapping();
+		destroyFileMapping(m_hFileMapping);
+	}
+
+	MemoryImage::MemoryImage(const TWord _pSize, const TWord _xySize, const TWord _externalMemAddress)
+		: m_pSize(_pSize)
+		, m_xySize(_xySize)
+		, m_externalMemAddress(_externalMemAddress)
+	{
+	}
+
+	MemoryImage::~MemoryImage()
+	{
+		unmapView(m_data);
+
+		if(m_hFileMapping != MemoryBuffer::InvalidHandle)
+			MemoryBuffer::destroyFileMapping(m_hFileMapping);
+	}
+
+	std::shared_ptr<MemoryImage> MemoryImage::create(const MemoryBuffer& _source)
+	{
+		if(!_source.isValid())
+			return {};
+
+		std::shared_ptr<MemoryImage> image(new MemoryImage(_source.getPSize(), _source.getXYSize(), _source.getExternalMemAddress()));
+
+		const auto ext = image->m_externalMemAddress;
+
+		image->m_hFileMapping = MemoryBuffer::createFileMapping(image->getWordSize() * static_cast<TWord>(sizeof(TWord)));
+
+		if(image->m_hFileMapping == MemoryBuffer::InvalidHandle)
+			return {};
+
+		auto* dst = image->mapView(true);
+
+		if(!dst)
+			return {};
+
+		memcpy(dst, _source.ptrX(), ext * sizeof(TWord));
+		memcpy(dst + ext, _source.ptrY(), ext * sizeof(TWord));
+		memcpy(dst + 2 * ext, _source.ptrP(), ext * sizeof(TWord));
+		memcpy(dst + 3 * ext, _source.ptrX() + ext, (image->getWordSize() - 3 * ext) * sizeof(TWord));
+
+		image->unmapView(dst);
+
+		// from now on, the image is read-only
+		image->m_data = image->mapView(false);
+
+		if(!image->m_data)
+			return {};
+
+		return image;
 	}
 #ifdef _WIN32
 	TWord* MemoryBuffer::mapMem(TWord _offset, TWord _size, TWord* _ptr)
@@ -244,6 +334,20 @@ namespace dsp56k
 		return nullptr;
 	}
 
+	TWord* MemoryBuffer::mapMemCopyOnWrite(TWord _offset, TWord _size, TWord* _ptr)
+	{
+		auto* p = static_cast<TWord*>(MapViewOfFileEx(m_baseImage->getFileMapping(), FILE_MAP_COPY, 0, _offset * sizeof(TWord), _size * sizeof(TWord), _ptr));
+		if(p == _ptr)
+		{
+			m_mappedSizes.insert(std::make_pair(p, _size));
+			return p;
+		}
+
+		const auto err = GetLastError();
+		LOG("Failed to create copy-on-write memory mapping, err " << err);
+		return nullptr;
+	}
+
 	bool MemoryBuffer::unmapMem(TWord*& _ptr)
 	{
 		const auto res = UnmapViewOfFile(_ptr);
@@ -272,12 +376,28 @@ namespace dsp56k
 		return CreateFileMapping(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, 0, _neededByteSize, nullptr);
 	}
 
-	void MemoryBuffer::destroyFileMapping()
+	void MemoryBuffer::destroyFileMapping(THandle& _handle)
 	{
-		if(m_hFileMapping == InvalidHandle)
+		if(_handle == InvalidHandle)
+			return;
+		CloseHandle(_handle);
+		_handle = InvalidHandle;
+	}
+
+	TWord* MemoryImage::mapView(const bool _write) const
+	{
+		auto* p = static_cast<TWord*>(MapViewOfFile(m_hFileMapping, _write ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, getWordSize() * sizeof(TWord)));
+		if(!p)
+			LOG("Failed to map memory image, err " << GetLastError());
+		return p;
+	}
+
+	void MemoryImage::unmapView(TWord*& _ptr) const
+	{
+		if(!_ptr)
 			return;
-		CloseHandle(m_hFileMapping);
-		m_hFileMapping = InvalidHandle;
+		UnmapViewOfFile(_ptr);
+		_ptr = nullptr;
 	}
 #else
 	TWord* MemoryBuffer::mapMem(TWord _offset, TWord _size, TWord* _ptr)
@@ -295,6 +415,21 @@ namespace dsp56k
 		return nullptr;
 	}
 
+	TWord* MemoryBuffer::mapMemCopyOnWrite(TWord _offset, TWord _size, TWord* _ptr)
+	{
+		errno = 0;
+		auto* p = static_cast<TWord*>(mmap(_ptr, _size * sizeof(TWord), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED, m_baseImage->getFileMapping(), _offset * sizeof(TWord)));
+		if(p == _ptr)
+		{
+			// no mlock here, locking a private writable mapping creates private copies of all pages
+			m_mappedSizes.insert(std::make_pair(p, _size));
+			return p;
+		}
+
+		LOG("Failed to create copy-on-write memory mapping, err " << errno << ", ptr=" << HEX(p) << " but requested ptr is " << HEX(_ptr));
+		return nullptr;
+	}
+
 	bool MemoryBuffer::unmapMem(TWord*& _ptr)
 	{
 		auto it = m_mappedSizes.find(_ptr);
@@ -340,10 +475,10 @@ namespace dsp56k
 
 	MemoryBuffer::THandle MemoryBuffer::createFileMapping(const TWord _neededByteSize)
 	{
-		static uint32_t g_uid = 0;
+		static std::atomic<uint32_t> g_uid = 0;
 
 		std::stringstream name;
-		name << "dsp56300_" << (uint64_t)this << '_' << g_uid++;
+		name << "dsp56300_" << getpid() << '_' << g_uid++;
 		const std::string na(name.str());
 		const char* n = na.c_str();
 
@@ -359,16 +494,36 @@ namespace dsp56k
 		return fd;
 	}
 
-	void MemoryBuffer::destroyFileMapping()
+	void MemoryBuffer::destroyFileMapping(THandle& _handle)
 	{
-		if(m_hFileMapping == InvalidHandle)
+		if(_handle == InvalidHandle)
 		{
 			LOG("Cannot close file, already closed");
 			return;
 		}
-		if(close(m_hFileMapping))
-			LOG("Failed to close file descriptor " << m_hFileMapping);
-		m_hFileMapping = InvalidHandle;
+		if(close(_handle))
+			LOG("Failed to close file descriptor " << _handle);
+		_handle = InvalidHandle;
+	}
+
+	TWord* MemoryImage::mapView(const bool _write) const
+	{
+		const auto byteSize = getWordSize() * sizeof(TWord);
+		auto* p = mmap(nullptr, byteSize, _write ? (PROT_READ | PROT_WRITE) : PROT_READ, MAP_SHARED, m_hFileMapping, 0);
+		if(p == MAP_FAILED)
+		{
+			LOG("Failed to map memory image, err " << errno);
+			return nullptr;
+		}
+		return static_cast<TWord*>(p);
+	}
+
+	void MemoryImage::unmapView(TWord*& _ptr) const
+	{
+		if(!_ptr)
+			return;
+		munmap(_ptr, getWordSize() * sizeof(TWord));
+		_ptr = nullptr;
 	}
 #endif
 }
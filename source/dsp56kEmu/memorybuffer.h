@@ -1,16 +1,20 @@
 #pragma once
 
+#include <algorithm>
 #include <map>
+#include <memory>
 
 #include "types.h"
 
 namespace dsp56k
 {
+	class MemoryImage;
+
 #ifdef __ANDROID__
 	class MemoryBuffer
 	{
 	public:
-		MemoryBuffer(TWord _pSize, TWord _xySize, TWord _externalMemAddress) {}
+		MemoryBuffer(TWord _pSize, TWord _xySize, TWord _externalMemAddress, std::shared_ptr<MemoryImage> _baseImage = {}) {}
 		~MemoryBuffer() {}
 
 		bool isValid() const { return false; }
@@ -19,6 +23,19 @@ namespace dsp56k
 		TWord* ptrY() const { return nullptr; }
 		TWord* ptrP() const { return nullptr; }
 	};
+
+	class MemoryImage
+	{
+	public:
+		static std::shared_ptr<MemoryImage> create(const MemoryBuffer& _source) { return {}; }
+
+		bool matches(TWord _pSize, TWord _xySize, TWord _externalMemAddress) const { return false; }
+
+		const TWord* ptrX() const { return nullptr; }
+		const TWord* ptrY() const { return nullptr; }
+		const TWord* ptrP() const { return nullptr; }
+		const TWord* ptrExternal() const { return nullptr; }
+	};
 #else
 	class MemoryBuffer
 	{
@@ -31,7 +48,10 @@ namespace dsp56k
 		static constexpr THandle InvalidHandle = -1;
 #endif
 
-		MemoryBuffer(TWord _pSize, TWord _xySize, TWord _externalMemAddress);
+		// If a base image is specified, internal X, Y and P memory are mapped copy-on-write from the image, i.e. pages are
+		// shared with all other buffers using the same image until they are written to. External memory is bridged and
+		// is therefore mapped three times, which rules out copy-on-write. It is initialized with a copy of the image instead
+		MemoryBuffer(TWord _pSize, TWord _xySize, TWord _externalMemAddress, std::shared_ptr<MemoryImage> _baseImage = {});
 		~MemoryBuffer();
 
 		bool isValid() const { return m_isValid; }
@@ -40,18 +60,29 @@ namespace dsp56k
 		TWord* ptrY() const { return m_y; }
 		TWord* ptrP() const { return m_p; }
 
+		TWord getPSize() const { return m_pSize; }
+		TWord getXYSize() const { return m_xySize; }
+		TWord getExternalMemAddress() const { return m_externalMemAddress; }
+
+		static THandle createFileMapping(TWord _neededByteSize);
+		static void destroyFileMapping(THandle& _handle);
+
 	private:
 		TWord* mapMem(TWord _offset, TWord _size, TWord* _ptr);
+		TWord* mapMemCopyOnWrite(TWord _offset, TWord _size, TWord* _ptr);
 		bool unmapMem(TWord*& _ptr);
 
 		TWord* createBasePtr(TWord _totalByteSize);
 		void freeBasePtr();
 
-		THandle createFileMapping(TWord _neededByteSize);
-		void destroyFileMapping();
-
 		THandle m_hFileMapping = InvalidHandle;
 
+		TWord m_pSize;
+		TWord m_xySize;
+		TWord m_externalMemAddress;
+
+		std::shared_ptr<MemoryImage> m_baseImage;
+
 		TWord* m_x = nullptr;
 		TWord* m_y = nullptr;
 		TWord* m_p = nullptr;
@@ -66,6 +97,47 @@ namespace dsp56k
 
 		std::map<TWord*, TWord> m_mappedSizes;	// ptr => size
 	};
+
+	// Read-only snapshot of the contents of a MemoryBuffer, used as base image for other buffers with the same layout.
+	// The layout matches the file mapping of MemoryBuffer: internal X, internal Y, internal P, followed by external memory
+	class MemoryImage
+	{
+	public:
+		using THandle = MemoryBuffer::THandle;
+
+		MemoryImage(const MemoryImage&) = delete;
+		MemoryImage& operator = (const MemoryImage&) = delete;
+		~MemoryImage();
+
+		static std::shared_ptr<MemoryImage> create(const MemoryBuffer& _source);
+
+		bool matches(TWord _pSize, TWord _xySize, TWord _externalMemAddress) const
+		{
+			return m_pSize == _pSize && m_xySize == _xySize && m_externalMemAddress == _externalMemAddress;
+		}
+
+		THandle getFileMapping() const { return m_hFileMapping; }
+
+		const TWord* ptrX() const { return m_data; }
+		const TWord* ptrY() const { return m_data + m_externalMemAddress; }
+		const TWord* ptrP() const { return m_data + 2 * m_externalMemAddress; }
+		const TWord* ptrExternal() const { return m_data + 3 * m_externalMemAddress; }
+
+	private:
+		MemoryImage(TWord _pSize, TWord _xySize, TWord _externalMemAddress);
+
+		TWord* mapView(bool _write) const;
+		void unmapView(TWord*& _ptr) const;
+
+		TWord getWordSize() const { return 3 * m_externalMemAddress + std::max(m_pSize, m_xySize) - m_externalMemAddress; }
+
+		const TWord m_pSize;
+		const TWord m_xySize;
+		const TWord m_externalMemAddress;
+
+		THandle m_hFileMapping = MemoryBuffer::InvalidHandle;
+		TWord* m_data = nullptr;
+	};
 #endif
 }
 
@@ -116,19 +116,22 @@ void OMFLoader::parseLine( const std::string& _line, Memory& _dst )
 
 			if( m_currentBitSize == 24 )
 			{
+				m_lineData.clear();
+
 				int remaining = static_cast<int>(_line.size());
 				while( remaining >= 6 )
 				{
-					const uint32_t result = parse24Bit( src );				
-
-					_dst.set( m_currentArea, m_currentTargetAddress, result );
-
-					m_currentTargetAddress++;
+					m_lineData.push_back( parse24Bit( src ) );
 
 					src += 7;		// 6 hex digits + space
 					remaining -= 7;
 				}
 				assert( remaining == 0 );
+
+				// write the whole line at once, P memory is invalidated once per line
+				_dst.set( m_currentArea, m_currentTargetAddress, m_lineData.data(), static_cast<TWord>(m_lineData.size()) );
+
+				m_currentTargetAddress += static_cast<TWord>(m_lineData.size());
 			}
 			else if( m_currentBitSize == 48 )
 			{
@@ -2,6 +2,7 @@
 
 #include <list>
 #include <string>
+#include <vector>
 
 #include "types.h"
 
@@ -22,6 +23,8 @@ namespace dsp56k
 
 		char		m_currentSymbolArea = 0;
 
+		std::vector<TWord>	m_lineData;
+
 		// _____________________________________________________________________________
 		// implementation
 		//
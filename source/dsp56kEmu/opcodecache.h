@@ -0,0 +1,110 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <memory>
+#include <vector>
+
+#include "dspassert.h"
+#include "types.h"
+
+namespace dsp56k
+{
+	// Cache of decoded opcodes for the interpreter, one entry per P memory address. The P memory can be very large but
+	// usually only a small part of it contains code, so entries are allocated in pages once an address within a page is
+	// executed for the first time. Nothing is allocated as long as the interpreter is not used
+	template<typename TEntry, uint32_t PageBits = 10> class OpcodeCache
+	{
+	public:
+		static constexpr uint32_t PageSize = 1 << PageBits;
+		static constexpr uint32_t PageMask = PageSize - 1;
+
+		using Page = std::array<TEntry, PageSize>;
+
+		explicit OpcodeCache(const TEntry& _default) : m_default(_default)
+		{
+		}
+
+		// discards all pages, the cache covers the addresses [0, _size) afterwards
+		void reset(const size_t _size)
+		{
+			m_pages.clear();
+			m_pages.shrink_to_fit();
+			m_size = _size;
+			m_pageCount = 0;
+		}
+
+		size_t size() const { return m_size; }
+
+		// number of pages that have been allocated so far
+		size_t pageCount() const { return m_pageCount; }
+
+		size_t byteSize() const { return m_pages.capacity() * sizeof(std::unique_ptr<Page>) + m_pageCount * sizeof(Page); }
+
+		TEntry& operator[](const TWord _address)
+		{
+			assert(_address < m_size);
+
+			const auto pageIndex = _address >> PageBits;
+
+			if(pageIndex >= m_pages.size() || !m_pages[pageIndex])
+				return allocate(_address)[_address & PageMask];
+
+			return (*m_pages[pageIndex])[_address & PageMask];
+		}
+
+		// resets entries to the default entry, pages that have not been allocated yet are not touched
+		void invalidate(const TWord _address)
+		{
+			auto* page = getPage(_address >> PageBits);
+
+			if(page)
+				(*page)[_address & PageMask] = m_default;
+		}
+
+		void invalidate(const TWord _first, const TWord _count)
+		{
+			const auto end = static_cast<size_t>(_first) + _count;
+
+			for(size_t a = _first; a < end;)
+			{
+				const auto pageEnd = std::min((a & ~static_cast<size_t>(PageMask)) + PageSize, end);
+
+				if(auto* page = getPage(static_cast<TWord>(a >> PageBits)))
+				{
+					for(; a < pageEnd; ++a)
+						(*page)[a & PageMask] = m_default;
+				}
+
+				a = pageEnd;
+			}
+		}
+
+	private:
+		Page* getPage(const TWord _pageIndex) const
+		{
+			return _pageIndex < m_pages.size() ? m_pages[_pageIndex].get() : nullptr;
+		}
+
+		Page& allocate(const TWord _address)
+		{
+			const auto pageIndex = _address >> PageBits;
+
+			// the page table itself is created on first use, too
+			if(m_pages.empty())
+				m_pages.resize((m_size + PageMask) >> PageBits);
+
+			auto& page = m_pages[pageIndex];
+			page.reset(new Page());
+			page->fill(m_default);
+			++m_pageCount;
+
+			return *page;
+		}
+
+		const TEntry m_default;
+		std::vector<std::unique_ptr<Page>> m_pages;
+		size_t m_size = 0;
+		size_t m_pageCount = 0;
+	};
+}
@@ -0,0 +1,133 @@
+#include "opcodedecodetable.h"
+
+#include <algorithm>
+#include <limits>
+
+#include "opcodes.h"
+
+namespace dsp56k
+{
+	namespace
+	{
+		constexpr uint32_t g_splitBits = 8;
+		constexpr size_t g_maxLeafSize = 4;
+	}
+
+	OpcodeDecodeTable::OpcodeDecodeTable(const std::vector<const OpcodeInfo*>& _opcodes, const uint32_t _shift, const uint32_t _bits)
+		: m_shift(_shift)
+		, m_mask((1u << _bits) - 1)
+	{
+		const uint32_t rootCount = 1u << _bits;
+
+		m_nodes.resize(rootCount);
+
+		std::vector<const OpcodeInfo*> candidates;
+		std::vector<const OpcodeInfo*> subCandidates;
+
+		for(uint32_t k=0; k<rootCount; ++k)
+		{
+			getCandidates(candidates, _opcodes, k, _shift, _bits);
+
+			if(candidates.size() <= g_maxLeafSize || _shift < g_splitBits)
+			{
+				initLeaf(m_nodes[k], candidates);
+				continue;
+			}
+
+			// find the bit range below the first level that distributes the candidates best
+			uint32_t bestShift = 0;
+			size_t bestMax = std::numeric_limits<size_t>::max();
+
+			for(uint32_t s=0; s + g_splitBits <= _shift; ++s)
+			{
+				size_t maxCount = 0;
+
+				for(uint32_t k2=0; k2<(1u<<g_splitBits); ++k2)
+				{
+					getCandidates(subCandidates, candidates, k2, s, g_splitBits);
+					maxCount = std::max(maxCount, subCandidates.size());
+				}
+
+				if(maxCount < bestMax)
+				{
+					bestMax = maxCount;
+					bestShift = s;
+				}
+			}
+
+			const auto first = static_cast<uint32_t>(m_nodes.size());
+
+			m_nodes.resize(m_nodes.size() + (1u<<g_splitBits));
+
+			auto& n = m_nodes[k];
+			n.first = first;
+			n.shift = static_cast<uint8_t>(bestShift);
+			n.bits = static_cast<uint8_t>(g_splitBits);
+
+			for(uint32_t k2=0; k2<(1u<<g_splitBits); ++k2)
+			{
+				getCandidates(subCandidates, candidates, k2, bestShift, g_splitBits);
+				initLeaf(m_nodes[first + k2], subCandidates);
+			}
+		}
+	}
+
+	const OpcodeInfo* OpcodeDecodeTable::find(const TWord _opcode) const
+	{
+		const auto* n = &m_nodes[(_opcode >> m_shift) & m_mask];
+
+		if(n->bits)
+			n = &m_nodes[n->first + ((_opcode >> n->shift) & ((1u << n->bits) - 1))];
+
+		const OpcodeInfo* res = nullptr;
+
+		for(uint32_t i=n->first; i<n->first + n->count; ++i)
+		{
+			const auto* oi = m_candidates[i];
+
+			if(match(*oi, _opcode))
+			{
+#ifdef _DEBUG
+				if(res != nullptr)
+				{
+					// it is unexpected that we have a second match. debugging helpers below, two opcodes for the same opcode should not happen
+					match(*oi, _opcode);
+					match(*res, _opcode);
+					assert(res == nullptr && "opcode collision, more than one instruction possible");
+				}
+				res = oi;
+#else
+				return oi;
+#endif
+			}
+		}
+		return res;
+	}
+
+	void OpcodeDecodeTable::getCandidates(std::vector<const OpcodeInfo*>& _result, const std::vector<const OpcodeInfo*>& _opcodes, const TWord _key, const uint32_t _shift, const uint32_t _bits)
+	{
+		// an opcode is a candidate if its fixed bits in the key range are equal to the key
+		const auto keyMask = ((1u << _bits) - 1) << _shift;
+		const auto key = _key << _shift;
+
+		_result.clear();
+
+		for (const auto* oi : _opcodes)
+		{
+			const auto fixed = (oi->m_mask0 | oi->m_mask1) & keyMask;
+
+			if((key & fixed) == (oi->m_mask1 & keyMask))
+				_result.push_back(oi);
+		}
+	}
+
+	void OpcodeDecodeTable::initLeaf(Node& _node, const std::vector<const OpcodeInfo*>& _candidates)
+	{
+		_node.first = static_cast<uint32_t>(m_candidates.size());
+		_node.count = static_cast<uint16_t>(_candidates.size());
+
+		m_candidates.insert(m_candidates.end(), _candidates.begin(), _candidates.end());
+
+		m_maxCandidates = std::max(m_maxCandidates, _candidates.size());
+	}
+}
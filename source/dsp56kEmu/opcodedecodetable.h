@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "types.h"
+
+namespace dsp56k
+{
+	struct OpcodeInfo;
+
+	// Finds the OpcodeInfo that matches an opcode word without testing all candidates.
+	// The first level is indexed by a range of opcode bits. If a bucket still contains too many candidates, it is split
+	// again by the 8 bit range below the first level that results in the smallest buckets
+	class OpcodeDecodeTable
+	{
+	public:
+		OpcodeDecodeTable(const std::vector<const OpcodeInfo*>& _opcodes, uint32_t _shift, uint32_t _bits);
+
+		const OpcodeInfo* find(TWord _opcode) const;
+
+		size_t getMaxCandidates() const { return m_maxCandidates; }
+
+	private:
+		struct Node
+		{
+			uint32_t first = 0;		// leaf: index of the first candidate, otherwise index of the first child node
+			uint16_t count = 0;		// leaf: number of candidates
+			uint8_t shift = 0;		// split nodes: range of bits used to index the children
+			uint8_t bits = 0;		// 0 = leaf
+		};
+
+		static void getCandidates(std::vector<const OpcodeInfo*>& _result, const std::vector<const OpcodeInfo*>& _opcodes, TWord _key, uint32_t _shift, uint32_t _bits);
+		void initLeaf(Node& _node, const std::vector<const OpcodeInfo*>& _candidates);
+
+		std::vector<Node> m_nodes;
+		std::vector<const OpcodeInfo*> m_candidates;
+		uint32_t m_shift;
+		uint32_t m_mask;
+		size_t m_maxCandidates = 0;
+	};
+}
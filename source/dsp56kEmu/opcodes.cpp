@@ -1,5 +1,6 @@
 #include "opcodes.h"
 #include "opcodeanalysis.h"
+#include "opcodedecodetable.h"
 
 namespace dsp56k
 {
@@ -43,48 +44,82 @@ namespace dsp56k
 		return g_runtimeFieldInfos.fieldInfos[_i].fieldInfos[_f];
 	}
 
-	Opcodes::Opcodes()
+	struct OpcodeDecodeTables
 	{
-		constexpr auto len = g_opcodeCount;
+		// non-parallel opcodes have the upper four bits cleared, parallel moves are encoded in the upper 16 bits and the
+		// ALU operation of a parallel opcode in the lower 8 bits
+		OpcodeDecodeTables(const std::vector<const OpcodeInfo*>& _nonParallel, const std::vector<const OpcodeInfo*>& _move, const std::vector<const OpcodeInfo*>& _alu)
+			: nonParallel(_nonParallel, 12, 8)
+			, move(_move, 16, 8)
+			, alu(_alu, 0, 8)
+		{
+		}
 
-		m_opcodesAlu.reserve(len);
-		m_opcodesMove.reserve(len);
-		m_opcodesNonParallel.reserve(len);
+		const OpcodeDecodeTable nonParallel;
+		const OpcodeDecodeTable move;
+		const OpcodeDecodeTable alu;
+	};
 
-		for(size_t i=0; i<len; ++i)
+	namespace
+	{
+		const OpcodeDecodeTables& getDecodeTables()
 		{
-			const auto& opcode = g_opcodes[i];
+			static const OpcodeDecodeTables tables = []()
+			{
+				constexpr auto len = g_opcodeCount;
+
+				std::vector<const OpcodeInfo*> opcodesNonParallel;
+				std::vector<const OpcodeInfo*> opcodesMove;
+				std::vector<const OpcodeInfo*> opcodesAlu;
 
-			if(opcode.getInstruction() == ResolveCache)
-				continue;
+				opcodesAlu.reserve(len);
+				opcodesMove.reserve(len);
+				opcodesNonParallel.reserve(len);
 
-			assert(opcode.getInstruction() == i && "programming error, list sorting is faulty");
+				for(size_t i=0; i<len; ++i)
+				{
+					const auto& opcode = g_opcodes[i];
 
-			if(dsp56k::isNonParallelOpcode(opcode))
-				m_opcodesNonParallel.push_back(&opcode);
-			else if(hasField(opcode, Field_AluOperation))
-				m_opcodesMove.push_back(&opcode);
-			else if(hasField(opcode, Field_MoveOperation))
-				m_opcodesAlu.push_back(&opcode);
+					if(opcode.getInstruction() == ResolveCache)
+						continue;
+
+					assert(opcode.getInstruction() == i && "programming error, list sorting is faulty");
+
+					if(dsp56k::isNonParallelOpcode(opcode))
+						opcodesNonParallel.push_back(&opcode);
+					else if(hasField(opcode, Field_AluOperation))
+						opcodesMove.push_back(&opcode);
+					else if(hasField(opcode, Field_MoveOperation))
+						opcodesAlu.push_back(&opcode);
+				}
+
+				return OpcodeDecodeTables(opcodesNonParallel, opcodesMove, opcodesAlu);
+			}();
+
+			return tables;
 		}
 	}
 
+	Opcodes::Opcodes() : m_tables(getDecodeTables())
+	{
+	}
+
 	const OpcodeInfo* Opcodes::findNonParallelOpcodeInfo(TWord _opcode) const
 	{
 		assert(isNonParallelOpcode(_opcode));
-		return findOpcodeInfo(_opcode, m_opcodesNonParallel);
+		return m_tables.nonParallel.find(_opcode);
 	}
 
 	const OpcodeInfo* Opcodes::findParallelMoveOpcodeInfo(TWord _opcode) const
 	{
 		assert(isParallelOpcode(_opcode));
-		return findOpcodeInfo(_opcode, m_opcodesMove);
+		return m_tables.move.find(_opcode);
 	}
 
 	const OpcodeInfo* Opcodes::findParallelAluOpcodeInfo(TWord _opcode) const
 	{
 		assert(isParallelOpcode(_opcode));
-		return findOpcodeInfo(_opcode, m_opcodesAlu);
+		return m_tables.alu.find(_opcode);
 	}
 
 	const OpcodeInfo& Opcodes::getOpcodeInfoAt(size_t _index)
@@ -217,29 +252,4 @@ namespace dsp56k
 			return dsp56k::getMemoryAddress(_addr, _area, instB, opA, opB);
 		return false;
 	}
-
-	const OpcodeInfo* Opcodes::findOpcodeInfo(TWord _opcode, const std::vector<const OpcodeInfo*>& _opcodes)
-	{
-		const OpcodeInfo* res = nullptr;
-
-		for (const auto* oi : _opcodes)
-		{
-			if(match(*oi, _opcode))
-			{
-#ifdef _DEBUG
-				if(res != nullptr)
-				{
-					// it is unexpected that we have a second match. debugging helpers below, two opcodes for the same opcode should not happen
-					match(*oi, _opcode);
-					match(*res, _opcode);
-					assert(res == nullptr && "opcode collision, more than one instruction possible");
-				}
-				res = oi;
-#else
-				return oi;
-#endif
-			}
-		}
-		return res;
-	}
 }
@@ -253,6 +253,8 @@ namespace dsp56k
 		return false;
 	}
 
+	struct OpcodeDecodeTables;
+
 	class Opcodes
 	{
 	public:
@@ -283,11 +285,7 @@ namespace dsp56k
 		static uint32_t getFlags(Instruction _instA, Instruction _instB);
 		bool getMemoryAddress(TWord& _addr, EMemArea& _area, TWord opA, TWord opB) const;
 	private:
-		static const OpcodeInfo* findOpcodeInfo(TWord _opcode, const std::vector<const OpcodeInfo*>& _opcodes);
-		
-		std::vector<const OpcodeInfo*> m_opcodesNonParallel;
-		std::vector<const OpcodeInfo*> m_opcodesMove;
-		std::vector<const OpcodeInfo*> m_opcodesAlu;
+		const OpcodeDecodeTables& m_tables;
 	};
 
 	// _____________________________________________
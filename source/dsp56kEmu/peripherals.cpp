@@ -5,6 +5,7 @@
 #include "dsp.h"
 #include "interrupts.h"
 #include "logging.h"
+#include "savestate.h"
 
 namespace dsp56k
 {
@@ -111,10 +112,133 @@ namespace dsp56k
 		}
 	}
 
+	IPeripherals::IPeripherals(const PeripheralType _t) : m_type(_t)
+	{
+		// unmapped registers read as zero and ignore writes
+		PeripheralRegister r;
+		r.read = [](IPeripherals&, TWord, Instruction) -> TWord { return 0; };
+		r.write = [](IPeripherals&, TWord, TWord) {};
+		m_registers.fill(r);
+	}
+
+	void IPeripherals::setReadHandler(const TWord _addr, const PeripheralRegister::ReadFunc _read, const TWord* _value/* = nullptr*/)
+	{
+		auto& r = m_registers[_addr - XIO_Reserved_High_First];
+		r.read = _read;
+		r.value = _value;
+	}
+
+	void IPeripherals::setReadValue(const TWord _addr, const TWord& _value)
+	{
+		setReadHandler(_addr, &readValue, &_value);
+	}
+
+	void IPeripherals::setWriteHandler(const TWord _addr, const PeripheralRegister::WriteFunc _write)
+	{
+		m_registers[_addr - XIO_Reserved_High_First].write = _write;
+	}
+
+	void IPeripherals::setEsxiRegister(const TWord _addr, const EsxiDataRegister& _reg)
+	{
+		m_esxiRegisters[_addr] = _reg;
+	}
+
+	const EsxiDataRegister* IPeripherals::getEsxiRegister(const TWord _addr) const
+	{
+		const auto it = m_esxiRegisters.find(_addr);
+		return it != m_esxiRegisters.end() ? &it->second : nullptr;
+	}
+
+	void IPeripherals::setMemoryRegisters(const TWord* _mem, const PeripheralRegister::WriteFunc _write)
+	{
+		for(TWord i=0; i<RegisterCount; ++i)
+		{
+			auto& r = m_registers[i];
+			r.read = &readValue;
+			r.write = _write;
+			r.value = &_mem[i];
+		}
+	}
+
+	TWord IPeripherals::readValue(IPeripherals& _periph, const TWord _addr, Instruction)
+	{
+		return *_periph.getRegister(_addr).value;
+	}
+
+	template<typename T> void IPeripherals::setDmaRegisters()
+	{
+		auto& dma = static_cast<T*>(this)->getDMA();
+
+		// channel 0 is located at the highest address
+		for(TWord c=0; c<6; ++c)
+		{
+			const auto o = c << 2;
+
+			setReadValue(XIO_DCR0 - o, dma.getDCR(c));
+			setReadValue(XIO_DCO0 - o, dma.getDCO(c));
+			setReadValue(XIO_DDR0 - o, dma.getDDR(c));
+			setReadValue(XIO_DSR0 - o, dma.getDSR(c));
+
+			setWriteHandler(XIO_DCR0 - o, [](IPeripherals& _p, const TWord _addr, const TWord _val) { static_cast<T&>(_p).getDMA().setDCR((XIO_DCR0 - _addr) >> 2, _val); });
+			setWriteHandler(XIO_DCO0 - o, [](IPeripherals& _p, const TWord _addr, const TWord _val) { static_cast<T&>(_p).getDMA().setDCO((XIO_DCO0 - _addr) >> 2, _val); });
+			setWriteHandler(XIO_DDR0 - o, [](IPeripherals& _p, const TWord _addr, const TWord _val) { static_cast<T&>(_p).getDMA().setDDR((XIO_DDR0 - _addr) >> 2, _val); });
+			setWriteHandler(XIO_DSR0 - o, [](IPeripherals& _p, const TWord _addr, const TWord _val) { static_cast<T&>(_p).getDMA().setDSR((XIO_DSR0 - _addr) >> 2, _val); });
+		}
+
+		for(TWord i=0; i<4; ++i)
+		{
+			setReadHandler(XIO_DOR0 - i, [](IPeripherals& _p, const TWord _addr, Instruction) { return static_cast<T&>(_p).getDMA().getDOR(XIO_DOR0 - _addr); });
+			setWriteHandler(XIO_DOR0 - i, [](IPeripherals& _p, const TWord _addr, const TWord _val) { static_cast<T&>(_p).getDMA().setDOR(XIO_DOR0 - _addr, _val); });
+		}
+
+		// DMA Status Register is read only
+		setReadValue(XIO_DSTR, dma.getDSTR());
+	}
+
+	template<typename T> void IPeripherals::setTimerRegisters()
+	{
+		auto& timers = static_cast<T*>(this)->getTimers();
+
+		// the registers of timer n are located at M_xxx0 - n * 4
+		for(int t=0; t<3; ++t)
+		{
+			const auto o = static_cast<TWord>(t) << 2;
+
+			setReadValue(Timers::M_TCSR0 - o, timers.readTCSR(t));
+			setReadValue(Timers::M_TLR0 - o, timers.readTLR(t));
+			setReadValue(Timers::M_TCPR0 - o, timers.readTCPR(t));
+			setReadValue(Timers::M_TCR0 - o, timers.readTCR(t));
+
+			setWriteHandler(Timers::M_TCSR0 - o, [](IPeripherals& _p, const TWord _addr, const TWord _val) { static_cast<T&>(_p).getTimers().writeTCSR(static_cast<int>((Timers::M_TCSR0 - _addr) >> 2), _val); });
+			setWriteHandler(Timers::M_TLR0 - o, [](IPeripherals& _p, const TWord _addr, const TWord _val) { static_cast<T&>(_p).getTimers().writeTLR(static_cast<int>((Timers::M_TLR0 - _addr) >> 2), _val); });
+			setWriteHandler(Timers::M_TCPR0 - o, [](IPeripherals& _p, const TWord _addr, const TWord _val) { static_cast<T&>(_p).getTimers().writeTCPR(static_cast<int>((Timers::M_TCPR0 - _addr) >> 2), _val); });
+			setWriteHandler(Timers::M_TCR0 - o, [](IPeripherals& _p, const TWord _addr, const TWord _val) { static_cast<T&>(_p).getTimers().writeTCR(static_cast<int>((Timers::M_TCR0 - _addr) >> 2), _val); });
+		}
+
+		setReadValue(Timers::M_TPLR, timers.readTPLR());
+		setReadValue(Timers::M_TPCR, timers.readTPCR());
+
+		setWriteHandler(Timers::M_TPLR, [](IPeripherals& _p, TWord, const TWord _val) { static_cast<T&>(_p).getTimers().writeTPLR(_val); });
+		setWriteHandler(Timers::M_TPCR, [](IPeripherals& _p, TWord, const TWord _val) { static_cast<T&>(_p).getTimers().writeTPCR(_val); });
+	}
+
 	void IPeripherals::setDelayCycles(const uint32_t _delayCycles)
 	{
 		m_delayCycles = std::min(m_delayCycles, _delayCycles);
 		m_targetClock = m_dsp->getInstructionCounter() + m_delayCycles;
+		m_scheduler.wake();
+	}
+
+	void IPeripherals::saveState(StateWriter& _w) const
+	{
+		_w.write(m_delayCycles);
+		_w.write(m_targetClock);
+	}
+
+	bool IPeripherals::loadState(StateReader& _r)
+	{
+		m_scheduler.wake();
+		return _r.read(m_delayCycles) && _r.read(m_targetClock);
 	}
 
 	// _____________________________________________________________________________
@@ -135,222 +259,92 @@ namespace dsp56k
 		m_essiClock.setExternalClockFrequency(4000000);			// 4 MHz
 
 		m_mem[XIO_IDR - XIO_Reserved_High_First] = 0x0005303;	// rev 5 derivative number 303
+
+		initRegisters();
 	}
 
-	TWord Peripherals56303::read(TWord _addr, Instruction _inst)
+	void Peripherals56303::initRegisters()
 	{
-		switch (_addr)
+		using P = Peripherals56303;
+
+		setMemoryRegisters(&m_mem[0], [](IPeripherals& _p, const TWord _addr, const TWord _val) { static_cast<P&>(_p).m_mem[_addr - XIO_Reserved_High_First] = _val; });
+
+		setReadHandler(HDI08::HSR,	[](IPeripherals& _p, TWord, Instruction) { return static_cast<P&>(_p).m_hi08.readStatusRegister(); });
+		setReadHandler(HDI08::HCR,	[](IPeripherals& _p, TWord, Instruction) { return static_cast<P&>(_p).m_hi08.readControlRegister(); });
+		setReadHandler(HDI08::HPCR,	[](IPeripherals& _p, TWord, Instruction) { return static_cast<P&>(_p).m_hi08.readPortControlRegister(); });
+		setReadHandler(HDI08::HORX,	[](IPeripherals& _p, TWord, const Instruction _inst) { return static_cast<P&>(_p).m_hi08.readRX(_inst); });
+		setReadHandler(HDI08::HDR,	[](IPeripherals& _p, TWord, Instruction) { return static_cast<P&>(_p).m_hi08.readHDR(); });
+		setReadHandler(HDI08::HDDR,	[](IPeripherals& _p, TWord, Instruction) { return static_cast<P&>(_p).m_hi08.readHDDR(); });
+
+		setWriteHandler(HDI08::HSR,		[](IPeripherals& _p, TWord, const TWord _val) { static_cast<P&>(_p).m_hi08.writeStatusRegister(_val); });
+		setWriteHandler(HDI08::HCR,		[](IPeripherals& _p, TWord, const TWord _val) { static_cast<P&>(_p).m_hi08.writeControlRegister(_val); });
+		setWriteHandler(HDI08::HPCR,	[](IPeripherals& _p, TWord, const TWord _val) { static_cast<P&>(_p).m_hi08.writePortControlRegister(_val); });
+		setWriteHandler(HDI08::HOTX,	[](IPeripherals& _p, TWord, const TWord _val) { static_cast<P&>(_p).m_hi08.writeTX(_val); });
+		setWriteHandler(HDI08::HDR,		[](IPeripherals& _p, TWord, const TWord _val) { static_cast<P&>(_p).m_hi08.writeHDR(_val); });
+		setWriteHandler(HDI08::HDDR,	[](IPeripherals& _p, TWord, const TWord _val) { static_cast<P&>(_p).m_hi08.writeHDDR(_val); });
+
+		// ESSI1 is located below ESSI0, see essi()
+		for(TWord i=0; i<2; ++i)
 		{
-		case HDI08::HSR:			return m_hi08.readStatusRegister();
-		case HDI08::HCR:			return m_hi08.readControlRegister();
-		case HDI08::HPCR:			return m_hi08.readPortControlRegister();
-		case HDI08::HORX:			return m_hi08.readRX(_inst);
-		case HDI08::HDR:			return m_hi08.readHDR();
-		case HDI08::HDDR:			return m_hi08.readHDDR();
-
-		case Essi::ESSI0_TX0:		return m_essi0.readTX(0);
-		case Essi::ESSI0_TX1:		return m_essi0.readTX(1);
-		case Essi::ESSI0_TX2:		return m_essi0.readTX(2);
-		case Essi::ESSI0_TSR:		return m_essi0.readTSR();
-		case Essi::ESSI0_RX:		return m_essi0.readRX();
-		case Essi::ESSI0_SSISR:		return m_essi0.readSR();
-		case Essi::ESSI0_CRA:		return m_essi0.readCRA();
-		case Essi::ESSI0_CRB:		return m_essi0.readCRB();
-		case Essi::ESSI0_TSMA:		return m_essi0.readTSMA();
-		case Essi::ESSI0_TSMB:		return m_essi0.readTSMB();
-		case Essi::ESSI0_RSMA:		return m_essi0.readRSMA();
-		case Essi::ESSI0_RSMB:		return m_essi0.readRSMB();
-
-		case Essi::ESSI1_TX0:		return m_essi1.readTX(0);
-		case Essi::ESSI1_TX1:		return m_essi1.readTX(1);
-		case Essi::ESSI1_TX2:		return m_essi1.readTX(2);
-		case Essi::ESSI1_TSR:		return m_essi1.readTSR();
-		case Essi::ESSI1_RX:		return m_essi1.readRX();
-		case Essi::ESSI1_SSISR:		return m_essi1.readSR();
-		case Essi::ESSI1_CRA:		return m_essi1.readCRA();
-		case Essi::ESSI1_CRB:		return m_essi1.readCRB();
-		case Essi::ESSI1_TSMA:		return m_essi1.readTSMA();
-		case Essi::ESSI1_TSMB:		return m_essi1.readTSMB();
-		case Essi::ESSI1_RSMA:		return m_essi1.readRSMA();
-		case Essi::ESSI1_RSMB:		return m_essi1.readRSMB();
-
-		case XIO_PCTL:				return m_essiClock.getPCTL();
-
-		case Timers::M_TCSR0:		return m_timers.readTCSR(0);	// TIMER0 Control/Status Register
-		case Timers::M_TCSR1:		return m_timers.readTCSR(1);	// TIMER1 Control/Status Register
-		case Timers::M_TCSR2:		return m_timers.readTCSR(2);	// TIMER2 Control/Status Register
-		case Timers::M_TLR0:		return m_timers.readTLR	(0);	// TIMER0 Load Reg
-		case Timers::M_TLR1:		return m_timers.readTLR	(1);	// TIMER1 Load Reg
-		case Timers::M_TLR2:		return m_timers.readTLR	(2);	// TIMER2 Load Reg
-		case Timers::M_TCPR0:		return m_timers.readTCPR(0);	// TIMER0 Compare Register
-		case Timers::M_TCPR1:		return m_timers.readTCPR(1);	// TIMER1 Compare Register
-		case Timers::M_TCPR2:		return m_timers.readTCPR(2);	// TIMER2 Compare Register
-		case Timers::M_TCR0:		return m_timers.readTCR	(0);	// TIMER0 Count Register
-		case Timers::M_TCR1:		return m_timers.readTCR	(1);	// TIMER1 Count Register
-		case Timers::M_TCR2:		return m_timers.readTCR	(2);	// TIMER2 Count Register
-
-		case Timers::M_TPLR:		return m_timers.readTPLR();		// TIMER Prescaler Load Register
-		case Timers::M_TPCR:		return m_timers.readTPCR();		// TIMER Prescalar Count Register
-
-		case XIO_DCR5: return m_dma.getDCR(5);	// DMA 5 Control Register
-		case XIO_DCO5: return m_dma.getDCO(5);	// DMA 5 Counter
-		case XIO_DDR5: return m_dma.getDDR(5);	// DMA 5 Destination Address Register
-		case XIO_DSR5: return m_dma.getDSR(5);	// DMA 5 Source Address Register
-
-		case XIO_DCR4: return m_dma.getDCR(4);	// DMA 4 Control Register
-		case XIO_DCO4: return m_dma.getDCO(4);	// DMA 4 Counter
-		case XIO_DDR4: return m_dma.getDDR(4);	// DMA 4 Destination Address Register
-		case XIO_DSR4: return m_dma.getDSR(4);	// DMA 4 Source Address Register
-
-		case XIO_DCR3: return m_dma.getDCR(3);	// DMA 3 Control Register
-		case XIO_DCO3: return m_dma.getDCO(3);	// DMA 3 Counter
-		case XIO_DDR3: return m_dma.getDDR(3);	// DMA 3 Destination Address Register
-		case XIO_DSR3: return m_dma.getDSR(3);	// DMA 3 Source Address Register
-
-		case XIO_DCR2: return m_dma.getDCR(2);	// DMA 2 Control Register
-		case XIO_DCO2: return m_dma.getDCO(2);	// DMA 2 Counter
-		case XIO_DDR2: return m_dma.getDDR(2);	// DMA 2 Destination Address Register
-		case XIO_DSR2: return m_dma.getDSR(2);	// DMA 2 Source Address Register
-
-		case XIO_DCR1: return m_dma.getDCR(1);	// DMA 1 Control Register
-		case XIO_DCO1: return m_dma.getDCO(1);	// DMA 1 Counter
-		case XIO_DDR1: return m_dma.getDDR(1);	// DMA 1 Destination Address Register
-		case XIO_DSR1: return m_dma.getDSR(1);	// DMA 1 Source Address Register
-
-		case XIO_DCR0: return m_dma.getDCR(0);	// DMA 0 Control Register
-		case XIO_DCO0: return m_dma.getDCO(0);	// DMA 0 Counter
-		case XIO_DDR0: return m_dma.getDDR(0);	// DMA 0 Destination Address Register
-		case XIO_DSR0: return m_dma.getDSR(0);	// DMA 0 Source Address Register
-
-		case XIO_DOR3: return m_dma.getDOR(3);	// DMA Offset Register 3
-		case XIO_DOR2: return m_dma.getDOR(2);	// DMA Offset Register 2 
-		case XIO_DOR1: return m_dma.getDOR(1);	// DMA Offset Register 1
-		case XIO_DOR0: return m_dma.getDOR(0);	// DMA Offset Register 0
-
-		case XIO_DSTR: return m_dma.getDSTR();	// DMA Status Register
+			const auto o = i * Essi::EssiAddressOffset;
+
+			setReadHandler(Essi::ESSI0_TX0 - o,		[](IPeripherals& _p, const TWord _addr, Instruction) { return essi(_p, _addr).readTX(0); });
+			setReadHandler(Essi::ESSI0_TX1 - o,		[](IPeripherals& _p, const TWord _addr, Instruction) { return essi(_p, _addr).readTX(1); });
+			setReadHandler(Essi::ESSI0_TX2 - o,		[](IPeripherals& _p, const TWord _addr, Instruction) { return essi(_p, _addr).readTX(2); });
+			setReadHandler(Essi::ESSI0_TSR - o,		[](IPeripherals& _p, const TWord _addr, Instruction) { return essi(_p, _addr).readTSR(); });
+			setReadHandler(Essi::ESSI0_RX - o,		[](IPeripherals& _p, const TWord _addr, Instruction) { return essi(_p, _addr).readRX(); });
+			setReadValue(Essi::ESSI0_SSISR - o,		(i ? m_essi1 : m_essi0).readSR());
+			setReadHandler(Essi::ESSI0_CRA - o,		[](IPeripherals& _p, const TWord _addr, Instruction) { return essi(_p, _addr).readCRA(); });
+			setReadHandler(Essi::ESSI0_CRB - o,		[](IPeripherals& _p, const TWord _addr, Instruction) { return essi(_p, _addr).readCRB(); });
+			setReadHandler(Essi::ESSI0_TSMA - o,	[](IPeripherals& _p, const TWord _addr, Instruction) { return essi(_p, _addr).readTSMA(); });
+			setReadHandler(Essi::ESSI0_TSMB - o,	[](IPeripherals& _p, const TWord _addr, Instruction) { return essi(_p, _addr).readTSMB(); });
+			setReadHandler(Essi::ESSI0_RSMA - o,	[](IPeripherals& _p, const TWord _addr, Instruction) { return essi(_p, _addr).readRSMA(); });
+			setReadHandler(Essi::ESSI0_RSMB - o,	[](IPeripherals& _p, const TWord _addr, Instruction) { return essi(_p, _addr).readRSMB(); });
+
+			setWriteHandler(Essi::ESSI0_TX0 - o,	[](IPeripherals& _p, const TWord _addr, const TWord _val) { essi(_p, _addr).writeTX(0, _val); });
+			setWriteHandler(Essi::ESSI0_TX1 - o,	[](IPeripherals& _p, const TWord _addr, const TWord _val) { essi(_p, _addr).writeTX(1, _val); });
+			setWriteHandler(Essi::ESSI0_TX2 - o,	[](IPeripherals& _p, const TWord _addr, const TWord _val) { essi(_p, _addr).writeTX(2, _val); });
+			setWriteHandler(Essi::ESSI0_TSR - o,	[](IPeripherals& _p, const TWord _addr, const TWord _val) { essi(_p, _addr).writeTSR(_val); });
+			setWriteHandler(Essi::ESSI0_RX - o,		[](IPeripherals& _p, const TWord _addr, const TWord _val) { essi(_p, _addr).writeRX(_val); });
+			setWriteHandler(Essi::ESSI0_SSISR - o,	[](IPeripherals& _p, const TWord _addr, const TWord _val) { essi(_p, _addr).writeSR(_val); });
+			setWriteHandler(Essi::ESSI0_CRA - o,	[](IPeripherals& _p, const TWord _addr, const TWord _val) { essi(_p, _addr).writeCRA(_val); });
+			setWriteHandler(Essi::ESSI0_CRB - o,	[](IPeripherals& _p, const TWord _addr, const TWord _val) { essi(_p, _addr).writeCRB(_val); });
+			setWriteHandler(Essi::ESSI0_TSMA - o,	[](IPeripherals& _p, const TWord _addr, const TWord _val) { essi(_p, _addr).writeTSMA(_val); });
+			setWriteHandler(Essi::ESSI0_TSMB - o,	[](IPeripherals& _p, const TWord _addr, const TWord _val) { essi(_p, _addr).writeTSMB(_val); });
+			setWriteHandler(Essi::ESSI0_RSMA - o,	[](IPeripherals& _p, const TWord _addr, const TWord _val) { essi(_p, _addr).writeRSMA(_val); });
+			setWriteHandler(Essi::ESSI0_RSMB - o,	[](IPeripherals& _p, const TWord _addr, const TWord _val) { essi(_p, _addr).writeRSMB(_val); });
+
+			const auto& e = i ? m_essi1 : m_essi0;
+
+			setEsxiRegister(Essi::ESSI0_TX0 - o, e.getTxRegister(0));
+			setEsxiRegister(Essi::ESSI0_TX1 - o, e.getTxRegister(1));
+			setEsxiRegister(Essi::ESSI0_TX2 - o, e.getTxRegister(2));
+			setEsxiRegister(Essi::ESSI0_RX - o, e.getRxRegister());
 		}
 
-//		LOG( "Periph read @ " << std::hex << _addr );
+		setReadHandler(XIO_PCTL,	[](IPeripherals& _p, TWord, Instruction) { return static_cast<P&>(_p).m_essiClock.getPCTL(); });
+		setWriteHandler(XIO_PCTL,	[](IPeripherals& _p, TWord, const TWord _val) { static_cast<P&>(_p).m_essiClock.setPCTL(_val); });
 
-		return m_mem[_addr - XIO_Reserved_High_First];
+		setTimerRegisters<P>();
+		setDmaRegisters<P>();
 	}
 
-	const TWord* Peripherals56303::readAsPtr(const TWord _addr, Instruction _inst)
+	Essi& Peripherals56303::essi(IPeripherals& _periph, const TWord _addr)
 	{
-		switch (_addr)
-		{
-		case Essi::ESSI0_SSISR:		return &m_essi0.readSR();
-		case Essi::ESSI1_SSISR:		return &m_essi1.readSR();
-		default:					return nullptr;
-		}
-	}
-
-	void Peripherals56303::write(TWord _addr, TWord _val)
-	{
-		switch (_addr)
-		{
-		case HDI08::HSR:			m_hi08.writeStatusRegister(_val);		return;
-		case HDI08::HCR:			m_hi08.writeControlRegister(_val);		return;
-		case HDI08::HPCR:			m_hi08.writePortControlRegister(_val);	return;
-		case HDI08::HOTX:			m_hi08.writeTX(_val);					return;
-		case HDI08::HDR:			m_hi08.writeHDR(_val);					return;
-		case HDI08::HDDR:			m_hi08.writeHDDR(_val);					return;
-
-
-		case Essi::ESSI0_TX0:		m_essi0.writeTX(0, _val);				return;
-		case Essi::ESSI0_TX1:		m_essi0.writeTX(1, _val);				return;
-		case Essi::ESSI0_TX2:		m_essi0.writeTX(2, _val);				return;
-		case Essi::ESSI0_TSR:		m_essi0.writeTSR(_val);					return;
-		case Essi::ESSI0_RX:		m_essi0.writeRX(_val);					return;
-		case Essi::ESSI0_SSISR:		m_essi0.writeSR(_val);					return;
-		case Essi::ESSI0_CRA:		m_essi0.writeCRA(_val);					return;
-		case Essi::ESSI0_CRB:		m_essi0.writeCRB(_val);					return;
-		case Essi::ESSI0_TSMA:		m_essi0.writeTSMA(_val);				return;
-		case Essi::ESSI0_TSMB:		m_essi0.writeTSMB(_val);				return;
-		case Essi::ESSI0_RSMA:		m_essi0.writeRSMA(_val);				return;
-		case Essi::ESSI0_RSMB:		m_essi0.writeRSMB(_val);				return;
-
-		case Essi::ESSI1_TX0:		m_essi1.writeTX(0, _val);				return;
-		case Essi::ESSI1_TX1:		m_essi1.writeTX(1, _val);				return;
-		case Essi::ESSI1_TX2:		m_essi1.writeTX(2, _val);				return;
-		case Essi::ESSI1_TSR:		m_essi1.writeTSR(_val);					return;
-		case Essi::ESSI1_RX:		m_essi1.writeRX(_val);					return;
-		case Essi::ESSI1_SSISR:		m_essi1.writeSR(_val);					return;
-		case Essi::ESSI1_CRA:		m_essi1.writeCRA(_val);					return;
-		case Essi::ESSI1_CRB:		m_essi1.writeCRB(_val);					return;
-		case Essi::ESSI1_TSMA:		m_essi1.writeTSMA(_val);				return;
-		case Essi::ESSI1_TSMB:		m_essi1.writeTSMB(_val);				return;
-		case Essi::ESSI1_RSMA:		m_essi1.writeRSMA(_val);				return;
-		case Essi::ESSI1_RSMB:		m_essi1.writeRSMB(_val);				return;
-
-		case XIO_PCTL:				m_essiClock.setPCTL(_val);				return;
-
-		case Timers::M_TCSR0:		m_timers.writeTCSR	(0, _val);	return;		// TIMER0 Control/Status Register
-		case Timers::M_TCSR1:		m_timers.writeTCSR	(1, _val);	return;		// TIMER1 Control/Status Register
-		case Timers::M_TCSR2:		m_timers.writeTCSR	(2, _val);	return;		// TIMER2 Control/Status Register
-		case Timers::M_TLR0:		m_timers.writeTLR	(0, _val);	return;		// TIMER0 Load Reg
-		case Timers::M_TLR1:		m_timers.writeTLR	(1, _val);	return;		// TIMER1 Load Reg
-		case Timers::M_TLR2:		m_timers.writeTLR	(2, _val);	return;		// TIMER2 Load Reg
-		case Timers::M_TCPR0:		m_timers.writeTCPR	(0, _val);	return;		// TIMER0 Compare Register
-		case Timers::M_TCPR1:		m_timers.writeTCPR	(1, _val);	return;		// TIMER1 Compare Register
-		case Timers::M_TCPR2:		m_timers.writeTCPR	(2, _val);	return;		// TIMER2 Compare Register
-		case Timers::M_TCR0:		m_timers.writeTCR	(0, _val);	return;		// TIMER0 Count Register
-		case Timers::M_TCR1:		m_timers.writeTCR	(1, _val);	return;		// TIMER1 Count Register
-		case Timers::M_TCR2:		m_timers.writeTCR	(2, _val);	return;		// TIMER2 Count Register
-
-		case Timers::M_TPLR:		m_timers.writeTPLR	(_val);		return;		// TIMER Prescaler Load Register
-		case Timers::M_TPCR:		m_timers.writeTPCR	(_val);		return;		// TIMER Prescalar Count Register
-		
-
-		case XIO_DCR5: m_dma.setDCR(5, _val); return;	// DMA 5 Control Register
-		case XIO_DCO5: m_dma.setDCO(5, _val); return;	// DMA 5 Counter
-		case XIO_DDR5: m_dma.setDDR(5, _val); return;	// DMA 5 Destination Address Register
-		case XIO_DSR5: m_dma.setDSR(5, _val); return;	// DMA 5 Source Address Register
-
-		case XIO_DCR4: m_dma.setDCR(4, _val); return;	// DMA 4 Control Register
-		case XIO_DCO4: m_dma.setDCO(4, _val); return;	// DMA 4 Counter
-		case XIO_DDR4: m_dma.setDDR(4, _val); return;	// DMA 4 Destination Address Register
-		case XIO_DSR4: m_dma.setDSR(4, _val); return;	// DMA 4 Source Address Register
-
-		case XIO_DCR3: m_dma.setDCR(3, _val); return;	// DMA 3 Control Register
-		case XIO_DCO3: m_dma.setDCO(3, _val); return;	// DMA 3 Counter
-		case XIO_DDR3: m_dma.setDDR(3, _val); return;	// DMA 3 Destination Address Register
-		case XIO_DSR3: m_dma.setDSR(3, _val); return;	// DMA 3 Source Address Register
-
-		case XIO_DCR2: m_dma.setDCR(2, _val); return;	// DMA 2 Control Register
-		case XIO_DCO2: m_dma.setDCO(2, _val); return;	// DMA 2 Counter
-		case XIO_DDR2: m_dma.setDDR(2, _val); return;	// DMA 2 Destination Address Register
-		case XIO_DSR2: m_dma.setDSR(2, _val); return;	// DMA 2 Source Address Register
-
-		case XIO_DCR1: m_dma.setDCR(1, _val); return;	// DMA 1 Control Register
-		case XIO_DCO1: m_dma.setDCO(1, _val); return;	// DMA 1 Counter
-		case XIO_DDR1: m_dma.setDDR(1, _val); return;	// DMA 1 Destination Address Register
-		case XIO_DSR1: m_dma.setDSR(1, _val); return;	// DMA 1 Source Address Register
-
-		case XIO_DCR0: m_dma.setDCR(0, _val); return;	// DMA 0 Control Register
-		case XIO_DCO0: m_dma.setDCO(0, _val); return;	// DMA 0 Counter
-		case XIO_DDR0: m_dma.setDDR(0, _val); return;	// DMA 0 Destination Address Register
-		case XIO_DSR0: m_dma.setDSR(0, _val); return;	// DMA 0 Source Address Register
-
-		case XIO_DOR3: m_dma.setDOR(3, _val); return;	// DMA Offset Register 3
-		case XIO_DOR2: m_dma.setDOR(2, _val); return;	// DMA Offset Register 2 
-		case XIO_DOR1: m_dma.setDOR(1, _val); return;	// DMA Offset Register 1
-		case XIO_DOR0: m_dma.setDOR(0, _val); return;	// DMA Offset Register 0
-
-//		case XIO_DSTR: m_dma.setDSTR(_val); return;		// DMA Status Register is read only
-		default:
-//			LOG( "Periph write @ " << std::hex << _addr );
-			m_mem[_addr - XIO_Reserved_High_First] = _val;
-		}
+		auto& p = static_cast<Peripherals56303&>(_periph);
+		return _addr >= Essi::ESSI0_RSMB ? p.m_essi0 : p.m_essi1;
 	}
 
 	uint32_t Peripherals56303::exec()
 	{
-		auto delay = m_essiClock.exec();
-		delay = std::min(delay, m_hi08.exec());
-		delay = std::min(delay, m_timers.exec());
-		delay = std::min(delay, m_dma.exec());
-		return delay;
+		m_scheduler.begin(getDSP().getInstructionCounter());
+
+		m_scheduler.run(PeripheralScheduler::SlotAudio, [this] { return m_essiClock.exec(); });
+		m_scheduler.run(PeripheralScheduler::SlotHost, [this] { return m_hi08.exec(); });
+		m_scheduler.run(PeripheralScheduler::SlotTimers, [this] { return m_timers.exec(); });
+		m_scheduler.run(PeripheralScheduler::SlotDma, [this] { return m_dma.exec(); });
+
+		return m_scheduler.end(MaxDelayCycles);
 	}
 
 	void Peripherals56303::reset()
@@ -376,6 +370,27 @@ namespace dsp56k
 		m_essi1.terminate();
 	}
 
+	void Peripherals56303::saveState(StateWriter& _w) const
+	{
+		IPeripherals::saveState(_w);
+
+		_w.write(m_mem);
+
+		m_dma.saveState(_w);
+		m_essiClock.saveState(_w);
+		m_essi0.saveState(_w);
+		m_essi1.saveState(_w);
+		m_hi08.saveState(_w);
+		m_timers.saveState(_w);
+	}
+
+	bool Peripherals56303::loadState(StateReader& _r)
+	{
+		return IPeripherals::loadState(_r) && _r.read(m_mem) &&
+			m_dma.loadState(_r) && m_essiClock.loadState(_r) && m_essi0.loadState(_r) && m_essi1.loadState(_r) &&
+			m_hi08.loadState(_r) && m_timers.loadState(_r);
+	}
+
 	Peripherals56362::Peripherals56362(Peripherals56367* _peripherals56367/* = nullptr*/)
 	: IPeripherals(PeripheralType::Peripherals56362)
 	, m_mem(0)
@@ -389,288 +404,96 @@ namespace dsp56k
 		m_esaiClock.setEsaiDivider(&m_esai, 0);
 		if(_peripherals56367)
 			m_esaiClock.setEsaiDivider(&_peripherals56367->getEsai(), 0);
-	}
 
-	TWord Peripherals56362::read(const TWord _addr, const Instruction _inst)
-	{
-		switch (_addr)
-		{
-		case HDI08::HSR:	return m_hdi08.readStatusRegister();
-		case HDI08::HCR:	return m_hdi08.readControlRegister();
-		case HDI08::HPCR:	return m_hdi08.readPortControlRegister();
-		case HDI08::HORX:	return m_hdi08.readRX(_inst);
-		case HDI08::HDR:	return m_hdi08.readHDR();
-		case HDI08::HDDR:	return m_hdi08.readHDDR();
-
-		case Esai::M_RCR:	return m_esai.readReceiveControlRegister();
-		case Esai::M_RCCR:	return m_esai.readReceiveClockControlRegister();
-		case Esai::M_SAISR:	return m_esai.readStatusRegister();
-		case Esai::M_TCR:	return m_esai.readTransmitControlRegister();
-		case Esai::M_TCCR:	return m_esai.readTransmitClockControlRegister();
-		case Esai::M_RX0:
-		case Esai::M_RX1:
-		case Esai::M_RX2:
-		case Esai::M_RX3:	return m_esai.readRX(_addr - Esai::M_RX0);
-		case Esai::M_TSMA:	return m_esai.readTSMA();
-		case Esai::M_TSMB:	return m_esai.readTSMB();
-		case Esai::M_PCRC:	return m_portC.getControl();
-		case Esai::M_PDRC:	return m_portC.dspRead();
-		case Esai::M_PRRC:	return m_portC.getDirection();
-
-		case XIO_PCTL:		return m_esaiClock.getPCTL();
-
-		case Timers::M_TCSR0:		return m_timers.readTCSR(0);	// TIMER0 Control/Status Register
-		case Timers::M_TCSR1:		return m_timers.readTCSR(1);	// TIMER1 Control/Status Register
-		case Timers::M_TCSR2:		return m_timers.readTCSR(2);	// TIMER2 Control/Status Register
-		case Timers::M_TLR0:		return m_timers.readTLR	(0);	// TIMER0 Load Reg
-		case Timers::M_TLR1:		return m_timers.readTLR	(1);	// TIMER1 Load Reg
-		case Timers::M_TLR2:		return m_timers.readTLR	(2);	// TIMER2 Load Reg
-		case Timers::M_TCPR0:		return m_timers.readTCPR(0);	// TIMER0 Compare Register
-		case Timers::M_TCPR1:		return m_timers.readTCPR(1);	// TIMER1 Compare Register
-		case Timers::M_TCPR2:		return m_timers.readTCPR(2);	// TIMER2 Compare Register
-		case Timers::M_TCR0:		return m_timers.readTCR	(0);	// TIMER0 Count Register
-		case Timers::M_TCR1:		return m_timers.readTCR	(1);	// TIMER1 Count Register
-		case Timers::M_TCR2:		return m_timers.readTCR	(2);	// TIMER2 Count Register
-
-		case Timers::M_TPLR:		return m_timers.readTPLR();		// TIMER Prescaler Load Register
-		case Timers::M_TPCR:		return m_timers.readTPCR();		// TIMER Prescalar Count Register
-
-		case 0xffffff:
-		case 0xfffffe:
-			return m_mem[_addr - XIO_Reserved_High_First];
-		case 0xFFFF93:			// SHI__HTX
-		case 0xFFFF94:			// SHI__HRX
-//			LOG("Read from " << HEX(_addr));
-			return 0;	//m_mem[_addr - XIO_Reserved_High_First];	// There is nothing connected.
-
-//		case XIO_DSTR:					// DMA status reg
-//			return 0x3f;
-		case XIO_IDR:					// ID Register
-			return 0x362;
-
-		case M_AAR0:
-		case M_AAR1:
-		case M_AAR2:
-		case M_AAR3:
-			return m_mem[_addr - XIO_Reserved_High_First];
-
-		case XIO_DCR5: return m_dma.getDCR(5);	// DMA 5 Control Register
-		case XIO_DCO5: return m_dma.getDCO(5);	// DMA 5 Counter
-		case XIO_DDR5: return m_dma.getDDR(5);	// DMA 5 Destination Address Register
-		case XIO_DSR5: return m_dma.getDSR(5);	// DMA 5 Source Address Register
-
-		case XIO_DCR4: return m_dma.getDCR(4);	// DMA 4 Control Register
-		case XIO_DCO4: return m_dma.getDCO(4);	// DMA 4 Counter
-		case XIO_DDR4: return m_dma.getDDR(4);	// DMA 4 Destination Address Register
-		case XIO_DSR4: return m_dma.getDSR(4);	// DMA 4 Source Address Register
-
-		case XIO_DCR3: return m_dma.getDCR(3);	// DMA 3 Control Register
-		case XIO_DCO3: return m_dma.getDCO(3);	// DMA 3 Counter
-		case XIO_DDR3: return m_dma.getDDR(3);	// DMA 3 Destination Address Register
-		case XIO_DSR3: return m_dma.getDSR(3);	// DMA 3 Source Address Register
-
-		case XIO_DCR2: return m_dma.getDCR(2);	// DMA 2 Control Register
-		case XIO_DCO2: return m_dma.getDCO(2);	// DMA 2 Counter
-		case XIO_DDR2: return m_dma.getDDR(2);	// DMA 2 Destination Address Register
-		case XIO_DSR2: return m_dma.getDSR(2);	// DMA 2 Source Address Register
-
-		case XIO_DCR1: return m_dma.getDCR(1);	// DMA 1 Control Register
-		case XIO_DCO1: return m_dma.getDCO(1);	// DMA 1 Counter
-		case XIO_DDR1: return m_dma.getDDR(1);	// DMA 1 Destination Address Register
-		case XIO_DSR1: return m_dma.getDSR(1);	// DMA 1 Source Address Register
-
-		case XIO_DCR0: return m_dma.getDCR(0);	// DMA 0 Control Register
-		case XIO_DCO0: return m_dma.getDCO(0);	// DMA 0 Counter
-		case XIO_DDR0: return m_dma.getDDR(0);	// DMA 0 Destination Address Register
-		case XIO_DSR0: return m_dma.getDSR(0);	// DMA 0 Source Address Register
-
-		case XIO_DOR3: return m_dma.getDOR(3);	// DMA Offset Register 3
-		case XIO_DOR2: return m_dma.getDOR(2);	// DMA Offset Register 2 
-		case XIO_DOR1: return m_dma.getDOR(1);	// DMA Offset Register 1
-		case XIO_DOR0: return m_dma.getDOR(0);	// DMA Offset Register 0
-
-		case XIO_DSTR: return m_dma.getDSTR();	// DMA Status Register
-		}
-
-		const auto& value = m_mem[_addr - XIO_Reserved_High_First];
-
-//		if (_addr!=0xffffd5) {LOG( "Periph read @ " << std::hex << _addr << ": returning (0x" <<  HEX(value) << ")");}
-
-		return value;
+		initRegisters();
 	}
 
-	const TWord* Peripherals56362::readAsPtr(const TWord _addr, Instruction _inst)
+	void Peripherals56362::initRegisters()
 	{
-		switch (_addr)
-		{
-		case Esai::M_PCRC:			return &m_portC.getControl();
-		case Esai::M_PRRC:			return &m_portC.getDirection();
-		case Esai::M_SAISR:			return &m_esai.readStatusRegister();
-
-		case Timers::M_TCSR0:		return &m_timers.readTCSR(0);	// TIMER0 Control/Status Register
-		case Timers::M_TCSR1:		return &m_timers.readTCSR(1);	// TIMER1 Control/Status Register
-		case Timers::M_TCSR2:		return &m_timers.readTCSR(2);	// TIMER2 Control/Status Register
-		case Timers::M_TLR0:		return &m_timers.readTLR(0);	// TIMER0 Load Reg
-		case Timers::M_TLR1:		return &m_timers.readTLR(1);	// TIMER1 Load Reg
-		case Timers::M_TLR2:		return &m_timers.readTLR(2);	// TIMER2 Load Reg
-		case Timers::M_TCPR0:		return &m_timers.readTCPR(0);	// TIMER0 Compare Register
-		case Timers::M_TCPR1:		return &m_timers.readTCPR(1);	// TIMER1 Compare Register
-		case Timers::M_TCPR2:		return &m_timers.readTCPR(2);	// TIMER2 Compare Register
-		case Timers::M_TCR0:		return &m_timers.readTCR(0);	// TIMER0 Count Register
-		case Timers::M_TCR1:		return &m_timers.readTCR(1);	// TIMER1 Count Register
-		case Timers::M_TCR2:		return &m_timers.readTCR(2);	// TIMER2 Count Register
-
-		case Timers::M_TPLR:		return &m_timers.readTPLR();	// TIMER Prescaler Load Register
-		case Timers::M_TPCR:		return &m_timers.readTPCR();	// TIMER Prescalar Count Register
-
-		case XIO_DCR5:				return &m_dma.getDCR(5);		// DMA 5 Control Register
-		case XIO_DCO5:				return &m_dma.getDCO(5);		// DMA 5 Counter
-		case XIO_DDR5:				return &m_dma.getDDR(5);		// DMA 5 Destination Address Register
-		case XIO_DSR5:				return &m_dma.getDSR(5);		// DMA 5 Source Address Register
-
-		case XIO_DCR4:				return &m_dma.getDCR(4);		// DMA 4 Control Register
-		case XIO_DCO4:				return &m_dma.getDCO(4);		// DMA 4 Counter
-		case XIO_DDR4:				return &m_dma.getDDR(4);		// DMA 4 Destination Address Register
-		case XIO_DSR4:				return &m_dma.getDSR(4);		// DMA 4 Source Address Register
-
-		case XIO_DCR3:				return &m_dma.getDCR(3);		// DMA 3 Control Register
-		case XIO_DCO3:				return &m_dma.getDCO(3);		// DMA 3 Counter
-		case XIO_DDR3:				return &m_dma.getDDR(3);		// DMA 3 Destination Address Register
-		case XIO_DSR3:				return &m_dma.getDSR(3);		// DMA 3 Source Address Register
-
-		case XIO_DCR2:				return &m_dma.getDCR(2);		// DMA 2 Control Register
-		case XIO_DCO2:				return &m_dma.getDCO(2);		// DMA 2 Counter
-		case XIO_DDR2:				return &m_dma.getDDR(2);		// DMA 2 Destination Address Register
-		case XIO_DSR2:				return &m_dma.getDSR(2);		// DMA 2 Source Address Register
-
-		case XIO_DCR1:				return &m_dma.getDCR(1);		// DMA 1 Control Register
-		case XIO_DCO1:				return &m_dma.getDCO(1);		// DMA 1 Counter
-		case XIO_DDR1:				return &m_dma.getDDR(1);		// DMA 1 Destination Address Register
-		case XIO_DSR1:				return &m_dma.getDSR(1);		// DMA 1 Source Address Register
-
-		case XIO_DCR0:				return &m_dma.getDCR(0);		// DMA 0 Control Register
-		case XIO_DCO0:				return &m_dma.getDCO(0);		// DMA 0 Counter
-		case XIO_DDR0:				return &m_dma.getDDR(0);		// DMA 0 Destination Address Register
-		case XIO_DSR0:				return &m_dma.getDSR(0);		// DMA 0 Source Address Register
-
-		case XIO_DSTR:				return &m_dma.getDSTR();		// DMA Status Register
-		}
-
-		return nullptr;
-	}
-
-	void Peripherals56362::write(const TWord _addr, const TWord _val)
-	{
-		switch (_addr)
-		{
-		case HDI08::HSR:	m_hdi08.writeStatusRegister(_val);		return;
-		case HDI08::HCR:	m_hdi08.writeControlRegister(_val);		return;
-		case HDI08::HPCR:	m_hdi08.writePortControlRegister(_val);	return;
-		case HDI08::HOTX:	m_hdi08.writeTX(_val);					return;
-		case HDI08::HDR:	m_hdi08.writeHDR(_val);					return;
-		case HDI08::HDDR:	m_hdi08.writeHDDR(_val);				return;
-
-		case Timers::M_TCSR0:		m_timers.writeTCSR	(0, _val);	return;		// TIMER0 Control/Status Register
-		case Timers::M_TCSR1:		m_timers.writeTCSR	(1, _val);	return;		// TIMER1 Control/Status Register
-		case Timers::M_TCSR2:		m_timers.writeTCSR	(2, _val);	return;		// TIMER2 Control/Status Register
-		case Timers::M_TLR0:		m_timers.writeTLR	(0, _val);	return;		// TIMER0 Load Reg
-		case Timers::M_TLR1:		m_timers.writeTLR	(1, _val);	return;		// TIMER1 Load Reg
-		case Timers::M_TLR2:		m_timers.writeTLR	(2, _val);	return;		// TIMER2 Load Reg
-		case Timers::M_TCPR0:		m_timers.writeTCPR	(0, _val);	return;		// TIMER0 Compare Register
-		case Timers::M_TCPR1:		m_timers.writeTCPR	(1, _val);	return;		// TIMER1 Compare Register
-		case Timers::M_TCPR2:		m_timers.writeTCPR	(2, _val);	return;		// TIMER2 Compare Register
-		case Timers::M_TCR0:		m_timers.writeTCR	(0, _val);	return;		// TIMER0 Count Register
-		case Timers::M_TCR1:		m_timers.writeTCR	(1, _val);	return;		// TIMER1 Count Register
-		case Timers::M_TCR2:		m_timers.writeTCR	(2, _val);	return;		// TIMER2 Count Register
-
-		case Timers::M_TPLR:		m_timers.writeTPLR	(_val);		return;		// TIMER Prescaler Load Register
-		case Timers::M_TPCR:		m_timers.writeTPCR	(_val);		return;		// TIMER Prescalar Count Register
-		
-		case 0xFFFF91:			// SHI__HCSR
-			return;
-		case 0xFFFF93:			// SHI__HTX
-		case 0xFFFF94:			// SHI__HRX
-//			LOG("Write to " << HEX(_addr) << ": " << HEX(_val));
-//			m_mem[_addr - XIO_Reserved_High_First] = _val;	// Do not write!
-			return;
-
-		case Esai::M_SAISR:			m_esai.writestatusRegister(_val);					return;
-		case Esai::M_SAICR:			m_esai.writeControlRegister(_val);					return;
-		case Esai::M_RCR:			m_esai.writeReceiveControlRegister(_val);			return;
-		case Esai::M_RCCR:			m_esai.writeReceiveClockControlRegister(_val);		return;
-		case Esai::M_TCR:			m_esai.writeTransmitControlRegister(_val);			return;
-		case Esai::M_TCCR:			m_esai.writeTransmitClockControlRegister(_val);		return;
-		case Esai::M_TX0:
-		case Esai::M_TX1:
-		case Esai::M_TX2:
-		case Esai::M_TX3:
-		case Esai::M_TX4:
-		case Esai::M_TX5:			m_esai.writeTX(_addr - Esai::M_TX0, _val);			return;
-		case Esai::M_TSMA:			m_esai.writeTSMA(_val);								return;
-		case Esai::M_TSMB:			m_esai.writeTSMB(_val);								return;
-		case Esai::M_PCRC:			m_portC.setControl(_val);							return;
-		case Esai::M_PDRC:			m_portC.dspWrite(_val);								return;
-		case Esai::M_PRRC:			m_portC.setDirection(_val);							return;
-
-		case XIO_PCTL:				m_esaiClock.setPCTL(_val);							return;
-
-		case XIO_DCR5: m_dma.setDCR(5, _val); return;	// DMA 5 Control Register
-		case XIO_DCO5: m_dma.setDCO(5, _val); return;	// DMA 5 Counter
-		case XIO_DDR5: m_dma.setDDR(5, _val); return;	// DMA 5 Destination Address Register
-		case XIO_DSR5: m_dma.setDSR(5, _val); return;	// DMA 5 Source Address Register
-
-		case XIO_DCR4: m_dma.setDCR(4, _val); return;	// DMA 4 Control Register
-		case XIO_DCO4: m_dma.setDCO(4, _val); return;	// DMA 4 Counter
-		case XIO_DDR4: m_dma.setDDR(4, _val); return;	// DMA 4 Destination Address Register
-		case XIO_DSR4: m_dma.setDSR(4, _val); return;	// DMA 4 Source Address Register
-
-		case XIO_DCR3: m_dma.setDCR(3, _val); return;	// DMA 3 Control Register
-		case XIO_DCO3: m_dma.setDCO(3, _val); return;	// DMA 3 Counter
-		case XIO_DDR3: m_dma.setDDR(3, _val); return;	// DMA 3 Destination Address Register
-		case XIO_DSR3: m_dma.setDSR(3, _val); return;	// DMA 3 Source Address Register
-
-		case XIO_DCR2: m_dma.setDCR(2, _val); return;	// DMA 2 Control Register
-		case XIO_DCO2: m_dma.setDCO(2, _val); return;	// DMA 2 Counter
-		case XIO_DDR2: m_dma.setDDR(2, _val); return;	// DMA 2 Destination Address Register
-		case XIO_DSR2: m_dma.setDSR(2, _val); return;	// DMA 2 Source Address Register
-
-		case XIO_DCR1: m_dma.setDCR(1, _val); return;	// DMA 1 Control Register
-		case XIO_DCO1: m_dma.setDCO(1, _val); return;	// DMA 1 Counter
-		case XIO_DDR1: m_dma.setDDR(1, _val); return;	// DMA 1 Destination Address Register
-		case XIO_DSR1: m_dma.setDSR(1, _val); return;	// DMA 1 Source Address Register
-
-		case XIO_DCR0: m_dma.setDCR(0, _val); return;	// DMA 0 Control Register
-		case XIO_DCO0: m_dma.setDCO(0, _val); return;	// DMA 0 Counter
-		case XIO_DDR0: m_dma.setDDR(0, _val); return;	// DMA 0 Destination Address Register
-		case XIO_DSR0: m_dma.setDSR(0, _val); return;	// DMA 0 Source Address Register
-
-		case XIO_DOR3: m_dma.setDOR(3, _val); return;	// DMA Offset Register 3
-		case XIO_DOR2: m_dma.setDOR(2, _val); return;	// DMA Offset Register 2 
-		case XIO_DOR1: m_dma.setDOR(1, _val); return;	// DMA Offset Register 1
-		case XIO_DOR0: m_dma.setDOR(0, _val); return;	// DMA Offset Register 0
-
-//		case XIO_DSTR: m_dma.setDSTR(_val); return;		// DMA Status Register is read only
-
-		case 0xffffd2:	// DAX audio data register A
-			return;
-		default:
-			break;
-		}
-		if (_addr!=0xffffd5)
-		{
-//			LOG( "Periph write @ " << std::hex << _addr << ": 0x" << HEX(_val));
-		}
-		m_mem[_addr - XIO_Reserved_High_First] = _val;
+		using P = Peripherals56362;
+
+		setMemoryRegisters(&m_mem[0], [](IPeripherals& _p, const TWord _addr, const TWord _val) { static_cast<P&>(_p).m_mem[_addr - XIO_Reserved_High_First] = _val; });
+
+		setReadHandler(HDI08::HSR,	[](IPeripherals& _p, TWord, Instruction) { return static_cast<P&>(_p).m_hdi08.readStatusRegister(); });
+		setReadHandler(HDI08::HCR,	[](IPeripherals& _p, TWord, Instruction) { return static_cast<P&>(_p).m_hdi08.readControlRegister(); });
+		setReadHandler(HDI08::HPCR,	[](IPeripherals& _p, TWord, Instruction) { return static_cast<P&>(_p).m_hdi08.readPortControlRegister(); });
+		setReadHandler(HDI08::HORX,	[](IPeripherals& _p, TWord, const Instruction _inst) { return static_cast<P&>(_p).m_hdi08.readRX(_inst); });
+		setReadHandler(HDI08::HDR,	[](IPeripherals& _p, TWord, Instruction) { return static_cast<P&>(_p).m_hdi08.readHDR(); });
+		setReadHandler(HDI08::HDDR,	[](IPeripherals& _p, TWord, Instruction) { return static_cast<P&>(_p).m_hdi08.readHDDR(); });
+
+		setWriteHandler(HDI08::HSR,		[](IPeripherals& _p, TWord, const TWord _val) { static_cast<P&>(_p).m_hdi08.writeStatusRegister(_val); });
+		setWriteHandler(HDI08::HCR,		[](IPeripherals& _p, TWord, const TWord _val) { static_cast<P&>(_p).m_hdi08.writeControlRegister(_val); });
+		setWriteHandler(HDI08::HPCR,	[](IPeripherals& _p, TWord, const TWord _val) { static_cast<P&>(_p).m_hdi08.writePortControlRegister(_val); });
+		setWriteHandler(HDI08::HOTX,	[](IPeripherals& _p, TWord, const TWord _val) { static_cast<P&>(_p).m_hdi08.writeTX(_val); });
+		setWriteHandler(HDI08::HDR,		[](IPeripherals& _p, TWord, const TWord _val) { static_cast<P&>(_p).m_hdi08.writeHDR(_val); });
+		setWriteHandler(HDI08::HDDR,	[](IPeripherals& _p, TWord, const TWord _val) { static_cast<P&>(_p).m_hdi08.writeHDDR(_val); });
+
+		setReadHandler(Esai::M_RCR,		[](IPeripherals& _p, TWord, Instruction) { return static_cast<P&>(_p).m_esai.readReceiveControlRegister(); });
+		setReadHandler(Esai::M_RCCR,	[](IPeripherals& _p, TWord, Instruction) { return static_cast<P&>(_p).m_esai.readReceiveClockControlRegister(); });
+		setReadValue(Esai::M_SAISR,		m_esai.readStatusRegister());
+		setReadHandler(Esai::M_TCR,		[](IPeripherals& _p, TWord, Instruction) { return static_cast<P&>(_p).m_esai.readTransmitControlRegister(); });
+		setReadHandler(Esai::M_TCCR,	[](IPeripherals& _p, TWord, Instruction) { return static_cast<P&>(_p).m_esai.readTransmitClockControlRegister(); });
+		for(TWord a = Esai::M_RX0; a <= Esai::M_RX3; ++a)
+			setReadHandler(a, [](IPeripherals& _p, const TWord _addr, Instruction) { return static_cast<P&>(_p).m_esai.readRX(_addr - Esai::M_RX0); });
+		setReadHandler(Esai::M_TSMA,	[](IPeripherals& _p, TWord, Instruction) { return static_cast<P&>(_p).m_esai.readTSMA(); });
+		setReadHandler(Esai::M_TSMB,	[](IPeripherals& _p, TWord, Instruction) { return static_cast<P&>(_p).m_esai.readTSMB(); });
+		setReadValue(Esai::M_PCRC,		m_portC.getControl());
+		setReadHandler(Esai::M_PDRC,	[](IPeripherals& _p, TWord, Instruction) { return static_cast<P&>(_p).m_portC.dspRead(); });
+		setReadValue(Esai::M_PRRC,		m_portC.getDirection());
+
+		setWriteHandler(Esai::M_SAISR,	[](IPeripherals& _p, TWord, const TWord _val) { static_cast<P&>(_p).m_esai.writestatusRegister(_val); });
+		setWriteHandler(Esai::M_SAICR,	[](IPeripherals& _p, TWord, const TWord _val) { static_cast<P&>(_p).m_esai.writeControlRegister(_val); });
+		setWriteHandler(Esai::M_RCR,	[](IPeripherals& _p, TWord, const TWord _val) { static_cast<P&>(_p).m_esai.writeReceiveControlRegister(_val); });
+		setWriteHandler(Esai::M_RCCR,	[](IPeripherals& _p, TWord, const TWord _val) { static_cast<P&>(_p).m_esai.writeReceiveClockControlRegister(_val); });
+		setWriteHandler(Esai::M_TCR,	[](IPeripherals& _p, TWord, const TWord _val) { static_cast<P&>(_p).m_esai.writeTransmitControlRegister(_val); });
+		setWriteHandler(Esai::M_TCCR,	[](IPeripherals& _p, TWord, const TWord _val) { static_cast<P&>(_p).m_esai.writeTransmitClockControlRegister(_val); });
+		for(TWord a = Esai::M_TX0; a <= Esai::M_TX5; ++a)
+			setWriteHandler(a, [](IPeripherals& _p, const TWord _addr, const TWord _val) { static_cast<P&>(_p).m_esai.writeTX(_addr - Esai::M_TX0, _val); });
+		setWriteHandler(Esai::M_TSMA,	[](IPeripherals& _p, TWord, const TWord _val) { static_cast<P&>(_p).m_esai.writeTSMA(_val); });
+		setWriteHandler(Esai::M_TSMB,	[](IPeripherals& _p, TWord, const TWord _val) { static_cast<P&>(_p).m_esai.writeTSMB(_val); });
+		setWriteHandler(Esai::M_PCRC,	[](IPeripherals& _p, TWord, const TWord _val) { static_cast<P&>(_p).m_portC.setControl(_val); });
+		setWriteHandler(Esai::M_PDRC,	[](IPeripherals& _p, TWord, const TWord _val) { static_cast<P&>(_p).m_portC.dspWrite(_val); });
+		setWriteHandler(Esai::M_PRRC,	[](IPeripherals& _p, TWord, const TWord _val) { static_cast<P&>(_p).m_portC.setDirection(_val); });
+
+		for(TWord i=0; i<=Esai::M_TX5 - Esai::M_TX0; ++i)
+			setEsxiRegister(Esai::M_TX0 + i, m_esai.getTxRegister(i));
+		for(TWord i=0; i<=Esai::M_RX3 - Esai::M_RX0; ++i)
+			setEsxiRegister(Esai::M_RX0 + i, m_esai.getRxRegister(i));
+
+		setReadHandler(XIO_PCTL,	[](IPeripherals& _p, TWord, Instruction) { return static_cast<P&>(_p).m_esaiClock.getPCTL(); });
+		setWriteHandler(XIO_PCTL,	[](IPeripherals& _p, TWord, const TWord _val) { static_cast<P&>(_p).m_esaiClock.setPCTL(_val); });
+
+		setTimerRegisters<P>();
+		setDmaRegisters<P>();
+
+		// SHI, there is nothing connected
+		constexpr PeripheralRegister::ReadFunc readZero = [](IPeripherals&, TWord, Instruction) -> TWord { return 0; };
+		constexpr PeripheralRegister::WriteFunc writeNothing = [](IPeripherals&, TWord, TWord) {};
+
+		setWriteHandler(0xFFFF91, writeNothing);	// SHI__HCSR
+		setReadHandler(0xFFFF93, readZero);			// SHI__HTX
+		setWriteHandler(0xFFFF93, writeNothing);
+		setReadHandler(0xFFFF94, readZero);			// SHI__HRX
+		setWriteHandler(0xFFFF94, writeNothing);
+
+		setWriteHandler(0xffffd2, writeNothing);	// DAX audio data register A
+
+		setReadHandler(XIO_IDR, [](IPeripherals&, TWord, Instruction) -> TWord { return 0x362; });
 	}
 
 	uint32_t Peripherals56362::exec()
 	{
-		auto delay = m_esaiClock.exec();
-		delay = std::min(delay, m_hdi08.exec());
+		m_scheduler.begin(getDSP().getInstructionCounter());
+
+		m_scheduler.run(PeripheralScheduler::SlotAudio, [this] { return m_esaiClock.exec(); });
+		m_scheduler.run(PeripheralScheduler::SlotHost, [this] { return m_hdi08.exec(); });
 		if (!m_disableTimers)
-			delay = std::min(delay, m_timers.exec());
-		delay = std::min(delay, m_dma.exec());
-		return delay;
+			m_scheduler.run(PeripheralScheduler::SlotTimers, [this] { return m_timers.exec(); });
+		else
+			m_scheduler.disable(PeripheralScheduler::SlotTimers);
+		m_scheduler.run(PeripheralScheduler::SlotDma, [this] { return m_dma.exec(); });
+
+		return m_scheduler.end(MaxDelayCycles);
 	}
 
 	void Peripherals56362::reset()
@@ -729,6 +552,27 @@ namespace dsp56k
 		m_esai.terminate();
 	}
 
+	void Peripherals56362::saveState(StateWriter& _w) const
+	{
+		IPeripherals::saveState(_w);
+
+		_w.write(m_mem);
+
+		m_dma.saveState(_w);
+		m_esaiClock.saveState(_w);
+		m_esai.saveState(_w);
+		m_hdi08.saveState(_w);
+		m_timers.saveState(_w);
+		m_portC.saveState(_w);
+	}
+
+	bool Peripherals56362::loadState(StateReader& _r)
+	{
+		return IPeripherals::loadState(_r) && _r.read(m_mem) &&
+			m_dma.loadState(_r) && m_esaiClock.loadState(_r) && m_esai.loadState(_r) &&
+			m_hdi08.loadState(_r) && m_timers.loadState(_r) && m_portC.loadState(_r);
+	}
+
 	void Peripherals56362::setDSP(DSP* _dsp)
 	{
 		IPeripherals::setDSP(_dsp);
@@ -741,54 +585,41 @@ namespace dsp56k
 	Peripherals56367::Peripherals56367() : IPeripherals(PeripheralType::Peripherals56367),	m_mem(), m_esai(*this, MemArea_Y)
 	{
 		m_mem.fill(0);
-	}
 
-	TWord Peripherals56367::read(const TWord _addr, Instruction _inst)
-	{
-		switch (_addr)
-		{
-		case Esai::M_RCR_1:			return m_esai.readReceiveControlRegister();
-		case Esai::M_RCCR_1:		return m_esai.readReceiveClockControlRegister();
-		case Esai::M_SAISR_1:		return m_esai.readStatusRegister();
-		case Esai::M_TCR_1:			return m_esai.readTransmitControlRegister();
-		case Esai::M_TCCR_1:		return m_esai.readTransmitClockControlRegister();
-		case Esai::M_RX0_1:
-		case Esai::M_RX1_1:
-		case Esai::M_RX2_1:
-		case Esai::M_RX3_1:			return m_esai.readRX(_addr - Esai::M_RX0_1);
-		case Esai::M_TSMA_1:		return m_esai.readTSMA();
-		case Esai::M_TSMB_1:		return m_esai.readTSMB();
-		default:
-			return m_mem[_addr - XIO_Reserved_High_First];
-		}
+		initRegisters();
 	}
 
-	void Peripherals56367::write(TWord _addr, TWord _val)
+	void Peripherals56367::initRegisters()
 	{
-		switch (_addr)
-		{
-		case Esai::M_SAISR_1:	m_esai.writestatusRegister(_val);					return;
-		case Esai::M_SAICR_1:	m_esai.writeControlRegister(_val);					return;
-		case Esai::M_RCR_1:		m_esai.writeReceiveControlRegister(_val);			return;
-		case Esai::M_RCCR_1:	m_esai.writeReceiveClockControlRegister(_val);		return;
-		case Esai::M_TCR_1:		m_esai.writeTransmitControlRegister(_val);			return;
-		case Esai::M_TCCR_1:	m_esai.writeTransmitClockControlRegister(_val);		return;
-		case Esai::M_TX0_1:
-		case Esai::M_TX1_1:
-		case Esai::M_TX2_1:
-		case Esai::M_TX3_1:
-		case Esai::M_TX4_1:
-		case Esai::M_TX5_1:		m_esai.writeTX(_addr - Esai::M_TX0_1, _val);		return;
-		case Esai::M_TSMA_1:	m_esai.writeTSMA(_val);								return;
-		case Esai::M_TSMB_1:	m_esai.writeTSMB(_val);								return;
-		default:
-			break;
-		}
-		if (_addr != 0xffffd5)
-		{
-//			LOG("Periph write @ " << std::hex << _addr << ": 0x" << HEX(_val));
-		}
-		m_mem[_addr - XIO_Reserved_High_First] = _val;
+		using P = Peripherals56367;
+
+		setMemoryRegisters(m_mem.data(), [](IPeripherals& _p, const TWord _addr, const TWord _val) { static_cast<P&>(_p).m_mem[_addr - XIO_Reserved_High_First] = _val; });
+
+		setReadHandler(Esai::M_RCR_1,	[](IPeripherals& _p, TWord, Instruction) { return static_cast<P&>(_p).m_esai.readReceiveControlRegister(); });
+		setReadHandler(Esai::M_RCCR_1,	[](IPeripherals& _p, TWord, Instruction) { return static_cast<P&>(_p).m_esai.readReceiveClockControlRegister(); });
+		setReadHandler(Esai::M_SAISR_1,	[](IPeripherals& _p, TWord, Instruction) { return static_cast<P&>(_p).m_esai.readStatusRegister(); });
+		setReadHandler(Esai::M_TCR_1,	[](IPeripherals& _p, TWord, Instruction) { return static_cast<P&>(_p).m_esai.readTransmitControlRegister(); });
+		setReadHandler(Esai::M_TCCR_1,	[](IPeripherals& _p, TWord, Instruction) { return static_cast<P&>(_p).m_esai.readTransmitClockControlRegister(); });
+		for(TWord a = Esai::M_RX0_1; a <= Esai::M_RX3_1; ++a)
+			setReadHandler(a, [](IPeripherals& _p, const TWord _addr, Instruction) { return static_cast<P&>(_p).m_esai.readRX(_addr - Esai::M_RX0_1); });
+		setReadHandler(Esai::M_TSMA_1,	[](IPeripherals& _p, TWord, Instruction) { return static_cast<P&>(_p).m_esai.readTSMA(); });
+		setReadHandler(Esai::M_TSMB_1,	[](IPeripherals& _p, TWord, Instruction) { return static_cast<P&>(_p).m_esai.readTSMB(); });
+
+		setWriteHandler(Esai::M_SAISR_1,	[](IPeripherals& _p, TWord, const TWord _val) { static_cast<P&>(_p).m_esai.writestatusRegister(_val); });
+		setWriteHandler(Esai::M_SAICR_1,	[](IPeripherals& _p, TWord, const TWord _val) { static_cast<P&>(_p).m_esai.writeControlRegister(_val); });
+		setWriteHandler(Esai::M_RCR_1,		[](IPeripherals& _p, TWord, const TWord _val) { static_cast<P&>(_p).m_esai.writeReceiveControlRegister(_val); });
+		setWriteHandler(Esai::M_RCCR_1,		[](IPeripherals& _p, TWord, const TWord _val) { static_cast<P&>(_p).m_esai.writeReceiveClockControlRegister(_val); });
+		setWriteHandler(Esai::M_TCR_1,		[](IPeripherals& _p, TWord, const TWord _val) { static_cast<P&>(_p).m_esai.writeTransmitControlRegister(_val); });
+		setWriteHandler(Esai::M_TCCR_1,		[](IPeripherals& _p, TWord, const TWord _val) { static_cast<P&>(_p).m_esai.writeTransmitClockControlRegister(_val); });
+		for(TWord a = Esai::M_TX0_1; a <= Esai::M_TX5_1; ++a)
+			setWriteHandler(a, [](IPeripherals& _p, const TWord _addr, const TWord _val) { static_cast<P&>(_p).m_esai.writeTX(_addr - Esai::M_TX0_1, _val); });
+		setWriteHandler(Esai::M_TSMA_1,		[](IPeripherals& _p, TWord, const TWord _val) { static_cast<P&>(_p).m_esai.writeTSMA(_val); });
+		setWriteHandler(Esai::M_TSMB_1,		[](IPeripherals& _p, TWord, const TWord _val) { static_cast<P&>(_p).m_esai.writeTSMB(_val); });
+
+		for(TWord i=0; i<=Esai::M_TX5_1 - Esai::M_TX0_1; ++i)
+			setEsxiRegister(Esai::M_TX0_1 + i, m_esai.getTxRegister(i));
+		for(TWord i=0; i<=Esai::M_RX3_1 - Esai::M_RX0_1; ++i)
+			setEsxiRegister(Esai::M_RX0_1 + i, m_esai.getRxRegister(i));
 	}
 
 	void Peripherals56367::setSymbols(Disassembler& _disasm) const
@@ -800,4 +631,18 @@ namespace dsp56k
 	{
 		m_esai.terminate();
 	}
+
+	void Peripherals56367::saveState(StateWriter& _w) const
+	{
+		IPeripherals::saveState(_w);
+
+		_w.write(m_mem);
+
+		m_esai.saveState(_w);
+	}
+
+	bool Peripherals56367::loadState(StateReader& _r)
+	{
+		return IPeripherals::loadState(_r) && _r.read(m_mem) && m_esai.loadState(_r);
+	}
 }
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <map>
+
 #include "dma.h"
 #include "esai.h"
 #include "esaiclock.h"
@@ -7,6 +9,7 @@
 #include "gpio.h"
 #include "hdi08.h"
 #include "opcodetypes.h"
+#include "peripheralscheduler.h"
 #include "timers.h"
 #include "types.h"
 #include "staticArray.h"
@@ -14,6 +17,8 @@
 namespace dsp56k
 {
 	class Disassembler;
+	class StateReader;
+	class StateWriter;
 
 	enum class PeripheralType
 	{
@@ -85,14 +90,26 @@ namespace dsp56k
 		XIO_IPRC = XIO_Reserved_High_Last	// Interrupt Priority Register Core
 	};
 
+	class IPeripherals;
+
+	// handlers of a register in the peripheral address range
+	struct PeripheralRegister
+	{
+		using ReadFunc = TWord(*)(IPeripherals& _periph, TWord _addr, Instruction _inst);
+		using WriteFunc = void(*)(IPeripherals& _periph, TWord _addr, TWord _val);
+
+		ReadFunc read = nullptr;
+		WriteFunc write = nullptr;
+		const TWord* value = nullptr;	// plain backing word if reading has no side effects, returned by readAsPtr
+	};
+
 	class IPeripherals
 	{
 	public:
 		static constexpr uint32_t MaxDelayCycles = 16384;
+		static constexpr TWord RegisterCount = XIO_Reserved_High_Last - XIO_Reserved_High_First + 1;
 
-		explicit IPeripherals(const PeripheralType _t) : m_type(_t)
-		{
-		}
+		explicit IPeripherals(PeripheralType _t);
 		virtual ~IPeripherals() = default;
 
 		virtual void setDSP(DSP* _dsp)
@@ -103,13 +120,36 @@ namespace dsp56k
 		DSP& getDSP() const		{ return *m_dsp; }
 		bool hasDSP() const		{ return m_dsp != nullptr; }
 
-		virtual TWord read(TWord _addr, Instruction _inst) = 0;
-		virtual const TWord* readAsPtr(TWord _addr, Instruction _inst) = 0;
-		virtual void write(TWord _addr, TWord _value) = 0;
+		TWord read(const TWord _addr, const Instruction _inst)
+		{
+			return getRegister(_addr).read(*this, _addr, _inst);
+		}
+
+		const TWord* readAsPtr(const TWord _addr, Instruction/* _inst*/) const
+		{
+			return getRegister(_addr).value;
+		}
+
+		void write(const TWord _addr, const TWord _value)
+		{
+			getRegister(_addr).write(*this, _addr, _value);
+		}
+
+		const PeripheralRegister& getRegister(const TWord _addr) const
+		{
+			return m_registers[(_addr - XIO_Reserved_High_First) & (RegisterCount - 1)];
+		}
+
+		// ESAI/ESSI data register at the given address or nullptr, see EsxiDataRegister
+		const EsxiDataRegister* getEsxiRegister(TWord _addr) const;
+
 		virtual void reset() = 0;
 		virtual void setSymbols(Disassembler& _disasm) const = 0;
 		virtual void terminate() = 0;
 
+		virtual void saveState(StateWriter& _w) const;
+		virtual bool loadState(StateReader& _r);
+
 		void setDelayCycles(uint32_t _delayCycles);
 
 		void resetDelayCycles(const uint64_t _instructionCount, const uint32_t _delayCycles) noexcept
@@ -123,7 +163,25 @@ namespace dsp56k
 
 		auto getType() const { return m_type; }
 
+	protected:
+		void setReadHandler(TWord _addr, PeripheralRegister::ReadFunc _read, const TWord* _value = nullptr);
+		void setReadValue(TWord _addr, const TWord& _value);
+		void setWriteHandler(TWord _addr, PeripheralRegister::WriteFunc _write);
+		void setEsxiRegister(TWord _addr, const EsxiDataRegister& _reg);
+
+		// all registers read from and write to the given memory, specific handlers are installed afterwards
+		void setMemoryRegisters(const TWord* _mem, PeripheralRegister::WriteFunc _write);
+
+		template<typename T> void setDmaRegisters();
+		template<typename T> void setTimerRegisters();
+
+		PeripheralScheduler m_scheduler;
+
 	private:
+		static TWord readValue(IPeripherals& _periph, TWord _addr, Instruction _inst);
+
+		std::array<PeripheralRegister, RegisterCount> m_registers;
+		std::map<TWord, EsxiDataRegister> m_esxiRegisters;
 		DSP* m_dsp = nullptr;
 		uint32_t m_delayCycles = 0;
 		uint64_t m_targetClock = 0;
@@ -137,9 +195,6 @@ namespace dsp56k
 		uint32_t exec() { return MaxDelayCycles; }
 
 	private:
-		TWord read(TWord _addr, Instruction _inst) override { return 0; }
-		const TWord* readAsPtr(TWord _addr, Instruction _inst) override { return nullptr; }
-		void write(TWord _addr, TWord _value) override {}
 		void reset() override {}
 		void setSymbols(Disassembler& _disasm) const override {}
 		void terminate() override {}
@@ -157,10 +212,6 @@ namespace dsp56k
 		//
 	public:
 		Peripherals56303();
-		
-		TWord read(TWord _addr, Instruction _inst) override;
-		const TWord* readAsPtr(TWord _addr, Instruction _inst) override;
-		void write(TWord _addr, TWord _val) override;
 
 		uint32_t exec();
 		void reset() override;
@@ -180,13 +231,20 @@ namespace dsp56k
 		Essi& getEssi0()				{ return m_essi0; }
 		Essi& getEssi1()				{ return m_essi1; }
 		HDI08& getHI08()				{ return m_hi08; }
+		Timers& getTimers()				{ return m_timers; }
 		const Timers& getTimers() const	{ return m_timers; }
 
 		void setSymbols(Disassembler& _disasm) const override;
 
 		void terminate() override;
 
+		void saveState(StateWriter& _w) const override;
+		bool loadState(StateReader& _r) override;
+
 	private:
+		void initRegisters();
+		static Essi& essi(IPeripherals& _periph, TWord _addr);
+
 		Dma m_dma;
 		EssiClock m_essiClock;
 		Essi m_essi0;
@@ -209,10 +267,6 @@ namespace dsp56k
 		//
 	public:
 		Peripherals56362(Peripherals56367* _peripherals56367 = nullptr);
-		
-		TWord read(TWord _addr, Instruction _inst) override;
-		const TWord* readAsPtr(TWord _addr, Instruction _inst) override;
-		void write(TWord _addr, TWord _val) override;
 
 		uint32_t exec();
 		void reset() override;
@@ -222,20 +276,27 @@ namespace dsp56k
 		HDI08& getHDI08()				{ return m_hdi08; }
 		Dma& getDMA()					{ return m_dma; }
 		EsaiPortC& getPortC()			{ return m_portC; }
+		Timers& getTimers()				{ return m_timers; }
 		const Timers& getTimers() const	{ return m_timers; }
 
 		void setSymbols(Disassembler& _disasm) const override;
 
 		void terminate() override;
 
+		void saveState(StateWriter& _w) const override;
+		bool loadState(StateReader& _r) override;
+
 		void disableTimers(const bool _disable)
 		{
 			m_disableTimers = _disable;
+			m_scheduler.wake();
 		}
 
 		void setDSP(DSP* _dsp) override;
 
 	private:
+		void initRegisters();
+
 		Dma m_dma;
 		EsaiClock m_esaiClock;
 		Esai m_esai;
@@ -250,10 +311,6 @@ namespace dsp56k
 	public:
 		Peripherals56367();
 
-		TWord read(TWord _addr, Instruction _inst) override;
-		const TWord* readAsPtr(TWord _addr, Instruction _inst) override { return nullptr; }
-		void write(TWord _addr, TWord _val) override;
-
 		uint32_t exec() const { return MaxDelayCycles; }
 
 		void reset() override {}
@@ -264,6 +321,9 @@ namespace dsp56k
 
 		void terminate() override;
 
+		void saveState(StateWriter& _w) const override;
+		bool loadState(StateReader& _r) override;
+
 		void setDSP(DSP* _dsp) override
 		{
 			IPeripherals::setDSP(_dsp);
@@ -271,6 +331,8 @@ namespace dsp56k
 		}
 
 	private:
+		void initRegisters();
+
 		std::array<TWord, XIO_Reserved_High_Last - XIO_Reserved_High_First + 1> m_mem;
 		Esai m_esai;
 	};
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <limits>
+
+namespace dsp56k
+{
+	// Remembers the instruction counter at which each peripheral component needs to run next so that components that are
+	// not due are skipped instead of being polled on every peripheral update. The components report their next event
+	// time via the delay returned from their exec() functions.
+	// Any state change that might pull an event forward, i.e. a register write or data pushed by the host, is announced
+	// via IPeripherals::setDelayCycles() which calls wake(). All components run on the next update in that case
+	class PeripheralScheduler
+	{
+	public:
+		enum Slot
+		{
+			SlotAudio,		// ESAI / ESSI clock
+			SlotHost,		// HDI08 / HI08
+			SlotTimers,
+			SlotDma,
+
+			SlotCount
+		};
+
+		static constexpr uint64_t Never = std::numeric_limits<uint64_t>::max();
+
+		// called before the components are processed, _now is the current DSP instruction counter
+		void begin(const uint64_t _now)
+		{
+			m_now = _now;
+			m_all = m_wake.exchange(false, std::memory_order_acquire);
+		}
+
+		// executes the component if it is due, _exec returns the number of instructions until it needs to run again
+		template<typename TFunc> void run(const Slot _slot, TFunc&& _exec)
+		{
+			auto& due = m_due[_slot];
+
+			if(!m_all && due > m_now)
+				return;
+
+			due = m_now + _exec();
+		}
+
+		// removes a component from scheduling until the next wake
+		void disable(const Slot _slot)
+		{
+			m_due[_slot] = Never;
+		}
+
+		// number of instructions until the next component is due
+		uint32_t end(const uint32_t _maxDelay) const
+		{
+			const auto next = *std::min_element(m_due.begin(), m_due.end());
+
+			if(next <= m_now)
+				return 0;
+
+			return static_cast<uint32_t>(std::min(next - m_now, static_cast<uint64_t>(_maxDelay)));
+		}
+
+		// may be called from a different thread, i.e. when the host writes data
+		void wake()
+		{
+			m_wake.store(true, std::memory_order_release);
+		}
+
+	private:
+		std::array<uint64_t, SlotCount> m_due{};
+		std::atomic<bool> m_wake{true};
+		uint64_t m_now = 0;
+		bool m_all = true;
+	};
+}
@@ -97,6 +97,69 @@ namespace dsp56k
 			return res;
 		}
 
+		// Writes _count entries with one synchronization per chunk of up to C entries. _fillEntry(T&, size_t _index) is called for each entry
+		template<typename TFunc>
+		void emplace_back_n(size_t _count, const TFunc& _fillEntry)
+		{
+			size_t index = 0;
+
+			while(_count)
+			{
+				const auto count = std::min(_count, C);
+
+				m_writeSem.wait(static_cast<uint32_t>(count));
+
+				for(size_t i=0; i<count; ++i)
+					_fillEntry(m_data[wrapCounter(m_writeCount + i)], index++);
+
+				// usage need to be incremented AFTER data has been written, otherwise, reader thread would read incomplete data
+				m_writeCount += count;
+
+				m_readSem.notify(static_cast<uint32_t>(count));
+
+				_count -= count;
+			}
+		}
+
+		void push_back_n(const T* _values, const size_t _count)
+		{
+			emplace_back_n(_count, [&](T& _dst, const size_t _i)
+			{
+				_dst = _values[_i];
+			});
+		}
+
+		// Reads _count entries with one synchronization per chunk of up to C entries. _readCallback(T&, size_t _index) is called for each entry
+		template<typename TFunc>
+		void pop_front_n(size_t _count, const TFunc& _readCallback)
+		{
+			size_t index = 0;
+
+			while(_count)
+			{
+				const auto count = std::min(_count, C);
+
+				m_readSem.wait(static_cast<uint32_t>(count));
+
+				for(size_t i=0; i<count; ++i)
+					_readCallback(m_data[wrapCounter(m_readCount + i)], index++);
+
+				m_readCount += count;
+
+				m_writeSem.notify(static_cast<uint32_t>(count));
+
+				_count -= count;
+			}
+		}
+
+		void pop_front_n(T* _dst, const size_t _count)
+		{
+			pop_front_n(_count, [&](T& _src, const size_t _i)
+			{
+				_dst[_i] = std::move(_src);
+			});
+		}
+
 		T& operator[](const size_t _i)
 		{
 			return get(_i);
@@ -226,6 +289,21 @@ namespace dsp56k
 
 			assert( rb.front() == 77 );
 			assert( rb[0] == 77 );
+
+			rb.pop_front();
+
+			const int values[] = {1,2,3,4,5,6,7,8,9,10};
+			rb.push_back_n(values, 10);
+
+			assert( rb.full() );
+			assert( rb[9] == 10 );
+
+			int popped[10] = {};
+			rb.pop_front_n(popped, 6);
+
+			assert( rb.size() == 4 );
+			assert( popped[5] == 6 );
+			assert( rb.front() == 7 );
 		}
 	};
 }
@@ -0,0 +1,97 @@
+#include "savestate.h"
+
+#include <algorithm>
+
+namespace dsp56k
+{
+	namespace
+	{
+		constexpr uint32_t g_runFlag = 0x80000000;
+		constexpr size_t g_minRunLength = 8;
+		constexpr size_t g_maxChunkLength = g_runFlag - 1;
+
+		size_t getRunLength(const TWord* _data, const size_t _count)
+		{
+			size_t len = 1;
+			while(len < _count && len < g_maxChunkLength && _data[len] == _data[0])
+				++len;
+			return len;
+		}
+	}
+
+	void StateWriter::write(const void* _data, const size_t _size)
+	{
+		const auto* src = static_cast<const uint8_t*>(_data);
+		m_data.insert(m_data.end(), src, src + _size);
+	}
+
+	void StateWriter::writeWords(const TWord* _data, const size_t _count)
+	{
+		// chunks are either a run of one repeated word or a sequence of literal words
+		size_t i = 0;
+
+		while(i < _count)
+		{
+			const auto run = getRunLength(_data + i, _count - i);
+
+			if(run >= g_minRunLength)
+			{
+				write(static_cast<uint32_t>(run | g_runFlag));
+				write(_data[i]);
+				i += run;
+				continue;
+			}
+
+			auto end = i + run;
+
+			while(end < _count && end - i < g_maxChunkLength && getRunLength(_data + end, std::min(_count - end, g_minRunLength)) < g_minRunLength)
+				++end;
+
+			write(static_cast<uint32_t>(end - i));
+			write(_data + i, (end - i) * sizeof(TWord));
+			i = end;
+		}
+	}
+
+	bool StateReader::read(void* _data, const size_t _size)
+	{
+		if(m_failed || _size > m_size - m_pos)
+			return fail();
+
+		memcpy(_data, m_data + m_pos, _size);
+		m_pos += _size;
+		return true;
+	}
+
+	bool StateReader::readWords(TWord* _data, const size_t _count)
+	{
+		size_t i = 0;
+
+		while(i < _count)
+		{
+			uint32_t header;
+			if(!read(header))
+				return false;
+
+			const size_t len = header & ~g_runFlag;
+
+			if(!len || len > _count - i)
+				return fail();
+
+			if(header & g_runFlag)
+			{
+				TWord value;
+				if(!read(value))
+					return false;
+				std::fill_n(_data + i, len, value);
+			}
+			else if(!read(_data + i, len * sizeof(TWord)))
+			{
+				return false;
+			}
+
+			i += len;
+		}
+		return true;
+	}
+}
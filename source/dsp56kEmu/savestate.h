@@ -0,0 +1,94 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+#include "ringbuffer.h"
+#include "types.h"
+
+namespace dsp56k
+{
+	// Binary snapshot of the emulation state. The data is stored in host byte order and is meant to be restored by the same
+	// build, i.e. to clone an instance that has already been booted. DSP::saveState/loadState add a versioned header
+
+	class StateWriter
+	{
+	public:
+		template<typename T> void write(const T& _value)
+		{
+			static_assert(std::is_standard_layout_v<T> && std::is_trivially_destructible_v<T> && !std::is_pointer_v<T>, "type cannot be stored as raw data");
+			write(&_value, sizeof(_value));
+		}
+
+		void write(const void* _data, size_t _size);
+
+		template<typename T, size_t C, bool Lock, bool StackAlloc> void write(const RingBuffer<T, C, Lock, StackAlloc>& _buffer)
+		{
+			const auto size = static_cast<uint32_t>(_buffer.size());
+			write(size);
+			for(uint32_t i=0; i<size; ++i)
+				write(_buffer[i]);
+		}
+
+		// memory areas are mostly filled with an init pattern or zeroes, runs of identical words are compressed
+		void writeWords(const TWord* _data, size_t _count);
+
+		const std::vector<uint8_t>& getData() const { return m_data; }
+		std::vector<uint8_t>& getData() { return m_data; }
+
+	private:
+		std::vector<uint8_t> m_data;
+	};
+
+	class StateReader
+	{
+	public:
+		StateReader(const uint8_t* _data, const size_t _size) : m_data(_data), m_size(_size) {}
+		explicit StateReader(const std::vector<uint8_t>& _data) : StateReader(_data.data(), _data.size()) {}
+
+		template<typename T> bool read(T& _value)
+		{
+			static_assert(std::is_standard_layout_v<T> && std::is_trivially_destructible_v<T> && !std::is_pointer_v<T>, "type cannot be restored from raw data");
+			return read(&_value, sizeof(_value));
+		}
+
+		bool read(void* _data, size_t _size);
+
+		template<typename T, size_t C, bool Lock, bool StackAlloc> bool read(RingBuffer<T, C, Lock, StackAlloc>& _buffer)
+		{
+			uint32_t size;
+			if(!read(size) || size > C)
+				return fail();
+
+			_buffer.clear();
+
+			for(uint32_t i=0; i<size; ++i)
+			{
+				T v;
+				if(!read(v))
+					return false;
+				_buffer.push_back(v);
+			}
+			return true;
+		}
+
+		bool readWords(TWord* _data, size_t _count);
+
+		bool failed() const { return m_failed; }
+		bool atEnd() const { return m_pos == m_size; }
+
+	private:
+		bool fail()
+		{
+			m_failed = true;
+			return false;
+		}
+
+		const uint8_t* m_data;
+		size_t m_size;
+		size_t m_pos = 0;
+		bool m_failed = false;
+	};
+}
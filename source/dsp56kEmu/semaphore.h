@@ -52,17 +52,21 @@ namespace dsp56k
 		{
 		}
 
-		void notify()
+		void notify(const uint32_t _count = 1)
 		{
-			const int prev = m_count.fetch_add(1, std::memory_order_release);
-	        if (prev < 0)
+			const int count = static_cast<int>(_count);
+			const int prev = m_count.fetch_add(count, std::memory_order_release);
+
+			// there is only one consumer. Wake it once the amount it is waiting for is available
+	        if (prev < 0 && prev + count >= 0)
 	            m_sem.notify();
 		}
 
-		void wait()
+		void wait(const uint32_t _count = 1)
 		{
-			const auto count = m_count.fetch_sub(1, std::memory_order_acquire);
-			if (count < 1)
+			const int count = static_cast<int>(_count);
+			const auto prev = m_count.fetch_sub(count, std::memory_order_acquire);
+			if (prev < count)
 				m_sem.wait();
 		}
 	private:
@@ -1,6 +1,7 @@
 #include "interrupts.h"
 #include "peripherals.h"
 #include "dsp.h"
+#include "savestate.h"
 
 #include "timers.h"
 
@@ -186,4 +187,32 @@ namespace dsp56k
 		const auto offset = Vba_TIMER0_Compare - m_vbaBase;
 		m_peripherals.getDSP().injectInterrupt(offset + _vba + (_index << 2));
 	}
+
+	void Timers::saveState(StateWriter& _w) const
+	{
+		_w.write(m_tplr);
+		_w.write(m_tpcr);
+		_w.write(m_lastClock);
+
+		for (const auto& t : m_timers)
+		{
+			_w.write(t.m_tlr);
+			_w.write(t.m_tcpr);
+			_w.write(t.m_tcr);
+			_w.write(t.m_tcsr);
+		}
+	}
+
+	bool Timers::loadState(StateReader& _r)
+	{
+		if(!_r.read(m_tplr) || !_r.read(m_tpcr) || !_r.read(m_lastClock))
+			return false;
+
+		for (auto& t : m_timers)
+		{
+			if(!_r.read(t.m_tlr) || !_r.read(t.m_tcpr) || !_r.read(t.m_tcr) || !_r.read(t.m_tcsr))
+				return false;
+		}
+		return true;
+	}
 }
@@ -8,6 +8,8 @@ namespace dsp56k
 {
 	class Timers;
 	class IPeripherals;
+	class StateReader;
+	class StateWriter;
 
 	class Timer
 	{
@@ -133,6 +135,9 @@ namespace dsp56k
 
 		void setSymbols(Disassembler& _disasm) const;
 
+		void saveState(StateWriter& _w) const;
+		bool loadState(StateReader& _r);
+
 	private:
 		template<Timer::TcsrBits B> static void timerFlagReset(const Bitfield<unsigned, Timer::TcsrBits, 22>& _tcsr, TWord& _val)
 		{
@@ -1,9 +1,43 @@
 #include "unittests.h"
 
+#include <array>
+#include <chrono>
+#include <limits>
+#include <map>
+#include <thread>
+#include <vector>
+
+#include "audio.h"
+#include "audioconvert.h"
+#include "dsplockstep.h"
+#include "dspscheduler.h"
+#include "savestate.h"
+
 namespace dsp56k
 {
 	static DefaultMemoryValidator g_defaultMemoryValidator;
 
+	namespace
+	{
+		// an additional DSP that increments A in an endless loop, used by the tests that run several DSPs
+		struct LoopDsp
+		{
+			explicit LoopDsp(const Memory& _ref)
+				: memory(g_defaultMemoryValidator, _ref.sizeP(), _ref.sizeXY(), _ref.getBridgedMemoryAddress())
+				, dsp(memory, &perifX, &perifY)
+			{
+				memory.set(MemArea_P, 0x100, 0x000008);	// inc a
+				memory.set(MemArea_P, 0x101, 0x0c0100);	// jmp $100
+				dsp.setPC(0x100);
+			}
+
+			Peripherals56362 perifX;
+			Peripherals56367 perifY;
+			Memory memory;
+			DSP dsp;
+		};
+	}
+
 	UnitTests::UnitTests()
 		: mem(g_defaultMemoryValidator, 0x080000, 0x800000, 0x200000)
 		, dsp(mem, &peripheralsX, &peripheralsY)
@@ -86,6 +120,18 @@ namespace dsp56k
 		move();
 		movel();
 		parallel();
+
+		saveLoadState();
+
+		audioConvert();
+
+		peripheralRegisters();
+
+		memoryImage();
+
+		scheduler();
+
+		lockstep();
 	}
 
 	void UnitTests::conditionCodes()
@@ -3285,4 +3331,692 @@ namespace dsp56k
 			verify(dsp.regs().b.var == 0x88999999aaaaaa);
 		});
 	}
+
+	void UnitTests::saveLoadState()
+	{
+		runTest([&]()
+		{
+			dsp.regs().a.var = 0x00123456789abc;
+			dsp.regs().r[2].var = 0x000010;
+			dsp.memory().set(MemArea_X, 0x10, 0x654321);
+
+			emit(0x200003);	// tst a
+		}, [&]()
+		{
+			StateWriter w;
+			dsp.saveState(w);
+
+			const auto sr = dsp.regs().sr.var;
+			const auto instructions = dsp.getInstructionCounter();
+
+			dsp.regs().a.var = 0;
+			dsp.regs().r[2].var = 0;
+			dsp.regs().sr.var ^= 0xf;
+			dsp.memory().set(MemArea_X, 0x10, 0);
+
+			StateReader r(w.getData());
+			verify(dsp.loadState(r));
+
+			verify(dsp.regs().a.var == 0x00123456789abc);
+			verify(dsp.regs().r[2].var == 0x000010);
+			verify(dsp.regs().sr.var == sr);
+			verify(dsp.getInstructionCounter() == instructions);
+			verify(dsp.memory().get(MemArea_X, 0x10) == 0x654321);
+
+			// a truncated state fails after the registers have been read, the DSP needs to keep its current state
+			dsp.regs().a.var = 0x00111111222222;
+			dsp.memory().set(MemArea_X, 0x10, 0x123123);
+
+			const auto& data = w.getData();
+			StateReader truncated(data.data(), data.size() - 1);
+			verify(!dsp.loadState(truncated));
+
+			verify(dsp.regs().a.var == 0x00111111222222);
+			verify(dsp.memory().get(MemArea_X, 0x10) == 0x123123);
+		});
+	}
+
+	void UnitTests::audioConvert()
+	{
+		// the vector kernels leave the rest that does not fill a whole vector to the scalar code, all lengths up to this one are tested
+		constexpr size_t count = 37;
+		constexpr float nan = std::numeric_limits<float>::quiet_NaN();
+		constexpr float inf = std::numeric_limits<float>::infinity();
+
+		std::vector<float> floats = {0.0f, 1.0f, -1.0f, 0.5f, -0.5f, 1.5f, -1.5f, 100.0f, -100.0f, nan, -nan, inf, -inf,
+			8388607.0f / 8388608.0f, 1.0f / 8388608.0f, -1.0f / 8388608.0f, 0.25f / 8388608.0f, -0.25f / 8388608.0f};
+
+		std::vector<TWord> words = {0x000000, 0x7fffff, 0x800000, 0x800001, 0xffffff, 0x000001, 0x400000, 0xc00000, 0x0000ff, 0xffff00};
+
+		for(size_t i=floats.size(); i<count; ++i)
+			floats.push_back(static_cast<float>(i) * 0.0625f - 1.125f);
+
+		for(size_t i=words.size(); i<count; ++i)
+			words.push_back(static_cast<TWord>(i * 0x3a5b17) & 0xffffff);
+
+		// reference values for the int24 limits
+		verify(sample2dsp<float>(1.0f) == 0x7fffff);
+		verify(sample2dsp<float>(-1.0f) == 0x800000);
+		verify(dsp2sample<float>(0x7fffff) == 8388607.0f / 8388608.0f);
+		verify(dsp2sample<float>(0x800000) == -1.0f);
+
+		// host samples for the integer formats, raw bytes are fine as the scalar kernels are the reference
+		std::vector<uint8_t> bytes(count * 4);
+		for(size_t i=0; i<bytes.size(); ++i)
+			bytes[i] = static_cast<uint8_t>(i * 0x9d + 0x80);
+
+		const auto& scalar = AudioConvert::getScalarKernels();
+
+		constexpr TWord sentinelWord = 0xdeadbe;
+		constexpr uint8_t sentinelByte = 0xa5;
+
+		for (const auto* k : AudioConvert::getSupportedKernels())
+		{
+			for(size_t len=0; len<=count; ++len)
+			{
+				// one additional element to detect writes past the end
+				std::vector<TWord> dspWords(len + 1, sentinelWord);
+				std::vector<float> hostFloats(len + 1, 42.0f);
+
+				k->toDsp[static_cast<size_t>(SampleFormat::Float32)](dspWords.data(), floats.data(), len);
+				k->fromDsp[static_cast<size_t>(SampleFormat::Float32)](hostFloats.data(), words.data(), len);
+
+				for(size_t i=0; i<len; ++i)
+				{
+					verify(dspWords[i] == sample2dsp<float>(floats[i]));
+					verify(hostFloats[i] == dsp2sample<float>(words[i]));
+				}
+
+				verify(dspWords[len] == sentinelWord);
+				verify(hostFloats[len] == 42.0f);
+
+				for(size_t f=static_cast<size_t>(SampleFormat::Int16); f<static_cast<size_t>(SampleFormat::Count); ++f)
+				{
+					const auto size = getSampleSize(static_cast<SampleFormat>(f));
+
+					std::vector<TWord> resWords(len + 1, sentinelWord);
+					std::vector<TWord> refWords(len + 1, sentinelWord);
+
+					k->toDsp[f](resWords.data(), bytes.data(), len);
+					scalar.toDsp[f](refWords.data(), bytes.data(), len);
+
+					verify(resWords == refWords);
+
+					std::vector<uint8_t> resBytes((len + 1) * size, sentinelByte);
+					std::vector<uint8_t> refBytes((len + 1) * size, sentinelByte);
+
+					k->fromDsp[f](resBytes.data(), words.data(), len);
+					scalar.fromDsp[f](refBytes.data(), words.data(), len);
+
+					verify(resBytes == refBytes);
+				}
+			}
+		}
+
+		// the block functions of Audio, an odd frame count to cover the remainder of each channel as well
+		constexpr uint32_t frames = count;
+
+		Audio audio;
+
+		std::vector<std::vector<float>> ins(8);
+		std::vector<const float*> inPtrs;
+
+		for(size_t c=0; c<ins.size(); ++c)
+		{
+			for(size_t i=0; i<frames; ++i)
+				ins[c].push_back(floats[(i + c * 5) % floats.size()]);
+			inPtrs.push_back(ins[c].data());
+		}
+
+		audio.processAudioInputInterleaved(inPtrs.data(), frames);
+
+		auto& rx = audio.getAudioInputs();
+		verify(rx.size() == frames);
+
+		for(size_t i=0; i<frames; ++i)
+		{
+			const auto frame = rx.pop_front();
+			verify(frame.size() == 2);
+
+			for(size_t c=0; c<ins.size(); ++c)
+				verify(frame[c & 1][c >> 1] == sample2dsp<float>(ins[c][i]));
+		}
+
+		for(size_t i=0; i<frames; ++i)
+		{
+			Audio::TxFrame frame;
+			frame.resize(2);
+
+			for(size_t c=0; c<12; ++c)
+				frame[c & 1][c >> 1] = words[(i + c * 3) % words.size()];
+
+			audio.getAudioOutputs().push_back(frame);
+		}
+
+		std::vector<std::vector<float>> outs(12, std::vector<float>(frames, 0.0f));
+		std::vector<float*> outPtrs;
+
+		for (auto& out : outs)
+			outPtrs.push_back(out.data());
+
+		audio.processAudioOutputInterleaved(outPtrs.data(), frames);
+
+		for(size_t c=0; c<outs.size(); ++c)
+		{
+			for(size_t i=0; i<frames; ++i)
+				verify(outs[c][i] == dsp2sample<float>(words[(i + c * 3) % words.size()]));
+		}
+	}
+
+	void UnitTests::peripheralRegisters()
+	{
+		// a register that is not plain peripheral memory
+		struct Register
+		{
+			TWord value;					// value written by the test
+			std::function<TWord()> state;	// component state that receives the write, empty if it cannot be observed
+			std::function<TWord()> read;	// expected result of a read
+		};
+
+		using Registers = std::map<TWord, Register>;
+
+		const std::function<TWord()> zero = [] { return 0; };
+
+		auto pattern = [](const TWord _addr) { return 0x5a0000 | (_addr & 0xffff); };
+
+		// control registers get values that do not enable anything, the peripherals are never executed here
+		auto rw = [&](Registers& _regs, const TWord _addr, const std::function<TWord()>& _state, const TWord _value)
+		{
+			_regs[_addr] = {_value, _state, _state};
+		};
+
+		auto addHdi08 = [&](Registers& _regs, HDI08& _h)
+		{
+			rw(_regs, HDI08::HCR, [&] { return _h.readControlRegister(); }, 0x000018);
+			rw(_regs, HDI08::HSR, [&] { return _h.readStatusRegister(); }, 0x000018);
+			rw(_regs, HDI08::HPCR, [&] { return _h.readPortControlRegister(); }, 0x000002);
+			rw(_regs, HDI08::HDR, [&] { return _h.readHDR(); }, pattern(HDI08::HDR));
+			rw(_regs, HDI08::HDDR, [&] { return _h.readHDDR(); }, pattern(HDI08::HDDR));
+
+			// nothing received, HOTX reads the unused peripheral memory
+			_regs[HDI08::HORX] = {pattern(HDI08::HORX), {}, zero};
+			_regs[HDI08::HOTX] = {pattern(HDI08::HOTX), [&] { return _h.hasTX() ? _h.txData().front() : 0; }, zero};
+		};
+
+		auto addTimers = [&](Registers& _regs, Timers& _t)
+		{
+			for(int i=0; i<3; ++i)
+			{
+				const auto o = static_cast<TWord>(i) << 2;
+				rw(_regs, Timers::M_TCSR0 - o, [&_t, i] { return _t.readTCSR(i); }, 0x000010);
+				rw(_regs, Timers::M_TLR0 - o, [&_t, i] { return _t.readTLR(i); }, pattern(Timers::M_TLR0 - o));
+				rw(_regs, Timers::M_TCPR0 - o, [&_t, i] { return _t.readTCPR(i); }, pattern(Timers::M_TCPR0 - o));
+				rw(_regs, Timers::M_TCR0 - o, [&_t, i] { return _t.readTCR(i); }, pattern(Timers::M_TCR0 - o));
+			}
+			rw(_regs, Timers::M_TPLR, [&] { return _t.readTPLR(); }, pattern(Timers::M_TPLR));
+			rw(_regs, Timers::M_TPCR, [&] { return _t.readTPCR(); }, pattern(Timers::M_TPCR));
+		};
+
+		auto addDma = [&](Registers& _regs, Dma& _d)
+		{
+			for(TWord c=0; c<6; ++c)
+			{
+				const auto o = c << 2;
+				rw(_regs, XIO_DCR0 - o, [&_d, c] { return _d.getDCR(c); }, 0x000100);
+				rw(_regs, XIO_DCO0 - o, [&_d, c] { return _d.getDCO(c); }, pattern(XIO_DCO0 - o));
+				rw(_regs, XIO_DDR0 - o, [&_d, c] { return _d.getDDR(c); }, pattern(XIO_DDR0 - o));
+				rw(_regs, XIO_DSR0 - o, [&_d, c] { return _d.getDSR(c); }, pattern(XIO_DSR0 - o));
+			}
+			for(TWord i=0; i<4; ++i)
+				rw(_regs, XIO_DOR0 - i, [&_d, i] { return _d.getDOR(i); }, pattern(XIO_DOR0 - i));
+
+			// read only
+			_regs[XIO_DSTR] = {pattern(XIO_DSTR), {}, [&] { return _d.getDSTR(); }};
+		};
+
+		// _offset is zero for the ESAI of the 56362 and the distance to the ESAI_1 addresses for the 56367
+		auto addEsai = [&](Registers& _regs, Esai& _e, const TWord _offset)
+		{
+			rw(_regs, Esai::M_SAISR - _offset, [&] { return _e.readStatusRegister(); }, 0x000003);
+			rw(_regs, Esai::M_RCR - _offset, [&] { return _e.readReceiveControlRegister(); }, 0x000100);
+			rw(_regs, Esai::M_RCCR - _offset, [&] { return _e.readReceiveClockControlRegister(); }, pattern(Esai::M_RCCR));
+			rw(_regs, Esai::M_TCR - _offset, [&] { return _e.readTransmitControlRegister(); }, 0x000100);
+			rw(_regs, Esai::M_TCCR - _offset, [&] { return _e.readTransmitClockControlRegister(); }, pattern(Esai::M_TCCR));
+			rw(_regs, Esai::M_TSMA - _offset, [&] { return _e.readTSMA(); }, pattern(Esai::M_TSMA));
+			rw(_regs, Esai::M_TSMB - _offset, [&] { return _e.readTSMB(); }, pattern(Esai::M_TSMB));
+
+			// write only, reads return the unused peripheral memory
+			_regs[Esai::M_SAICR - _offset] = {pattern(Esai::M_SAICR), {}, zero};
+			for(TWord i=0; i<6; ++i)
+				_regs[Esai::M_TX0 - _offset + i] = {pattern(Esai::M_TX0 + i), [&_e, i] { return *_e.getTxRegister(i).data; }, zero};
+
+			// receivers are disabled
+			for(TWord i=0; i<4; ++i)
+				_regs[Esai::M_RX0 - _offset + i] = {pattern(Esai::M_RX0 + i), {}, zero};
+		};
+
+		auto addEssi = [&](Registers& _regs, Essi& _e, const TWord _offset)
+		{
+			for(TWord i=0; i<3; ++i)
+				rw(_regs, Essi::ESSI0_TX0 - _offset - i, [&_e, i] { return _e.readTX(i); }, pattern(Essi::ESSI0_TX0 - _offset - i));
+			rw(_regs, Essi::ESSI0_TSR - _offset, [&] { return _e.readTSR(); }, pattern(Essi::ESSI0_TSR - _offset));
+			rw(_regs, Essi::ESSI0_SSISR - _offset, [&] { return _e.readSR(); }, 0x000003);
+			rw(_regs, Essi::ESSI0_CRA - _offset, [&] { return _e.readCRA(); }, pattern(Essi::ESSI0_CRA - _offset));
+			rw(_regs, Essi::ESSI0_CRB - _offset, [&] { return _e.readCRB(); }, 0x000100);
+			rw(_regs, Essi::ESSI0_TSMA - _offset, [&] { return _e.readTSMA(); }, pattern(Essi::ESSI0_TSMA - _offset));
+			rw(_regs, Essi::ESSI0_TSMB - _offset, [&] { return _e.readTSMB(); }, pattern(Essi::ESSI0_TSMB - _offset));
+			rw(_regs, Essi::ESSI0_RSMA - _offset, [&] { return _e.readRSMA(); }, pattern(Essi::ESSI0_RSMA - _offset));
+			rw(_regs, Essi::ESSI0_RSMB - _offset, [&] { return _e.readRSMB(); }, pattern(Essi::ESSI0_RSMB - _offset));
+
+			// the receiver is disabled
+			_regs[Essi::ESSI0_RX - _offset] = {pattern(Essi::ESSI0_RX - _offset), {}, zero};
+		};
+
+		// writes all registers in ascending order, registers that are not listed are plain peripheral memory and read back what has been written
+		auto walk = [&](IPeripherals& _p, const Registers& _regs)
+		{
+			auto check = [&](const TWord _addr)
+			{
+				const auto it = _regs.find(_addr);
+				const auto* ptr = _p.readAsPtr(_addr, Move_ea);
+
+				if(it == _regs.end())
+				{
+					verify(_p.read(_addr, Move_ea) == pattern(_addr));
+					verify(ptr && *ptr == pattern(_addr));
+					return;
+				}
+
+				const auto& r = it->second;
+
+				if(r.state)
+					verify(r.state() == r.value);
+				verify(_p.read(_addr, Move_ea) == r.read());
+				verify(!ptr || *ptr == r.read());
+			};
+
+			for(TWord a = XIO_Reserved_High_First; a <= XIO_Reserved_High_Last; ++a)
+			{
+				const auto it = _regs.find(a);
+				_p.write(a, it == _regs.end() ? pattern(a) : it->second.value);
+				check(a);
+			}
+
+			// a write must not have modified any other register
+			for(TWord a = XIO_Reserved_High_First; a <= XIO_Reserved_High_Last; ++a)
+				check(a);
+		};
+
+		DefaultMemoryValidator validator;
+
+		{
+			Peripherals56367 perifY;
+			Peripherals56362 perifX(&perifY);
+			Memory m(validator, mem.sizeP(), mem.sizeXY(), mem.getBridgedMemoryAddress());
+			DSP d(m, &perifX, &perifY);
+
+			Registers regsX;
+			addHdi08(regsX, perifX.getHDI08());
+			addTimers(regsX, perifX.getTimers());
+			addDma(regsX, perifX.getDMA());
+			addEsai(regsX, perifX.getEsai(), 0);
+
+			auto& portC = perifX.getPortC();
+			rw(regsX, Esai::M_PCRC, [&] { return portC.getControl(); }, pattern(Esai::M_PCRC));
+			rw(regsX, Esai::M_PRRC, [&] { return portC.getDirection(); }, pattern(Esai::M_PRRC));
+			regsX[Esai::M_PDRC] = {pattern(Esai::M_PDRC), {}, [&] { return portC.dspRead(); }};
+
+			auto& clock = perifX.getEsaiClock();
+			rw(regsX, XIO_PCTL, [&] { return clock.getPCTL(); }, pattern(XIO_PCTL));
+
+			// SHI and DAX, there is nothing connected
+			regsX[0xFFFF91] = {pattern(0xFFFF91), {}, zero};
+			regsX[0xFFFF93] = {pattern(0xFFFF93), {}, zero};
+			regsX[0xFFFF94] = {pattern(0xFFFF94), {}, zero};
+			regsX[0xffffd2] = {pattern(0xffffd2), {}, zero};
+
+			regsX[XIO_IDR] = {pattern(XIO_IDR), {}, [] { return 0x362; }};
+
+			// AAR0-3 are plain peripheral memory
+			walk(perifX, regsX);
+
+			Registers regsY;
+			addEsai(regsY, perifY.getEsai(), Esai::M_TX0 - Esai::M_TX0_1);
+			walk(perifY, regsY);
+		}
+
+		{
+			PeripheralsNop perifY;
+			Peripherals56303 perifX;
+			Memory m(validator, mem.sizeP(), mem.sizeXY(), mem.getBridgedMemoryAddress());
+			DSP d(m, &perifX, &perifY);
+
+			// the ID register is plain peripheral memory with a predefined value
+			verify(perifX.read(XIO_IDR, Move_ea) == 0x0005303);
+
+			Registers regs;
+			addHdi08(regs, perifX.getHI08());
+			addTimers(regs, perifX.getTimers());
+			addDma(regs, perifX.getDMA());
+			addEssi(regs, perifX.getEssi0(), 0);
+			addEssi(regs, perifX.getEssi1(), Essi::EssiAddressOffset);
+
+			auto& clock = perifX.getEssiClock();
+			rw(regs, XIO_PCTL, [&] { return clock.getPCTL(); }, pattern(XIO_PCTL));
+
+			walk(perifX, regs);
+		}
+	}
+
+	void UnitTests::memoryImage()
+	{
+		const auto sizeP = mem.sizeP();
+		const auto sizeXY = mem.sizeXY();
+		const auto ext = mem.getBridgedMemoryAddress();
+		const auto end = std::max(sizeP, sizeXY);
+
+		Memory source(g_defaultMemoryValidator, sizeP, sizeXY, ext);
+
+		// images can only be created if the host supports mapping memory
+		if(!source.hasMmuSupport())
+			return;
+
+		// a value unique per area and address, sampled at every page of internal and external memory
+		auto value = [](const EMemArea _area, const TWord _addr)
+		{
+			return (static_cast<TWord>(_area + 1) * 0x345678 + _addr * 0x10001) & 0xffffff;
+		};
+
+		std::vector<std::pair<EMemArea, TWord>> addrs;
+
+		for(auto area : {MemArea_X, MemArea_Y, MemArea_P})
+		{
+			for(TWord a=0; a<ext; a += 0x1000)
+				addrs.emplace_back(area, a);
+			addrs.emplace_back(area, ext - 1);
+		}
+
+		for(TWord a=ext; a<end; a += 0x1000)
+			addrs.emplace_back(MemArea_P, a);
+		addrs.emplace_back(MemArea_P, end - 1);
+
+		for (const auto& [area, a] : addrs)
+			source.getMemAreaPtr(area)[a] = value(area, a);
+
+		const auto image = source.createImage();
+		verify(image);
+
+		auto readImage = [&](const EMemArea _area, const TWord _addr)
+		{
+			if(_addr >= ext)
+				return image->ptrExternal()[_addr - ext];
+
+			switch (_area)
+			{
+			case MemArea_X:	return image->ptrX()[_addr];
+			case MemArea_Y:	return image->ptrY()[_addr];
+			default:		return image->ptrP()[_addr];
+			}
+		};
+
+		auto verifyContents = [&](Memory& _m)
+		{
+			for (const auto& [area, a] : addrs)
+				verify(_m.getMemAreaPtr(area)[a] == value(area, a));
+		};
+
+		for (const auto& [area, a] : addrs)
+			verify(readImage(area, a) == value(area, a));
+
+		Memory memA(g_defaultMemoryValidator, sizeP, sizeXY, ext, nullptr, image);
+		Memory memB(g_defaultMemoryValidator, sizeP, sizeXY, ext, nullptr, image);
+
+		verifyContents(memA);
+		verifyContents(memB);
+
+		// writes to one instance are private to it, neither the image, the source nor other instances see them
+		const std::pair<EMemArea, TWord> written[] = {{MemArea_X, 0x1000}, {MemArea_Y, 0x2000}, {MemArea_P, 0x3000}, {MemArea_P, ext + 0x4000}};
+
+		for (const auto& [area, a] : written)
+			memA.getMemAreaPtr(area)[a] = 0x5a5a5a;
+
+		Memory memC(g_defaultMemoryValidator, sizeP, sizeXY, ext, nullptr, image);
+
+		for (const auto& [area, a] : written)
+		{
+			verify(memA.getMemAreaPtr(area)[a] == 0x5a5a5a);
+			verify(memB.getMemAreaPtr(area)[a] == value(area, a));
+			verify(memC.getMemAreaPtr(area)[a] == value(area, a));
+			verify(source.getMemAreaPtr(area)[a] == value(area, a));
+			verify(readImage(area, a) == value(area, a));
+		}
+
+		for (const auto& [area, a] : written)
+			memA.getMemAreaPtr(area)[a] = value(area, a);
+
+		verifyContents(memA);
+		verifyContents(memB);
+		verifyContents(memC);
+
+		// external memory is still bridged into X, Y and P, internal memory is still separate
+		auto* x = memA.getMemAreaPtr(MemArea_X);
+		auto* y = memA.getMemAreaPtr(MemArea_Y);
+		auto* p = memA.getMemAreaPtr(MemArea_P);
+
+		x[ext + 0x10] = 0x111111;
+		verify(y[ext + 0x10] == 0x111111 && p[ext + 0x10] == 0x111111);
+
+		y[ext + 0x20] = 0x222222;
+		verify(x[ext + 0x20] == 0x222222 && p[ext + 0x20] == 0x222222);
+
+		p[ext + 0x30] = 0x333333;
+		verify(x[ext + 0x30] == 0x333333 && y[ext + 0x30] == 0x333333);
+
+		x[0x10] = 0x444444;
+		verify(y[0x10] != 0x444444 && p[0x10] != 0x444444);
+
+		verify(memB.getMemAreaPtr(MemArea_X)[ext + 0x10] != 0x111111);
+	}
+
+	void UnitTests::scheduler()
+	{
+		struct Instance : LoopDsp
+		{
+			using LoopDsp::LoopDsp;
+
+			std::atomic<size_t> budget{0};
+			std::atomic<uint32_t> chunks{0};
+		};
+
+		std::array<std::unique_ptr<Instance>, 3> instances;
+
+		for (auto& instance : instances)
+			instance.reset(new Instance(mem));
+
+		auto waitFor = [](const std::function<bool()>& _pred)
+		{
+			const auto timeout = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+
+			while(!_pred() && std::chrono::steady_clock::now() < timeout)
+				std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+			return _pred();
+		};
+
+		auto idle = []
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(20));
+		};
+
+		// slices of four chunks on two workers
+		DSPScheduler scheduler(2, ThreadPriority::Normal, 4);
+
+		std::array<DSPScheduler::Entry*, 3> entries{};
+
+		// every chunk consumes one frame of the budget. Without budget, the DSPs are parked right away
+		for(size_t i=0; i<2; ++i)
+		{
+			auto& instance = *instances[i];
+
+			entries[i] = scheduler.add(instance.dsp, nullptr, [&instance] { return instance.budget.load(); });
+			entries[i]->setCallback([&instance](uint32_t)
+			{
+				++instance.chunks;
+				--instance.budget;
+			});
+		}
+
+		idle();
+
+		verify(instances[0]->chunks == 0);
+		verify(instances[1]->chunks == 0);
+
+		// unpark, a DSP runs until one frame is left
+		instances[0]->budget = 10;
+		instances[1]->budget = 10;
+		scheduler.wakeUp();
+
+		verify(waitFor([&] { return instances[0]->chunks == 9 && instances[1]->chunks == 9; }));
+
+		idle();
+
+		for(size_t i=0; i<2; ++i)
+		{
+			verify(instances[i]->chunks == 9);
+			verify(instances[i]->budget == 1);
+
+			DSPScheduler::Guard g(entries[i]->mutex());
+			verify(instances[i]->dsp.regs().a.var != 0);
+		}
+
+		// unpark a single DSP again
+		instances[0]->budget += 5;
+		scheduler.wakeUp();
+
+		verify(waitFor([&] { return instances[0]->chunks == 14; }));
+		verify(instances[1]->chunks == 9);
+
+		// remove a parked DSP, it is not run anymore even if it has budget
+		scheduler.remove(entries[1]);
+
+		instances[1]->budget = 10;
+		scheduler.wakeUp();
+		idle();
+
+		verify(instances[1]->chunks == 9);
+
+		// remove a running DSP
+		auto& unbounded = *instances[2];
+
+		entries[2] = scheduler.add(unbounded.dsp, "unbounded");
+		entries[2]->setCallback([&unbounded](uint32_t)
+		{
+			++unbounded.chunks;
+		});
+
+		verify(waitFor([&] { return unbounded.chunks > 0; }));
+
+		scheduler.remove(entries[2]);
+
+		const uint32_t chunks = unbounded.chunks;
+		idle();
+		verify(unbounded.chunks == chunks);
+
+		// the remaining DSP is still scheduled
+		instances[0]->budget += 3;
+		scheduler.wakeUp();
+
+		verify(waitFor([&] { return instances[0]->chunks == 17; }));
+	}
+
+	void UnitTests::lockstep()
+	{
+		LoopDsp dspA(mem);
+		LoopDsp dspB(mem);
+
+		// stand-ins for the audio interfaces of both DSPs, the test transmits frames on A and receives them on B
+		Audio audioA;
+		Audio audioB;
+
+		constexpr uint64_t quantum = 1024;
+		constexpr size_t latency = 2;
+
+		DSPLockstep lockstep;
+		lockstep.add(dspA.dsp, quantum);
+		lockstep.add(dspB.dsp, quantum);
+		lockstep.link(dspA.dsp, audioA, dspB.dsp, audioB, latency);
+
+		auto counter = [](const DSP& _dsp)
+		{
+			return _dsp.useJIT() ? _dsp.getCycles() : _dsp.getInstructionCounter();
+		};
+
+		auto transmit = [&](const TWord _value)
+		{
+			audioA.getAudioOutputs().emplace_back([&](Audio::TxFrame& _frame)
+			{
+				_frame.resize(1);
+				_frame[0].fill(_value);
+			});
+		};
+
+		auto receive = [&]
+		{
+			return audioB.getAudioInputs().pop_front();
+		};
+
+		// the latency frames are received before anything has been transmitted
+		verify(audioB.getAudioInputs().size() == latency);
+
+		const auto startA = counter(dspA.dsp);
+		const auto startB = counter(dspB.dsp);
+
+		// a frame that is transmitted in step n is received in step n+1
+		transmit(0x123456);
+
+		lockstep.step();
+
+		verify(lockstep.getStepCount() == 1);
+		verify(audioA.getAudioOutputs().empty());
+		verify(audioB.getAudioInputs().size() == latency + 1);
+
+		for(size_t i=0; i<latency; ++i)
+			verify(receive().empty());
+
+		const auto rx = receive();
+		verify(rx.size() == 1);
+		for(uint32_t r=0; r<Audio::RxRegisterCount; ++r)
+			verify(rx[0][r] == 0x123456);
+
+		// B can run as long as the latency frames were available, both DSPs advanced by one quantum
+		verify(counter(dspA.dsp) - startA >= quantum && counter(dspA.dsp) - startA < quantum + 128);
+		verify(counter(dspB.dsp) - startB >= quantum && counter(dspB.dsp) - startB < quantum + 128);
+
+		// without input, B is blocked while A continues to run
+		const auto blockedB = counter(dspB.dsp);
+
+		for(size_t i=0; i<4; ++i)
+			lockstep.step();
+
+		verify(lockstep.getStepCount() == 5);
+		verify(counter(dspB.dsp) == blockedB);
+		verify(counter(dspA.dsp) - startA >= 5 * quantum && counter(dspA.dsp) - startA < 5 * quantum + 128);
+
+		// once B is unblocked, it advances by a single quantum and does not catch up on the steps it missed
+		transmit(1);
+		transmit(2);
+
+		lockstep.step();
+
+		verify(audioB.getAudioInputs().size() == 2);
+		verify(counter(dspB.dsp) == blockedB);
+
+		lockstep.step();
+
+		verify(counter(dspB.dsp) - blockedB >= quantum && counter(dspB.dsp) - blockedB < quantum + 128);
+		verify(counter(dspA.dsp) - startA >= 7 * quantum && counter(dspA.dsp) - startA < 7 * quantum + 128);
+
+		verify(receive()[0][0] == 1);
+		verify(receive()[0][0] == 2);
+	}
 }
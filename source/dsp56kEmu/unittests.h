@@ -102,6 +102,18 @@ namespace  dsp56k
 		void movel();
 		void parallel();
 
+		void saveLoadState();
+
+		void audioConvert();
+
+		void peripheralRegisters();
+
+		void memoryImage();
+
+		void scheduler();
+
+		void lockstep();
+
 		Peripherals56362 peripheralsX;
 		Peripherals56367 peripheralsY;
 		Memory mem;
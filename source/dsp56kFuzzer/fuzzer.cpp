@@ -0,0 +1,445 @@
+#include <algorithm>
+#include <cstddef>
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "generator.h"
+
+#include "dsp56kEmu/dsp.h"
+#include "dsp56kEmu/jit.h"
+#include "dsp56kEmu/memory.h"
+#include "dsp56kEmu/peripherals.h"
+
+using namespace dsp56k;
+
+namespace dsp56kFuzzer
+{
+	enum class Result
+	{
+		Match,
+		Diverged,
+		Invalid		// the case left the valid address range and cannot be compared
+	};
+
+	std::string hex(const uint64_t _value, const int _digits = 6)
+	{
+		char temp[32];
+		snprintf(temp, sizeof(temp), "$%0*llx", _digits, static_cast<unsigned long long>(_value));
+		return temp;
+	}
+
+	// one emulated DSP, either running the interpreter or the JIT
+	class Instance
+	{
+	public:
+		Instance(const bool _jit, const JitConfig& _config)
+			: m_mem(m_validator, 0x080000, 0x800000, 0x200000)
+			, m_dsp(m_mem, &m_periphX, &m_periphY)
+		{
+			m_dsp.setUseInterpreter(!_jit);
+			m_dsp.getJit().setConfig(_config);
+			m_dsp.resetHW();
+
+			m_resetSR = m_dsp.getSR().var;
+		}
+
+		DSP& dsp() { return m_dsp; }
+		Memory& memory() { return m_mem; }
+
+		void setup(const TestCase& _case)
+		{
+			const auto& s = _case.state;
+
+			m_mem.set(MemArea_X, 0, s.x.data(), MemWindowSize);
+			m_mem.set(MemArea_Y, 0, s.y.data(), MemWindowSize);
+
+			std::vector<TWord> code;
+			for (const auto& op : _case.ops)
+			{
+				code.push_back(op.word);
+				if(op.length > 1)
+					code.push_back(op.ext);
+			}
+			code.push_back(0x00000c);	// rts
+
+			// clear leftovers of a previous, longer case
+			code.resize(std::max<size_t>(code.size(), m_codeSize), 0);
+			m_codeSize = code.size();
+
+			m_mem.set(MemArea_P, CodeAddress, code.data(), static_cast<TWord>(code.size()));
+
+			auto& r = m_dsp.regs();
+
+			TReg56 a, b;
+			a.var = static_cast<int64_t>(s.a);
+			b.var = static_cast<int64_t>(s.b);
+			m_dsp.writeReg(Reg_A, a);
+			m_dsp.writeReg(Reg_B, b);
+
+			m_dsp.writeReg(Reg_X0, TReg24(s.x0));
+			m_dsp.writeReg(Reg_X1, TReg24(s.x1));
+			m_dsp.writeReg(Reg_Y0, TReg24(s.y0));
+			m_dsp.writeReg(Reg_Y1, TReg24(s.y1));
+
+			for(uint32_t i=0; i<8; ++i)
+			{
+				m_dsp.writeReg(static_cast<EReg>(Reg_R0 + i), TReg24(s.r[i]));
+				m_dsp.writeReg(static_cast<EReg>(Reg_N0 + i), TReg24(s.n[i]));
+				m_dsp.writeReg(static_cast<EReg>(Reg_M0 + i), TReg24(s.m[i]));
+			}
+
+			// reading the SR resolves pending CCR updates of the interpreter, the SR can be written directly afterwards
+			m_dsp.getSR();
+			r.sr.var = (m_resetSR & ~static_cast<TWord>(0xff | SR_S0 | SR_S1)) | s.ccr | s.scaling;
+
+			r.la.var = s.la;
+			r.lc.var = s.lc;
+			r.sp.var = 0;
+			r.sc.var = 0;
+
+			for(size_t i=0; i<r.ss.size(); ++i)
+				r.ss[i].var = 0;
+
+			m_dsp.setPC(StopAddress);
+			m_dsp.jsr(CodeAddress);
+		}
+
+		bool addressRegistersValid()
+		{
+			for (const auto& r : m_dsp.regs().r)
+			{
+				if(r.var >= RLimit)
+					return false;
+			}
+			return true;
+		}
+
+	private:
+		DefaultMemoryValidator m_validator;
+		PeripheralsNop m_periphX;
+		PeripheralsNop m_periphY;
+		Memory m_mem;
+		DSP m_dsp;
+		TWord m_resetSR = 0;
+		size_t m_codeSize = 0;
+	};
+
+	class Fuzzer
+	{
+	public:
+		explicit Fuzzer(const JitConfig& _config)
+			: m_interpreter(false, _config)
+			, m_jit(true, _config)
+			, m_generator(m_interpreter.dsp().opcodes())
+		{
+		}
+
+		Generator& generator() { return m_generator; }
+
+		// runs both DSPs block by block. After each JIT block, the interpreter executes the same number of instructions
+		Result run(const TestCase& _case, std::string* _report = nullptr)
+		{
+			m_interpreter.setup(_case);
+			m_jit.setup(_case);
+
+			auto& dspI = m_interpreter.dsp();
+			auto& dspJ = m_jit.dsp();
+
+			const auto maxBlocks = _case.ops.size() + 2;
+
+			for(size_t block=0; block<maxBlocks; ++block)
+			{
+				const auto pcBefore = dspJ.getPC().var;
+				const auto instructionsBefore = dspJ.getInstructionCounter();
+
+				dspJ.exec();
+
+				const auto count = dspJ.getInstructionCounter() - instructionsBefore;
+
+				for(uint64_t i=0; i<count; ++i)
+				{
+					if(!m_interpreter.addressRegistersValid())
+						return Result::Invalid;
+
+					const auto target = dspI.getInstructionCounter() + 1;
+
+					while(dspI.getInstructionCounter() < target)
+						dspI.exec();
+				}
+
+				std::stringstream ss;
+
+				if(!compare(ss))
+				{
+					if(_report)
+					{
+						std::stringstream r;
+						r << "Divergence after block " << block << " at P:" << hex(pcBefore, 4) << " (" << count << " instructions)" << std::endl << ss.str();
+						*_report = r.str();
+					}
+					return Result::Diverged;
+				}
+
+				if(dspJ.getPC().var == StopAddress)
+					return Result::Match;
+
+				if(!count)
+				{
+					if(_report)
+						*_report = "JIT did not make progress at P:" + hex(pcBefore, 4) + "\n";
+					return Result::Diverged;
+				}
+			}
+
+			if(_report)
+				*_report = "Code did not return to the stop address\n";
+
+			return Result::Diverged;
+		}
+
+		// removes instructions as long as the case keeps diverging
+		TestCase minimize(const TestCase& _case)
+		{
+			auto c = _case;
+
+			bool changed = true;
+
+			while(changed)
+			{
+				changed = false;
+
+				for(size_t i=0; i<c.ops.size() && c.ops.size() > 1;)
+				{
+					auto candidate = c;
+					candidate.ops.erase(candidate.ops.begin() + static_cast<ptrdiff_t>(i));
+
+					if(run(candidate) == Result::Diverged)
+					{
+						c = std::move(candidate);
+						changed = true;
+					}
+					else
+					{
+						++i;
+					}
+				}
+			}
+
+			return c;
+		}
+
+		std::string describe(const TestCase& _case)
+		{
+			std::stringstream ss;
+
+			const auto& s = _case.state;
+
+			ss << "Case " << _case.seed << std::endl;
+			ss << "a=" << hex(s.a, 14) << " b=" << hex(s.b, 14) << " x0=" << hex(s.x0) << " x1=" << hex(s.x1) << " y0=" << hex(s.y0) << " y1=" << hex(s.y1) << std::endl;
+			ss << "ccr=" << hex(s.ccr, 2) << " scaling=" << (s.scaling >> 10) << " la=" << hex(s.la) << " lc=" << hex(s.lc) << std::endl;
+
+			for(size_t i=0; i<8; ++i)
+				ss << "r" << i << "=" << hex(s.r[i]) << " n" << i << "=" << hex(s.n[i]) << " m" << i << "=" << hex(s.m[i]) << std::endl;
+
+			auto& disasm = m_interpreter.dsp().disassembler();
+
+			TWord pc = CodeAddress;
+
+			for (const auto& op : _case.ops)
+			{
+				std::string assembly;
+				disasm.disassemble(assembly, op.word, op.ext, 0, 0, pc);
+
+				ss << "P:" << hex(pc, 4) << "\t" << hex(op.word);
+				if(op.length > 1)
+					ss << " " << hex(op.ext);
+				else
+					ss << "        ";
+				ss << "\t" << assembly << std::endl;
+
+				pc += op.length;
+			}
+
+			return ss.str();
+		}
+
+	private:
+		template<typename T> static void compareReg(std::stringstream& _ss, bool& _equal, const char* _name, const T& _interpreter, const T& _jit, const int _digits = 6)
+		{
+			if(_interpreter.var == _jit.var)
+				return;
+
+			_ss << "\t" << _name << ": interpreter " << hex(static_cast<uint64_t>(_interpreter.var), _digits) << ", JIT " << hex(static_cast<uint64_t>(_jit.var), _digits) << std::endl;
+			_equal = false;
+		}
+
+		bool compare(std::stringstream& _ss)
+		{
+			auto& dspI = m_interpreter.dsp();
+			auto& dspJ = m_jit.dsp();
+
+			const auto& i = dspI.regs();
+			const auto& j = dspJ.regs();
+
+			bool equal = true;
+
+			compareReg(_ss, equal, "sr", dspI.getSR(), dspJ.getSR());
+			compareReg(_ss, equal, "a", i.a, j.a, 14);
+			compareReg(_ss, equal, "b", i.b, j.b, 14);
+			compareReg(_ss, equal, "x", i.x, j.x, 12);
+			compareReg(_ss, equal, "y", i.y, j.y, 12);
+
+			static const char* const names[][8] =
+			{
+				{"r0", "r1", "r2", "r3", "r4", "r5", "r6", "r7"},
+				{"n0", "n1", "n2", "n3", "n4", "n5", "n6", "n7"},
+				{"m0", "m1", "m2", "m3", "m4", "m5", "m6", "m7"}
+			};
+
+			for(size_t r=0; r<8; ++r)
+			{
+				compareReg(_ss, equal, names[0][r], i.r[r], j.r[r]);
+				compareReg(_ss, equal, names[1][r], i.n[r], j.n[r]);
+				compareReg(_ss, equal, names[2][r], i.m[r], j.m[r]);
+			}
+
+			compareReg(_ss, equal, "pc", i.pc, j.pc);
+			compareReg(_ss, equal, "omr", i.omr, j.omr);
+			compareReg(_ss, equal, "la", i.la, j.la);
+			compareReg(_ss, equal, "lc", i.lc, j.lc);
+			compareReg(_ss, equal, "sp", i.sp, j.sp);
+			compareReg(_ss, equal, "sc", i.sc, j.sc, 2);
+			compareReg(_ss, equal, "sz", i.sz, j.sz);
+			compareReg(_ss, equal, "vba", i.vba, j.vba);
+			compareReg(_ss, equal, "ep", i.ep, j.ep);
+
+			for(size_t s=0; s<i.ss.size(); ++s)
+			{
+				const auto name = "ss[" + std::to_string(s) + "]";
+				compareReg(_ss, equal, name.c_str(), i.ss[s], j.ss[s], 12);
+			}
+
+			uint32_t memDiffs = 0;
+
+			for(const auto area : {MemArea_X, MemArea_Y})
+			{
+				for(TWord a=0; a<MemWindowSize; ++a)
+				{
+					const auto vi = m_interpreter.memory().get(area, a);
+					const auto vj = m_jit.memory().get(area, a);
+
+					if(vi == vj)
+						continue;
+
+					if(++memDiffs <= 16)
+						_ss << "\t" << g_memAreaNames[area] << ":" << hex(a, 4) << ": interpreter " << hex(vi) << ", JIT " << hex(vj) << std::endl;
+
+					equal = false;
+				}
+			}
+
+			if(memDiffs > 16)
+				_ss << "\t" << (memDiffs - 16) << " more memory differences" << std::endl;
+
+			return equal;
+		}
+
+		Instance m_interpreter;
+		Instance m_jit;
+		Generator m_generator;
+	};
+}
+
+int main(int _argc, char* _argv[])
+{
+	using namespace dsp56kFuzzer;
+
+	uint32_t seed = 1;
+	uint64_t iterations = 100000;
+	uint32_t maxOps = 16;
+	bool singleCase = false;
+	bool keepGoing = false;
+
+	JitConfig config;
+
+	for(int i=1; i<_argc; ++i)
+	{
+		const std::string arg(_argv[i]);
+		const bool hasValue = i + 1 < _argc;
+
+		if(arg == "--seed" && hasValue)
+			seed = static_cast<uint32_t>(std::stoul(_argv[++i]));
+		else if(arg == "--case" && hasValue)
+		{
+			seed = static_cast<uint32_t>(std::stoul(_argv[++i]));
+			singleCase = true;
+		}
+		else if(arg == "--iterations" && hasValue)
+			iterations = std::stoull(_argv[++i]);
+		else if(arg == "--length" && hasValue)
+			maxOps = static_cast<uint32_t>(std::stoul(_argv[++i]));
+		else if(arg == "--no-link")
+			config.linkJitBlocks = false;
+		else if(arg == "--max-instructions-per-block" && hasValue)
+			config.maxInstructionsPerBlock = static_cast<uint32_t>(std::stoul(_argv[++i]));
+		else if(arg == "--dpa")
+			config.dynamicPeripheralAddressing = true;
+		else if(arg == "--optimize")
+			config.optimizeJitCode = true;
+		else if(arg == "--keep-going")
+			keepGoing = true;
+		else
+		{
+			std::cout << "Usage: dsp56kFuzzer [--seed value] [--iterations count] [--case seed] [--length maxInstructions] [--no-link] [--max-instructions-per-block count] [--dpa] [--optimize] [--keep-going]" << std::endl;
+			return -1;
+		}
+	}
+
+	if(!g_jitSupported)
+	{
+		std::cout << "JIT is not supported on this platform" << std::endl;
+		return -1;
+	}
+
+	Fuzzer fuzzer(config);
+
+	std::mt19937 rand(seed);
+
+	uint64_t matches = 0;
+	uint64_t invalid = 0;
+	uint64_t divergences = 0;
+
+	const auto count = singleCase ? 1 : iterations;
+
+	for(uint64_t i=0; i<count; ++i)
+	{
+		const auto caseSeed = singleCase ? seed : static_cast<uint32_t>(rand());
+
+		const auto c = fuzzer.generator().createCase(caseSeed, maxOps);
+
+		switch (fuzzer.run(c))
+		{
+		case Result::Match:		++matches;		continue;
+		case Result::Invalid:	++invalid;		continue;
+		case Result::Diverged:	++divergences;	break;
+		}
+
+		const auto minimized = fuzzer.minimize(c);
+
+		std::string report;
+		fuzzer.run(minimized, &report);
+
+		std::cout << fuzzer.describe(minimized) << report << "Reproduce with --case " << caseSeed << " --length " << maxOps << " (" << c.ops.size() << " instructions before minimizing)" << std::endl << std::endl;
+
+		if(!keepGoing)
+			break;
+	}
+
+	std::cout << matches << " cases matched, " << divergences << " diverged, " << invalid << " discarded" << std::endl;
+
+	return divergences ? 1 : 0;
+}
@@ -0,0 +1,190 @@
+#include "generator.h"
+
+#include <algorithm>
+
+#include "dsp56kEmu/opcodeanalysis.h"
+#include "dsp56kEmu/opcodeinfo.h"
+#include "dsp56kEmu/opcodes.h"
+#include "dsp56kEmu/peripherals.h"
+
+using namespace dsp56k;
+
+namespace dsp56kFuzzer
+{
+	namespace
+	{
+		// not implemented by either the interpreter or the JIT, or not suitable for straight-line code
+		constexpr Instruction g_excluded[] =
+		{
+			ADC, Bchg_ea, BRKcc, Clb, Cmpu_S1S2,
+			Debug, Debugcc, DoForever, DorForever, Enddo,
+			Eor_xx, Eor_xxxx, Extract_S1S2, Extract_CoS2,
+			Illegal, Lra_Rn, Lra_xxxx,
+			Maci_xxxx, Macri_xxxx, Merge, Movem_aa, Movep_eaqq, Mpyr_SD, Mpyri,
+			Norm, Normf,
+			Pflush, Pflushun, Pfree, Plock, Plockr, Punlock, Punlockr,
+			Reset, Ror, Rti, Rts, Sbc, Stop, Subr, Trap, Trapcc, Vsl, Wait
+		};
+
+		constexpr uint32_t g_excludedFlags = OpFlagBranch | OpFlagLoop | OpFlagDo | OpFlagPopPC | OpFlagPushPC | OpFlagPopSR | OpFlagCacheMod | OpFlagRepImmediate | OpFlagRepDynamic;
+
+		// writing these would break the call/return frame around the code or change the processing mode
+		constexpr RegisterMask g_excludedWrites = RegisterMask::N | RegisterMask::M | RegisterMask::PC | RegisterMask::SSH | RegisterMask::SP |
+			RegisterMask::SC | RegisterMask::SZ | RegisterMask::EP | RegisterMask::MR | RegisterMask::EMR | RegisterMask::OMR;
+
+		// reading SSH pops the stack
+		constexpr RegisterMask g_excludedReads = RegisterMask::SSH;
+
+		bool isExcluded(const Instruction _inst)
+		{
+			return std::find(std::begin(g_excluded), std::end(g_excluded), _inst) != std::end(g_excluded);
+		}
+
+		TWord random24(std::mt19937& _rand)
+		{
+			return _rand() & 0xffffff;
+		}
+	}
+
+	Generator::Generator(const Opcodes& _opcodes) : m_opcodes(_opcodes)
+	{
+		for(size_t i=0; i<g_opcodeCount; ++i)
+		{
+			const auto& oi = Opcodes::getOpcodeInfoAt(i);
+
+			if(oi.getInstruction() == Nop || isExcluded(oi.getInstruction()) || (oi.m_flags & g_excludedFlags))
+				continue;
+
+			m_candidates.push_back(i);
+		}
+	}
+
+	TestCase Generator::createCase(const uint32_t _seed, const uint32_t _maxOps) const
+	{
+		std::mt19937 rand(_seed);
+
+		TestCase c;
+		c.seed = _seed;
+
+		auto& s = c.state;
+
+		s.a = ((static_cast<uint64_t>(rand()) << 32) | rand()) & 0x00ffffffffffffffull;
+		s.b = ((static_cast<uint64_t>(rand()) << 32) | rand()) & 0x00ffffffffffffffull;
+
+		s.x0 = random24(rand);	s.x1 = random24(rand);
+		s.y0 = random24(rand);	s.y1 = random24(rand);
+
+		for(size_t i=0; i<8; ++i)
+		{
+			s.r[i] = rand() % RMax;
+			s.n[i] = rand() & 0xf;
+
+			// linear or modulo addressing, bit reverse and multiple wrap-around modulo are not used
+			s.m[i] = (rand() & 1) ? 0xffffff : (1 + (rand() & 0xff));
+		}
+
+		s.ccr = rand() & 0xff;
+
+		// no scaling, scale down, scale up
+		s.scaling = (rand() % 3) << 10;
+
+		s.la = random24(rand);
+		s.lc = random24(rand);
+
+		s.x.resize(MemWindowSize);
+		s.y.resize(MemWindowSize);
+
+		for(TWord i=0; i<MemWindowSize; ++i)
+		{
+			s.x[i] = random24(rand);
+			s.y[i] = random24(rand);
+		}
+
+		const auto count = 1 + rand() % std::max(_maxOps, 1u);
+
+		while(c.ops.size() < count)
+		{
+			Op op;
+			if(createOp(op, rand))
+				c.ops.push_back(op);
+		}
+
+		return c;
+	}
+
+	bool Generator::isValidAddress(const TWord _addr)
+	{
+		return _addr < MemWindowSize || _addr >= XIO_Reserved_High_First;
+	}
+
+	bool Generator::createOp(Op& _op, std::mt19937& _rand) const
+	{
+		// pick an instruction first and fill its variable bits, random words would nearly always decode to parallel moves
+		const auto& oi = Opcodes::getOpcodeInfoAt(m_candidates[_rand() % m_candidates.size()]);
+
+		const auto fixedBits = oi.m_mask0 | oi.m_mask1;
+
+		_op.word = oi.m_mask1 | (random24(_rand) & ~fixedBits & 0xffffff);
+
+		// extension words are either addresses, displacements or immediate data. Keep them small so that memory accesses stay in the window
+		_op.ext = _rand() % MemWindowSize;
+
+		_op.length = m_opcodes.getOpcodeLength(_op.word);
+
+		if(_op.length < 1 || _op.length > 2)
+			return false;
+
+		return isAllowed(_op);
+	}
+
+	bool Generator::isAllowed(const Op& _op) const
+	{
+		Instruction instA, instB;
+
+		m_opcodes.getInstructionTypes(_op.word, instA, instB);
+
+		if(Opcodes::isParallelOpcode(_op.word))
+		{
+			if(!m_opcodes.findParallelMoveOpcodeInfo(_op.word))
+				return false;
+			if((_op.word & 0xff) && !m_opcodes.findParallelAluOpcodeInfo(_op.word))
+				return false;
+		}
+		else if(instA == Invalid)
+		{
+			return false;
+		}
+
+		if(isExcluded(instA) || isExcluded(instB))
+			return false;
+
+		if(Opcodes::getFlags(instA, instB) & g_excludedFlags)
+			return false;
+
+		if(m_opcodes.writesToPMemory(_op.word))
+			return false;
+
+		RegisterMask written, read;
+		Opcodes::getRegisters(written, read, _op.word, instA, instB);
+
+		if((written & g_excludedWrites) != RegisterMask::None)
+			return false;
+
+		if((read & g_excludedReads) != RegisterMask::None)
+			return false;
+
+		// address register loads would move memory accesses out of the window, address updates are fine
+		const auto writtenR = written & RegisterMask::R;
+
+		if((writtenR & read) != writtenR)
+			return false;
+
+		TWord addr;
+		EMemArea area;
+
+		if(m_opcodes.getMemoryAddress(addr, area, _op.word, _op.ext) && !isValidAddress(addr))
+			return false;
+
+		return true;
+	}
+}
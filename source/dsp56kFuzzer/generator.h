@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "dsp56kEmu/types.h"
+
+namespace dsp56k
+{
+	class Opcodes;
+}
+
+namespace dsp56kFuzzer
+{
+	// code is placed at P:CodeAddress and called via a JSR from StopAddress. It ends with an RTS so that it returns to StopAddress
+	constexpr dsp56k::TWord CodeAddress = 0x100;
+	constexpr dsp56k::TWord StopAddress = 0x1000;
+
+	// X and Y memory below this address is initialized with random data and compared after every block. Generated code only
+	// accesses memory in this window, see Generator::isValidAddress
+	constexpr dsp56k::TWord MemWindowSize = 0x2000;
+
+	// address registers are initialized below RMax and a case is discarded if one of them leaves the range [0, RLimit)
+	constexpr dsp56k::TWord RMax = 0x800;
+	constexpr dsp56k::TWord RLimit = 0x1000;
+
+	struct Op
+	{
+		dsp56k::TWord word = 0;
+		dsp56k::TWord ext = 0;
+		uint32_t length = 1;
+	};
+
+	struct InitialState
+	{
+		uint64_t a = 0;
+		uint64_t b = 0;
+		dsp56k::TWord x0 = 0, x1 = 0, y0 = 0, y1 = 0;
+		dsp56k::TWord r[8]{};
+		dsp56k::TWord n[8]{};
+		dsp56k::TWord m[8]{};
+		dsp56k::TWord ccr = 0;
+		dsp56k::TWord scaling = 0;	// S1:S0 bits of the SR
+		dsp56k::TWord la = 0, lc = 0;
+
+		std::vector<dsp56k::TWord> x;
+		std::vector<dsp56k::TWord> y;
+	};
+
+	struct TestCase
+	{
+		uint32_t seed = 0;
+		InitialState state;
+		std::vector<Op> ops;
+	};
+
+	// Creates random sequences of valid straight-line opcodes. Instructions that change the control flow, modify P memory or
+	// change the processing mode are excluded, as well as instructions that are not implemented by the interpreter or the JIT
+	class Generator
+	{
+	public:
+		explicit Generator(const dsp56k::Opcodes& _opcodes);
+
+		TestCase createCase(uint32_t _seed, uint32_t _maxOps) const;
+
+		static bool isValidAddress(dsp56k::TWord _addr);
+
+	private:
+		bool createOp(Op& _op, std::mt19937& _rand) const;
+		bool isAllowed(const Op& _op) const;
+
+		const dsp56k::Opcodes& m_opcodes;
+		std::vector<size_t> m_candidates;	// indices into g_opcodes
+	};
+}
@@ -1,11 +1,20 @@
 #include <iostream>
+#include <string>
 
+#include "dsp56kEmu/audiobenchmark.h"
 #include "dsp56kEmu/dspconfig.h"
 #include "dsp56kEmu/jitunittests.h"
 #include "dsp56kEmu/interpreterunittests.h"
 
 int main(int _argc, char* _argv[])
 {
+	if(_argc > 1 && std::string(_argv[1]) == "--audiobenchmark")
+	{
+		const auto r = dsp56k::AudioBenchmark::run();
+		std::cout << "Audio ring buffer frames/s: per frame " << r.perFrameFramesPerSecond << ", bulk " << r.bulkFramesPerSecond << std::endl;
+		return 0;
+	}
+
 	std::cout << "Running Unit Tests..." << std::endl;
 	try
 	{